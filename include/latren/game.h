@@ -8,9 +8,12 @@
 #include "io/resourcemanager.h"
 #include "audio/audioplayer.h"
 #include "physics/physics.h"
+#include "threads/threadpool.h"
 
 class  Game {
 protected:
+    // declared first so the workers outlive everything that could still have jobs queued
+    Threads::ThreadPool threadPool_;
     EntityManager entityManager_;
     GameWindow window_;
     Renderer renderer_;
@@ -72,6 +75,7 @@ public:
     virtual ModularResourceManager& GetResources();
     virtual AudioPlayer& GetAudioPlayer();
     virtual PhysicsWorld& GetPhysics();
+    virtual Threads::ThreadPool& GetThreadPool();
 
     virtual void RegisterComponents();
     virtual void RegisterDeserializers();
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <vector>
+#include <cstdint>
+
+#include "camera.h"
+#include "culling.h"
+
+// bounding volume hierarchy for things that don't move (static renderables)
+// built with binned SAH, a change in the item bounds only needs a refit
+class  BVH {
+public:
+    struct Node {
+        glm::vec3 min;
+        glm::vec3 max;
+        // range in the item order, inner nodes cover all the items of their subtree
+        std::uint32_t first;
+        std::uint32_t count;
+        // the right child is always left + 1, -1 for leaves
+        std::int32_t left;
+        bool IsLeaf() const { return left < 0; }
+    };
+private:
+    std::vector<Node> nodes_;
+    std::vector<ViewFrustum::AABB> items_;
+    std::vector<glm::vec3> centroids_;
+    // item indices ordered so that every node covers a contiguous range
+    std::vector<std::uint32_t> order_;
+    bool dirty_ = false;
+    // inserts since the last full build
+    int insertions_ = 0;
+
+    void BuildSubtree(std::uint32_t, int);
+    void Subdivide(std::uint32_t);
+    void RefitNode(std::uint32_t);
+    void UpdateNodeBounds(Node&);
+    void CullNode(std::uint32_t, int, const ViewFrustum&, Culling::VisibilitySet&) const;
+    void MarkVisible(const Node&, Culling::VisibilitySet&) const;
+    ViewFrustum::AABB GetNodeAABB(const Node&) const;
+public:
+    void Build(const std::vector<ViewFrustum::AABB>&);
+    // appends the items with a subtree of their own, their indices continue from the current item count.
+    // only the new items get split, every few inserts this is a full rebuild instead
+    void Insert(const std::vector<ViewFrustum::AABB>&);
+    void Clear();
+    // doesn't change the structure, call Refit after all the updates
+    void Update(std::uint32_t, const ViewFrustum::AABB&);
+    void Refit();
+    // sets the bits of the visible items, the set is resized to the item count
+    void CullFrustum(const ViewFrustum&, Culling::VisibilitySet&) const;
+    std::size_t GetItemCount() const;
+    std::size_t GetNodeCount() const;
+
+    // calls fn with every item whose box overlaps
+    template <typename F>
+    void QueryAABB(const ViewFrustum::AABB& aabb, F fn) const {
+        Traverse([&](const ViewFrustum::AABB& box) { return Culling::Intersects(box, aabb); }, fn);
+    }
+    template <typename F>
+    void QuerySphere(const glm::vec3& center, float radius, F fn) const {
+        Traverse([&](const ViewFrustum::AABB& box) { return Culling::IntersectsSphere(box, center, radius); }, fn);
+    }
+    // fn gets the item and the distance to its box
+    template <typename F>
+    void QueryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, F fn) const {
+        glm::vec3 invDir = 1.0f / dir;
+        float t;
+        Traverse(
+            [&](const ViewFrustum::AABB& box) { return Culling::IntersectsRay(box, origin, invDir, maxDistance, t); },
+            [&](std::uint32_t item) { fn(item, t); }
+        );
+    }
+    template <typename Test, typename F>
+    void Traverse(Test test, F fn) const {
+        if (nodes_.empty())
+            return;
+        std::uint32_t stack[64];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const Node& node = nodes_[stack[--stackSize]];
+            if (!test(GetNodeAABB(node)))
+                continue;
+            if (node.IsLeaf()) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+                    if (test(items_[order_[i]]))
+                        fn(order_[i]);
+                }
+            }
+            // the depth is capped when building so this can't overflow
+            else {
+                stack[stackSize++] = node.left + 1;
+                stack[stackSize++] = node.left;
+            }
+        }
+    }
+};
\ No newline at end of file
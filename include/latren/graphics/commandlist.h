@@ -0,0 +1,128 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstring>
+
+#include "shader.h"
+#include "texture.h"
+
+class GLState;
+
+namespace RenderCommands {
+    enum class Type : uint8_t {
+        USE_SHADER,
+        BIND_VERTEX_ARRAY,
+        BIND_TEXTURE,
+        SET_ENABLED,
+        UNIFORM,
+        DRAW_ELEMENTS
+    };
+    enum class UniformType : uint8_t {
+        INT,
+        FLOAT,
+        VEC2,
+        VEC3,
+        VEC4,
+        MAT2,
+        MAT3,
+        MAT4
+    };
+
+    // the gl object names are just numbers here, nothing is resolved until the list is submitted
+    struct Command {
+        Type type;
+        union {
+            // resolved to the program on submit, the lazy lookup in Shader isn't thread safe
+            const Shader* shader;
+            struct {
+                GLuint vao;
+                GLuint ebo;
+            } vertexArray;
+            struct {
+                GLenum target;
+                GLuint texture;
+                GLuint unit;
+            } texture;
+            struct {
+                GLenum capability;
+                bool enabled;
+            } capability;
+            // offsets into the list's arena
+            struct {
+                UniformType type;
+                uint32_t name;
+                uint32_t value;
+            } uniform;
+            struct {
+                GLenum indexType;
+                GLsizei count;
+                GLint baseVertex;
+                std::size_t offset;
+            } draw;
+        };
+    };
+
+    // uniform locations per program, only touched on the gl thread
+    class  UniformLocationCache {
+    private:
+        std::unordered_map<GLuint, std::unordered_map<std::string, GLint>> locations_;
+        std::string key_;
+    public:
+        GLint Get(GLuint, const char*);
+        void Clear();
+    };
+};
+
+// draw commands recorded without a gl context (so on any thread) and replayed later on the gl thread
+// the uniform names and values are copied into the list's own arena, which is reused frame to frame
+class  CommandList {
+private:
+    std::vector<RenderCommands::Command> commands_;
+    std::vector<unsigned char> arena_;
+    uint32_t PushData(const void*, std::size_t);
+    void PushUniform(RenderCommands::UniformType, const char*, const void*, std::size_t);
+public:
+    void Clear();
+    bool IsEmpty() const;
+    std::size_t GetCommandCount() const;
+    std::size_t GetDrawCount() const;
+
+    void UseShader(const Shader&);
+    void BindVertexArray(GLuint, GLuint);
+    void BindTexture(GLenum, Texture::TextureID, GLuint = 0);
+    void SetEnabled(GLenum, bool);
+    // the base vertex is for the meshes in a MeshArena
+    void DrawElements(GLenum, GLsizei, std::size_t, GLint = 0);
+
+    template <typename T>
+    void SetUniform(const char* name, const T& value) {
+        using namespace RenderCommands;
+        if constexpr (std::is_same_v<T, bool>) {
+            int i = value;
+            PushUniform(UniformType::INT, name, &i, sizeof(int));
+        }
+        else if constexpr (std::is_same_v<T, int>)
+            PushUniform(UniformType::INT, name, &value, sizeof(int));
+        else if constexpr (std::is_same_v<T, float>)
+            PushUniform(UniformType::FLOAT, name, &value, sizeof(float));
+        else if constexpr (std::is_same_v<T, glm::vec2>)
+            PushUniform(UniformType::VEC2, name, &value[0], sizeof(glm::vec2));
+        else if constexpr (std::is_same_v<T, glm::vec3>)
+            PushUniform(UniformType::VEC3, name, &value[0], sizeof(glm::vec3));
+        else if constexpr (std::is_same_v<T, glm::vec4>)
+            PushUniform(UniformType::VEC4, name, &value[0], sizeof(glm::vec4));
+        else if constexpr (std::is_same_v<T, glm::mat2>)
+            PushUniform(UniformType::MAT2, name, &value[0][0], sizeof(glm::mat2));
+        else if constexpr (std::is_same_v<T, glm::mat3>)
+            PushUniform(UniformType::MAT3, name, &value[0][0], sizeof(glm::mat3));
+        else if constexpr (std::is_same_v<T, glm::mat4>)
+            PushUniform(UniformType::MAT4, name, &value[0][0], sizeof(glm::mat4));
+    }
+
+    // replays the commands, has to be called on the thread with the gl context
+    void Submit(GLState&, RenderCommands::UniformLocationCache&) const;
+};
\ No newline at end of file
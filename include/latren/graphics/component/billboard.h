@@ -20,6 +20,6 @@ public:
 
     virtual void UpdateVertexBuffer();
     virtual void CalculateMatrices();
-    virtual void UpdateUniforms(const Shader&, const glm::mat4&, const glm::mat4&, const glm::vec3&) const override;
+    virtual void UpdateUniforms(const Shader&) const override;
     virtual void Render(const glm::mat4&, const glm::mat4&, const glm::vec3&, const Shader* = nullptr, int = RENDER_MODE_NORMAL) const;
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <latren/ec/component.h>
 #include <latren/ec/entity.h>
 #include <latren/ec/serializable.h>
+#include <vector>
 
 namespace Lights {
     enum class LightType {
@@ -16,21 +17,39 @@ namespace Lights {
     
     extern int LIGHTS_INDEX;
      int GetNextLightIndex();
-    typedef uint32_t LightReserves;
+    // true for the reserved indices
+    typedef std::vector<bool> LightReserves;
     extern LightReserves RESERVED_LIGHTS;
-    extern const uint8_t MAX_LIGHTS;
+    // sanity cap, the lights are culled per cluster so the count itself doesn't matter much
+    extern const int MAX_LIGHTS;
 
      void ReserveIndex(int);
      bool IsReserved(int);
      int& GetIndex(LightType);
      void ResetIndices();
 
+    // packed into the light texture buffer by LightClusters
+    struct LightData {
+        glm::vec3 color = glm::vec3(0.0f);
+        float intensity = 0.0f;
+        glm::vec3 pos = glm::vec3(0.0f);
+        float range = 0.0f;
+        glm::vec3 dir = glm::vec3(0.0f);
+        float y = 0.0f;
+        int type = 0;
+        int enabled = GL_FALSE;
+        float cutOffMin = 0.0f;
+        float cutOffMax = 0.0f;
+    };
+
     class ILight {
     public:
         virtual ~ILight() = default;
         virtual void UseAsNext() = 0;
-        virtual void ApplyLight(GLuint) const = 0;
-        virtual void ApplyForShaders(const std::vector<GLuint>&) const = 0;
+        virtual int GetIndex() const = 0;
+        virtual void ApplyLight(LightData&) const = 0;
+        // call this after modifying the light at runtime, marks the light buffer dirty
+        void UpdateLight() const;
 
         virtual operator IComponent&() = 0;
     };
@@ -41,27 +60,21 @@ namespace Lights {
         LightType lightType_ = LightType::NONE;
     protected:
         void SetLightType(LightType t) { lightType_ = t; }
-        std::string lightUniform_;
+        int lightIndex_ = -1;
     public:
         SERIALIZABLE(glm::vec3, color) = glm::vec3(1.0f);
         SERIALIZABLE(float, intensity) = 1.0f;
 
         LightType GetType() { return lightType_; }
         virtual void UseAsNext() override {
-            lightUniform_ = "lights[" + std::to_string(GetNextLightIndex()) + "]";
-        }
-        virtual void ApplyLight(GLuint shader) const override {
-            glUniform1i(glGetUniformLocation(shader, std::string(lightUniform_ + ".enabled").c_str()), GL_TRUE);
-            glUniform1i(glGetUniformLocation(shader, std::string(lightUniform_ + ".type").c_str()), static_cast<int>(lightType_));
-            glUniform3f(glGetUniformLocation(shader, std::string(lightUniform_ + ".color").c_str()), color->x, color->y, color->z);
-            glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".intensity").c_str()), intensity);
+            lightIndex_ = GetNextLightIndex();
         }
-        virtual void ApplyForShaders(const std::vector<GLuint>& shaders) const override {
-            for (GLuint shader : shaders) {
-                glUseProgram(shader);
-                ApplyLight(shader);
-            }
-            glUseProgram(0);
+        virtual int GetIndex() const override { return lightIndex_; }
+        virtual void ApplyLight(LightData& data) const override {
+            data.enabled = GL_TRUE;
+            data.type = static_cast<int>(lightType_);
+            data.color = color;
+            data.intensity = intensity;
         }
 
         virtual operator IComponent&() override { return *this; }
@@ -73,7 +86,7 @@ namespace Lights {
         SERIALIZABLE(glm::vec3, offset) = glm::vec3(0.0f);
 
         PointLight() { Light::SetLightType(LightType::POINT); }
-        void ApplyLight(GLuint) const;
+        void ApplyLight(LightData&) const;
     };
 
     class  DirectionalLight : public Light<DirectionalLight> {
@@ -81,7 +94,7 @@ namespace Lights {
         SERIALIZABLE(glm::vec3, dir);
         
         DirectionalLight() { Light::SetLightType(LightType::DIRECTIONAL); }
-        void ApplyLight(GLuint) const;
+        void ApplyLight(LightData&) const;
     };
 
     class  DirectionalLightPlane : public Light<DirectionalLightPlane> {
@@ -91,7 +104,7 @@ namespace Lights {
         SERIALIZABLE(float, offset) = 0.0f;
 
         DirectionalLightPlane() { Light::SetLightType(LightType::DIRECTIONAL_PLANE); }
-        void ApplyLight(GLuint) const;
+        void ApplyLight(LightData&) const;
     };
 
     class  Spotlight : public Light<Spotlight> {
@@ -103,6 +116,6 @@ namespace Lights {
         SERIALIZABLE(glm::vec3, offset) = glm::vec3(0.0f);
 
         Spotlight() { Light::SetLightType(LightType::SPOTLIGHT); }
-        void ApplyLight(GLuint) const;
+        void ApplyLight(LightData&) const;
     };
 }
\ No newline at end of file
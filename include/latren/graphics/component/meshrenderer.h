@@ -7,23 +7,41 @@
 #include <latren/defines/opengl.h>
 #include <memory>
 
+class CommandList;
+
 class  MeshRenderer : public Renderable<MeshRenderer> {
 friend class Renderer;
 private:
     mutable glm::mat4 modelMatrix_;
     ViewFrustum::AABB aabb_;
+    // aabb_ transformed by the model matrix, updated in CalculateMatrices
+    ViewFrustum::AABB worldAabb_;
     bool isAssignedToRenderer_ = false;
+    // from the object's lod settings
+    std::vector<float> lodScreenSizes_;
+    int lodLevel_ = 0;
 public:
     // enable this if the object transform doesn't update, no need to calculate model matrices every frame that way
     SERIALIZABLE(std::string, object) = { };
     SERIALIZABLE(std::vector<std::shared_ptr<Mesh>>, meshes);
     SERIALIZABLE(bool, copyMeshes) = false;
+    // multiplies the projected size, lower values switch to the coarser levels sooner
+    SERIALIZABLE(float, lodBias) = 1.0f;
+    // -1 to pick the level by the screen size
+    SERIALIZABLE(int, forceLod) = -1;
 
     void CalculateMatrices() override;
-    virtual void UpdateUniforms(const Shader&, const glm::mat4&, const glm::mat4&, const glm::mat4&, const glm::vec3&) const;
+    virtual void UpdateUniforms(const Shader&, const glm::mat4&) const;
 
     void Start() override;
     bool IsOnFrustum(const ViewFrustum&) const override;
+    bool GetWorldAABB(ViewFrustum::AABB&) const override;
+    std::size_t GetDrawCallCount() const override;
+    void UpdateLOD(const Camera&) override;
+    int GetLODLevel() const;
+    const glm::mat4& GetModelMatrix() const;
     void Render(const glm::mat4&, const glm::mat4&, const glm::vec3&, const Shader* = nullptr, int = RENDER_MODE_NORMAL) const override;
+    // the normal render mode recorded into a command list, called from the renderer's worker threads
+    void RecordCommands(CommandList&) const;
     const ViewFrustum::AABB& GetAABB() const;
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "renderable.h"
+#include "../shaders.h"
+#include "../material.h"
+#include "../particles.h"
+
+// cpu simulated particles drawn as instanced camera facing quads. the particles live in a fixed size pool
+// that's allocated on start, they're simulated in world space and streamed into the renderer's stream
+// buffer every frame. goes into the late pass by default since the quads don't write depth.
+class  ParticleSystem : public Renderable<ParticleSystem> {
+private:
+    Particles::ParticleBuffer particles_;
+    Particles::ColorCurve colorCurve_;
+    Particles::FloatCurve sizeCurve_;
+    float maxSizeScale_ = 1.0f;
+    Particles::Bounds bounds_;
+    std::vector<Particles::Bounds> chunkBounds_;
+    mutable Particles::DepthSorter sorter_;
+    float emitAccumulator_ = 0.0f;
+    std::uint32_t random_ = 0x9e3779b9;
+    GLuint vao_ = GL_NONE;
+    inline static Shader SHADER_ = Shaders::ShaderID::PARTICLE;
+
+    // [0, 1)
+    float Random();
+    float Random(const glm::vec2&);
+public:
+    SERIALIZABLE(int, maxParticles) = 10000;
+    // particles per second while emitting
+    SERIALIZABLE(float, emitRate) = 50.0f;
+    // emitted all at once on start
+    SERIALIZABLE(int, burst) = 0;
+    SERIALIZABLE(bool, emitting) = true;
+    // these are picked randomly between x and y
+    SERIALIZABLE(glm::vec2, lifetime) = glm::vec2(1.0f, 2.0f);
+    SERIALIZABLE(glm::vec2, speed) = glm::vec2(1.0f, 2.0f);
+    SERIALIZABLE(glm::vec2, size) = glm::vec2(.1f, .2f);
+    // rotated with the transform, spread is the cone angle around it in degrees
+    SERIALIZABLE(glm::vec3, direction) = glm::vec3(0.0f, 1.0f, 0.0f);
+    SERIALIZABLE(float, spread) = 15.0f;
+    SERIALIZABLE(float, emitRadius) = 0.0f;
+    SERIALIZABLE(glm::vec3, gravity) = glm::vec3(0.0f, -9.81f, 0.0f);
+    SERIALIZABLE(float, drag) = 0.0f;
+    // keys spaced evenly over the lifetime, the size is multiplied with the start size
+    SERIALIZABLE(std::vector<glm::vec4>, colorOverLife);
+    SERIALIZABLE(std::vector<float>, sizeOverLife);
+    SERIALIZABLE(bool, additive) = false;
+    // back to front, not needed with additive blending
+    SERIALIZABLE(bool, sortByDepth) = false;
+    // only the texture, color and opacity are used
+    SERIALIZABLE(std::shared_ptr<Material>, material);
+
+    ParticleSystem();
+    virtual void Start();
+    virtual void Update();
+
+    void Emit(int);
+    void Clear();
+    // call after changing the over-life keys
+    void UpdateCurves();
+    std::size_t GetParticleCount() const;
+
+    virtual bool GetWorldAABB(ViewFrustum::AABB&) const override;
+    virtual std::size_t GetDrawCallCount() const override;
+    virtual void Delete();
+    virtual void Render(const glm::mat4&, const glm::mat4&, const glm::vec3&, const Shader* = nullptr, int = RENDER_MODE_NORMAL) const;
+};
\ No newline at end of file
@@ -9,6 +9,17 @@
 
 class Renderer;
 class IRenderable {
+private:
+    friend class Renderer;
+    // slot in the renderer's culling arrays
+    std::size_t cullingIndex_ = static_cast<std::size_t>(-1);
+    // item in the renderer's static bvh
+    std::size_t staticIndex_ = static_cast<std::size_t>(-1);
+    // merged into the renderer's static batches, not drawn on its own
+    bool staticBatched_ = false;
+protected:
+    // through the renderer's state cache
+    static void SetDepthTest(bool);
 public:
     virtual ~IRenderable() = default;
     virtual RenderPass::Enum GetRenderPass() const = 0;
@@ -16,7 +27,18 @@ public:
     virtual bool IsStatic() const = 0;
     virtual bool IsAlwaysOnFrustum() const = 0;
     virtual bool IsOnFrustum(const ViewFrustum&) const = 0;
+    // world space bounds for culling, returns false if there aren't any (always drawn)
+    // only read after CalculateMatrices
+    virtual bool GetWorldAABB(ViewFrustum::AABB&) const = 0;
     virtual glm::vec3 GetPosition() const = 0;
+    // how many draw calls IRender issues, only used for the renderer stats
+    virtual std::size_t GetDrawCallCount() const = 0;
+    // occlusion culling opt-in, occluders get drawn into the occlusion depth buffer
+    // and occludees can get culled by it (both need a world aabb)
+    virtual bool IsOccluder() const = 0;
+    virtual bool IsOccludee() const = 0;
+    // called once per frame for the visible renderables before rendering
+    virtual void UpdateLOD(const Camera&) = 0;
     virtual void IRender(const glm::mat4&, const glm::mat4&, const glm::vec3&, const Shader* = nullptr, int = RENDER_MODE_NORMAL) const = 0;
     
     virtual operator IComponent&() = 0;
@@ -33,6 +55,9 @@ public:
     SERIALIZABLE(std::unordered_set<int>, meshesUsingCustomMaterial);
     SERIALIZABLE(RenderPass::Enum, renderPass) = RenderPass::NORMAL;
     SERIALIZABLE(glm::vec3, offset) = glm::vec3(0.0f);
+    // large, solid things (walls, terrain) that hide other stuff
+    SERIALIZABLE(bool, occluder) = false;
+    SERIALIZABLE(bool, occludee) = false;
 
     virtual bool IsStatic() const override {
         return this->parent.GetTransform().isStatic;
@@ -45,29 +70,30 @@ public:
 
     virtual const Shader& GetMaterialShader(const std::shared_ptr<Material>& mat) const { return mat->GetShader(); }
     virtual void UseMaterial(const std::shared_ptr<Material>& mat) const { mat->Use(); }
-    virtual void UpdateUniforms(const Shader& shader, const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& viewPos) const {
+    // camera data (projection, view, viewPos, time) comes from the shared uniform buffer
+    virtual void UpdateUniforms(const Shader& shader) const {
         shader.Use();
-        shader.SetUniform("projection", projectionMatrix);
-        shader.SetUniform("view", viewMatrix);
-        shader.SetUniform("viewPos", viewPos);
-        shader.SetUniform("time", (float) IComponent::GetTime());
     }
 
     virtual bool IsAlwaysOnFrustum() const override { return alwaysOnFrustum; }
     virtual bool IsOnFrustum(const ViewFrustum&) const override { return true; }
+    virtual bool GetWorldAABB(ViewFrustum::AABB&) const override { return false; }
     virtual RenderPass::Enum GetRenderPass() const override { return renderPass; }
     virtual glm::vec3 GetPosition() const {
         return this->parent.GetTransform().position.Get() + offset.Get();
     }
 
+    virtual std::size_t GetDrawCallCount() const override { return 1; }
+    virtual bool IsOccluder() const override { return occluder; }
+    virtual bool IsOccludee() const override { return occludee; }
+    virtual void UpdateLOD(const Camera&) override { }
     virtual void CalculateMatrices() override { }
     virtual void IRender(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& viewPos, const Shader* shader = nullptr, int renderMode = RENDER_MODE_NORMAL) const override {
         if (disableDepthTest)
-            glDisable(GL_DEPTH_TEST);
+            SetDepthTest(false);
         Render(projectionMatrix, viewMatrix, viewPos, shader, renderMode);
-        glBindVertexArray(0);
         if (disableDepthTest)
-            glEnable(GL_DEPTH_TEST);
+            SetDepthTest(true);
     }
     virtual void Render(const glm::mat4&, const glm::mat4&, const glm::vec3&, const Shader* = nullptr, int = RENDER_MODE_NORMAL) const { }
 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <latren/defines/opengl.h>
+#include <latren/io/fs.h>
+#include <vector>
+#include <cstdint>
+
+// block-compressed textures with their mip chains built offline (see tools/texcompress.cpp).
+// nothing in here touches the gl context, so the files can be read and decoded on the workers
+namespace Texture {
+enum class CompressedFormat {
+    NONE,
+    // rgb + 1-bit alpha, 8 bytes per block
+    BC1,
+    // rgba, 16 bytes per block
+    BC3,
+    // single channel (r), 8 bytes per block
+    BC4,
+    // two channels (rg), normal maps, 16 bytes per block
+    BC5,
+    // high quality rgba, 16 bytes per block. no cpu fallback for this one
+    BC7,
+    // ktx2 only, no cpu fallback either
+    ETC2_RGB,
+    ETC2_RGBA
+};
+
+struct CompressedImage {
+    struct Level {
+        int width;
+        int height;
+        std::vector<uint8_t> data;
+    };
+    CompressedFormat format = CompressedFormat::NONE;
+    // the first level is the full size one
+    std::vector<Level> levels;
+};
+
+bool IsCompressedTexturePath(const std::fs::path&);
+// a .ktx2 or .dds with the same name next to the file, empty if there's none
+std::fs::path FindCompressedVariant(const std::fs::path&);
+// dds (legacy fourccs and the dx10 header) and uncompressed ktx2, 2d textures only
+bool LoadCompressedImage(const std::fs::path&, CompressedImage&);
+bool LoadDDS(const std::fs::path&, CompressedImage&);
+bool LoadKTX2(const std::fs::path&, CompressedImage&);
+// BC1-BC5 use the legacy fourccs, BC7 the dx10 header. etc2 can't be saved as dds
+bool SaveDDS(const std::fs::path&, const CompressedImage&);
+
+const char* GetCompressedFormatName(CompressedFormat);
+GLenum GetCompressedGLFormat(CompressedFormat);
+std::size_t GetCompressedBlockSize(CompressedFormat);
+std::size_t GetCompressedLevelSize(CompressedFormat, int, int);
+// from the glew flags, so it can only be trusted after glewInit
+bool IsCompressedFormatSupported(CompressedFormat);
+bool CanDecodeCompressedFormat(CompressedFormat);
+// the cpu fallback, BC4 decodes to 1 channel, BC5 to 2 and the rest to 4. returns the channel count, 0 if it can't
+int DecodeCompressedLevel(CompressedFormat, const CompressedImage::Level&, std::vector<uint8_t>&);
+};
\ No newline at end of file
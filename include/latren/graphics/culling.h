@@ -0,0 +1,87 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <vector>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "camera.h"
+
+namespace Culling {
+    // the kernel handles this many boxes at a time, the arrays are padded to a multiple of it
+    const std::size_t BATCH_SIZE = 4;
+
+    // world space aabbs in SoA form so they can be loaded straight into simd registers
+    class  BoundsArray {
+    private:
+        std::size_t count_ = 0;
+    public:
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+
+        void Resize(std::size_t);
+        void Set(std::size_t, const ViewFrustum::AABB&);
+        std::size_t GetCount() const;
+        // count rounded up to BATCH_SIZE
+        std::size_t GetPaddedCount() const;
+    };
+
+    inline int CountTrailingZeros(std::uint64_t v) {
+        #ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward64(&i, v);
+        return (int) i;
+        #else
+        return __builtin_ctzll(v);
+        #endif
+    }
+
+    class  VisibilitySet {
+    private:
+        std::vector<std::uint64_t> bits_;
+    public:
+        void Resize(std::size_t);
+        void Clear();
+        void Set(std::size_t);
+        bool Test(std::size_t) const;
+        // ors the bits of another set of the same size
+        void Merge(const VisibilitySet&);
+        // clears the bits that are set in the other one
+        void Subtract(const VisibilitySet&);
+        // set bits
+        std::size_t Count() const;
+        std::vector<std::uint64_t>& GetWords();
+        const std::vector<std::uint64_t>& GetWords() const;
+
+        // calls fn with the index of every set bit in order
+        template <typename F>
+        void ForEach(F fn) const {
+            for (std::size_t w = 0; w < bits_.size(); w++) {
+                std::uint64_t word = bits_[w];
+                while (word != 0) {
+                    fn(w * 64 + CountTrailingZeros(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    };
+
+    enum class FrustumTestResult {
+        OUTSIDE,
+        INTERSECTS,
+        INSIDE
+    };
+    // planeMask has a bit for every plane that still needs testing (in the order left, right, top, bottom, near, far),
+    // planes the box is fully inside of are cleared from it
+     FrustumTestResult TestFrustum(const ViewFrustum&, const ViewFrustum::AABB&, int& planeMask);
+     bool Intersects(const ViewFrustum::AABB&, const ViewFrustum::AABB&);
+     bool IntersectsSphere(const ViewFrustum::AABB&, const glm::vec3&, float);
+    // slab test, invDir is 1 / direction. t is the entry distance (0 if the origin is inside)
+     bool IntersectsRay(const ViewFrustum::AABB&, const glm::vec3&, const glm::vec3&, float, float&);
+
+    // tests every box against all six planes and writes the results into the set (1 = visible)
+    // uses sse when available, the results are the same as ViewFrustum::IsOnFrustum
+     void CullAABBs(const ViewFrustum&, const BoundsArray&, VisibilitySet&);
+};
\ No newline at end of file
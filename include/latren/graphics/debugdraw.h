@@ -0,0 +1,53 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+
+// immediate mode debug drawing, everything queued during the frame gets drawn in one go when flushed
+// (one draw call per primitive type, the vertices go through the renderer's stream buffer)
+class  DebugDraw {
+private:
+    struct Vertex {
+        glm::vec3 pos;
+        // rgba8
+        GLuint color;
+    };
+    struct TextMarker {
+        glm::vec3 pos;
+        glm::vec4 color;
+        std::string text;
+    };
+    GLuint vao_ = GL_NONE;
+    Shader shader_;
+    std::vector<Vertex> lines_;
+    std::vector<Vertex> points_;
+    std::vector<TextMarker> markers_;
+
+    void DrawVertices(const std::vector<Vertex>&, GLenum);
+    void DrawMarkerLabels(const glm::mat4&);
+public:
+    // the font used for marker labels, they're skipped if it isn't loaded
+    std::string markerFont = "FONT_FIRACODE";
+    float pointSize = 6.0f;
+
+    void Init(GLuint);
+    void Delete();
+    void Line(const glm::vec3&, const glm::vec3&, const glm::vec4& = glm::vec4(1.0f));
+    void Point(const glm::vec3&, const glm::vec4& = glm::vec4(1.0f));
+    void Box(const glm::vec3&, const glm::vec3&, const glm::vec4& = glm::vec4(1.0f));
+    // box transformed by a matrix (e.g. an aabb in model space)
+    void Box(const glm::vec3&, const glm::vec3&, const glm::mat4&, const glm::vec4& = glm::vec4(1.0f));
+    void Sphere(const glm::vec3&, float, const glm::vec4& = glm::vec4(1.0f));
+    // takes the view-projection matrix of the frustum
+    void Frustum(const glm::mat4&, const glm::vec4& = glm::vec4(1.0f));
+    // a point with a text label next to it
+    void Marker(const glm::vec3&, const std::string&, const glm::vec4& = glm::vec4(1.0f));
+    // draws and clears everything queued, takes the camera's view-projection for the labels
+    void Flush(const glm::mat4&);
+    void Clear();
+    std::size_t GetQueuedVertexCount() const;
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <array>
+
+// measures the gpu frame time with timer queries and scales the 3d render resolution to hit a target
+// the render targets stay at the window size, the scene is just drawn into the bottom-left corner of them
+// and stretched back over the whole screen in the framebuffer pass
+class  DynamicResolution {
+public:
+    // a few frames in flight so reading the results never stalls
+    static const int QUERIES = 4;
+private:
+    std::array<GLuint, QUERIES> queries_ = { };
+    std::array<bool, QUERIES> pending_ = { };
+    int query_ = 0;
+    bool running_ = false;
+    float scale_ = 1.0f;
+    // smoothed, in milliseconds
+    float gpuFrameTime_ = 0.0f;
+    int framesSinceChange_ = 0;
+
+    void Adjust();
+public:
+    bool enabled = false;
+    // milliseconds
+    float targetFrameTime = 1000.0f / 60.0f;
+    // max can't go over 1, the targets aren't bigger than the window
+    float minScale = .5f;
+    float maxScale = 1.0f;
+
+    void Init();
+    void Delete();
+    // wrap the whole frame in these
+    void BeginFrame();
+    void EndFrame();
+    float GetScale() const;
+    float GetGPUFrameTime() const;
+    // the scaled size for an output size, at least 1x1
+    glm::ivec2 GetRenderSize(const glm::ivec2&) const;
+};
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <array>
+
+// shadows the gl state that gets toggled per draw and drops the calls that wouldn't change anything
+// everything that touches these states has to go through here (or call Invalidate after), otherwise the shadow goes stale
+// validateState checks every elided call against glGet* and logs the mismatches, debug only, it's slow
+class  GLState {
+public:
+    static const GLuint MAX_TEXTURE_UNITS = 16;
+    struct Counters {
+        std::size_t calls = 0;
+        std::size_t elided = 0;
+        // the binds that weren't elided
+        std::size_t programBinds = 0;
+        std::size_t vertexArrayBinds = 0;
+        std::size_t textureBinds = 0;
+        // reported with the Count* functions below
+        std::size_t draws = 0;
+        std::size_t triangles = 0;
+        std::size_t instances = 0;
+        std::size_t uniforms = 0;
+        std::size_t uploadBytes = 0;
+    };
+private:
+    enum TextureTarget {
+        TEXTURE_2D,
+        TEXTURE_2D_MULTISAMPLE,
+        TEXTURE_2D_ARRAY,
+        TEXTURE_CUBE_MAP,
+        TEXTURE_BUFFER,
+        TOTAL_TEXTURE_TARGETS
+    };
+    enum Capability {
+        DEPTH_TEST,
+        CULL_FACE,
+        BLEND,
+        SCISSOR_TEST,
+        DEPTH_CLAMP,
+        MULTISAMPLE,
+        TOTAL_CAPABILITIES
+    };
+    // -1 for unknown, the next call always goes through
+    static const GLint UNKNOWN = -1;
+
+    GLint program_;
+    GLint vao_;
+    GLint activeTexture_;
+    std::array<std::array<GLint, TOTAL_TEXTURE_TARGETS>, MAX_TEXTURE_UNITS> textures_;
+    std::array<GLint, TOTAL_CAPABILITIES> capabilities_;
+    GLint depthFunc_;
+    GLint depthMask_;
+    GLint cullFace_;
+    std::array<GLint, 2> blendFunc_;
+    std::array<GLint, 4> scissor_;
+    std::array<GLint, 4> viewport_;
+    Counters counters_;
+    // the renderer's cache, meshes and textures can outlive it
+    static GLState* instance_;
+
+    static int GetTextureTarget(GLenum);
+    static GLenum GetTextureBinding(GLenum);
+    static int GetCapability(GLenum);
+    // counts the call, returns false if it can be dropped
+    bool Changed(GLint&, GLint);
+    bool ValidateValue(GLenum, GLint) const;
+    bool ValidateCapability(int) const;
+public:
+    bool validateState = false;
+
+    GLState();
+    ~GLState();
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+    // forget everything, for after code that uses gl directly
+    void Invalidate();
+    // compares the whole shadow against glGet*, logs the mismatches and returns false if there were any
+    bool Validate() const;
+    const Counters& GetCounters() const;
+    void ResetCounters();
+
+    void UseProgram(GLuint);
+    void BindVertexArray(GLuint);
+    void ActiveTexture(GLuint);
+    // the unit is left active
+    void BindTexture(GLenum, GLuint, GLuint = 0);
+    void SetEnabled(GLenum, bool);
+    void Enable(GLenum);
+    void Disable(GLenum);
+    void DepthFunc(GLenum);
+    void DepthMask(bool);
+    void CullFace(GLenum);
+    void BlendFunc(GLenum, GLenum);
+    void Scissor(GLint, GLint, GLsizei, GLsizei);
+    void Viewport(GLint, GLint, GLsizei, GLsizei);
+    // gl unbinds deleted objects and the names get reused, so deletes have to go through here too
+    // static since they can happen after the renderer is gone (static meshes etc.)
+    static void DeleteTexture(GLuint);
+    static void DeleteVertexArray(GLuint);
+    // draws, uniforms and buffer uploads don't go through the cache, they're just counted for the frame stats
+    // static for the same reason as above
+    // false adds to the previous call, for the commands of a multi-draw
+    static void CountDraw(GLenum, std::size_t, std::size_t = 1, bool = true);
+    static void CountUniform();
+    static void CountUpload(std::size_t);
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+
+#include "camera.h"
+#include "uniformbuffer.h"
+#include "component/light.h"
+#include "culling.h"
+
+// clustered forward lighting
+// the view frustum is split into a grid of froxels (exponential depth slices) and the lights are assigned to them
+// on the cpu every frame, so the lit shaders only loop over the lights of their own cluster
+// gl 3.3 doesn't have ssbos so the lists go through texture buffers
+class  LightClusters {
+public:
+    static const glm::uvec3 GRID_SIZE;
+private:
+    struct TextureBuffer {
+        GLuint buffer = GL_NONE;
+        GLuint texture = GL_NONE;
+        GLenum format;
+        void Create(GLenum);
+        void Delete();
+        // orphans the old storage
+        void Upload(const void*, GLsizeiptr);
+    };
+    TextureBuffer lightBuffer_;
+    TextureBuffer clusterBuffer_;
+    TextureBuffer indexBuffer_;
+    UniformBuffer uniforms_;
+
+    // view space bounds of the clusters in soa, recalculated when the projection changes
+    std::vector<float> minX_, minY_, minZ_, maxX_, maxY_, maxZ_;
+    glm::vec4 projectionParams_ = glm::vec4(0.0f);
+
+    // lights as vec4s (color + intensity, pos + range, dir + y, type + cutoffs)
+    std::vector<glm::vec4> packedLights_;
+    std::vector<uint32_t> globalLights_;
+    // (cluster, light) pairs, sorted into the index list
+    std::vector<uint32_t> assignedClusters_;
+    std::vector<uint32_t> assignedLights_;
+    // offset and count for every cluster
+    std::vector<glm::uvec2> clusters_;
+    std::vector<uint32_t> indices_;
+
+    void CalculateClusterBounds(const Camera&);
+    std::size_t GetSlice(float) const;
+    void AssignLight(uint32_t, const Lights::LightData&, const glm::mat4&);
+public:
+    void Init();
+    void Delete();
+    // call when the light data changes
+    void UpdateLights(const std::vector<Lights::LightData>&);
+    // reassigns the lights for the camera, every frame
+    void Update(const Camera&, const glm::ivec2&, const std::vector<Lights::LightData>&);
+    void Bind() const;
+    // light indices in all the clusters combined, for the stats
+    std::size_t GetAssignmentCount() const;
+};
\ No newline at end of file
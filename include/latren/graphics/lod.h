@@ -0,0 +1,36 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <vector>
+
+#include "camera.h"
+
+class Mesh;
+
+// how the lod chain of a mesh is generated and when the levels are used, can be overridden per object in objects.json
+struct LODSettings {
+    bool enabled = true;
+    // max simplification error of each level, relative to the size of the mesh (aabb diagonal)
+    std::vector<float> errors = { .005f, .015f, .04f };
+    // triangle count target of each level as a fraction of the full mesh
+    std::vector<float> ratios = { .5f, .25f, .1f };
+    // projected size (fraction of the screen height) below which each level is used
+    std::vector<float> screenSizes = { .35f, .15f, .05f };
+    // not worth it for small meshes
+    std::size_t minTriangles = 256;
+};
+
+namespace LOD {
+    // how far the projected size has to go past a threshold before switching, relative to the threshold
+    inline const float HYSTERESIS = .1f;
+
+    // quadric error metric edge collapse, keeps the original vertices so the result can share the vertex buffer
+    // uv/normal seams and open borders are locked, returns the simplified indices and writes the reached error (same units as the positions)
+     std::vector<unsigned int> Simplify(const std::vector<float>&, const std::vector<unsigned int>&, std::size_t, float, float* = nullptr);
+    // fills mesh.lods, call before GenerateVAO
+     void GenerateLODs(Mesh&, const LODSettings&);
+    // projected diameter of the bounds as a fraction of the screen height
+     float GetScreenSize(const ViewFrustum::AABB&, const Camera&);
+    // thresholds in descending order, the current level is kept unless the size is clearly past the threshold
+     int SelectLevel(float, const std::vector<float>&, int);
+};
\ No newline at end of file
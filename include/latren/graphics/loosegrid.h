@@ -0,0 +1,108 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+
+#include "camera.h"
+#include "culling.h"
+
+// uniform hash grid for things that move, each item sits in the cell of its center
+// queries look one cell further than the query box, so anything smaller than a cell is found ("loose")
+// items bigger than a cell go into a separate list that's always checked
+class  LooseGrid {
+private:
+    struct Item {
+        ViewFrustum::AABB aabb;
+        std::uint64_t cell;
+        // index in the cell's (or the oversized) list
+        std::uint32_t position;
+        bool oversized;
+        bool inserted = false;
+    };
+    float cellSize_ = 16.0f;
+    std::vector<Item> items_;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> cells_;
+    std::vector<std::uint32_t> oversized_;
+
+    glm::ivec3 GetCellCoords(const glm::vec3&) const;
+    static std::uint64_t GetCellKey(const glm::ivec3&);
+    void Insert(std::uint32_t);
+    void Unlink(std::uint32_t);
+public:
+    LooseGrid() = default;
+    LooseGrid(float);
+    void SetCellSize(float);
+    float GetCellSize() const;
+    // drops all the items but keeps the cell lists around
+    void Clear();
+    void Resize(std::size_t);
+    // only touches the cell lists if the item moved to another cell
+    void Update(std::uint32_t, const ViewFrustum::AABB&);
+    void Remove(std::uint32_t);
+    std::size_t GetCellCount() const;
+
+    template <typename F>
+    void QueryAABB(const ViewFrustum::AABB& aabb, F fn) const {
+        glm::ivec3 min = GetCellCoords(aabb.GetMin() - glm::vec3(cellSize_));
+        glm::ivec3 max = GetCellCoords(aabb.GetMax() + glm::vec3(cellSize_));
+        // huge query, checking every item is cheaper than looking up all those cells
+        glm::vec3 cellCount = glm::vec3(max - min) + 1.0f;
+        if (cellCount.x * cellCount.y * cellCount.z > (float) items_.size()) {
+            for (std::uint32_t i = 0; i < items_.size(); i++) {
+                if (items_[i].inserted && Culling::Intersects(items_[i].aabb, aabb))
+                    fn(i);
+            }
+            return;
+        }
+        for (std::uint32_t item : oversized_) {
+            if (Culling::Intersects(items_[item].aabb, aabb))
+                fn(item);
+        }
+        for (int x = min.x; x <= max.x; x++) {
+            for (int y = min.y; y <= max.y; y++) {
+                for (int z = min.z; z <= max.z; z++) {
+                    auto it = cells_.find(GetCellKey({ x, y, z }));
+                    if (it == cells_.end())
+                        continue;
+                    for (std::uint32_t item : it->second) {
+                        if (Culling::Intersects(items_[item].aabb, aabb))
+                            fn(item);
+                    }
+                }
+            }
+        }
+    }
+    template <typename F>
+    void QuerySphere(const glm::vec3& center, float radius, F fn) const {
+        ViewFrustum::AABB bounds;
+        bounds.center = center;
+        bounds.extents = glm::vec3(radius);
+        QueryAABB(bounds, [&](std::uint32_t item) {
+            if (Culling::IntersectsSphere(items_[item].aabb, center, radius))
+                fn(item);
+        });
+    }
+    // fn gets the item and the distance to its box
+    template <typename F>
+    void QueryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, F fn) const {
+        glm::vec3 invDir = 1.0f / dir;
+        float t;
+        // the box around an endless ray would cover everything anyway
+        if (std::isinf(maxDistance)) {
+            for (std::uint32_t i = 0; i < items_.size(); i++) {
+                if (items_[i].inserted && Culling::IntersectsRay(items_[i].aabb, origin, invDir, maxDistance, t))
+                    fn(i, t);
+            }
+            return;
+        }
+        glm::vec3 end = origin + dir * maxDistance;
+        ViewFrustum::AABB bounds = ViewFrustum::AABB::FromMinMax(glm::min(origin, end), glm::max(origin, end));
+        QueryAABB(bounds, [&](std::uint32_t item) {
+            if (Culling::IntersectsRay(items_[item].aabb, origin, invDir, maxDistance, t))
+                fn(item, t);
+        });
+    }
+};
\ No newline at end of file
@@ -11,6 +11,8 @@
 
 #define MATERIAL_MISSING "MATERIAL_MISSING"
 
+class CommandList;
+
 class  Material {
 private:
     std::unordered_map<std::string, int> intUniforms_ = {
@@ -32,6 +34,29 @@ private:
 
     Shader shader_;
     Texture::TextureID texture_ = TEXTURE_NONE;
+    // drawn from the array instead of texture_ if set, the shader needs a textureArraySampler for these
+    Texture::ArrayLayer textureArray_;
+
+    // fn(name, value) for every uniform, same order for Use and Record
+    template <typename F>
+    void ForEachUniform(F fn) const {
+        for (const auto& i : intUniforms_)
+            fn(i.first, i.second);
+        for (const auto& f : floatUniforms_)
+            fn(f.first, f.second);
+        for (const auto& mat2 : mat2Uniforms_)
+            fn(mat2.first, mat2.second);
+        for (const auto& mat3 : mat3Uniforms_)
+            fn(mat3.first, mat3.second);
+        for (const auto& mat4 : mat4Uniforms_)
+            fn(mat4.first, mat4.second);
+        for (const auto& vec2 : vec2Uniforms_)
+            fn(vec2.first, vec2.second);
+        for (const auto& vec3 : vec3Uniforms_)
+            fn(vec3.first, vec3.second);
+        for (const auto& vec4 : vec4Uniforms_)
+            fn(vec4.first, vec4.second);
+    }
 public:
     template <typename T>
     struct Uniform {
@@ -57,14 +82,21 @@ public:
     void ClearUniforms();
     void Use(const Shader&) const;
     void Use() const;
+    // same as Use but into a command list, doesn't touch gl so it's safe off the gl thread
+    void Record(CommandList&, const Shader&) const;
     template <typename T>
     void SetShader(T s) {
         shader_ = Shader(s);
     }
     void SetTexture(Texture::TextureID t);
+    void SetTexture(const Texture::ArrayLayer&);
     void BindTexture() const;
     const Shader& GetShader() { return shader_; }
     Texture::TextureID GetTexture() { return texture_; }
+    const Texture::ArrayLayer& GetTextureArray() const { return textureArray_; }
+    bool HasTextureArray() const { return textureArray_.array != TEXTURE_NONE; }
+    // everything but the array layer is the same, so the draws can share the state and pass the layer per instance
+    bool IsBatchCompatible(const Material&) const;
 
     template <typename T>
     T& GetShaderUniformReference(const std::string& name) {
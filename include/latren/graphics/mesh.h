@@ -8,23 +8,49 @@
 #include "material.h"
 #include "shader.h"
 #include "camera.h"
+#include "vertexlayout.h"
+#include "mesharena.h"
+
+class CommandList;
+
+// a simplified version of the mesh, uses the same vertices
+struct MeshLOD {
+    std::vector<unsigned int> indices;
+    // relative to the mesh size
+    float error = 0.0f;
+    // first index in the ebo, set by GenerateVAO
+    std::size_t first = 0;
+};
 
 class  Mesh {
+private:
+    void DeleteBuffers();
+    // the vertices in the layout's format
+    std::vector<uint8_t> PackVertices() const;
 public:
     GLuint vao = GL_NONE;
     GLuint vbo = GL_NONE;
     GLuint ebo = GL_NONE;
-    GLuint normalBuffer = GL_NONE;
-    GLuint texCoordBuffer = GL_NONE;
     glm::mat4 transformMatrix = glm::mat4(1.0f);
     ViewFrustum::AABB aabb;
     std::vector<float> vertices;
     std::vector<float> normals;
     std::vector<float> texCoords;
     std::vector<unsigned int> indices;
+    // lod levels after the full mesh, coarsest last
+    std::vector<MeshLOD> lods;
     std::shared_ptr<Material> material;
     std::string id;
     bool cullFaces = true;
+    VertexLayout layout = VertexLayouts::PACKED;
+    // GenerateVAO puts the data in the renderer's shared buffers instead of its own (if the layout allows it)
+    bool useMeshArena = false;
+    // set by GenerateVAO
+    GLenum indexType = GL_UNSIGNED_INT;
+    std::size_t bufferSize = 0;
+    // the vao is the arena's then, and the draws are offset by the allocation
+    MeshArena* arena = nullptr;
+    MeshArena::Allocation arenaAllocation;
 
     virtual ~Mesh();
     Mesh() = default;
@@ -35,9 +61,23 @@ public:
     Mesh(const std::string&, const std::vector<float>&, const std::vector<unsigned int>&);
     Mesh(const Mesh&);
     Mesh(Mesh&&);
+    // picks the most compact layout that doesn't lose precision on the current data
+    void ChooseLayout();
     virtual void GenerateVAO();
-    virtual void Render() const;
+    // 0 is the full mesh, clamped to the available levels
+    virtual void Render(int = 0) const;
+    virtual void RenderInstanced(GLsizei, int = 0) const;
+    // the first index and the index count, ignores the lods
+    void RenderRange(std::size_t, std::size_t) const;
+    int GetLODCount() const;
+    std::size_t GetIndexCount(int = 0) const;
+    // the first index of the lod in the ebo, the arena offset included
+    std::size_t GetFirstIndex(int = 0) const;
+    GLint GetBaseVertex() const;
+    GLuint GetIndexBuffer() const;
     virtual void Bind() const;
+    // Bind and Render into a command list
+    void Record(CommandList&, int = 0) const;
 };
 
 namespace Meshes {
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+#include <memory>
+#include <limits>
+
+#include "vertexlayout.h"
+
+// first fit over a free list sorted by offset, the neighbouring ranges are merged on free.
+// doesn't know what it's allocating, the arena uses vertices and indices as the units
+class  RangeAllocator {
+public:
+    static const std::size_t NONE = std::numeric_limits<std::size_t>::max();
+private:
+    struct Range {
+        std::size_t offset;
+        std::size_t size;
+    };
+    std::vector<Range> free_;
+    std::size_t capacity_ = 0;
+    std::size_t used_ = 0;
+public:
+    // NONE if there's no room, grow and try again
+    std::size_t Allocate(std::size_t);
+    void Free(std::size_t, std::size_t);
+    // the new space goes to the end of the free list
+    void Grow(std::size_t);
+    void Clear();
+    std::size_t GetCapacity() const;
+    std::size_t GetUsed() const;
+};
+
+// shared vertex and index buffers for every mesh of the same vertex format and index type.
+// the meshes in it have the same vao, so they're drawn with base vertices instead of switching
+// the vao, and the renderer can draw a whole bucket of them with a single multi-draw
+class  MeshArena {
+public:
+    struct Allocation {
+        std::size_t firstVertex = 0;
+        std::size_t vertexCount = 0;
+        std::size_t firstIndex = 0;
+        std::size_t indexCount = 0;
+    };
+    // starting capacities, doubled whenever something doesn't fit
+    static const std::size_t INITIAL_VERTICES = 1 << 16;
+    static const std::size_t INITIAL_INDICES = 1 << 18;
+private:
+    VertexLayout layout_;
+    GLenum indexType_ = GL_UNSIGNED_INT;
+    GLuint vao_ = GL_NONE;
+    GLuint vbo_ = GL_NONE;
+    GLuint ebo_ = GL_NONE;
+    RangeAllocator vertices_;
+    RangeAllocator indices_;
+
+    std::size_t GetIndexSize() const;
+    // copies the old contents over to a bigger buffer, the allocations keep their offsets
+    void GrowBuffer(GLuint&, std::size_t, std::size_t);
+    void Reserve(std::size_t, std::size_t);
+public:
+    void Create(const VertexLayout&, GLenum);
+    void Delete();
+    // the data is already in the layout's format, returns false if the arena has been deleted
+    bool Allocate(const void*, std::size_t, const void*, std::size_t, Allocation&);
+    void Free(const Allocation&);
+    bool Matches(const VertexLayout&, GLenum) const;
+    GLuint GetVertexArray() const;
+    GLuint GetIndexBuffer() const;
+    GLenum GetIndexType() const;
+    std::size_t GetBufferSize() const;
+    std::size_t GetUsedSize() const;
+};
+
+// an arena per vertex format and index type, owned by the renderer
+class  MeshArenas {
+private:
+    std::vector<std::unique_ptr<MeshArena>> arenas_;
+public:
+    // nullptr for the layouts that can't be shared (non-interleaved)
+    MeshArena* Get(const VertexLayout&, GLenum);
+    void Delete();
+    std::size_t GetBufferSize() const;
+    std::size_t GetUsedSize() const;
+};
\ No newline at end of file
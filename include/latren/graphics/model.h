@@ -7,13 +7,17 @@
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "lod.h"
 
 class  Model {
 private:
     std::string dir_;
+    LODSettings lodSettings_;
     void ProcessNodes(const aiNode*, const aiScene*);
     std::shared_ptr<Mesh> ProcessMesh(const aiMesh*, const aiScene*);
 public:
     std::vector<std::shared_ptr<Mesh>> meshes;
-    void LoadModel(const std::string&);
+    // the vaos can be left for later if this isn't on the game thread
+    void LoadModel(const std::string&, const LODSettings& = LODSettings(), bool = true);
+    void GenerateVAOs();
 };
\ No newline at end of file
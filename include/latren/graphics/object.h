@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mesh.h"
+#include "lod.h"
 
 #include <unordered_map>
 #include <latren/ec/transform.h>
@@ -9,4 +10,5 @@ struct Object {
     std::shared_ptr<Material> defaultMaterial = nullptr;
     std::unordered_map<int, std::shared_ptr<Material>> materials;
     glm::vec3 size = glm::vec3(1.0f);
+    LODSettings lod;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+#include <array>
+
+#include "camera.h"
+#include "shader.h"
+
+class IRenderable;
+
+// occlusion culling against a low-res depth buffer of the occluders
+// the depth is read back asynchronously (pbo) and turned into a hi-z mip chain on the cpu,
+// so the tests always use the previous frame's depth (with the matrices it was rendered with)
+class  OcclusionCuller {
+private:
+    glm::ivec2 size_ = glm::ivec2(0);
+    GLuint fbo_ = GL_NONE;
+    GLuint depthTexture_ = GL_NONE;
+    std::array<GLuint, 2> pbos_ = { GL_NONE, GL_NONE };
+    std::array<GLsync, 2> fences_ = { };
+    std::array<glm::mat4, 2> pboViewProjections_;
+    int frame_ = 0;
+    Shader depthShader_;
+
+    // level 0 is the full buffer, every level after that has the max of the 2x2 block under it
+    std::vector<std::vector<float>> hiZ_;
+    std::vector<glm::ivec2> levelSizes_;
+    glm::mat4 hiZViewProjection_;
+    bool hasDepth_ = false;
+    // frames since the last fresh depth
+    int staleFrames_ = 0;
+    static const int MAX_STALE_FRAMES = 8;
+
+    void BuildHiZ(const float*);
+    // maps the pbo if its fence has been signalled, true if the hi-z was updated
+    bool ReadBackSlot(int);
+    float GetMaxDepth(int, const glm::ivec2&, const glm::ivec2&) const;
+public:
+    void Init(const glm::ivec2&);
+    void Delete();
+    // maps the depth from the last frame if it's ready
+    void ReadBack();
+    // draws the occluders into the depth buffer and starts reading it back, takes the view-projection used
+    void RenderOccluders(const std::vector<IRenderable*>&, const glm::mat4&);
+    // true if the box is certainly hidden behind the occluders
+    bool IsOccluded(const ViewFrustum::AABB&) const;
+    bool HasDepth() const;
+    void Invalidate();
+};
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace Particles {
+    // the kernels go through this many particles at once
+    const std::size_t BATCH_SIZE = 4;
+    // entries in the sampled over-life curves
+    const std::size_t CURVE_RESOLUTION = 64;
+
+    // what gets streamed into the instance buffer per particle
+    struct Instance {
+        float x, y, z;
+        float size;
+        // rgba8
+        std::uint32_t color;
+    };
+    static_assert(sizeof(Instance) == 20);
+
+    // structure of arrays with a fixed capacity, nothing gets allocated after Reserve.
+    // the particles are kept packed in [0, count), dead ones are swapped out with the last one
+    class  ParticleBuffer {
+    private:
+        std::size_t count_ = 0;
+        std::size_t capacity_ = 0;
+    public:
+        std::vector<float> posX, posY, posZ;
+        std::vector<float> velX, velY, velZ;
+        // age divided by the lifetime, the particle dies at 1
+        std::vector<float> life;
+        std::vector<float> invLifetime;
+        std::vector<float> size;
+
+        void Reserve(std::size_t);
+        // returns the new index or the capacity if it's full
+        std::size_t Add();
+        void Clear();
+        // only touches the dead ones, so this is cheap as long as most particles are alive
+        void RemoveDead();
+        std::size_t GetCount() const;
+        std::size_t GetCapacity() const;
+    };
+
+    // evenly spaced keys over the lifetime sampled into a table, so the lookup is just an index
+    class  ColorCurve {
+    private:
+        // packed rgba8
+        std::array<std::uint32_t, CURVE_RESOLUTION> table_;
+    public:
+        ColorCurve();
+        void Set(const std::vector<glm::vec4>&);
+        std::uint32_t Sample(float t) const {
+            return table_[static_cast<std::size_t>(t * (CURVE_RESOLUTION - 1) + .5f)];
+        }
+    };
+
+    class  FloatCurve {
+    private:
+        std::array<float, CURVE_RESOLUTION> table_;
+    public:
+        FloatCurve();
+        void Set(const std::vector<float>&);
+        float Sample(float t) const {
+            return table_[static_cast<std::size_t>(t * (CURVE_RESOLUTION - 1) + .5f)];
+        }
+    };
+
+    struct Bounds {
+        glm::vec3 min;
+        glm::vec3 max;
+        Bounds();
+        void Merge(const Bounds&);
+        bool IsEmpty() const;
+    };
+
+    // all of these work on the range [begin, end) so they can be split across the thread pool
+
+    // gravity, drag, position and age in one go
+     void Simulate(ParticleBuffer&, std::size_t, std::size_t, float, const glm::vec3&, float);
+     Bounds ComputeBounds(const ParticleBuffer&, std::size_t, std::size_t);
+    // writes the instances in the given order (or as they are if it's null), the output starts at begin
+     void WriteInstances(const ParticleBuffer&, const std::uint32_t*, std::size_t, std::size_t, const ColorCurve&, const FloatCurve&, Instance*);
+
+    // radix sort by the distance along the view direction, furthest first for alpha blending.
+    // keeps the buffers between frames so it doesn't allocate once they've grown
+    class  DepthSorter {
+    private:
+        std::vector<std::uint32_t> keys_;
+        std::vector<std::uint32_t> tmpKeys_;
+        std::vector<std::uint32_t> order_;
+        std::vector<std::uint32_t> tmpOrder_;
+    public:
+        const std::vector<std::uint32_t>& Sort(const ParticleBuffer&, const glm::vec3&, const glm::vec3&);
+    };
+};
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "shader.h"
+#include "shape.h"
+#include "rendertarget.h"
+
+// ordered fullscreen passes after the scene, every pass but the last one draws into a target from the
+// renderer's pool and the later passes can sample any of the earlier ones. the last one draws onto the screen.
+// the targets go back to the pool right after their last reader, so passes that don't overlap share them.
+//
+// every input sampler 'x' also gets 'xRect' (uv scale in xy, max uv in zw) and 'xTexelSize' uniforms,
+// the scene doesn't cover its whole texture with dynamic resolution so the uvs have to go through the rect
+class  PostProcessGraph {
+public:
+    // the resolved scene, always available as an input
+    static const std::string SCENE;
+
+    struct Pass {
+        std::string name;
+        Shader shader;
+        // sampler uniform -> pass name (or SCENE), inputs from disabled passes are left unbound
+        std::vector<std::pair<std::string, std::string>> inputs;
+        // output size relative to the scene, ignored for the last pass
+        float scale = 1.0f;
+        GLenum format = GL_RGB8;
+        std::function<void(const Shader&)> setUniforms;
+        bool enabled = true;
+    };
+private:
+    struct Input {
+        GLuint texture;
+        // null for the scene or once it's been released
+        RenderTarget* target;
+        glm::vec4 rect;
+        glm::vec2 texelSize;
+    };
+    std::vector<Pass> passes_;
+    std::unordered_map<std::string, Input> outputs_;
+    std::size_t passesDrawn_ = 0;
+public:
+    void AddPass(const Pass&);
+    // for adding effects before the composite etc., appends if there's no such pass
+    void InsertPass(const Pass&, const std::string&);
+    void RemovePass(const std::string&);
+    Pass* GetPass(const std::string&);
+    // scene texture, the part of it that has the scene in it and the full texture size
+    // the last pass is drawn into the given framebuffer with the output size
+    void Execute(GLuint, const glm::ivec2&, const glm::ivec2&, GLuint, const glm::ivec2&, const Shape&);
+    std::size_t GetPassesDrawn() const;
+};
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <vector>
 #include <numeric>
+#include <cmath>
 #include <spdlog/spdlog.h>
 
 #include <latren/latren.h>
@@ -29,15 +31,37 @@ public:
 
         Vignette vignette;
     };
+    // separable gaussian/box blur, two 1d passes at a lower resolution before the composite
+    // way cheaper than a gaussian through the kernels (2 * (2r + 1) taps instead of (2r + 1)^2)
+    struct Blur {
+        static constexpr int MAX_RADIUS = 16;
+
+        bool isActive = false;
+        bool gaussian = true;
+        // taps on each side of the center
+        int radius = 3;
+        // <= 0 to derive it from the radius
+        float sigma = 0.0f;
+        // uv distance between the taps, same as kernel.offset
+        float offset = 1.0f / 300.0f;
+        float blend = 1.0f;
+        // of the blur passes, relative to the scene
+        float resolutionScale = .5f;
+
+        Vignette vignette;
+    };
     Vignette vignette;
     glm::vec3 vignetteColor = glm::vec3(0.0f);
     Kernel kernel;
+    Blur blur;
     float gamma = 1.0f;
     float contrast = 1.0f;
     float brightness = 1.0f;
     float saturation = 1.0f;
 
     void ApplyUniforms(const Shader&) const;
+    // center weight first, then the ones on both sides
+    std::vector<float> GetBlurWeights() const;
     template <std::size_t S>
     void ApplyKernel(const std::array<float, S>& k) {
         switch(S) {
@@ -91,18 +115,35 @@ namespace Convolution {
     // anyway, the decompiling was pretty fun :)
     // obviously had no idea what i was doing but managed to make the player move 5 times as fast
     template <std::size_t S>
+    constexpr std::array<float, S> GaussianBlur1D(float sigma = S) {
+        std::array<float, S> kernel;
+        float s = 2.0f * sigma * sigma;
+        for (int x = 0; x < S; x++) {
+            float dist = (float) x - (S - 1) * .5f;
+            kernel[x] = std::exp(-(dist * dist) / s);
+        }
+        Normalize(kernel);
+        return kernel;
+    }
+    // the 2d one is just the outer product of the 1d one, so it's the same thing as two 1d passes
+    template <std::size_t S>
     constexpr std::array<float, S * S> GaussianBlur(int sigma = S) {
+        std::array<float, S> kernel1D = GaussianBlur1D<S>((float) sigma);
         std::array<float, S * S> kernel;
-        float s = 2.0f * (float) (sigma * sigma);
         for (int y = 0; y < S; y++) {
             for (int x = 0; x < S; x++) {
-                float distX = std::abs((float) x - (S - 1));
-                float distY = std::abs((float) y - (S - 1));
-                float val = std::exp(-(distX * distX + distY * distY) / s) / std::sqrt(Math::PI_F * s);
-                kernel[y * S + x] = val;
+                kernel[y * S + x] = kernel1D[x] * kernel1D[y];
             }
         }
-        Normalize(kernel);
         return kernel;
     }
+    template <std::size_t S>
+    constexpr std::array<float, S> BoxBlur1D() {
+        std::array<float, S> kernel;
+        kernel.fill(1.0f / S);
+        return kernel;
+    }
+    // runtime sized, only the center and one side (radius + 1 weights) since they're symmetric
+     std::vector<float> GaussianBlur1D(int, float);
+     std::vector<float> BoxBlur1D(int);
 };
\ No newline at end of file
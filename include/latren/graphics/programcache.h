@@ -0,0 +1,47 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <latren/io/fs.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "shader.h"
+
+// linked program binaries on disk under ${shadercache}, keyed by a hash of the shader sources and the driver.
+// anything that doesn't match (changed sources, driver update, the driver refusing the binary) just gets
+// compiled again and the cached binary is replaced.
+class  ProgramCache {
+public:
+    struct Stats {
+        std::size_t hits = 0;
+        // programs that had to be compiled
+        std::size_t misses = 0;
+        // binaries the driver didn't accept
+        std::size_t rejected = 0;
+        // all in ms
+        double loadTime = 0.0;
+        double compileTime = 0.0;
+        // what the cached programs took to compile when they were stored
+        double savedTime = 0.0;
+    };
+private:
+    bool initialized_ = false;
+    bool supported_ = false;
+    std::string driver_;
+    Stats stats_;
+    void Init();
+    std::fs::path GetPath(uint64_t) const;
+public:
+    bool enabled = true;
+    uint64_t GetKey(const std::vector<Shaders::ShaderSource>&);
+    // false if the program has to be compiled
+    bool Load(GLuint, uint64_t);
+    // call before linking so that the driver keeps the binary around
+    void PrepareProgram(GLuint);
+    // with the compile + link time in ms, only stored if the program linked
+    void Store(GLuint, uint64_t, double);
+    const Stats& GetStats() const;
+    void ResetStats();
+};
\ No newline at end of file
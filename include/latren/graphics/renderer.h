@@ -3,6 +3,7 @@
 #include <latren/defines/opengl.h>
 #include <vector>
 #include <unordered_map>
+#include <optional>
 
 #include "camera.h"
 #include "shader.h"
@@ -11,40 +12,176 @@
 #include "viewport.h"
 #include "renderpass.h"
 #include "rendermode.h"
+#include "uniformbuffer.h"
+#include "streambuffer.h"
+#include "debugdraw.h"
+#include "occlusion.h"
+#include "lightclusters.h"
+#include "glstate.h"
+#include "commandlist.h"
+#include "dynamicresolution.h"
+#include "postprocessgraph.h"
+#include "postprocessing.h"
+#include "culling.h"
+#include "bvh.h"
+#include "loosegrid.h"
+#include "staticbatches.h"
+#include "renderstats.h"
+#include "component/light.h"
 #include <latren/ec/mempool.h>
 
 // forward declarations
-class PostProcessing;
 class IRenderable;
+class MeshRenderer;
 namespace UI {
     class Canvas;
 };
-namespace Lights {
-    class ILight;
-};
 namespace Config {
     struct VideoSettings;
 };
 
 class  Renderer {
 private:
+    struct MeshInstance {
+        const Mesh* mesh;
+        int lod;
+        // the batch's material, see GetBatchMaterial
+        Material* material;
+        float textureLayer;
+        glm::mat4 modelMatrix;
+    };
+    // per instance in instanceBuffer_, matches the InstanceData block of the multi-draw shaders (std430)
+    struct InstanceData {
+        glm::mat4 modelMatrix;
+        // x = texture array layer
+        glm::vec4 params;
+    };
+    // glMultiDrawElementsIndirect's command layout
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    // a range of meshInstances_ drawn with a single call, either instanced or as a multi-draw
+    struct InstanceBatch {
+        std::size_t begin;
+        std::size_t end;
+        // in indirectCommands_, none if the batch isn't a multi-draw
+        std::size_t firstCommand;
+        std::size_t commandCount;
+    };
+
     Viewport* viewport_;
-    GLuint fbo_ = GL_NONE;
-    GLuint rbo_ = GL_NONE;
-    GLuint framebufferTexture_ = GL_NONE;
-    GLuint MSAAFbo_ = GL_NONE;
-    GLuint MSAATextureColorBuffer_ = GL_NONE;
+    GLState glState_;
+    RenderTargetPool renderTargets_;
+    // multisampled scene and the texture it's resolved into, both viewport-sized
+    RenderTarget* sceneTarget_ = nullptr;
+    RenderTarget* resolveTarget_ = nullptr;
     Shape framebufferShape_;
     // smart pointers would be ideal here but i'm too lazy and tired to start rewriting
     std::unordered_map<std::string, UI::Canvas*> canvases_;
     Camera camera_ = Camera();
     Shader framebufferShader_;
     glm::ivec2 viewportSize_;
-    int maxRenderedLights_ = 0;
+    // the 3d scene size, smaller than the viewport with dynamic resolution
+    glm::ivec2 renderSize_;
+    DynamicResolution dynamicResolution_;
+    PostProcessGraph postProcessGraph_;
+    PostProcessing postProcessing_;
+    std::array<float, PostProcessing::Blur::MAX_RADIUS + 1> blurWeights_ = { };
+    int blurRadius_ = 0;
+    UniformBuffer cameraUniforms_;
+    LightClusters lightClusters_;
+    std::vector<Lights::LightData> lights_;
+    bool lightsDirty_ = false;
     std::vector<GLuint> shaders_;
+    struct VisibleRenderable {
+        float distance;
+        GeneralComponentReference ref;
+    };
+
+    // every renderable that isn't in the static bvh, gathered in UpdateFrustum but culled every frame
+    std::vector<GeneralComponentReference> renderables_;
+    Culling::BoundsArray cullingBounds_;
+    Culling::VisibilitySet visibility_;
+    // renderables without bounds or with alwaysOnFrustum
+    Culling::VisibilitySet alwaysVisible_;
+    // camera distances from the last SortMeshesByDistance
+    std::vector<float> distances_;
+    LooseGrid dynamicGrid_;
+    // static renderables with bounds, built on stage load
+    std::vector<GeneralComponentReference> staticRenderables_;
+    std::vector<glm::vec3> staticPositions_;
+    std::vector<float> staticDistances_;
+    BVH staticBvh_;
+    Culling::VisibilitySet staticVisibility_;
+    // in the bvh but not static anymore, these are handled with the dynamic ones until the next build
+    Culling::VisibilitySet staticExcluded_;
+    // in the bvh for the queries but drawn through the static batches
+    Culling::VisibilitySet staticBatched_;
+    StaticBatches staticBatches_;
+    // a batched renderer stopped being static or got destroyed, its group is merged again before the next frame
+    bool staticBatchesDirty_ = false;
+    // cleared slots in staticRenderables_ that are still in the bvh
+    std::size_t deadStaticRenderables_ = 0;
+    std::vector<VisibleRenderable> visibleRenderables_;
     std::vector<GeneralComponentReference> renderablesOnFrustum_;
     std::unordered_map<std::string, std::shared_ptr<Material>> materials_;
     std::array<std::vector<GeneralComponentReference>, RenderPass::TOTAL_RENDER_PASSES> renderPasses_;
+    GLuint instanceBuffer_ = GL_NONE;
+    std::vector<MeshInstance> meshInstances_;
+    std::vector<InstanceData> instanceData_;
+    // materials that only differ by their texture array layer are drawn as one, reset every frame
+    std::vector<Material*> batchMaterials_;
+    std::unordered_map<const Material*, Material*> batchMaterialLookup_;
+    // base program -> instanced variant (if there is one)
+    std::unordered_map<GLuint, std::optional<Shader>> instancedShaders_;
+    MeshArenas meshArenas_;
+    // gl 4.3, the instanced buckets of the arena meshes are drawn with glMultiDrawElementsIndirect
+    bool multiDrawSupported_ = false;
+    GLuint indirectBuffer_ = GL_NONE;
+    // 0, 1, 2... as a per-instance attribute, the shaders index the instance matrices with it
+    GLuint instanceIndexBuffer_ = GL_NONE;
+    std::size_t instanceIndexCapacity_ = 0;
+    std::vector<InstanceBatch> instanceBatches_;
+    std::vector<DrawElementsIndirectCommand> indirectCommands_;
+    std::unordered_map<GLuint, std::optional<Shader>> multiDrawShaders_;
+    // the frame in progress and the last finished one
+    RenderStats stats_;
+    RenderStats frameStats_;
+    GPUTimers gpuTimers_;
+    RenderStatsLog statsLog_;
+    StreamBuffer streamBuffer_;
+    DebugDraw debugDraw_;
+    OcclusionCuller occlusion_;
+    std::vector<IRenderable*> occluders_;
+    // normal pass mesh renderers that weren't instanced, recorded into one list per worker chunk
+    std::vector<const MeshRenderer*> recordedRenderers_;
+    std::vector<CommandList> commandLists_;
+    RenderCommands::UniformLocationCache uniformLocations_;
+
+    void UpdateUniformBuffers();
+    void RepackCullingBounds();
+    bool IsInStaticBVH(const IRenderable&, const GeneralComponentReference&) const;
+    void UpdateCullingBounds(const IRenderable&, const GeneralComponentReference&);
+    void CullRenderables();
+    void CullOccludedRenderables();
+    const Shader* GetShaderVariant(std::unordered_map<GLuint, std::optional<Shader>>&, const Shader&, const std::string&);
+    const Shader* GetInstancedShader(const Shader&);
+    const Shader* GetMultiDrawShader(const Shader&);
+    Material* GetBatchMaterial(Material*);
+    bool QueueInstances(const MeshRenderer&);
+    void DrawInstances();
+    void RecordCommandLists();
+    void SubmitCommandLists();
+    void AcquireSceneTargets();
+    // only the bvh, the batches are left as they are
+    void RebuildStaticBVH();
+    void BuildStaticBatches();
+    void UpdateStaticBatches();
+    void UpdateStaticBatchedSet();
 public:
     std::shared_ptr<Mesh> skybox = nullptr;
     Texture::TextureID skyboxTexture = TEXTURE_NONE;
@@ -52,11 +189,21 @@ public:
     bool highlightNormals = false;
     bool showHitboxes = false;
     bool showAabbs = false;
+    bool useInstancing = true;
+    // falls back to the instanced draws when gl 4.3 isn't there
+    bool useMultiDrawIndirect = true;
+    // uses last frame's depth of the occluders, so things can pop in for a frame on fast turns
+    bool useOcclusionCulling = true;
+    // record the normal pass on the worker threads and replay it here, only plain MeshRenderers go through this
+    bool useCommandLists = true;
+    // merge the static mesh renderers per material on stage load, takes effect on the next BuildStaticBVH
+    bool useStaticBatching = true;
 
     Renderer() = default;
     Renderer(Viewport*);
     virtual ~Renderer();
     void UpdateLighting();
+    void UpdateLight(const Lights::ILight&);
     void SetViewport(Viewport*);
     Camera& GetCamera();
     bool Init();
@@ -66,7 +213,17 @@ public:
     void DoRenderPass(RenderPass::Enum);
     void UpdateCameraProjection(int, int);
     void CopyShadersFromResources();
+    // refreshes the list of renderables, the actual culling is done every frame in Render
     void UpdateFrustum();
+    // puts all the static renderables into a bvh (stage loads etc.), also calls UpdateFrustum
+    void BuildStaticBVH();
+    // adds the static renderables that aren't in the bvh yet and batches them separately from the rest,
+    // so an additive stage load only costs as much as the stage. also calls UpdateFrustum
+    void AddStaticRenderables();
+    // drops the destroyed ones after a stage unload, only their batch groups are touched
+    void RemoveStaticRenderables();
+    // re-reads the bounds of the static renderables if they were moved after all, rebuilds all the batches
+    void RefitStaticBVH();
     void SortMeshesByDistance();
     void UpdateVideoSettings(const Config::VideoSettings&);
     void ApplyPostProcessing(const PostProcessing&);
@@ -82,9 +239,33 @@ public:
     void CleanUp();
     std::size_t CountEntitiesOnFrustum() const;
     void ForEachRenderableOnFrustum(const std::function<void(IRenderable&)>&);
+    // spatial queries over the world bounds of the renderables
+    void QueryAABB(const ViewFrustum::AABB&, const std::function<void(IRenderable&)>&);
+    void QuerySphere(const glm::vec3&, float, const std::function<void(IRenderable&)>&);
+    // the callback gets the distance along the ray to the bounds
+    void QueryRay(const glm::vec3&, const glm::vec3&, float, const std::function<void(IRenderable&, float)>&);
     std::shared_ptr<Material> GetMaterial(const std::string&) const;
     std::unordered_map<std::string, std::shared_ptr<Material>>& GetMaterials();
     const std::vector<GLuint>& GetShaders() const;
+    // the last finished frame
+    const RenderStats& GetStats() const;
+    // writes the stats of every frame into a csv file until stopped
+    bool StartStatsLog(const std::string&);
+    void StopStatsLog();
+    // for per-frame geometry, allocations are valid until the end of the frame
+    StreamBuffer& GetStreamBuffer();
+    // shared buffers for the static model meshes, see Mesh::useMeshArena
+    MeshArenas& GetMeshArenas();
+    // queued debug primitives are drawn after the late pass
+    DebugDraw& GetDebugDraw();
+    // all the per-draw state changes should go through this
+    GLState& GetGLState();
+    DynamicResolution& GetDynamicResolution();
+    // the blur passes and the composite (framebuffer shader) are set up in Init, custom effects can be inserted before the composite
+    PostProcessGraph& GetPostProcessGraph();
+    // offscreen targets for the scene, post-processing and text, release them when done
+    RenderTargetPool& GetRenderTargetPool();
+    StaticBatches& GetStaticBatches();
 
     void DebugDrawNormals();
     void DebugDrawHitboxes();
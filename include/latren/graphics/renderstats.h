@@ -0,0 +1,115 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <functional>
+
+#include "renderpass.h"
+
+// filled by the renderer every frame, Renderer::GetStats has the last finished frame
+struct RenderStats {
+    // draw calls the frame would've taken without instancing
+    std::size_t unbatchedDrawCalls = 0;
+    std::size_t drawCalls = 0;
+    std::size_t instancedDrawCalls = 0;
+    std::size_t instancedMeshes = 0;
+    // instanced draws that went through glMultiDrawElementsIndirect, each one covers a whole bucket
+    std::size_t multiDrawCalls = 0;
+    // counted at the gl calls, so these include the ui, post-processing and debug drawing too
+    std::size_t glDrawCalls = 0;
+    std::array<std::size_t, RenderPass::TOTAL_RENDER_PASSES> passDrawCalls = { };
+    std::size_t triangles = 0;
+    // one per plain draw call
+    std::size_t instances = 0;
+    // binds that actually reached gl, the cached ones aren't counted
+    std::size_t programBinds = 0;
+    std::size_t textureBinds = 0;
+    std::size_t vertexArrayBinds = 0;
+    std::size_t uniformCalls = 0;
+    std::size_t uploadBytes = 0;
+    // renderables that went through the frustum culling, how many of them were visible and how many got culled
+    std::size_t cullingTested = 0;
+    std::size_t cullingVisible = 0;
+    std::size_t frustumCulled = 0;
+    // occludees tested against the occlusion buffer and how many of them were hidden
+    std::size_t occlusionTests = 0;
+    std::size_t occlusionCulled = 0;
+    // draw calls skipped because of the above
+    std::size_t occlusionCulledDrawCalls = 0;
+    // point/spot light references in the light clusters
+    std::size_t clusteredLights = 0;
+    // gl state calls that went through the cache and the ones it dropped
+    std::size_t stateChanges = 0;
+    std::size_t stateChangesElided = 0;
+    // draw calls recorded on the worker threads and how many lists they were split into
+    std::size_t recordedDrawCalls = 0;
+    std::size_t commandLists = 0;
+    // draw calls of the static batches and the meshes they covered
+    std::size_t staticBatchDrawCalls = 0;
+    std::size_t staticBatchedMeshes = 0;
+    // smoothed gpu time of the whole frame in ms and the 3d resolution scale it led to
+    float gpuFrameTime = 0.0f;
+    float resolutionScale = 1.0f;
+    // gpu times in ms from the timer queries, these lag a few frames behind
+    std::array<float, RenderPass::TOTAL_RENDER_PASSES> passGPUTime = { };
+    float postProcessGPUTime = 0.0f;
+    float uiGPUTime = 0.0f;
+    // time spent in Renderer::Render in ms
+    float cpuRenderTime = 0.0f;
+    std::size_t postProcessPasses = 0;
+    // pooled render targets, their estimated vram and the targets created and deleted this frame
+    std::size_t renderTargets = 0;
+    std::size_t renderTargetMemory = 0;
+    std::size_t renderTargetAllocations = 0;
+    std::size_t renderTargetFrees = 0;
+
+    // every value with a name, always in the same order (the csv columns and the overlay rows)
+    void ForEachValue(const std::function<void(const std::string&, double)>&) const;
+    // counts without decimals, times with two
+    static std::string FormatValue(double);
+};
+
+// gpu timestamps around the sections of a frame. the results are read back a few frames later
+// without waiting, so a section that's still pending just keeps its previous time
+class  GPUTimers {
+public:
+    static const int FRAMES = 4;
+private:
+    std::size_t sections_ = 0;
+    // begin and end per section per frame
+    std::vector<GLuint> queries_;
+    // sections that got both of their timestamps per frame
+    std::vector<bool> written_;
+    std::array<bool, FRAMES> pending_ = { };
+    std::vector<float> times_;
+    int frame_ = 0;
+    bool running_ = false;
+    GLuint GetQuery(int, std::size_t, bool) const;
+public:
+    void Init(std::size_t);
+    void Delete();
+    // wrap the frame in these, the sections go in between
+    void BeginFrame();
+    void EndFrame();
+    void Begin(std::size_t);
+    void End(std::size_t);
+    // ms
+    float GetTime(std::size_t) const;
+};
+
+// one row per frame for tracking regressions between builds
+class  RenderStatsLog {
+private:
+    std::ofstream file_;
+    std::size_t frame_ = 0;
+public:
+    // the path goes through ResourcePath, truncates the file
+    bool Open(const std::string&);
+    void Close();
+    bool IsOpen() const;
+    void Write(const RenderStats&);
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+#include <memory>
+
+struct RenderTargetDesc {
+    glm::ivec2 size = glm::ivec2(0);
+    GLenum format = GL_RGB8;
+    // 0 for a plain GL_TEXTURE_2D, otherwise GL_TEXTURE_2D_MULTISAMPLE
+    int samples = 0;
+    // GL_NONE for no depth, otherwise a renderbuffer with this format
+    GLenum depthFormat = GL_NONE;
+
+    bool operator==(const RenderTargetDesc& other) const {
+        return size == other.size && format == other.format && samples == other.samples && depthFormat == other.depthFormat;
+    }
+    bool operator!=(const RenderTargetDesc& other) const { return !(*this == other); }
+};
+
+// a framebuffer with a single color texture (and optionally a depth renderbuffer) for the offscreen passes
+class  RenderTarget {
+private:
+    GLuint fbo_ = GL_NONE;
+    GLuint texture_ = GL_NONE;
+    GLuint depthBuffer_ = GL_NONE;
+    RenderTargetDesc desc_;
+public:
+    void Create(const RenderTargetDesc&);
+    void Delete();
+    // also sets the viewport to the whole target
+    void Bind() const;
+    bool IsCreated() const;
+    GLuint GetFramebuffer() const;
+    GLuint GetTexture() const;
+    GLenum GetTextureTarget() const;
+    const glm::ivec2& GetSize() const;
+    const RenderTargetDesc& GetDesc() const;
+    // estimated, the driver might pad things
+    std::size_t GetMemoryUsage() const;
+};
+
+// hands out render targets by descriptor. released targets stay around for a while and get handed out again
+// for the same descriptor, so transient targets are recycled from frame to frame and passes that don't
+// overlap can share them. resizes only allocate once per size.
+class  RenderTargetPool {
+public:
+    // frames a released target is kept around before it's deleted
+    static constexpr uint64_t RETENTION_FRAMES = 120;
+
+    struct Stats {
+        std::size_t targets = 0;
+        std::size_t targetsInUse = 0;
+        std::size_t memoryUsage = 0;
+        // since the last NextFrame
+        std::size_t allocations = 0;
+        std::size_t frees = 0;
+        std::size_t reuses = 0;
+    };
+private:
+    struct Entry {
+        RenderTarget target;
+        bool inUse = false;
+        uint64_t lastUsed = 0;
+    };
+    std::vector<std::unique_ptr<Entry>> entries_;
+    uint64_t frame_ = 0;
+    Stats stats_;
+    Stats frameStats_;
+public:
+    RenderTarget* Acquire(const RenderTargetDesc&);
+    void Release(RenderTarget*);
+    // deletes the targets that haven't been used in a while
+    void NextFrame();
+    void Delete();
+    // the counters are from the previous frame
+    const Stats& GetStats() const;
+};
\ No newline at end of file
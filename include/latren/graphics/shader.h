@@ -8,6 +8,7 @@
 #include <array>
 
 #include "shaders.h"
+#include "glstate.h"
 
 namespace Shaders {
     enum class ShaderType {
@@ -17,9 +18,19 @@ namespace Shaders {
         VERT_FRAG,
         VERT_FRAG_GEOM
     };
+    // a single stage of a program, read but not compiled yet
+    struct ShaderSource {
+        GLenum type;
+        std::string name;
+        std::string source;
+    };
     extern const std::string EXT_VERT;
     extern const std::string EXT_FRAG;
     extern const std::string EXT_GEOM;
+    // a shader 'X' can be drawn instanced if a shader 'X_INSTANCED' is loaded as well
+    extern const std::string INSTANCED_SUFFIX;
+    // and with multi-draw-indirect if there's an 'X_MULTI_DRAW', these are only loaded on gl 4.3
+    extern const std::string MULTI_DRAW_SUFFIX;
      GLuint GetShaderProgram(ShaderID);
      GLuint GetShaderProgram(const std::string&);
 };
@@ -45,7 +56,10 @@ public:
     
     template <typename T>
     void SetUniform(const char* name, const T& value) const {
-        GLuint location = glGetUniformLocation(GetProgram(), name);
+        GLint location = glGetUniformLocation(GetProgram(), name);
+        // counted the same way as in the command lists, the ones not in the shader are ignored by gl anyway
+        if (location != -1)
+            GLState::CountUniform();
 
         // yanderedev switch statement
         if constexpr (std::is_same_v<T, int> || std::is_same_v<T, bool>)
@@ -12,6 +12,17 @@ namespace Shaders {
         LINE,
         STROBE_UNLIT,
         SKYBOX,
-        BILLBOARD
+        BILLBOARD,
+        UNLIT_INSTANCED,
+        LIT_INSTANCED,
+        STROBE_UNLIT_INSTANCED,
+        DEBUG,
+        BLUR,
+        PARTICLE,
+        UNLIT_MULTI_DRAW,
+        LIT_MULTI_DRAW,
+        STROBE_UNLIT_MULTI_DRAW,
+        // magenta placeholder for programs that fail to link
+        MISSING
     };
 };
\ No newline at end of file
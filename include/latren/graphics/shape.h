@@ -6,6 +6,8 @@
 class  Shape {
 private:
     float* vertexData = nullptr;
+    // false if the vbo is shared (e.g. the stream buffer)
+    bool ownsBuffer_ = true;
 public:
     int numVertices = 6;
     int numVertexAttributes = 2;
@@ -21,6 +23,8 @@ public:
     Shape& operator=(Shape&&);
     void DeleteBuffers();
     void GenerateVAO();
+    // uses an existing buffer instead of creating one
+    void GenerateVAO(GLuint);
     void Bind() const;
     void SetVertexData(float*, bool);
     void SetVertexData(const float*);
@@ -29,8 +33,10 @@ public:
 namespace Shapes {
     enum class DefaultShape {
         RECTANGLE_VEC4,
-        RECTANGLE_VEC2_VEC2
+        RECTANGLE_VEC2_VEC2,
+        // vec4 vertices sourced from the renderer's stream buffer
+        STREAM_VEC4
     };
-     void CreateDefaultShapes();
+     void CreateDefaultShapes(GLuint);
     const Shape& GetDefaultShape(DefaultShape);
 };
\ No newline at end of file
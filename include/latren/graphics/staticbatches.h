@@ -0,0 +1,79 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <vector>
+#include <memory>
+
+#include "mesh.h"
+#include "material.h"
+#include "camera.h"
+#include "culling.h"
+#include <latren/ec/mempool.h>
+
+class MeshRenderer;
+
+// static mesh renderers merged into world space buffers per material, built on stage load.
+// the geometry is grouped into grid cells that are contiguous in the index buffer, so the cells are
+// still culled separately and neighbouring visible cells are drawn with a single call.
+// every Add makes a group of its own, so streaming a stage in or out only merges (or drops) its renderers
+class  StaticBatches {
+public:
+    struct Stats {
+        std::size_t batches = 0;
+        std::size_t cells = 0;
+        std::size_t renderers = 0;
+        std::size_t meshes = 0;
+        std::size_t groups = 0;
+    };
+private:
+    struct Cell {
+        ViewFrustum::AABB aabb;
+        // index range in the batch mesh
+        std::size_t first;
+        std::size_t count;
+        // meshes merged into it, for the draw call stats
+        std::size_t meshes;
+    };
+    struct Batch {
+        std::shared_ptr<Material> material;
+        std::unique_ptr<Mesh> mesh;
+        // range in the group's cells
+        std::size_t firstCell;
+        std::size_t cellCount;
+    };
+    struct Group {
+        std::vector<GeneralComponentReference> renderers;
+        std::vector<Batch> batches;
+        std::vector<Cell> cells;
+        Culling::BoundsArray cellBounds;
+        Stats stats;
+    };
+    std::vector<Group> groups_;
+    Culling::VisibilitySet visibility_;
+    Stats stats_;
+
+    void BuildGroup(Group&);
+    void UpdateStats();
+public:
+    // world units, smaller cells cull better but take more draw calls
+    float cellSize = 32.0f;
+    // merged meshes are split after this many vertices
+    std::size_t maxBatchVertices = 1 << 20;
+
+    // static, plain MeshRenderers without anything that changes the state per renderer
+    static bool CanBatch(const MeshRenderer&);
+    // replaces everything with a single group
+    void Build(const std::vector<GeneralComponentReference>&);
+    // merges the renderers into a new group, they have to be MeshRenderers that CanBatch.
+    // the renderers have to have their matrices calculated
+    void Add(const std::vector<GeneralComponentReference>&);
+    // drops the groups with destroyed renderers or ones that can't be batched anymore and merges
+    // the rest of their renderers again. returns the ones that were left out (not null)
+    std::vector<GeneralComponentReference> RemoveStale();
+    void Clear();
+    // returns the draw calls and adds the meshes they replaced to the second argument
+    std::size_t Render(const ViewFrustum&, std::size_t&);
+    bool IsEmpty() const;
+    const Stats& GetStats() const;
+};
\ No newline at end of file
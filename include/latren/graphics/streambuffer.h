@@ -0,0 +1,49 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <array>
+#include <vector>
+
+// a ring of per-frame segments for geometry that gets rewritten every frame (ui quads, text etc.)
+// uses a persistently mapped buffer if ARB_buffer_storage is there, otherwise the writes go through
+// a cpu-side copy and glBufferSubData. either way the segments are guarded with fences so the gpu is
+// never reading what we're writing.
+class  StreamBuffer {
+public:
+    static const int FRAMES = 3;
+
+    struct Allocation {
+        void* data = nullptr;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+        // the first vertex for glDrawArrays
+        GLint first = 0;
+    };
+private:
+    GLuint vbo_ = GL_NONE;
+    GLsizeiptr segmentSize_ = 0;
+    int segment_ = 0;
+    GLintptr head_ = 0;
+    bool persistent_ = false;
+    char* mapped_ = nullptr;
+    std::vector<char> staging_;
+    std::array<GLsync, FRAMES> fences_ = { };
+
+    void WaitForSegment(int);
+    void AdvanceSegment();
+public:
+    void Create(GLsizeiptr);
+    void Delete();
+    // returns an allocation with null data if it doesn't fit in a segment
+    // stride is the vertex size, the offset is aligned to it
+    Allocation Allocate(GLsizeiptr, GLsizei);
+    // makes the written data visible to the gpu, must be called before drawing
+    void Commit(const Allocation&, GLsizeiptr);
+    void Commit(const Allocation&);
+    Allocation Upload(const void*, GLsizeiptr, GLsizei);
+    // call once the frame has been submitted
+    void NextFrame();
+    GLuint GetBuffer() const;
+    bool IsPersistent() const;
+};
\ No newline at end of file
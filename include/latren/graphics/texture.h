@@ -6,4 +6,9 @@
 
 namespace Texture {
 typedef GLuint TextureID;
+// a texture packed into a GL_TEXTURE_2D_ARRAY with others of the same size and format
+struct ArrayLayer {
+    TextureID array = TEXTURE_NONE;
+    int layer = -1;
+};
 };
\ No newline at end of file
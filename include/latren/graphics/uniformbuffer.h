@@ -0,0 +1,61 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+
+// uniform blocks shared between all shader programs
+// the binding points are fixed so every program can just be pointed at them once after linking
+namespace UniformBlocks {
+    enum Binding : GLuint {
+        CAMERA = 0,
+        LIGHTS = 1
+    };
+    // shader storage blocks, set with the binding qualifier in the shaders
+    enum StorageBinding : GLuint {
+        INSTANCE_DATA = 0
+    };
+    extern const char* CAMERA_BLOCK_NAME;
+    extern const char* LIGHTS_BLOCK_NAME;
+
+    // std140, must match the CameraData block in the shaders
+    struct CameraData {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::vec3 viewPos;
+        float time;
+    };
+    static_assert(sizeof(CameraData) == 144, "CameraData doesn't match the std140 layout");
+
+    // std140, must match the LightData block in lit.frag
+    struct LightClusterData {
+        // cluster grid size and the number of lights that affect every cluster (directional)
+        glm::uvec4 gridSize;
+        // near, far, slice scale, slice bias
+        glm::vec4 depthParams;
+        // 1 / render target size
+        glm::vec4 invScreenSize;
+    };
+    static_assert(sizeof(LightClusterData) == 48, "LightClusterData doesn't match the std140 layout");
+
+    // texture units kept free for the light cluster buffers and the texture arrays, the samplers are pointed at these in BindProgram
+    enum TextureUnit : GLint {
+        // not unit 0 so that the sampler2D and the sampler2DArray of a material never share a unit
+        TEXTURE_ARRAY_UNIT = 12,
+        LIGHT_BUFFER_UNIT = 13,
+        LIGHT_CLUSTER_UNIT = 14,
+        LIGHT_INDEX_UNIT = 15
+    };
+
+     void BindProgram(GLuint);
+};
+
+class  UniformBuffer {
+private:
+    GLuint ubo_ = GL_NONE;
+    GLsizeiptr size_ = 0;
+public:
+    void Create(UniformBlocks::Binding, GLsizeiptr);
+    void Delete();
+    void Update(const void*, GLsizeiptr, GLintptr = 0) const;
+    GLuint GetBuffer() const;
+};
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <latren/latren.h>
+#include <latren/defines/opengl.h>
+#include <cstddef>
+
+// how the mesh data is laid out on the gpu, the cpu side copies are always plain floats
+struct VertexLayout {
+    enum class NormalFormat {
+        FLOAT,
+        // signed normalized GL_INT_2_10_10_10_REV, 4 bytes instead of 12
+        PACKED
+    };
+    enum class TexCoordFormat {
+        FLOAT,
+        HALF_FLOAT
+    };
+    enum class IndexFormat {
+        UINT32,
+        // 16-bit if the vertex count allows it
+        SMALLEST
+    };
+    // all attributes in a single vbo
+    bool interleaved = true;
+    NormalFormat normalFormat = NormalFormat::PACKED;
+    TexCoordFormat texCoordFormat = TexCoordFormat::HALF_FLOAT;
+    IndexFormat indexFormat = IndexFormat::SMALLEST;
+
+    std::size_t GetPositionSize() const;
+    std::size_t GetTexCoordSize() const;
+    std::size_t GetNormalSize() const;
+    std::size_t GetVertexSize() const;
+    // byte offsets of the attributes in a buffer of the given vertex count
+    std::size_t GetTexCoordOffset(std::size_t) const;
+    std::size_t GetNormalOffset(std::size_t) const;
+    // points the attributes 0-2 of the bound vao at the bound GL_ARRAY_BUFFER
+    void SetAttribPointers(std::size_t) const;
+    // same vertex format, the index format doesn't matter here
+    bool IsVertexCompatible(const VertexLayout&) const;
+};
+
+namespace VertexLayouts {
+    // non-interleaved floats and 32-bit indices, the old format
+    inline const VertexLayout UNPACKED = { false, VertexLayout::NormalFormat::FLOAT, VertexLayout::TexCoordFormat::FLOAT, VertexLayout::IndexFormat::UINT32 };
+    inline const VertexLayout PACKED = { };
+    // half floats don't have the precision for tiled texcoords
+    inline const VertexLayout PACKED_FLOAT_TEXCOORDS = { true, VertexLayout::NormalFormat::PACKED, VertexLayout::TexCoordFormat::FLOAT, VertexLayout::IndexFormat::SMALLEST };
+};
\ No newline at end of file
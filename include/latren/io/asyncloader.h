@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+
+#include "resourcetype.h"
+
+namespace Resources {
+    // two-phase loading: the decode jobs (file io, image/audio/model decoding) run on the thread pool
+    // and whatever they return is queued up for the game thread, which does the gl and al calls in ProcessUploads.
+    // the jobs are counted per resource type so the dependent types can wait for the ones they need
+    class  AsyncLoader {
+    public:
+        typedef std::function<void()> UploadJob;
+        typedef std::function<UploadJob()> DecodeJob;
+    private:
+        std::mutex mutex_;
+        std::condition_variable stateChanged_;
+        std::deque<std::pair<ResourceType, UploadJob>> uploads_;
+        // submitted but not uploaded yet
+        std::unordered_map<ResourceType, std::size_t> pending_;
+        std::size_t totalPending_ = 0;
+        std::size_t decoding_ = 0;
+        void FinishJob(ResourceType);
+    public:
+        AsyncLoader() = default;
+        AsyncLoader(const AsyncLoader&) = delete;
+        AsyncLoader& operator=(const AsyncLoader&) = delete;
+        // waits for the decodes still running, their uploads are dropped
+        ~AsyncLoader();
+        void Submit(ResourceType, DecodeJob);
+        // skips the decode phase, for the stuff that has to happen on the game thread anyway
+        void SubmitUpload(ResourceType, UploadJob);
+        // runs the queued uploads on the calling thread until the budget (in ms) runs out,
+        // at least one is always run so a single big upload can't stall the loading. returns how many were run
+        std::size_t ProcessUploads(double);
+        // blocks until there's something to upload or nothing's pending anymore
+        void WaitForUploads();
+        // blocks until everything submitted so far is uploaded
+        void Finish();
+        std::size_t GetPendingCount();
+        std::size_t GetPendingCount(ResourceType);
+    };
+};
\ No newline at end of file
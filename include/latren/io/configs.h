@@ -20,5 +20,11 @@ namespace Config {
         DATA_FIELD(glm::ivec2, resolution, glm::ivec2(LATREN_BASE_WND_WIDTH, LATREN_BASE_WND_HEIGHT));
         META_COMMENT("-1 -1 for auto");
         DATA_FIELD(glm::ivec2, fullscreenResolution, glm::ivec2(-1));
+        META_NEWLINE();
+        META_COMMENT("scales the 3d resolution to keep the gpu frame time (ms) under the target");
+        DATA_FIELD(bool, dynamicResolution, false);
+        DATA_FIELD(float, targetFrameTime, 16.6f);
+        DATA_FIELD(float, minResolutionScale, .5f);
+        DATA_FIELD(float, maxResolutionScale, 1.0f);
     };
 };
\ No newline at end of file
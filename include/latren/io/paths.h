@@ -47,7 +47,8 @@ namespace Paths {
 
         // user
         { "video.cfg", "${usr}/video.cfg" },
-        { "savedata", "${usr}/savedata" }
+        { "savedata", "${usr}/savedata" },
+        { "shadercache", "${usr}/shadercache" }
     };
 
     // return a copy of pathvar map as a vector ordered alphabetically by var name
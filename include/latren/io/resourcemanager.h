@@ -5,6 +5,8 @@
 #include <cstring>
 #include <unordered_map>
 #include <map>
+#include <set>
+#include <memory>
 #include <filesystem>
 #include <optional>
 #include <variant>
@@ -12,6 +14,7 @@
 
 #include "resourcepath.h"
 #include "resourcetype.h"
+#include "asyncloader.h"
 #include "configs.h"
 #include "files/materials.h"
 #include "files/objects.h"
@@ -20,6 +23,7 @@
 #include "files/cfg.h"
 #include <latren/stage.h>
 #include <latren/graphics/shader.h>
+#include <latren/graphics/programcache.h>
 #include <latren/graphics/texture.h>
 #include <latren/graphics/model.h>
 #include <latren/ui/text.h>
@@ -64,6 +68,8 @@ namespace Resources {
         std::string itemID_;
         std::string typeStr_;
         AdditionalImportData additionalData_;
+        // submitted to an AsyncLoader but not uploaded yet
+        std::set<std::string, ItemComp> loading_;
     protected:
         std::map<std::string, T, ItemComp> items_;
         ResourcePath path_;
@@ -85,6 +91,18 @@ namespace Resources {
             return ResourcePath(path_, rawPath);
         }
         const AdditionalImportData& GetAdditionalData() { return additionalData_; }
+        // the async version of LoadResource. this runs on a worker thread so it can't touch the manager's state,
+        // the id and additional data are passed in instead. the returned function runs on the game thread
+        // and does the gl/al side. by default the whole LoadResource is done there
+        virtual std::function<std::optional<T>()> DecodeResource(const ResourcePath& p, const std::string& id, const AdditionalImportData& data) {
+            return [this, p, id, data]() {
+                SetItemID(id);
+                SetAdditionalData(data);
+                return LoadResource(p);
+            };
+        }
+        // only the managers overriding DecodeResource are loaded asynchronously
+        virtual bool CanDecodeAsync() const { return false; }
     public:
         SingleEventHandler<const std::string&> onResourceLoad;
         virtual ~ResourceTypeManager() = default;
@@ -130,6 +148,49 @@ namespace Resources {
                 Load(import);
             RestoreDefaultPath();
         }
+        // decodes on the thread pool, the resources are added (and onResourceLoad dispatched)
+        // as the loader's uploads are processed. synchronous if the manager can't decode asynchronously
+        void LoadImportsAsync(const Imports<Import>& imports, AsyncLoader& loader) {
+            if (!CanDecodeAsync()) {
+                LoadImports(imports);
+                return;
+            }
+            SetPath(imports.parentPath);
+            for (const auto& import : imports.imports) {
+                ResourcePath importPath = MakeImportPath(import.path);
+                std::string id = import.id.empty() ? std::fs::proximate(importPath.GetParsedPath(), path_.GetParsedPath()).generic_string() : import.id;
+                if (HasLoaded(id) || loading_.find(id) != loading_.end()) {
+                    onResourceLoad.Dispatch(id);
+                    continue;
+                }
+                std::fs::path parsedPath = importPath.GetParsedPath();
+                std::string fileName = std::fs::proximate(parsedPath, path_.GetParsedPath().parent_path()).generic_string();
+                spdlog::info("Loading {} '{}'", typeStr_, fileName);
+                loading_.insert(id);
+                ResourcePath absolutePath = std::fs::absolute(parsedPath);
+                AdditionalImportData data = import.additionalData;
+                loader.Submit(imports.resourceType, [this, absolutePath, id, data, fileName]() -> AsyncLoader::UploadJob {
+                    std::function<std::optional<T>()> finish;
+                    try {
+                        finish = DecodeResource(absolutePath, id, data);
+                    }
+                    catch (std::exception& e) {
+                        spdlog::debug(e.what());
+                        finish = [] { return std::optional<T>(); };
+                    }
+                    return [this, finish, id, fileName]() {
+                        loading_.erase(id);
+                        std::optional<T> resource = finish();
+                        if (resource.has_value())
+                            items_[id] = resource.value();
+                        else
+                            spdlog::info("Failed loading {} '{}'", typeStr_, fileName);
+                        onResourceLoad.Dispatch(id);
+                    };
+                });
+            }
+            RestoreDefaultPath();
+        }
         virtual T& Get(const std::string& item) {
             return items_.at(item);
         }
@@ -152,16 +213,65 @@ namespace Resources {
     };
 
     class  TextureManager : public ResourceTypeManager<Texture::TextureID> {
+    private:
+        // decoded pixels of the imported textures, kept until BuildTextureArrays
+        struct PendingTexture {
+            std::string id;
+            int width;
+            int height;
+            int channels;
+            std::vector<uint8_t> pixels;
+        };
+        std::vector<PendingTexture> pendingTextures_;
+        std::unordered_map<std::string, Texture::ArrayLayer> arrayLayers_;
+        std::vector<Texture::TextureID> textureArrays_;
     protected:
         virtual std::optional<Texture::TextureID> LoadResource(const ResourcePath&) override;
+        // stbi_load on the worker, the gl texture is created on the game thread
+        virtual std::function<std::optional<Texture::TextureID>()> DecodeResource(const ResourcePath&, const std::string&, const AdditionalImportData&) override;
+        virtual bool CanDecodeAsync() const override { return true; }
+        // nullptr if the file can't be used, the caller falls back to the uncompressed one
+        std::function<std::optional<Texture::TextureID>()> DecodeCompressedTexture(const std::fs::path&);
     public:
+        // load the .ktx2/.dds next to an imported image instead of it when there's one (see tools/texcompress.cpp).
+        // those have their mips prebuilt and stay compressed on the gpu, but they aren't packed into texture arrays
+        bool preferCompressedTextures = true;
+        // pack the imported textures of the same size and format into texture arrays once the imports are done.
+        // the materials using them can then be batched together, the plain 2d textures are still there for everything else
+        bool packTextureArrays = false;
+        // smaller groups stay as plain textures
+        int minArrayLayers = 2;
         TextureManager();
+        // called after the texture imports, before the materials are parsed. replaces the arrays of an earlier load
+        void BuildTextureArrays();
+        // false if the texture isn't in an array
+        bool GetArrayLayer(const std::string&, Texture::ArrayLayer&) const;
+        const std::vector<Texture::TextureID>& GetTextureArrays() const;
     };
 
     class  ShaderManager : public ResourceTypeManager<GLuint> {
     protected:
+        // linked but not checked yet
+        struct PendingProgram {
+            std::string id;
+            GLuint program;
+            std::vector<GLuint> shaders;
+            uint64_t key;
+            double start;
+        };
+        ProgramCache programCache_;
+        std::vector<PendingProgram> pendingPrograms_;
+        int batchDepth_ = 0;
+        double batchStart_ = 0.0;
+        bool parallelCompileChecked_ = false;
         virtual std::optional<GLuint> LoadResource(const ResourcePath&) override;
-        virtual void LoadShader(GLuint, const ResourcePath&, Shaders::ShaderType);
+        virtual void ReadShader(std::vector<Shaders::ShaderSource>&, const ResourcePath&, Shaders::ShaderType);
+        // from the program cache if the sources haven't changed, compiled otherwise
+        // inside a batch the program id is valid right away but it isn't checked until EndBatch
+        virtual GLuint CreateProgram(const std::string&, const std::vector<Shaders::ShaderSource>&);
+        // swaps in the MISSING shader if the link failed
+        GLuint FinishProgram(const PendingProgram&);
+        void LogLoadTimes();
         virtual void LoadShader(const std::string&, const ResourcePath&, const ResourcePath&, const ResourcePath& = "");
         virtual void LoadStandardShader(Shaders::ShaderID, const ResourcePath&, Shaders::ShaderType);
         virtual void LoadStandardShader(Shaders::ShaderID, const ResourcePath&, const ResourcePath&, const ResourcePath& = "");
@@ -170,6 +280,11 @@ namespace Resources {
         virtual void Load(const Resources::ShaderImport&);
         virtual void LoadImports(const Imports<ShaderImport>&);
         virtual void LoadStandardShaders();
+        // the programs created in between are all submitted to the driver before any of them is checked,
+        // so it can compile them in parallel. batches can be nested
+        void BeginBatch();
+        void EndBatch();
+        ProgramCache& GetProgramCache();
         virtual GLuint& Get(Shaders::ShaderID);
         virtual GLuint& Get(const std::string& s) override { return ResourceTypeManager::Get(s); }
     };
@@ -179,6 +294,9 @@ namespace Resources {
     protected:
         glm::ivec2 fontSize_ = { 0, BASE_FONT_SIZE };
         virtual std::optional<UI::Text::Font> LoadResource(const ResourcePath&) override;
+        // the glyphs are rasterized and packed into the atlas on the worker
+        virtual std::function<std::optional<UI::Text::Font>()> DecodeResource(const ResourcePath&, const std::string&, const AdditionalImportData&) override;
+        virtual bool CanDecodeAsync() const override { return true; }
     public:
         FontManager();
         virtual void SetFontSize(const glm::ivec2&);
@@ -188,6 +306,10 @@ namespace Resources {
     class  ModelManager : public ResourceTypeManager<Model> {
     protected:
         virtual std::optional<Model> LoadResource(const ResourcePath&) override;
+        // assimp, lods and the object data on the worker, only the vaos are generated on the game thread.
+        // reads objects.json and materials, so they have to be loaded before this is submitted
+        virtual std::function<std::optional<Model>()> DecodeResource(const ResourcePath&, const std::string&, const AdditionalImportData&) override;
+        virtual bool CanDecodeAsync() const override { return true; }
     public:
         ModelManager();
     };
@@ -195,19 +317,87 @@ namespace Resources {
     class  AudioManager : public ResourceTypeManager<AudioBufferHandle> {
     protected:
         virtual std::optional<AudioBufferHandle> LoadResource(const ResourcePath&) override;
+        virtual std::function<std::optional<AudioBufferHandle>()> DecodeResource(const ResourcePath&, const std::string&, const AdditionalImportData&) override;
+        virtual bool CanDecodeAsync() const override { return true; }
     public:
         AudioManager();
     };
 
+    enum class StageLoadEvent {
+        LOAD_PROGRESS, // eventargs: string id, float progress (0-1), after every streamed slice
+        LOADED, // eventargs: string id, float progress (1)
+        UNLOADED // eventargs: string id, float progress (0)
+    };
+
     class  StageManager : public ResourceTypeManager<Stage> {
+    public:
+        // called on the game thread once the stage is in, false if it failed or got unloaded before that
+        typedef std::function<void(const std::string&, bool)> StageLoadCallback;
     protected:
+        // the field offsets resolved on the worker, so the game thread only has to copy the values
+        struct PreparedComponent {
+            ComponentType type;
+            std::vector<std::pair<std::size_t, const Serialization::SerializableFieldValue*>> fields;
+        };
+        struct PreparedEntity {
+            const DeserializedEntity* entity;
+            std::vector<PreparedComponent> components;
+        };
+        struct StreamedStage {
+            // empty until a stage file is parsed
+            std::string id;
+            StageLoadCallback callback;
+            std::vector<PreparedEntity> entities;
+            std::size_t nextEntity = 0;
+            bool ready = false;
+            bool cancelled = false;
+            // it changed entities that were there already, their static renderables might have moved
+            bool modifiedExisting = false;
+        };
         std::vector<std::string> loadedStages_;
         std::unique_ptr<Serialization::StageSerializer> stageSerializer_;
+        Serialization::BlueprintSerializer* blueprints_ = nullptr;
+        // the parsing and preparing is done with this, the uploads are the stage file parses finishing
+        std::unique_ptr<AsyncLoader> streamingLoader_;
+        std::vector<std::shared_ptr<StreamedStage>> streaming_;
+        // the ones StreamStages keeps loaded
+        std::vector<std::string> streamedStages_;
         virtual std::optional<Stage> LoadResource(const ResourcePath&) override;
+        // doesn't touch the manager, so this can run on a worker
+        std::vector<PreparedEntity> PrepareEntities(const Stage&) const;
+        // modifies the named entity if there's one already, the new components are added to the vector
+        // returns true if the entity existed already
+        bool InstantiateEntity(Stage&, const PreparedEntity&, std::vector<GeneralComponentReference>&);
+        void FinishStageLoad(const Stage&);
+        // submits the preparing of an imported stage
+        void PrepareStreamedStage(const std::shared_ptr<StreamedStage>&);
+        void FinishStreamedStage(const std::shared_ptr<StreamedStage>&, bool);
+        std::shared_ptr<StreamedStage> GetStreamedStage(const std::string&) const;
     public:
+        EventHandler<StageLoadEvent, std::string, float> eventHandler;
+        // how long UpdateStreaming can spend instantiating entities per frame (ms).
+        // a stage's lighting and static renderable update at the end doesn't count, that gets a frame of its own
+        double streamingBudget = 2.0;
+
         StageManager();
         virtual const std::vector<std::string>& GetLoadedStages();
         virtual bool LoadStage(const std::string&);
+        // the stage has to be imported, it's prepared on the thread pool and then instantiated
+        // a slice at a time in UpdateStreaming. the IStarts of a slice are called at the end of it.
+        // additive like LoadStage, false if the stage doesn't exist or is already streaming
+        virtual bool LoadStageAsync(const std::string&, const StageLoadCallback& = nullptr);
+        // reads the file on the thread pool and parses it on the game thread, the stage is then added as if it was imported.
+        // anything it references (blueprints, models, materials) has to be loaded already
+        virtual void LoadStageFileAsync(const ResourcePath&, const StageLoadCallback& = nullptr);
+        // keeps exactly these stages loaded (on top of the ones loaded otherwise),
+        // e.g. the stages around the player. the new ones are streamed, the dropped ones unloaded
+        virtual void StreamStages(const std::vector<std::string>&);
+        // called every frame by the game
+        virtual void UpdateStreaming();
+        // also true while the jobs of cancelled stages are still being drained
+        virtual bool IsStreaming() const;
+        virtual bool IsStageStreaming(const std::string&) const;
+        // cancels the streaming if it's still going on
         virtual bool UnloadStage(const std::string&);
         virtual void UnloadAllStages();
         virtual void UseBlueprints(Serialization::BlueprintSerializer*);
@@ -260,7 +450,7 @@ namespace Resources {
 
     enum class ResourceLoadEvent {
         IMPORTS_INDEXED, // eventargs: std::size_t totalImports
-        ON_IMPORT_LOAD // eventargs: string id
+        ON_IMPORT_LOAD // eventargs: string id, dispatched once the import is done (uploaded)
     };
 };
 
@@ -270,7 +460,13 @@ public:
         void(std::size_t),
         void(const std::string&)> eventHandler;
     
+    // blocks until everything's loaded
     virtual void LoadImports(const CFG::CFGObject*) = 0;
+    // returns right away, the loading is then advanced with UpdateLoading
+    virtual void BeginLoadImports(const CFG::CFGObject*) = 0;
+    // true once there's nothing left to load
+    virtual bool UpdateLoading() = 0;
+    virtual bool IsLoading() const = 0;
     virtual void UnloadAll() = 0;
     
     virtual Serialization::MaterialSerializer* GetMaterialSerializer() = 0;
@@ -311,6 +507,23 @@ typedef std::variant<
 
 private:
     std::unordered_map<Resources::ResourceType, BasicResourceLoader> basicResourceLoaders_;
+
+    enum class LoadingStage {
+        IDLE,
+        // textures, fonts and audio decoding
+        TEXTURES,
+        // shaders, materials and objects done, the models decoding
+        MODELS
+    };
+    Resources::AsyncLoader asyncLoader_;
+    LoadingStage loadingStage_ = LoadingStage::IDLE;
+    double loadingStart_ = 0.0;
+    // listed when the loading begins so the cfg doesn't have to stay around
+    std::unordered_map<Resources::ResourceType, std::vector<Resources::Imports<>>> pendingImports_;
+    std::vector<Resources::Imports<Resources::ShaderImport>> pendingShaderImports_;
+    // unsubscribe the ON_IMPORT_LOAD forwarding once everything's loaded
+    std::vector<std::function<void()>> importLoadSubscriptions_;
+    void LoadPendingImports(Resources::ResourceType, bool);
 protected:
     template <typename T>
     void AddBasicResourceLoaderIf(Resources::ResourceType check, Resources::ResourceType t) {
@@ -324,9 +537,18 @@ protected:
         return std::get_if<T>(&basicResourceLoaders_.at(t));
     }
 public:
+    // how long UpdateLoading can spend on the gl/al uploads (ms), the stages in between
+    // (shaders, materials etc.) are done on the game thread and don't care about this
+    double uploadBudget = 4.0;
+
     ModularResourceManager(Resources::ResourceType);
 
+    // textures, fonts, audio and models are decoded on the thread pool. the order still holds:
+    // the textures are uploaded before the materials are parsed and the models are decoded after that
     virtual void LoadImports(const CFG::CFGObject*) override;
+    virtual void BeginLoadImports(const CFG::CFGObject*) override;
+    virtual bool UpdateLoading() override;
+    virtual bool IsLoading() const override;
     virtual void UnloadAll() override;
 
     virtual Serialization::MaterialSerializer* GetMaterialSerializer() override;
@@ -315,6 +315,8 @@ namespace Serialization {
         virtual bool StreamRead(std::ifstream&) override;
         virtual bool StreamWrite(std::ofstream&) override;
     public:
+        // for json that has already been read, e.g. on a worker thread. the parsing itself might need the game thread
+        virtual void DeserializeJSON(const nlohmann::json&);
         virtual ~JSONFileSerializer() = default;
     };
 
@@ -13,6 +13,9 @@ class Renderer;
 class IResourceManager;
 class AudioPlayer;
 class PhysicsWorld;
+namespace Threads {
+    class ThreadPool;
+};
 
 // Systems - the crazy useful singleton dictionary
 namespace Systems {
@@ -33,6 +36,7 @@ namespace Systems {
      IResourceManager& GetResources();
      AudioPlayer& GetAudioPlayer();
      PhysicsWorld& GetPhysics();
+     Threads::ThreadPool& GetThreadPool();
      double GetTime();
      double GetDeltaTime();
 
@@ -43,6 +47,7 @@ namespace Systems {
      void SetResourcesGetter(const std::function<IResourceManager&()>&);
      void SetAudioPlayerGetter(const std::function<AudioPlayer&()>&);
      void SetPhysicsGetter(const std::function<PhysicsWorld&()>&);
+     void SetThreadPoolGetter(const std::function<Threads::ThreadPool&()>&);
      void SetTimeGetter(const std::function<double()>&);
      void SetDeltaTimeGetter(const std::function<double()>&);
 };
\ No newline at end of file
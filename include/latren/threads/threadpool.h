@@ -0,0 +1,39 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+namespace Threads {
+    // fixed set of worker threads for short cpu jobs (render command recording, decoding etc.)
+    // jobs must not touch the gl context, that lives on the game thread
+    class  ThreadPool {
+    private:
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> jobs_;
+        std::mutex mutex_;
+        std::condition_variable jobAvailable_;
+        bool stopping_ = false;
+        void WorkerLoop();
+    public:
+        ThreadPool() = default;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+        // 0 uses one thread less than there are cores (the game thread takes the last one)
+        void Start(std::size_t = 0);
+        // finishes the queued jobs first
+        void Stop();
+        void Submit(std::function<void()>);
+        std::size_t GetThreadCount() const;
+        // splits [0, count) into chunks of at least minChunk and calls fn(chunk, begin, end) for each,
+        // the calling thread works on the chunks too and this returns once all of them are done
+        // chunks are numbered from 0 so the results can be written into per-chunk storage without locking
+        void ParallelFor(std::size_t, std::size_t, const std::function<void(std::size_t, std::size_t, std::size_t)>&);
+        // how many chunks ParallelFor splits the count into
+        std::size_t GetChunkCount(std::size_t, std::size_t) const;
+    };
+};
\ No newline at end of file
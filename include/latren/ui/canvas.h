@@ -85,7 +85,6 @@ namespace UI {
         // the key represents the priority
         std::map<int, UIComponentContainer> components_;
         std::size_t componentCount_;
-        Shape bgShape_;
         bool breakUpdates_ = false;
         glm::vec2 mousePos_;
         glm::vec2 offset_ = glm::vec2(0.0f);
@@ -96,7 +95,6 @@ namespace UI {
         std::shared_ptr<Material> bgMaterial = nullptr;
         bool bgOverflow = true;
         CanvasBackgroundVerticalAnchor bgVerticalAnchor = CanvasBackgroundVerticalAnchor::UNDER;
-        virtual void GenerateBackgroundShape();
         virtual void Draw();
         virtual void Update();
         virtual void UpdateInteractions(UIComponent&);
@@ -9,6 +9,7 @@
 #include "../alignment.h"
 #include <latren/graphics/component/meshrenderer.h>
 #include <latren/graphics/shape.h>
+#include <latren/graphics/rendertarget.h>
 
 namespace UI {
     enum class TextRenderingMethod {
@@ -25,8 +26,8 @@ namespace UI {
         Shader shader_ = Shader(Shaders::ShaderID::UI_TEXT);
         Shader textureShader_ = Shader(Shaders::ShaderID::UI_TEXT);
         std::string text_ = "";
-        GLuint fbo_ = GL_NONE;
-        GLuint texture_ = GL_NONE;
+        // from the renderer's pool, the text only covers textureSize_ of it
+        RenderTarget* target_ = nullptr;
         glm::vec2 textSize_ = glm::vec2(0.0f);
         glm::vec2 actualTextSize_ = glm::vec2(0.0f);
         glm::ivec2 textureSize_ = glm::vec2(0);
@@ -36,7 +37,6 @@ namespace UI {
         float additionalRowsHeight_ = 0.0f;
         TextRenderingMethod renderingMethod_;
         bool hasStarted_ = false;
-        Shape shape_;
         UI::Rect bounds_;
         UI::Rect generalBounds_;
         glm::vec2 textOffset_ = glm::vec2(0.0f);
@@ -12,7 +12,6 @@ namespace UI {
         bool inputFocus_ = false;
         bool overflow_ = false;
         float textWidth_ = 0.0f;
-        Shape caretShape_;
         float blinkStart_;
         EventID specialKeyEvent_ = -1;
         EventID asciiKeyEvent_ = -1;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "canvas.h"
+
+#include <latren/graphics/shader.h>
+#include <string>
+
+namespace UI {
+    // the renderer stats as text in the top left corner. the whole text is a single draw since it
+    // goes through the font atlas, assign it to the renderer like any other canvas
+    class  RenderStatsOverlay : public Canvas {
+    private:
+        std::string text_;
+        double lastRefresh_ = -1.0;
+        Shader shader_ = Shaders::ShaderID::UI_TEXT;
+        void RefreshText();
+    public:
+        std::string font;
+        glm::vec4 color = glm::vec4(1.0f);
+        // relative to the font size
+        float size = .35f;
+        // top left corner of the text
+        glm::vec2 position = glm::vec2(10.0f, 710.0f);
+        // seconds, the numbers would be unreadable if they changed every frame
+        float refreshInterval = .25f;
+        // the zero values are left out
+        bool hideZeros = true;
+
+        virtual void Draw() override;
+        const std::string& GetText() const;
+    };
+};
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 330 core
+
+// one direction of a separable blur, the weights are symmetric so only one side is uploaded
+const int MAX_RADIUS = 16;
+
+out vec4 color;
+in vec2 fragmentTexCoord;
+
+uniform sampler2D source;
+uniform vec4 sourceRect;
+uniform vec2 sourceTexelSize;
+// uv step between the taps
+uniform vec2 direction;
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+
+vec3 sampleSource(vec2 uv) {
+    return texture(source, clamp(uv * sourceRect.xy, sourceTexelSize * .5, sourceRect.zw)).rgb;
+}
+
+void main() {
+    vec3 col = sampleSource(fragmentTexCoord) * weights[0];
+    for (int i = 1; i <= radius; i++) {
+        col += sampleSource(fragmentTexCoord + direction * float(i)) * weights[i];
+        col += sampleSource(fragmentTexCoord - direction * float(i)) * weights[i];
+    }
+    color = vec4(col, 1.0);
+}
\ No newline at end of file
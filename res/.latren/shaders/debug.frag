@@ -0,0 +1,9 @@
+#version 330 core
+
+in vec4 fragmentColor;
+
+out vec4 color;
+
+void main() {
+  color = fragmentColor;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec4 vertexColor;
+
+out vec4 fragmentColor;
+
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+void main() {
+  gl_Position = projection * view * vec4(pos, 1.0);
+  fragmentColor = vertexColor;
+}
\ No newline at end of file
@@ -34,8 +34,16 @@ struct Kernel {
     Vignette vignette;
 };
 
+struct Blur {
+    bool isActive;
+    float blend;
+
+    Vignette vignette;
+};
+
 struct PostProcessing {
     Kernel kernel;
+    Blur blur;
     Vignette vignette;
     vec3 vignetteColor;
 
@@ -47,6 +55,12 @@ struct PostProcessing {
 
 uniform Config cfg;
 uniform PostProcessing postProcessing;
+// set by the post-processing graph, the scene only covers the bottom-left part of the texture with dynamic resolution
+uniform vec4 screenTextureRect;
+// the separable blur passes
+uniform sampler2D blurTexture;
+uniform vec4 blurTextureRect;
+vec2 uv;
 
 vec3 applyKernels(float kernelIntensity, float offset) {
     vec3 col = vec3(0.0);
@@ -54,21 +68,21 @@ vec3 applyKernels(float kernelIntensity, float offset) {
         for (int i = 0; i < 9; i++) {
             int x = i / 3;
             int y = i % 3;
-            col += vec3(texture(screenTexture, fragmentTexCoord.st + ivec2(x - 1, 1 - y) * offset)) * postProcessing.kernel.kernel3x3[i] * kernelIntensity;
+            col += vec3(texture(screenTexture, uv + ivec2(x - 1, 1 - y) * offset)) * postProcessing.kernel.kernel3x3[i] * kernelIntensity;
         }
     }
     if (postProcessing.kernel.useKernel5x5) {
         for (int i = 0; i < 25; i++) {
             int x = i / 5;
-            int y = i % 3;
-            col += vec3(texture(screenTexture, fragmentTexCoord.st + ivec2(x - 2, 2 - y) * offset)) * postProcessing.kernel.kernel5x5[i] * kernelIntensity;
+            int y = i % 5;
+            col += vec3(texture(screenTexture, uv + ivec2(x - 2, 2 - y) * offset)) * postProcessing.kernel.kernel5x5[i] * kernelIntensity;
         }
     }
     if (postProcessing.kernel.useKernel7x7) {
         for (int i = 0; i < 49; i++) {
             int x = i / 7;
-            int y = i % 3;
-            col += vec3(texture(screenTexture, fragmentTexCoord.st + ivec2(x - 3, 3 - y) * offset)) * postProcessing.kernel.kernel7x7[i] * kernelIntensity;
+            int y = i % 7;
+            col += vec3(texture(screenTexture, uv + ivec2(x - 3, 3 - y) * offset)) * postProcessing.kernel.kernel7x7[i] * kernelIntensity;
         }
     }
     return col;
@@ -77,7 +91,8 @@ vec3 applyKernels(float kernelIntensity, float offset) {
 void main() {
     vec3 col = vec3(0.0);
     float dist = distance(fragmentTexCoord, vec2(.5, .5));
-    col = vec3(texture(screenTexture, fragmentTexCoord.st));
+    uv = min(fragmentTexCoord * screenTextureRect.xy, screenTextureRect.zw);
+    col = vec3(texture(screenTexture, uv));
 
     // convolution
     int kernels = 0;
@@ -92,12 +107,23 @@ void main() {
         }
         float kernelIntensity = postProcessing.kernel.blend / float(kernels);
         if (postProcessing.kernel.vignette.isActive && vignetteFactor < postProcessing.kernel.vignette.treshold) {
-            col = vec3(texture(screenTexture, fragmentTexCoord.st));
+            col = vec3(texture(screenTexture, uv));
         }
         else {
             col += applyKernels(kernelIntensity, offset);
         }
     }
+
+    // blur
+    if (postProcessing.blur.isActive && postProcessing.blur.blend > 0.0) {
+        float blend = postProcessing.blur.blend;
+        if (postProcessing.blur.vignette.isActive) {
+            float vignetteFactor = 1.0 - smoothstep(postProcessing.blur.vignette.size, .5 * postProcessing.blur.vignette.size, dist * (.3 + .5));
+            blend = vignetteFactor < postProcessing.blur.vignette.treshold ? 0.0 : blend * vignetteFactor;
+        }
+        vec3 blurred = vec3(texture(blurTexture, min(fragmentTexCoord * blurTextureRect.xy, blurTextureRect.zw)));
+        col = mix(col, blurred, blend);
+    }
     
     // contrast
     float contrast = cfg.contrast * postProcessing.contrast;
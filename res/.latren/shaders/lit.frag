@@ -9,15 +9,13 @@ out vec4 color;
 #define LIGHT_DIRECTIONAL_LIGHT_PLANE 4
 
 struct Light {
-  bool enabled;
   vec3 color;
   float intensity;
-  int type;
-
   vec3 pos;
   float range;
   vec3 dir;
   float y;
+  int type;
   float cutOffMin;
   float cutOffMax;
 };
@@ -37,6 +35,7 @@ struct Material {
   int specularHighlight;
   vec3 ambientColor;
   bool hasTexture;
+  bool hasTextureArray;
   vec2 tiling;
   vec2 offset;
   Fog fog;
@@ -45,13 +44,26 @@ struct Material {
 in vec3 fragmentNormal;
 in vec3 fragmentPos;
 in vec2 fragmentTexCoord;
+flat in float fragmentTextureLayer;
 in vec3 fragmentViewPos;
 
-#define MAX_LIGHTS 32
-uniform Light[MAX_LIGHTS] lights;
+// see LightClusters, the lights are assigned to a froxel grid on the cpu
+layout (std140) uniform LightData {
+  // xyz = cluster grid size, w = directional lights at the start of the index list
+  uvec4 clusterGridSize;
+  // near, far, slice scale, slice bias
+  vec4 clusterDepthParams;
+  vec4 invScreenSize;
+};
+// 4 texels per light (see LightClusters::UpdateLights)
+uniform samplerBuffer lightBuffer;
+// offset and count into lightIndices for every cluster
+uniform usamplerBuffer lightClusters;
+uniform usamplerBuffer lightIndices;
 
 uniform Material material;
 uniform sampler2D textureSampler;
+uniform sampler2DArray textureArraySampler;
 
 vec3 dirLight(vec3 lightDir, vec3 lightColor, vec3 normal) {
   vec3 diffuse = max(dot(normal, lightDir), 0.0) * lightColor;
@@ -97,36 +109,57 @@ float linearizeDepth(float depth, float near, float far) {
   return (2.0 * near * far) / (far + near - z * (far - near));	
 }
 
+Light fetchLight(int i) {
+  vec4 colorIntensity = texelFetch(lightBuffer, i * 4);
+  vec4 posRange = texelFetch(lightBuffer, i * 4 + 1);
+  vec4 dirY = texelFetch(lightBuffer, i * 4 + 2);
+  vec4 typeCutOffs = texelFetch(lightBuffer, i * 4 + 3);
+  return Light(colorIntensity.rgb, colorIntensity.a, posRange.xyz, posRange.w, dirY.xyz, dirY.w, int(typeCutOffs.x), typeCutOffs.z, typeCutOffs.w);
+}
+
+vec3 calcLight(Light light, vec3 normal) {
+  switch (light.type) {
+    case LIGHT_POINT_LIGHT:
+      return calcPointLight(light, normal);
+    case LIGHT_SPOTLIGHT:
+      return calcSpotlight(light, normal);
+    case LIGHT_DIRECTIONAL_LIGHT:
+      return calcDirectionalLight(light, normal);
+    case LIGHT_DIRECTIONAL_LIGHT_PLANE:
+      return calcDirectionalLightPlane(light, normal);
+    case LIGHT_NONE:
+    default:
+      return vec3(0.0);
+  }
+}
+
+uvec2 getCluster() {
+  float depth = linearizeDepth(gl_FragCoord.z, clusterDepthParams.x, clusterDepthParams.y);
+  uint slice = uint(max(log(depth) * clusterDepthParams.z + clusterDepthParams.w, 0.0));
+  uvec2 tile = uvec2(gl_FragCoord.xy * invScreenSize.xy * vec2(clusterGridSize.xy));
+  uvec3 cluster = min(uvec3(tile, slice), clusterGridSize.xyz - uvec3(1));
+  int i = int(cluster.z * clusterGridSize.x * clusterGridSize.y + cluster.y * clusterGridSize.x + cluster.x);
+  return texelFetch(lightClusters, i).rg;
+}
+
 void main() {
   vec3 normal = normalize(fragmentNormal);
   vec4 col = vec4(vec3(0.0), 1.0);
   vec3 materialColor = material.color + material.tint;
 
-  for (int i = 0; i < lights.length(); i++) {
-    if (!lights[i].enabled)
-      continue;
-    switch (lights[i].type) {
-      case LIGHT_POINT_LIGHT:
-        col.rgb += calcPointLight(lights[i], normal) * material.color;
-        break;
-      case LIGHT_SPOTLIGHT:
-        col.rgb += calcSpotlight(lights[i], normal) * material.color;
-        break;
-      case LIGHT_DIRECTIONAL_LIGHT:
-        col.rgb += calcDirectionalLight(lights[i], normal) * material.color;
-        break;
-      case LIGHT_DIRECTIONAL_LIGHT_PLANE:
-        col.rgb += calcDirectionalLightPlane(lights[i], normal) * material.color;
-        break;
-      case LIGHT_NONE:
-      default:
-        break;
-    }
+  for (uint i = 0u; i < clusterGridSize.w; i++) {
+    col.rgb += calcLight(fetchLight(int(texelFetch(lightIndices, int(i)).r)), normal) * material.color;
+  }
+  uvec2 cluster = getCluster();
+  for (uint i = cluster.x; i < cluster.x + cluster.y; i++) {
+    col.rgb += calcLight(fetchLight(int(texelFetch(lightIndices, int(i)).r)), normal) * material.color;
   }
   // more advanced ambient lighting (not necessary):
   // col += max(dot(normal, vec3(0.0, 1.0, 0.0)), length(material.ambientColor)) * material.ambientColor * material.color;
   col.rgb += material.ambientColor;
-  if (material.hasTexture)
+  if (material.hasTextureArray)
+    col *= texture(textureArraySampler, vec3(fragmentTexCoord * material.tiling + material.offset, fragmentTextureLayer));
+  else if (material.hasTexture)
     col *= texture(textureSampler, fragmentTexCoord * material.tiling + material.offset);
   col.a *= material.opacity;
   col.rgb += material.tint;
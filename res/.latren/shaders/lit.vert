@@ -8,14 +8,24 @@ out vec3 fragmentNormal;
 out vec3 fragmentPos;
 out vec3 fragmentViewPos;
 out vec2 fragmentTexCoord;
+flat out float fragmentTextureLayer;
 
-uniform mat4 projection, view, model;
-uniform vec3 viewPos;
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+uniform mat4 model;
+// set by the material if it has a texture array
+uniform float textureLayer;
 
 void main() {
   gl_Position = projection * view * model * vec4(pos, 1.0);
   fragmentPos = vec3(model * vec4(pos, 1.0));
   fragmentNormal = mat3(transpose(inverse(model))) * normal;
   fragmentTexCoord = texCoord;
+  fragmentTextureLayer = textureLayer;
   fragmentViewPos = viewPos;
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 texCoord;
+layout (location = 2) in vec3 normal;
+// per instance, takes up locations 3-6
+layout (location = 3) in mat4 model;
+layout (location = 7) in float instanceTextureLayer;
+
+out vec3 fragmentNormal;
+out vec3 fragmentPos;
+out vec3 fragmentViewPos;
+out vec2 fragmentTexCoord;
+flat out float fragmentTextureLayer;
+
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+void main() {
+  gl_Position = projection * view * model * vec4(pos, 1.0);
+  fragmentPos = vec3(model * vec4(pos, 1.0));
+  fragmentNormal = mat3(transpose(inverse(model))) * normal;
+  fragmentTexCoord = texCoord;
+  fragmentTextureLayer = instanceTextureLayer;
+  fragmentViewPos = viewPos;
+}
\ No newline at end of file
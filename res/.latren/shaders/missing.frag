@@ -0,0 +1,17 @@
+#version 330 core
+
+in vec2 fragmentTexCoord;
+
+out vec4 color;
+
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+// blinks like the missing material
+void main() {
+  color = mod(time, .5) < .25 ? vec4(1.0, 0.0, 1.0, 1.0) : vec4(0.0, 0.0, 0.0, 1.0);
+}
\ No newline at end of file
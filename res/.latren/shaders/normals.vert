@@ -7,7 +7,13 @@ out VS_OUT {
     vec3 normal;
 } vs_out;
 
-uniform mat4 view;
+layout (std140) uniform CameraData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+    float time;
+};
+
 uniform mat4 model;
 
 void main() {
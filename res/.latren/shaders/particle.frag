@@ -0,0 +1,24 @@
+#version 330 core
+
+struct Material {
+  vec3 color;
+  float opacity;
+  bool hasTexture;
+};
+
+out vec4 color;
+
+in vec2 fragmentTexCoord;
+in vec4 fragmentColor;
+
+uniform Material material;
+uniform sampler2D textureSampler;
+
+void main() {
+  vec4 col = fragmentColor * vec4(material.color, material.opacity);
+  if (material.hasTexture)
+    col *= texture(textureSampler, fragmentTexCoord);
+  if (col.a <= 0.0)
+    discard;
+  color = col;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 330 core
+
+// xyz and the size
+layout (location = 0) in vec4 particle;
+layout (location = 1) in vec4 particleColor;
+
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+out vec2 fragmentTexCoord;
+out vec4 fragmentColor;
+
+const vec2 CORNERS[4] = vec2[4](vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(-0.5, 0.5), vec2(0.5, 0.5));
+
+void main() {
+  vec2 corner = CORNERS[gl_VertexID];
+  // expanded in view space so the quad always faces the camera
+  vec4 pos = view * vec4(particle.xyz, 1.0);
+  pos.xy += corner * particle.w;
+  gl_Position = projection * pos;
+  fragmentTexCoord = vec2(corner.x + 0.5, 0.5 - corner.y);
+  fragmentColor = particleColor;
+}
\ No newline at end of file
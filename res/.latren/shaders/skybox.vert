@@ -4,10 +4,17 @@ layout (location = 0) in vec3 pos;
 
 out vec3 texCoords;
 
-uniform mat4 projection, view;
+layout (std140) uniform CameraData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+    float time;
+};
+
 uniform float clippingFar;
 
 void main() {
     texCoords = pos;
-    gl_Position = (projection * view * vec4(pos, .5 / clippingFar)).xyzw;
+    // strip the translation from the view matrix
+    gl_Position = (projection * mat4(mat3(view)) * vec4(pos, .5 / clippingFar)).xyzw;
 }
\ No newline at end of file
@@ -7,19 +7,29 @@ struct Material {
   int colorCount;
   float strobeInterval;
   bool hasTexture;
+  bool hasTextureArray;
 };
 
 out vec4 color;
 
 in vec2 fragmentTexCoord;
+flat in float fragmentTextureLayer;
 
 uniform Material material;
 uniform sampler2D textureSampler;
-uniform float time;
+uniform sampler2DArray textureArraySampler;
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
 
 void main() {
   int currentColor = int(fract(time / material.strobeInterval / material.colorCount) * material.colorCount);
   color = vec4(material.colors[currentColor], 1.0);
-  if (material.hasTexture)
+  if (material.hasTextureArray)
+    color *= texture(textureArraySampler, vec3(fragmentTexCoord, fragmentTextureLayer));
+  else if (material.hasTexture)
     color *= texture(textureSampler, fragmentTexCoord);
 }
\ No newline at end of file
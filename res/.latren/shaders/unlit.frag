@@ -12,6 +12,7 @@ struct Material {
   vec3 tint;
   float opacity;
   bool hasTexture;
+  bool hasTextureArray;
   vec2 tiling;
   vec2 offset;
   Fog fog;
@@ -20,9 +21,11 @@ struct Material {
 out vec4 color;
 
 in vec2 fragmentTexCoord;
+flat in float fragmentTextureLayer;
 
 uniform Material material;
 uniform sampler2D textureSampler;
+uniform sampler2DArray textureArraySampler;
 
 // copied from learnopengl.com
 float linearizeDepth(float depth, float near, float far) {
@@ -32,7 +35,9 @@ float linearizeDepth(float depth, float near, float far) {
 
 void main() {
   vec4 col = vec4(material.color, material.opacity);
-  if (material.hasTexture)
+  if (material.hasTextureArray)
+    col *= texture(textureArraySampler, vec3(fragmentTexCoord * material.tiling + material.offset, fragmentTextureLayer));
+  else if (material.hasTexture)
     col *= texture(textureSampler, fragmentTexCoord * material.tiling + material.offset);
   col.rgb += material.tint;
   if (material.fog.use) {
@@ -4,10 +4,21 @@ layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 texCoord;
 
 out vec2 fragmentTexCoord;
+flat out float fragmentTextureLayer;
 
-uniform mat4 projection, view, model;
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+uniform mat4 model;
+// set by the material if it has a texture array
+uniform float textureLayer;
 
 void main() {
   gl_Position =  projection * view * model * vec4(pos, 1.0);
   fragmentTexCoord = texCoord;
+  fragmentTextureLayer = textureLayer;
 }
\ No newline at end of file
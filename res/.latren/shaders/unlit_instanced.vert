@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 texCoord;
+// per instance, takes up locations 3-6
+layout (location = 3) in mat4 model;
+layout (location = 7) in float instanceTextureLayer;
+
+out vec2 fragmentTexCoord;
+flat out float fragmentTextureLayer;
+
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+void main() {
+  gl_Position = projection * view * model * vec4(pos, 1.0);
+  fragmentTexCoord = texCoord;
+  fragmentTextureLayer = instanceTextureLayer;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 430 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 texCoord;
+// per instance, 0, 1, 2... offset by the base instance of the indirect command
+layout (location = 3) in uint instanceIndex;
+
+out vec2 fragmentTexCoord;
+flat out float fragmentTextureLayer;
+
+layout (std140) uniform CameraData {
+  mat4 projection;
+  mat4 view;
+  vec3 viewPos;
+  float time;
+};
+
+struct Instance {
+  mat4 model;
+  // x = texture array layer
+  vec4 params;
+};
+
+layout (std430, binding = 0) readonly buffer InstanceData {
+  Instance instances[];
+};
+
+void main() {
+  gl_Position = projection * view * instances[instanceIndex].model * vec4(pos, 1.0);
+  fragmentTexCoord = texCoord;
+  fragmentTextureLayer = instances[instanceIndex].params.x;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# Compresses every png under the given folder (res by default) into a .dds next to it
+# Build the tool first with -DLATREN_BUILD_TOOLS=ON
+SCRIPT_DIR=$(dirname -- "$(readlink -f -- "$BASH_SOURCE")")
+LATREN_DIR=$(dirname "$SCRIPT_DIR")
+if [ -z "$TEXCOMPRESS" ]; then
+    # standalone builds put it under latren's own build folder, otherwise it's next to the project's binaries
+    for CANDIDATE in "$LATREN_DIR/build/bin/latren-texcompress" "bin/Release/latren-texcompress" "bin/Debug/latren-texcompress"; do
+        if [ -x "$CANDIDATE" ]; then
+            TEXCOMPRESS=$CANDIDATE
+            break
+        fi
+    done
+fi
+if [ -z "$TEXCOMPRESS" ] || [ ! -x "$TEXCOMPRESS" ]; then
+    echo "latren-texcompress not found, build it with -DLATREN_BUILD_TOOLS=ON or set TEXCOMPRESS"
+    exit 1
+fi
+RES_DIR=${1:-res}
+echo \[COMPRESSING TEXTURES\]
+FAILED=0
+while IFS= read -r -d '' f; do
+    "$TEXCOMPRESS" "$f" || FAILED=1
+done < <(find "$RES_DIR" -name "*.png" -print0)
+if [ $FAILED -ne 0 ]; then
+    echo \[COMPRESSING TEXTURES FAILED\]
+    exit 1
+fi
+echo \[TEXTURES COMPRESSED\]
\ No newline at end of file
@@ -4,19 +4,30 @@
 #include <latren/systems.h>
 #include <latren/audio/audioplayer.h>
 
+#include <memory>
+#include <cstdlib>
+
 std::optional<AudioBufferHandle> Resources::AudioManager::LoadResource(const ResourcePath& path) {
+    return DecodeResource(path, GetItemID(), GetAdditionalData())();
+}
+
+std::function<std::optional<AudioBufferHandle>()> Resources::AudioManager::DecodeResource(const ResourcePath& path, const std::string&, const AdditionalImportData&) {
     AudioBufferData bufferData;
     std::fs::path p = path.GetParsedPath();
     if (p.extension() == ".ogg") {
         int len = stb_vorbis_decode_filename(p.generic_string().c_str(), &bufferData.channels, &bufferData.sampleRate, reinterpret_cast<short**>(&bufferData.data));
         if (len < 0)
-            return std::nullopt;
+            return [] { return std::nullopt; };
         bufferData.size = len * 2 * bufferData.channels;
         bufferData.bitDepth = 16;
         bufferData.alFormat = bufferData.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
     }
     else {
-        return std::nullopt;
+        return [] { return std::nullopt; };
     }
-    return Systems::GetAudioPlayer().CreateAudioBuffer(bufferData);
+    // openal copies the samples, so the decoded buffer can go right after
+    std::shared_ptr<void> samples(bufferData.data, free);
+    return [bufferData, samples]() -> std::optional<AudioBufferHandle> {
+        return Systems::GetAudioPlayer().CreateAudioBuffer(bufferData);
+    };
 }
\ No newline at end of file
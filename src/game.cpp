@@ -59,6 +59,7 @@ void Game::GameThreadInit() {
     DumpComponentData(ComponentSerialization::GetComponentTypes(), LATREN_DUMP_COMPONENT_DATA);
     #endif
     RegisterDeserializers();
+    threadPool_.Start();
     if (!audioPlayer_.Init())
         spdlog::error("Audio disabled!");
     resources_.LoadConfigs();
@@ -108,7 +109,9 @@ void Game::GameThreadCleanUp() {
     audioPlayer_.DeleteAllSources();
 }
 
-void Game::GameThreadDestroy() { }
+void Game::GameThreadDestroy() {
+    threadPool_.Stop();
+}
 
 void Game::GameThreadPrepareUpdate() {
     window_.inputSystem.keyboardListener.UpdateStates();
@@ -161,6 +164,12 @@ void Game::GameThreadPrepareUpdate() {
 void Game::GameThreadUpdate() {
     GameThreadPrepareUpdate();
     window_.Update();
+    // imports started with BeginLoadImports get their uploads done a bit at a time
+    if (resources_.IsLoading())
+        resources_.UpdateLoading();
+    Resources::StageManager* stages = resources_.GetStageManager();
+    if (stages != nullptr && stages->IsStreaming())
+        stages->UpdateStreaming();
     if (isFixedUpdate_) {
         FixedUpdate();
         entityManager_.FixedUpdateAll();
@@ -236,6 +245,10 @@ PhysicsWorld& Game::GetPhysics() {
     return physics_;
 }
 
+Threads::ThreadPool& Game::GetThreadPool() {
+    return threadPool_;
+}
+
 void Game::RegisterComponents() {
     ComponentSerialization::RegisterCoreComponents();
 }
@@ -0,0 +1,287 @@
+#include <latren/graphics/bvh.h>
+
+#include <algorithm>
+#include <limits>
+
+const int SAH_BINS = 12;
+const std::uint32_t MAX_LEAF_SIZE = 4;
+// keeps the traversal stack small, anything deeper just becomes a bigger leaf
+const int MAX_DEPTH = 48;
+// each insert adds a level on top, this has to stay under the 64 of the traversal stack
+const int MAX_INSERTIONS = 8;
+
+struct SAHBin {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+    std::uint32_t count = 0;
+    void Grow(const glm::vec3& pMin, const glm::vec3& pMax) {
+        min = glm::min(min, pMin);
+        max = glm::max(max, pMax);
+    }
+    float Area() const {
+        glm::vec3 e = max - min;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+
+void BVH::Build(const std::vector<ViewFrustum::AABB>& items) {
+    items_ = items;
+    nodes_.clear();
+    order_.resize(items_.size());
+    centroids_.resize(items_.size());
+    for (std::uint32_t i = 0; i < items_.size(); i++) {
+        order_[i] = i;
+        centroids_[i] = items_[i].center;
+    }
+    dirty_ = false;
+    insertions_ = 0;
+    if (items_.empty())
+        return;
+    nodes_.reserve(items_.size() * 2);
+    Node root;
+    root.first = 0;
+    root.count = (std::uint32_t) items_.size();
+    root.left = -1;
+    nodes_.push_back(root);
+    UpdateNodeBounds(nodes_[0]);
+    BuildSubtree(0, 0);
+}
+
+void BVH::BuildSubtree(std::uint32_t rootIndex, int rootDepth) {
+    // depth first with an explicit stack, (node, depth)
+    std::vector<std::pair<std::uint32_t, int>> stack = { { rootIndex, rootDepth } };
+    while (!stack.empty()) {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+        if (depth >= MAX_DEPTH)
+            continue;
+        Subdivide(nodeIndex);
+        const Node& node = nodes_[nodeIndex];
+        if (!node.IsLeaf()) {
+            stack.push_back({ node.left, depth + 1 });
+            stack.push_back({ node.left + 1, depth + 1 });
+        }
+    }
+}
+
+void BVH::Insert(const std::vector<ViewFrustum::AABB>& items) {
+    if (items.empty())
+        return;
+    // every insert makes the tree a level deeper and the split worse, so start over once in a while
+    if (nodes_.empty() || insertions_ >= MAX_INSERTIONS) {
+        std::vector<ViewFrustum::AABB> all = items_;
+        all.insert(all.end(), items.begin(), items.end());
+        Build(all);
+        return;
+    }
+    Refit();
+    std::uint32_t first = (std::uint32_t) items_.size();
+    for (const ViewFrustum::AABB& item : items) {
+        order_.push_back((std::uint32_t) items_.size());
+        items_.push_back(item);
+        centroids_.push_back(item.center);
+    }
+    // the old root moves to the end and gets the new items' subtree as its sibling, under a new root.
+    // the old items are first in the order so the root still covers a contiguous range
+    std::int32_t oldRoot = (std::int32_t) nodes_.size();
+    nodes_.push_back(nodes_[0]);
+    Node subtree;
+    subtree.first = first;
+    subtree.count = (std::uint32_t) items.size();
+    subtree.left = -1;
+    nodes_.push_back(subtree);
+    UpdateNodeBounds(nodes_[oldRoot + 1]);
+    BuildSubtree(oldRoot + 1, 0);
+
+    Node& root = nodes_[0];
+    root.first = 0;
+    root.count = (std::uint32_t) items_.size();
+    root.left = oldRoot;
+    root.min = glm::min(nodes_[oldRoot].min, nodes_[oldRoot + 1].min);
+    root.max = glm::max(nodes_[oldRoot].max, nodes_[oldRoot + 1].max);
+    insertions_++;
+}
+
+void BVH::Clear() {
+    nodes_.clear();
+    items_.clear();
+    centroids_.clear();
+    order_.clear();
+    dirty_ = false;
+    insertions_ = 0;
+}
+
+void BVH::UpdateNodeBounds(Node& node) {
+    node.min = glm::vec3(std::numeric_limits<float>::max());
+    node.max = glm::vec3(-std::numeric_limits<float>::max());
+    for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+        const ViewFrustum::AABB& item = items_[order_[i]];
+        node.min = glm::min(node.min, item.GetMin());
+        node.max = glm::max(node.max, item.GetMax());
+    }
+}
+
+void BVH::Subdivide(std::uint32_t nodeIndex) {
+    Node node = nodes_[nodeIndex];
+    if (node.count <= MAX_LEAF_SIZE)
+        return;
+
+    // bin the centroids along each axis and pick the cheapest split
+    glm::vec3 cMin = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 cMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+        cMin = glm::min(cMin, centroids_[order_[i]]);
+        cMax = glm::max(cMax, centroids_[order_[i]]);
+    }
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = cMax[axis] - cMin[axis];
+        if (extent <= 0.0f)
+            continue;
+        SAHBin bins[SAH_BINS];
+        float scale = SAH_BINS / extent;
+        for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+            const ViewFrustum::AABB& item = items_[order_[i]];
+            int b = std::min(SAH_BINS - 1, (int) ((centroids_[order_[i]][axis] - cMin[axis]) * scale));
+            bins[b].count++;
+            bins[b].Grow(item.GetMin(), item.GetMax());
+        }
+        // sweep from both sides
+        float leftArea[SAH_BINS - 1], rightArea[SAH_BINS - 1];
+        std::uint32_t leftCount[SAH_BINS - 1], rightCount[SAH_BINS - 1];
+        SAHBin leftBox, rightBox;
+        std::uint32_t leftSum = 0, rightSum = 0;
+        for (int i = 0; i < SAH_BINS - 1; i++) {
+            leftSum += bins[i].count;
+            leftCount[i] = leftSum;
+            if (bins[i].count > 0)
+                leftBox.Grow(bins[i].min, bins[i].max);
+            leftArea[i] = leftBox.Area();
+
+            rightSum += bins[SAH_BINS - 1 - i].count;
+            rightCount[SAH_BINS - 2 - i] = rightSum;
+            if (bins[SAH_BINS - 1 - i].count > 0)
+                rightBox.Grow(bins[SAH_BINS - 1 - i].min, bins[SAH_BINS - 1 - i].max);
+            rightArea[SAH_BINS - 2 - i] = rightBox.Area();
+        }
+        for (int i = 0; i < SAH_BINS - 1; i++) {
+            if (leftCount[i] == 0 || rightCount[i] == 0)
+                continue;
+            float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+    // all the centroids are in the same spot, can't split this
+    if (bestAxis == -1)
+        return;
+    SAHBin parentBox;
+    parentBox.Grow(node.min, node.max);
+    if (bestCost >= node.count * parentBox.Area())
+        return;
+
+    float scale = SAH_BINS / (cMax[bestAxis] - cMin[bestAxis]);
+    auto middle = std::partition(order_.begin() + node.first, order_.begin() + node.first + node.count, [&](std::uint32_t item) {
+        int b = std::min(SAH_BINS - 1, (int) ((centroids_[item][bestAxis] - cMin[bestAxis]) * scale));
+        return b <= bestSplit;
+    });
+    std::uint32_t leftCount = (std::uint32_t) (middle - order_.begin()) - node.first;
+    if (leftCount == 0 || leftCount == node.count)
+        return;
+
+    Node left;
+    left.first = node.first;
+    left.count = leftCount;
+    left.left = -1;
+    Node right;
+    right.first = node.first + leftCount;
+    right.count = node.count - leftCount;
+    right.left = -1;
+    std::int32_t leftIndex = (std::int32_t) nodes_.size();
+    nodes_.push_back(left);
+    nodes_.push_back(right);
+    UpdateNodeBounds(nodes_[leftIndex]);
+    UpdateNodeBounds(nodes_[leftIndex + 1]);
+    nodes_[nodeIndex].left = leftIndex;
+}
+
+void BVH::Update(std::uint32_t item, const ViewFrustum::AABB& aabb) {
+    items_[item] = aabb;
+    dirty_ = true;
+}
+
+void BVH::RefitNode(std::uint32_t nodeIndex) {
+    Node& node = nodes_[nodeIndex];
+    if (node.IsLeaf()) {
+        UpdateNodeBounds(node);
+        return;
+    }
+    RefitNode(node.left);
+    RefitNode(node.left + 1);
+    const Node& l = nodes_[node.left];
+    const Node& r = nodes_[node.left + 1];
+    node.min = glm::min(l.min, r.min);
+    node.max = glm::max(l.max, r.max);
+}
+
+void BVH::Refit() {
+    if (!dirty_)
+        return;
+    // after an insert the old root sits after its children, so this can't just go backwards through the nodes
+    if (!nodes_.empty())
+        RefitNode(0);
+    dirty_ = false;
+}
+
+ViewFrustum::AABB BVH::GetNodeAABB(const Node& node) const {
+    return ViewFrustum::AABB::FromMinMax(node.min, node.max);
+}
+
+void BVH::MarkVisible(const Node& node, Culling::VisibilitySet& visibility) const {
+    for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+        visibility.Set(order_[i]);
+}
+
+void BVH::CullNode(std::uint32_t nodeIndex, int planeMask, const ViewFrustum& frustum, Culling::VisibilitySet& visibility) const {
+    const Node& node = nodes_[nodeIndex];
+    switch (Culling::TestFrustum(frustum, GetNodeAABB(node), planeMask)) {
+        case Culling::FrustumTestResult::OUTSIDE:
+            return;
+        // the whole subtree is visible, no need to go further
+        case Culling::FrustumTestResult::INSIDE:
+            MarkVisible(node, visibility);
+            return;
+        case Culling::FrustumTestResult::INTERSECTS:
+            break;
+    }
+    if (node.IsLeaf()) {
+        for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+            int itemMask = planeMask;
+            if (Culling::TestFrustum(frustum, items_[order_[i]], itemMask) != Culling::FrustumTestResult::OUTSIDE)
+                visibility.Set(order_[i]);
+        }
+        return;
+    }
+    CullNode(node.left, planeMask, frustum, visibility);
+    CullNode(node.left + 1, planeMask, frustum, visibility);
+}
+
+void BVH::CullFrustum(const ViewFrustum& frustum, Culling::VisibilitySet& visibility) const {
+    visibility.Resize(items_.size());
+    if (nodes_.empty())
+        return;
+    CullNode(0, 0x3F, frustum, visibility);
+}
+
+std::size_t BVH::GetItemCount() const {
+    return items_.size();
+}
+
+std::size_t BVH::GetNodeCount() const {
+    return nodes_.size();
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <latren/graphics/commandlist.h>
+#include <latren/graphics/glstate.h>
+
+#include <algorithm>
+
+using namespace RenderCommands;
+
+GLint UniformLocationCache::Get(GLuint program, const char* name) {
+    auto& programLocations = locations_[program];
+    // reusing the key string so the lookups don't allocate once it's big enough
+    key_.assign(name);
+    auto it = programLocations.find(key_);
+    if (it == programLocations.end())
+        it = programLocations.insert({ key_, glGetUniformLocation(program, name) }).first;
+    return it->second;
+}
+
+void UniformLocationCache::Clear() {
+    locations_.clear();
+}
+
+uint32_t CommandList::PushData(const void* data, std::size_t size) {
+    uint32_t offset = static_cast<uint32_t>(arena_.size());
+    arena_.resize(arena_.size() + size);
+    std::memcpy(&arena_[offset], data, size);
+    return offset;
+}
+
+void CommandList::PushUniform(UniformType type, const char* name, const void* value, std::size_t size) {
+    Command cmd;
+    cmd.type = Type::UNIFORM;
+    cmd.uniform.type = type;
+    cmd.uniform.name = PushData(name, std::strlen(name) + 1);
+    cmd.uniform.value = PushData(value, size);
+    commands_.push_back(cmd);
+}
+
+void CommandList::Clear() {
+    // keeps the capacity, the lists are refilled every frame
+    commands_.clear();
+    arena_.clear();
+}
+
+bool CommandList::IsEmpty() const {
+    return commands_.empty();
+}
+
+std::size_t CommandList::GetCommandCount() const {
+    return commands_.size();
+}
+
+std::size_t CommandList::GetDrawCount() const {
+    return std::count_if(commands_.begin(), commands_.end(), [](const Command& cmd) { return cmd.type == Type::DRAW_ELEMENTS; });
+}
+
+void CommandList::UseShader(const Shader& shader) {
+    Command cmd;
+    cmd.type = Type::USE_SHADER;
+    cmd.shader = &shader;
+    commands_.push_back(cmd);
+}
+
+void CommandList::BindVertexArray(GLuint vao, GLuint ebo) {
+    Command cmd;
+    cmd.type = Type::BIND_VERTEX_ARRAY;
+    cmd.vertexArray.vao = vao;
+    cmd.vertexArray.ebo = ebo;
+    commands_.push_back(cmd);
+}
+
+void CommandList::BindTexture(GLenum target, Texture::TextureID texture, GLuint unit) {
+    Command cmd;
+    cmd.type = Type::BIND_TEXTURE;
+    cmd.texture.target = target;
+    cmd.texture.texture = texture;
+    cmd.texture.unit = unit;
+    commands_.push_back(cmd);
+}
+
+void CommandList::SetEnabled(GLenum capability, bool enabled) {
+    Command cmd;
+    cmd.type = Type::SET_ENABLED;
+    cmd.capability.capability = capability;
+    cmd.capability.enabled = enabled;
+    commands_.push_back(cmd);
+}
+
+void CommandList::DrawElements(GLenum indexType, GLsizei count, std::size_t offset, GLint baseVertex) {
+    Command cmd;
+    cmd.type = Type::DRAW_ELEMENTS;
+    cmd.draw.indexType = indexType;
+    cmd.draw.count = count;
+    cmd.draw.baseVertex = baseVertex;
+    cmd.draw.offset = offset;
+    commands_.push_back(cmd);
+}
+
+// the arena isn't aligned for the value types so copy them out first
+template <typename T>
+T ReadValue(const std::vector<unsigned char>& arena, uint32_t offset) {
+    T value;
+    std::memcpy(&value, &arena[offset], sizeof(T));
+    return value;
+}
+
+void SubmitUniform(GLint location, const Command& cmd, const std::vector<unsigned char>& arena) {
+    uint32_t offset = cmd.uniform.value;
+    switch (cmd.uniform.type) {
+        case UniformType::INT:
+            glUniform1i(location, ReadValue<int>(arena, offset));
+            break;
+        case UniformType::FLOAT:
+            glUniform1f(location, ReadValue<float>(arena, offset));
+            break;
+        case UniformType::VEC2:
+            glUniform2fv(location, 1, &ReadValue<glm::vec2>(arena, offset)[0]);
+            break;
+        case UniformType::VEC3:
+            glUniform3fv(location, 1, &ReadValue<glm::vec3>(arena, offset)[0]);
+            break;
+        case UniformType::VEC4:
+            glUniform4fv(location, 1, &ReadValue<glm::vec4>(arena, offset)[0]);
+            break;
+        case UniformType::MAT2:
+            glUniformMatrix2fv(location, 1, GL_FALSE, &ReadValue<glm::mat2>(arena, offset)[0][0]);
+            break;
+        case UniformType::MAT3:
+            glUniformMatrix3fv(location, 1, GL_FALSE, &ReadValue<glm::mat3>(arena, offset)[0][0]);
+            break;
+        case UniformType::MAT4:
+            glUniformMatrix4fv(location, 1, GL_FALSE, &ReadValue<glm::mat4>(arena, offset)[0][0]);
+            break;
+    }
+}
+
+void CommandList::Submit(GLState& gl, UniformLocationCache& locations) const {
+    GLuint program = GL_NONE;
+    for (const Command& cmd : commands_) {
+        switch (cmd.type) {
+            case Type::USE_SHADER:
+                program = cmd.shader->GetProgram();
+                gl.UseProgram(program);
+                break;
+            case Type::BIND_VERTEX_ARRAY:
+                gl.BindVertexArray(cmd.vertexArray.vao);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cmd.vertexArray.ebo);
+                break;
+            case Type::BIND_TEXTURE:
+                gl.BindTexture(cmd.texture.target, cmd.texture.texture, cmd.texture.unit);
+                break;
+            case Type::SET_ENABLED:
+                gl.SetEnabled(cmd.capability.capability, cmd.capability.enabled);
+                break;
+            case Type::UNIFORM: {
+                GLint location = locations.Get(program, reinterpret_cast<const char*>(&arena_[cmd.uniform.name]));
+                if (location != -1) {
+                    SubmitUniform(location, cmd, arena_);
+                    GLState::CountUniform();
+                }
+            } break;
+            case Type::DRAW_ELEMENTS:
+                glDrawElementsBaseVertex(GL_TRIANGLES, cmd.draw.count, cmd.draw.indexType, reinterpret_cast<void*>(cmd.draw.offset), cmd.draw.baseVertex);
+                GLState::CountDraw(GL_TRIANGLES, cmd.draw.count);
+                break;
+        }
+    }
+}
\ No newline at end of file
@@ -1,30 +1,31 @@
 #include <latren/graphics/component/billboard.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
 #include <latren/game.h>
 
 void BillboardRenderer::Delete() {
     if (vao_ != GL_NONE)
-        glDeleteVertexArrays(1, &vao_);
+        GLState::DeleteVertexArray(vao_);
     if (vbo_ != GL_NONE)
         glDeleteBuffers(1, &vbo_);
     vao_ = GL_NONE;
     vbo_ = GL_NONE;
+    pointsCount_ = 0;
 }
 
 void BillboardRenderer::UpdateVertexBuffer() {
-    glBindVertexArray(vao_);
-    const glm::vec3 pos = positions->front();
-    float* pointsBuffer = new float[positions->size() * 3];
+    // glm::vec3 is tightly packed so the positions can go in as they are
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+    GLsizei prevCount = pointsCount_;
     pointsCount_ = (GLsizei) positions->size();
-    for (int i = 0; i < positions->size(); i++) {
-        int ptr = i * 3;
-        pointsBuffer[ptr] = positions->at(i).x;
-        pointsBuffer[ptr + 1] = positions->at(i).y;
-        pointsBuffer[ptr + 2] = positions->at(i).z;
-    }
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * pointsCount_, pointsBuffer, GL_STATIC_DRAW);
-    delete[] pointsBuffer;
-    glBindVertexArray(0);
+    // only reallocate the storage if the point count changes
+    if (pointsCount_ != prevCount)
+        glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * pointsCount_, positions->data(), GL_DYNAMIC_DRAW);
+    else
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec3) * pointsCount_, positions->data());
+    GLState::CountUpload(sizeof(glm::vec3) * pointsCount_);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void BillboardRenderer::Start() {
@@ -32,7 +33,7 @@ void BillboardRenderer::Start() {
 
     glGenVertexArrays(1, &vao_);
     glGenBuffers(1, &vbo_);
-    glBindVertexArray(vao_);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
     glEnableVertexAttribArray(0);
@@ -43,8 +44,8 @@ void BillboardRenderer::CalculateMatrices() {
     modelMatrix_ = parent.GetTransform().CreateTransformationMatrix();
 }
 
-void BillboardRenderer::UpdateUniforms(const Shader& shader, const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& viewPos) const {
-    Renderable::UpdateUniforms(shader, projectionMatrix, viewMatrix, viewPos);
+void BillboardRenderer::UpdateUniforms(const Shader& shader) const {
+    Renderable::UpdateUniforms(shader);
     shader.SetUniform("model", modelMatrix_);
 }
 
@@ -53,12 +54,13 @@ void BillboardRenderer::Render(const glm::mat4& projectionMatrix, const glm::mat
         return;
     
     if (material.Get() != nullptr) {
-        UpdateUniforms(GetMaterialShader(material), projectionMatrix, viewMatrix, viewPos);
+        UpdateUniforms(GetMaterialShader(material));
         material.Get()->Use();
     }
     else {
-        UpdateUniforms(BillboardRenderer::SHADER_, projectionMatrix, viewMatrix, viewPos);
+        UpdateUniforms(BillboardRenderer::SHADER_);
     }
-    glBindVertexArray(vao_);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao_);
     glDrawArrays(GL_POINTS, 0, pointsCount_);
+    GLState::CountDraw(GL_POINTS, pointsCount_);
 }
\ No newline at end of file
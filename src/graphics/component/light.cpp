@@ -6,11 +6,8 @@
 using namespace Lights;
 
 int Lights::LIGHTS_INDEX = 0;
-// this is fucking evil right here (and way too smartass)
-// 32 lights, 1 bit for reserved, 0 for not
-LightReserves Lights::RESERVED_LIGHTS = 0x0;
-// they warned about premature optimization but this is fucking prenatal optimization
-const uint8_t Lights::MAX_LIGHTS = (uint8_t) sizeof(LightReserves) * 8;
+LightReserves Lights::RESERVED_LIGHTS;
+const int Lights::MAX_LIGHTS = 4096;
 
 namespace Lights {
     int GetNextLightIndex() {
@@ -18,11 +15,15 @@ namespace Lights {
     }
     
     void ReserveIndex(int index) {
-        RESERVED_LIGHTS |= (1 << index);
+        if (index < 0)
+            return;
+        if (index >= RESERVED_LIGHTS.size())
+            RESERVED_LIGHTS.resize(index + 1, false);
+        RESERVED_LIGHTS[index] = true;
     }
     
     bool IsReserved(int i) {
-        return (RESERVED_LIGHTS >> i) == 0x1;
+        return i >= 0 && i < RESERVED_LIGHTS.size() && RESERVED_LIGHTS[i];
     }
 
     void ResetIndices() {
@@ -34,33 +35,34 @@ namespace Lights {
         return LIGHTS_INDEX;
     }
 
-    void PointLight::ApplyLight(GLuint shader) const {
-        Light::ApplyLight(shader);
-        glm::vec3 pos = parent.GetTransform().position.Get() + offset.Get();
-        glUniform3f(glGetUniformLocation(shader, std::string(lightUniform_ + ".pos").c_str()), pos.x, pos.y, pos.z);
-        glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".range").c_str()), range);
+    void ILight::UpdateLight() const {
+        Systems::GetRenderer().UpdateLight(*this);
     }
 
-    void DirectionalLight::ApplyLight(GLuint shader) const {
-        Light::ApplyLight(shader);
-        glUniform3f(glGetUniformLocation(shader, std::string(lightUniform_ + ".dir").c_str()), dir->x, dir->y, dir->z);
+    void PointLight::ApplyLight(LightData& data) const {
+        Light::ApplyLight(data);
+        data.pos = parent.GetTransform().position.Get() + offset.Get();
+        data.range = range;
     }
 
-    void DirectionalLightPlane::ApplyLight(GLuint shader) const {
-        Light::ApplyLight(shader);
-        glUniform3f(glGetUniformLocation(shader, std::string(lightUniform_ + ".dir").c_str()), dir->x, dir->y, dir->z);
-        float pos = parent.GetTransform().position->y + offset;
-        glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".y").c_str()), pos);
-        glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".range").c_str()), range);
+    void DirectionalLight::ApplyLight(LightData& data) const {
+        Light::ApplyLight(data);
+        data.dir = dir;
     }
 
-    void Spotlight::ApplyLight(GLuint shader) const {
-        Light::ApplyLight(shader);
-        glUniform3f(glGetUniformLocation(shader, std::string(lightUniform_ + ".dir").c_str()), dir->x, dir->y, dir->z);
-        glm::vec3 pos = parent.GetTransform().position.Get() + offset.Get();
-        glUniform3f(glGetUniformLocation(shader, std::string(lightUniform_ + ".pos").c_str()), pos.x, pos.y, pos.z);
-        glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".range").c_str()), range);
-        glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".cutOffMin").c_str()), cutOffMin);
-        glUniform1f(glGetUniformLocation(shader, std::string(lightUniform_ + ".cutOffMax").c_str()), cutOffMax);
+    void DirectionalLightPlane::ApplyLight(LightData& data) const {
+        Light::ApplyLight(data);
+        data.dir = dir;
+        data.y = parent.GetTransform().position->y + offset;
+        data.range = range;
+    }
+
+    void Spotlight::ApplyLight(LightData& data) const {
+        Light::ApplyLight(data);
+        data.dir = dir;
+        data.pos = parent.GetTransform().position.Get() + offset.Get();
+        data.range = range;
+        data.cutOffMin = cutOffMin;
+        data.cutOffMax = cutOffMax;
     }
 };
\ No newline at end of file
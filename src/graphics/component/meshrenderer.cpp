@@ -3,14 +3,20 @@
 #include <latren/systems.h>
 #include <latren/io/resourcemanager.h>
 #include <latren/graphics/renderer.h>
+#include <latren/graphics/commandlist.h>
 
 #include <limits>
+#include <algorithm>
 
-Shader DEBUG_AABB_SHADER = Shader(Shaders::ShaderID::LINE);
 Shader DEBUG_NORMAL_SHADER = Shader(Shaders::ShaderID::HIGHLIGHT_NORMALS);
 
 void MeshRenderer::Start() {
+    lodScreenSizes_ = LODSettings().screenSizes;
     if (!object->empty()) {
+        const auto& objects = Systems::GetResources().GetObjectSerializer()->GetItems();
+        auto objIt = objects.find(object.Get());
+        if (objIt != objects.end())
+            lodScreenSizes_ = objIt->second.lod.screenSizes;
         for (const auto& mesh : Systems::GetResources().GetModelManager()->Get(object).meshes) {
             if (copyMeshes) {
                 std::shared_ptr<Mesh> meshCopy = std::make_shared<Mesh>(*mesh);
@@ -38,10 +44,19 @@ void MeshRenderer::Start() {
 void MeshRenderer::CalculateMatrices() {
     modelMatrix_ = glm::translate(glm::mat4(1.0f), offset.Get());
     modelMatrix_ *= parent.GetTransform().CreateTransformationMatrix();
+
+    // the extents of a transformed box are the abs of the scaled axes summed up
+    glm::mat3 absAxes = glm::mat3(
+        glm::abs(glm::vec3(modelMatrix_[0])),
+        glm::abs(glm::vec3(modelMatrix_[1])),
+        glm::abs(glm::vec3(modelMatrix_[2]))
+    );
+    worldAabb_.center = modelMatrix_ * glm::vec4(aabb_.center, 1.0f);
+    worldAabb_.extents = absAxes * aabb_.extents;
 }
 
-void MeshRenderer::UpdateUniforms(const Shader& shader, const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::mat4& transformMatrix, const glm::vec3& viewPos) const {
-    Renderable::UpdateUniforms(shader, projectionMatrix, viewMatrix, viewPos);
+void MeshRenderer::UpdateUniforms(const Shader& shader, const glm::mat4& transformMatrix) const {
+    Renderable::UpdateUniforms(shader);
     shader.SetUniform("model", modelMatrix_ * transformMatrix);
 }
 
@@ -56,7 +71,7 @@ void MeshRenderer::Render(const glm::mat4& projectionMatrix, const glm::mat4& vi
                     continue;
                 if (!overrideShader)
                     shader = &GetMaterialShader(mesh->material);
-                UpdateUniforms(*shader, projectionMatrix, viewMatrix, mesh->transformMatrix, viewPos);
+                UpdateUniforms(*shader, mesh->transformMatrix);
                 if (renderMode != RENDER_MODE_NO_MATERIALS) {
                     mesh->material->Use(*shader);
                     if (useCustomMaterial && (meshesUsingCustomMaterial->empty() || meshesUsingCustomMaterial->count(i) > 0)) {
@@ -66,110 +81,77 @@ void MeshRenderer::Render(const glm::mat4& projectionMatrix, const glm::mat4& vi
                 }
                 else {
                     if (mesh->material->cullFaces)
-                        glEnable(GL_CULL_FACE);
+                        Systems::GetRenderer().GetGLState().Enable(GL_CULL_FACE);
                     else
-                        glDisable(GL_CULL_FACE);
+                        Systems::GetRenderer().GetGLState().Disable(GL_CULL_FACE);
                 }
                 mesh->Bind();
-                mesh->Render();
-                glBindVertexArray(0);
+                mesh->Render(lodLevel_);
             }
         } break;
         case RENDER_MODE_DEBUG_NORMALS:
             shader = &DEBUG_NORMAL_SHADER;
             for (int i = 0; i < meshes->size(); i++) {
                 const std::shared_ptr<Mesh>& mesh = meshes->at(i);
-                UpdateUniforms(*shader, projectionMatrix, viewMatrix, mesh->transformMatrix, viewPos);
+                UpdateUniforms(*shader, mesh->transformMatrix);
                 mesh->Bind();
                 mesh->Render();
-                glBindVertexArray(0);
             }
             break;
         case RENDER_MODE_DEBUG_AABBS:
-            shader = &DEBUG_AABB_SHADER;
-            glm::vec3 aabbMin = aabb_.GetMin();
-            glm::vec3 aabbMax = aabb_.GetMax();
-
-            shader->Use();
-            shader->SetUniform("lineColor", glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
-            shader->SetUniform("view", viewMatrix);
-            shader->SetUniform("projection", projectionMatrix);
-
-            GLuint aabbVao, aabbVbo;
-            glGenVertexArrays(1, &aabbVao);
-            glGenBuffers(1, &aabbVbo);
-
-            glBindVertexArray(aabbVao);
-            glBindBuffer(GL_ARRAY_BUFFER, aabbVbo);
-            // I LOVE WRITING PERMUTATIONS BY HAND
-            std::vector<glm::vec3> vertices = {
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMin.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMin.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMin.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMin.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMin.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMin.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMin.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMin.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMax.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMax.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMax.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMax.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMax.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMax.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMax.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMax.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMin.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMax.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMin.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMax.y, aabbMin.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMin.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMin.x, aabbMax.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMin.y, aabbMax.z, 1.0f),
-                modelMatrix_ * glm::vec4(aabbMax.x, aabbMax.y, aabbMax.z, 1.0f)
-            };
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * 3 * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), reinterpret_cast<void*>(0));
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
-            glDrawArrays(GL_POINTS, 0, (GLsizei) vertices.size() * 3);
-
-            glDeleteVertexArrays(1, &aabbVao);
-            glDeleteBuffers(1, &aabbVbo);
-
+            Systems::GetRenderer().GetDebugDraw().Box(aabb_.GetMin(), aabb_.GetMax(), modelMatrix_, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
             break;
     }
 }
 
-bool MeshRenderer::IsOnFrustum(const ViewFrustum& frustum) const {
-    glm::vec3 center = modelMatrix_ * glm::vec4(aabb_.center, 1.0f);
+void MeshRenderer::RecordCommands(CommandList& commands) const {
+    if (disableDepthTest)
+        commands.SetEnabled(GL_DEPTH_TEST, false);
+    for (int i = 0; i < meshes->size(); i++) {
+        const std::shared_ptr<Mesh>& mesh = meshes->at(i);
+        if (mesh->material == nullptr)
+            continue;
+        const Shader& shader = GetMaterialShader(mesh->material);
+        commands.UseShader(shader);
+        commands.SetUniform("model", modelMatrix_ * mesh->transformMatrix);
+        mesh->material->Record(commands, shader);
+        if (useCustomMaterial && (meshesUsingCustomMaterial->empty() || meshesUsingCustomMaterial->count(i) > 0)) {
+            customMaterial->Record(commands, shader);
+            commands.SetUniform("material.hasTexture", mesh->material->GetTexture() != TEXTURE_NONE);
+        }
+        mesh->Record(commands, lodLevel_);
+    }
+    if (disableDepthTest)
+        commands.SetEnabled(GL_DEPTH_TEST, true);
+}
 
-    // Scaled orientation
-    glm::vec3 right = modelMatrix_[0] * aabb_.extents.x;
-    glm::vec3 up = modelMatrix_[1] * aabb_.extents.y;
-    glm::vec3 forward = -modelMatrix_[2] * aabb_.extents.z;
+bool MeshRenderer::IsOnFrustum(const ViewFrustum& frustum) const {
+    return frustum.IsOnFrustum(worldAabb_);
+}
 
-    glm::vec3 extents;
+bool MeshRenderer::GetWorldAABB(ViewFrustum::AABB& aabb) const {
+    aabb = worldAabb_;
+    return true;
+}
 
-    extents.x =
-        std::abs(glm::dot(glm::vec3{ 1.0f, 0.0f, 0.0f }, right)) +
-        std::abs(glm::dot(glm::vec3{ 1.0f, 0.0f, 0.0f }, up)) +
-        std::abs(glm::dot(glm::vec3{ 1.0f, 0.0f, 0.0f }, forward));
+std::size_t MeshRenderer::GetDrawCallCount() const {
+    return std::count_if(meshes->begin(), meshes->end(), [](const std::shared_ptr<Mesh>& mesh) { return mesh->material != nullptr; });
+}
 
-    extents.y =
-        std::abs(glm::dot(glm::vec3{ 0.0f, 1.0f, 0.0f }, right)) +
-        std::abs(glm::dot(glm::vec3{ 0.0f, 1.0f, 0.0f }, up)) +
-        std::abs(glm::dot(glm::vec3{ 0.0f, 1.0f, 0.0f }, forward));
+void MeshRenderer::UpdateLOD(const Camera& camera) {
+    if (forceLod >= 0) {
+        lodLevel_ = forceLod;
+        return;
+    }
+    lodLevel_ = LOD::SelectLevel(LOD::GetScreenSize(worldAabb_, camera) * lodBias, lodScreenSizes_, lodLevel_);
+}
 
-    extents.z =
-        std::abs(glm::dot(glm::vec3{ 0.0f, 0.0f, 1.0f }, right)) +
-        std::abs(glm::dot(glm::vec3{ 0.0f, 0.0f, 1.0f }, up)) +
-        std::abs(glm::dot(glm::vec3{ 0.0f, 0.0f, 1.0f }, forward));
+int MeshRenderer::GetLODLevel() const {
+    return lodLevel_;
+}
 
-    //We not need to divise scale because it's based on the half extention of the AABB
-    ViewFrustum::AABB newAABB { center, extents };
-    return frustum.IsOnFrustum(newAABB);
+const glm::mat4& MeshRenderer::GetModelMatrix() const {
+    return modelMatrix_;
 }
 
 const ViewFrustum::AABB& MeshRenderer::GetAABB() const {
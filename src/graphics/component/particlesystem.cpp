@@ -0,0 +1,218 @@
+#include <latren/graphics/component/particlesystem.h>
+#include <latren/graphics/renderer.h>
+#include <latren/threads/threadpool.h>
+#include <latren/systems.h>
+#include <latren/ec/transform.h>
+
+#include <algorithm>
+#include <cstddef>
+
+// per job when the simulation and the instance writes are split across the thread pool,
+// anything smaller than this just runs on the calling thread
+const std::size_t MIN_PARTICLES_PER_JOB = 16384;
+// 320 kb of instances, keeps a single draw well within a stream buffer segment
+const std::size_t MAX_PARTICLES_PER_DRAW = 16384;
+
+using namespace Particles;
+
+ParticleSystem::ParticleSystem() {
+    renderPass.Get() = RenderPass::LATE;
+}
+
+float ParticleSystem::Random() {
+    // xorshift32, plenty for particles
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return (random_ >> 8) * (1.0f / 16777216.0f);
+}
+
+float ParticleSystem::Random(const glm::vec2& range) {
+    return range.x + (range.y - range.x) * Random();
+}
+
+void ParticleSystem::Start() {
+    Renderable::Start();
+    particles_.Reserve(static_cast<std::size_t>(std::max(maxParticles.Get(), 0)));
+    UpdateCurves();
+    // seeded per emitter so that systems spawned on the same frame don't look identical
+    random_ ^= static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(this) >> 4);
+    if (random_ == 0)
+        random_ = 0x9e3779b9;
+
+    glGenVertexArrays(1, &vao_);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, Systems::GetRenderer().GetStreamBuffer().GetBuffer());
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribDivisor(1, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    Emit(burst);
+}
+
+void ParticleSystem::Delete() {
+    if (vao_ != GL_NONE)
+        GLState::DeleteVertexArray(vao_);
+    vao_ = GL_NONE;
+    particles_.Reserve(0);
+}
+
+void ParticleSystem::UpdateCurves() {
+    colorCurve_.Set(colorOverLife);
+    sizeCurve_.Set(sizeOverLife);
+    maxSizeScale_ = 1.0f;
+    if (!sizeOverLife->empty())
+        maxSizeScale_ = *std::max_element(sizeOverLife->begin(), sizeOverLife->end());
+}
+
+void ParticleSystem::Emit(int count) {
+    if (count <= 0)
+        return;
+    const Transform& transform = parent.GetTransform();
+    glm::vec3 origin = transform.position.Get() + offset.Get();
+    glm::vec3 dir = glm::mat3_cast(transform.rotation->GetOrientation()) * direction.Get();
+    dir = glm::length(dir) > 0.0f ? glm::normalize(dir) : glm::vec3(0.0f, 1.0f, 0.0f);
+    // basis around the direction for the cone
+    glm::vec3 tangent = glm::normalize(glm::cross(dir, std::abs(dir.y) < .99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f)));
+    glm::vec3 bitangent = glm::cross(dir, tangent);
+    float cosSpread = std::cos(glm::radians(std::clamp(spread.Get(), 0.0f, 180.0f)));
+
+    for (int n = 0; n < count; n++) {
+        std::size_t i = particles_.Add();
+        if (i == particles_.GetCapacity())
+            break;
+        // uniform over the spherical cap
+        float cosTheta = 1.0f - Random() * (1.0f - cosSpread);
+        float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+        float phi = Random() * glm::two_pi<float>();
+        glm::vec3 v = (tangent * std::cos(phi) * sinTheta + bitangent * std::sin(phi) * sinTheta + dir * cosTheta) * Random(speed);
+        glm::vec3 p = origin;
+        if (emitRadius > 0.0f) {
+            glm::vec3 r;
+            do {
+                r = glm::vec3(Random(), Random(), Random()) * 2.0f - 1.0f;
+            } while (glm::dot(r, r) > 1.0f);
+            p += r * emitRadius.Get();
+        }
+        particles_.posX[i] = p.x;
+        particles_.posY[i] = p.y;
+        particles_.posZ[i] = p.z;
+        particles_.velX[i] = v.x;
+        particles_.velY[i] = v.y;
+        particles_.velZ[i] = v.z;
+        particles_.life[i] = 0.0f;
+        particles_.invLifetime[i] = 1.0f / std::max(Random(lifetime), .001f);
+        particles_.size[i] = Random(size);
+    }
+}
+
+void ParticleSystem::Clear() {
+    particles_.Clear();
+    bounds_ = Bounds();
+    emitAccumulator_ = 0.0f;
+}
+
+void ParticleSystem::Update() {
+    float dt = static_cast<float>(Systems::GetDeltaTime());
+    if (dt <= 0.0f)
+        return;
+    if (emitting) {
+        emitAccumulator_ += emitRate * dt;
+        int count = static_cast<int>(emitAccumulator_);
+        emitAccumulator_ -= count;
+        Emit(count);
+    }
+
+    std::size_t count = particles_.GetCount();
+    Threads::ThreadPool& pool = Systems::GetThreadPool();
+    chunkBounds_.resize(pool.GetChunkCount(count, MIN_PARTICLES_PER_JOB));
+    // the bounds are taken while the chunk is still in the cache, the ones that die here are
+    // included for this frame but that only makes the box a bit bigger
+    pool.ParallelFor(count, MIN_PARTICLES_PER_JOB, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        Simulate(particles_, begin, end, dt, gravity, drag);
+        chunkBounds_[chunk] = ComputeBounds(particles_, begin, end);
+    });
+    particles_.RemoveDead();
+
+    bounds_ = Bounds();
+    for (const Bounds& b : chunkBounds_)
+        bounds_.Merge(b);
+}
+
+std::size_t ParticleSystem::GetParticleCount() const {
+    return particles_.GetCount();
+}
+
+bool ParticleSystem::GetWorldAABB(ViewFrustum::AABB& aabb) const {
+    if (bounds_.IsEmpty() || particles_.GetCount() == 0) {
+        // nothing to see, but an emitter outside the view should still get culled
+        aabb = ViewFrustum::AABB::FromMinMax(GetPosition(), GetPosition());
+        return true;
+    }
+    // the quads stick out of the positions by half of the size
+    glm::vec3 padding = glm::vec3(size->y * maxSizeScale_ * .5f);
+    aabb = ViewFrustum::AABB::FromMinMax(bounds_.min - padding, bounds_.max + padding);
+    return true;
+}
+
+std::size_t ParticleSystem::GetDrawCallCount() const {
+    return (particles_.GetCount() + MAX_PARTICLES_PER_DRAW - 1) / MAX_PARTICLES_PER_DRAW;
+}
+
+void ParticleSystem::Render(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& viewPos, const Shader*, int renderMode) const {
+    std::size_t count = particles_.GetCount();
+    if (renderMode != RENDER_MODE_NORMAL || count == 0 || vao_ == GL_NONE)
+        return;
+    Renderer& renderer = Systems::GetRenderer();
+    GLState& state = renderer.GetGLState();
+    StreamBuffer& stream = renderer.GetStreamBuffer();
+    Threads::ThreadPool& pool = Systems::GetThreadPool();
+
+    // always the particle shader since it needs the instance layout, the material only gives the texture and color
+    if (material.Get() != nullptr) {
+        material.Get()->Use(SHADER_);
+    }
+    else {
+        SHADER_.Use();
+        SHADER_.SetUniform("material.hasTexture", false);
+        SHADER_.SetUniform("material.color", glm::vec3(1.0f));
+        SHADER_.SetUniform("material.opacity", 1.0f);
+    }
+    state.Disable(GL_CULL_FACE);
+    state.DepthMask(false);
+    if (additive)
+        state.BlendFunc(GL_SRC_ALPHA, GL_ONE);
+    state.BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.GetBuffer());
+
+    const std::uint32_t* order = nullptr;
+    if (sortByDepth && !additive) {
+        // the camera looks down -z in view space, so the forward vector is the negated third row
+        glm::vec3 forward = -glm::vec3(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2]);
+        order = sorter_.Sort(particles_, viewPos, forward).data();
+    }
+
+    for (std::size_t first = 0; first < count; first += MAX_PARTICLES_PER_DRAW) {
+        std::size_t n = std::min(count - first, MAX_PARTICLES_PER_DRAW);
+        StreamBuffer::Allocation alloc = stream.Allocate(n * sizeof(Instance), sizeof(Instance));
+        if (alloc.data == nullptr)
+            break;
+        Instance* instances = static_cast<Instance*>(alloc.data);
+        // every job writes its own range of the mapped memory, nothing in here touches gl
+        pool.ParallelFor(n, MIN_PARTICLES_PER_JOB, [&](std::size_t, std::size_t begin, std::size_t end) {
+            WriteInstances(particles_, order, first + begin, first + end, colorCurve_, sizeCurve_, instances + begin);
+        });
+        stream.Commit(alloc);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void*>(alloc.offset));
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance), reinterpret_cast<void*>(alloc.offset + offsetof(Instance, color)));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(n));
+        GLState::CountDraw(GL_TRIANGLE_STRIP, 4, n);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    state.DepthMask(true);
+    if (additive)
+        state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
\ No newline at end of file
@@ -0,0 +1,531 @@
+#include <latren/graphics/compressedtexture.h>
+
+#include <spdlog/spdlog.h>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+using namespace Texture;
+
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+    return (uint32_t) (uint8_t) a | ((uint32_t) (uint8_t) b << 8) | ((uint32_t) (uint8_t) c << 16) | ((uint32_t) (uint8_t) d << 24);
+}
+
+// dds
+const uint32_t DDS_MAGIC = MakeFourCC('D', 'D', 'S', ' ');
+const std::size_t DDS_HEADER_SIZE = 124;
+const std::size_t DDS_DX10_HEADER_SIZE = 20;
+const uint32_t DDSD_CAPS = 0x1;
+const uint32_t DDSD_HEIGHT = 0x2;
+const uint32_t DDSD_WIDTH = 0x4;
+const uint32_t DDSD_PIXELFORMAT = 0x1000;
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDSD_LINEARSIZE = 0x80000;
+const uint32_t DDPF_FOURCC = 0x4;
+const uint32_t DDSCAPS_COMPLEX = 0x8;
+const uint32_t DDSCAPS_TEXTURE = 0x1000;
+const uint32_t DDSCAPS_MIPMAP = 0x400000;
+const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+const uint32_t DDSCAPS2_VOLUME = 0x200000;
+const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+const uint32_t DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+const uint32_t DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+const uint32_t DXGI_FORMAT_BC4_UNORM = 80;
+const uint32_t DXGI_FORMAT_BC5_UNORM = 83;
+const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+const uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+// way over what any driver takes, just so that the sizes can't overflow
+const int MAX_TEXTURE_SIZE = 1 << 16;
+
+// ktx2
+const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+const std::size_t KTX2_HEADER_SIZE = 80;
+const std::size_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+const uint32_t VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+const uint32_t VK_FORMAT_BC3_SRGB_BLOCK = 138;
+const uint32_t VK_FORMAT_BC4_UNORM_BLOCK = 139;
+const uint32_t VK_FORMAT_BC5_UNORM_BLOCK = 141;
+const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+const uint32_t VK_FORMAT_BC7_SRGB_BLOCK = 146;
+const uint32_t VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147;
+const uint32_t VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK = 148;
+const uint32_t VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK = 151;
+const uint32_t VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK = 152;
+
+template <typename T>
+T ReadValue(const std::vector<uint8_t>& buffer, std::size_t offset) {
+    T value;
+    std::memcpy(&value, buffer.data() + offset, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void WriteValue(std::vector<uint8_t>& buffer, std::size_t offset, T value) {
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+bool ReadFileBytes(const std::fs::path& path, std::vector<uint8_t>& buffer) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    buffer.resize(static_cast<std::size_t>(size));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(buffer.data()), size));
+}
+
+std::string LowercaseExtension(const std::fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char) std::tolower(c); });
+    return ext;
+}
+
+bool Texture::IsCompressedTexturePath(const std::fs::path& path) {
+    std::string ext = LowercaseExtension(path);
+    return ext == ".dds" || ext == ".ktx2";
+}
+
+std::fs::path Texture::FindCompressedVariant(const std::fs::path& path) {
+    for (const char* ext : { ".ktx2", ".dds" }) {
+        std::fs::path variant = path;
+        variant.replace_extension(ext);
+        if (std::fs::exists(variant))
+            return variant;
+    }
+    return std::fs::path();
+}
+
+bool Texture::LoadCompressedImage(const std::fs::path& path, CompressedImage& image) {
+    std::string ext = LowercaseExtension(path);
+    if (ext == ".dds")
+        return LoadDDS(path, image);
+    if (ext == ".ktx2")
+        return LoadKTX2(path, image);
+    return false;
+}
+
+// a full mip chain down to 1x1, the level counts in the headers can't be trusted
+int GetMaxLevelCount(int width, int height) {
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size >>= 1)
+        levels++;
+    return levels;
+}
+
+// fills the levels from consecutive data, the way dds stores them
+bool ReadLevels(const std::vector<uint8_t>& buffer, std::size_t offset, int width, int height, int levelCount, CompressedImage& image) {
+    image.levels.clear();
+    if (width <= 0 || height <= 0 || width > MAX_TEXTURE_SIZE || height > MAX_TEXTURE_SIZE)
+        return false;
+    levelCount = std::min(levelCount, GetMaxLevelCount(width, height));
+    for (int i = 0; i < levelCount; i++) {
+        int w = std::max(1, width >> i);
+        int h = std::max(1, height >> i);
+        std::size_t size = GetCompressedLevelSize(image.format, w, h);
+        if (offset + size > buffer.size()) {
+            // some exporters leave out the smallest levels, a partial chain is still fine
+            if (i > 0)
+                break;
+            return false;
+        }
+        image.levels.push_back({ w, h, std::vector<uint8_t>(buffer.begin() + offset, buffer.begin() + offset + size) });
+        offset += size;
+    }
+    return !image.levels.empty();
+}
+
+bool Texture::LoadDDS(const std::fs::path& path, CompressedImage& image) {
+    std::vector<uint8_t> buffer;
+    if (!ReadFileBytes(path, buffer) || buffer.size() < 4 + DDS_HEADER_SIZE || ReadValue<uint32_t>(buffer, 0) != DDS_MAGIC) {
+        spdlog::warn("Not a DDS file!");
+        return false;
+    }
+    uint32_t flags = ReadValue<uint32_t>(buffer, 8);
+    int height = static_cast<int>(ReadValue<uint32_t>(buffer, 12));
+    int width = static_cast<int>(ReadValue<uint32_t>(buffer, 16));
+    uint32_t mipCount = ReadValue<uint32_t>(buffer, 28);
+    uint32_t pixelFormatFlags = ReadValue<uint32_t>(buffer, 80);
+    uint32_t fourCC = ReadValue<uint32_t>(buffer, 84);
+    uint32_t caps2 = ReadValue<uint32_t>(buffer, 112);
+    if ((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) != 0) {
+        spdlog::warn("DDS cubemaps and volume textures aren't supported!");
+        return false;
+    }
+    if ((pixelFormatFlags & DDPF_FOURCC) == 0) {
+        spdlog::warn("Uncompressed DDS files aren't supported!");
+        return false;
+    }
+
+    std::size_t dataOffset = 4 + DDS_HEADER_SIZE;
+    image.format = CompressedFormat::NONE;
+    if (fourCC == MakeFourCC('D', 'X', 'T', '1'))
+        image.format = CompressedFormat::BC1;
+    else if (fourCC == MakeFourCC('D', 'X', 'T', '5'))
+        image.format = CompressedFormat::BC3;
+    else if (fourCC == MakeFourCC('A', 'T', 'I', '1') || fourCC == MakeFourCC('B', 'C', '4', 'U'))
+        image.format = CompressedFormat::BC4;
+    else if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U'))
+        image.format = CompressedFormat::BC5;
+    else if (fourCC == MakeFourCC('D', 'X', '1', '0')) {
+        if (buffer.size() < dataOffset + DDS_DX10_HEADER_SIZE)
+            return false;
+        uint32_t dxgiFormat = ReadValue<uint32_t>(buffer, dataOffset);
+        uint32_t dimension = ReadValue<uint32_t>(buffer, dataOffset + 4);
+        uint32_t arraySize = ReadValue<uint32_t>(buffer, dataOffset + 12);
+        dataOffset += DDS_DX10_HEADER_SIZE;
+        if (dimension != DDS_DIMENSION_TEXTURE2D || arraySize > 1) {
+            spdlog::warn("Only single 2D textures are supported in DDS files!");
+            return false;
+        }
+        // the renderer doesn't do srgb, so they're read the same way as the unorm ones
+        switch (dxgiFormat) {
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+                image.format = CompressedFormat::BC1;
+                break;
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+                image.format = CompressedFormat::BC3;
+                break;
+            case DXGI_FORMAT_BC4_UNORM:
+                image.format = CompressedFormat::BC4;
+                break;
+            case DXGI_FORMAT_BC5_UNORM:
+                image.format = CompressedFormat::BC5;
+                break;
+            case DXGI_FORMAT_BC7_UNORM:
+            case DXGI_FORMAT_BC7_UNORM_SRGB:
+                image.format = CompressedFormat::BC7;
+                break;
+        }
+    }
+    if (image.format == CompressedFormat::NONE) {
+        spdlog::warn("Unsupported DDS format!");
+        return false;
+    }
+    int levelCount = (flags & DDSD_MIPMAPCOUNT) != 0 ? static_cast<int>(std::clamp<uint32_t>(mipCount, 1, 32)) : 1;
+    return ReadLevels(buffer, dataOffset, width, height, levelCount, image);
+}
+
+bool Texture::LoadKTX2(const std::fs::path& path, CompressedImage& image) {
+    std::vector<uint8_t> buffer;
+    if (!ReadFileBytes(path, buffer) || buffer.size() < KTX2_HEADER_SIZE || std::memcmp(buffer.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        spdlog::warn("Not a KTX2 file!");
+        return false;
+    }
+    uint32_t vkFormat = ReadValue<uint32_t>(buffer, 12);
+    int width = static_cast<int>(ReadValue<uint32_t>(buffer, 20));
+    int height = static_cast<int>(ReadValue<uint32_t>(buffer, 24));
+    uint32_t depth = ReadValue<uint32_t>(buffer, 28);
+    uint32_t layerCount = ReadValue<uint32_t>(buffer, 32);
+    uint32_t faceCount = ReadValue<uint32_t>(buffer, 36);
+    uint32_t levelCount = std::max<uint32_t>(ReadValue<uint32_t>(buffer, 40), 1);
+    uint32_t supercompression = ReadValue<uint32_t>(buffer, 44);
+    if (depth > 0 || layerCount > 1 || faceCount != 1) {
+        spdlog::warn("Only single 2D textures are supported in KTX2 files!");
+        return false;
+    }
+    if (supercompression != 0) {
+        spdlog::warn("Supercompressed KTX2 files (Basis, zstd) aren't supported!");
+        return false;
+    }
+
+    image.format = CompressedFormat::NONE;
+    if (vkFormat >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && vkFormat <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK)
+        image.format = CompressedFormat::BC1;
+    else if (vkFormat == VK_FORMAT_BC3_UNORM_BLOCK || vkFormat == VK_FORMAT_BC3_SRGB_BLOCK)
+        image.format = CompressedFormat::BC3;
+    else if (vkFormat == VK_FORMAT_BC4_UNORM_BLOCK)
+        image.format = CompressedFormat::BC4;
+    else if (vkFormat == VK_FORMAT_BC5_UNORM_BLOCK)
+        image.format = CompressedFormat::BC5;
+    else if (vkFormat == VK_FORMAT_BC7_UNORM_BLOCK || vkFormat == VK_FORMAT_BC7_SRGB_BLOCK)
+        image.format = CompressedFormat::BC7;
+    else if (vkFormat == VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK || vkFormat == VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK)
+        image.format = CompressedFormat::ETC2_RGB;
+    else if (vkFormat == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK || vkFormat == VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK)
+        image.format = CompressedFormat::ETC2_RGBA;
+    if (image.format == CompressedFormat::NONE) {
+        spdlog::warn("Unsupported KTX2 format ({})!", vkFormat);
+        return false;
+    }
+
+    if (width <= 0 || height <= 0 || width > MAX_TEXTURE_SIZE || height > MAX_TEXTURE_SIZE)
+        return false;
+    levelCount = std::min<uint32_t>(levelCount, GetMaxLevelCount(width, height));
+    if (buffer.size() < KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+        return false;
+    image.levels.clear();
+    // the level index goes from the biggest to the smallest, even though the data is stored the other way around
+    for (uint32_t i = 0; i < levelCount; i++) {
+        std::size_t entry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+        uint64_t offset = ReadValue<uint64_t>(buffer, entry);
+        uint64_t length = ReadValue<uint64_t>(buffer, entry + 8);
+        int w = std::max(1, width >> i);
+        int h = std::max(1, height >> i);
+        if (length < GetCompressedLevelSize(image.format, w, h) || offset > buffer.size() || length > buffer.size() - offset) {
+            spdlog::warn("Truncated KTX2 level {}!", i);
+            break;
+        }
+        image.levels.push_back({ w, h, std::vector<uint8_t>(buffer.begin() + offset, buffer.begin() + offset + GetCompressedLevelSize(image.format, w, h)) });
+    }
+    return !image.levels.empty();
+}
+
+bool Texture::SaveDDS(const std::fs::path& path, const CompressedImage& image) {
+    if (image.levels.empty())
+        return false;
+    uint32_t fourCC;
+    uint32_t dxgiFormat = 0;
+    switch (image.format) {
+        case CompressedFormat::BC1:
+            fourCC = MakeFourCC('D', 'X', 'T', '1');
+            break;
+        case CompressedFormat::BC3:
+            fourCC = MakeFourCC('D', 'X', 'T', '5');
+            break;
+        case CompressedFormat::BC4:
+            fourCC = MakeFourCC('A', 'T', 'I', '1');
+            break;
+        case CompressedFormat::BC5:
+            fourCC = MakeFourCC('A', 'T', 'I', '2');
+            break;
+        case CompressedFormat::BC7:
+            fourCC = MakeFourCC('D', 'X', '1', '0');
+            dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+            break;
+        default:
+            return false;
+    }
+    const CompressedImage::Level& base = image.levels.at(0);
+    bool hasMips = image.levels.size() > 1;
+    std::size_t headerSize = 4 + DDS_HEADER_SIZE + (dxgiFormat != 0 ? DDS_DX10_HEADER_SIZE : 0);
+    std::vector<uint8_t> header(headerSize, 0);
+    WriteValue<uint32_t>(header, 0, DDS_MAGIC);
+    WriteValue<uint32_t>(header, 4, (uint32_t) DDS_HEADER_SIZE);
+    WriteValue<uint32_t>(header, 8, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | (hasMips ? DDSD_MIPMAPCOUNT : 0));
+    WriteValue<uint32_t>(header, 12, (uint32_t) base.height);
+    WriteValue<uint32_t>(header, 16, (uint32_t) base.width);
+    WriteValue<uint32_t>(header, 20, (uint32_t) base.data.size());
+    WriteValue<uint32_t>(header, 28, (uint32_t) image.levels.size());
+    // pixel format
+    WriteValue<uint32_t>(header, 76, 32);
+    WriteValue<uint32_t>(header, 80, DDPF_FOURCC);
+    WriteValue<uint32_t>(header, 84, fourCC);
+    WriteValue<uint32_t>(header, 108, DDSCAPS_TEXTURE | (hasMips ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0));
+    if (dxgiFormat != 0) {
+        std::size_t dx10 = 4 + DDS_HEADER_SIZE;
+        WriteValue<uint32_t>(header, dx10, dxgiFormat);
+        WriteValue<uint32_t>(header, dx10 + 4, DDS_DIMENSION_TEXTURE2D);
+        WriteValue<uint32_t>(header, dx10 + 12, 1);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    for (const CompressedImage::Level& level : image.levels) {
+        file.write(reinterpret_cast<const char*>(level.data.data()), level.data.size());
+    }
+    return static_cast<bool>(file);
+}
+
+const char* Texture::GetCompressedFormatName(CompressedFormat format) {
+    switch (format) {
+        case CompressedFormat::BC1: return "BC1";
+        case CompressedFormat::BC3: return "BC3";
+        case CompressedFormat::BC4: return "BC4";
+        case CompressedFormat::BC5: return "BC5";
+        case CompressedFormat::BC7: return "BC7";
+        case CompressedFormat::ETC2_RGB: return "ETC2 RGB";
+        case CompressedFormat::ETC2_RGBA: return "ETC2 RGBA";
+        default: return "none";
+    }
+}
+
+GLenum Texture::GetCompressedGLFormat(CompressedFormat format) {
+    switch (format) {
+        // the rgba variant so that the 3-color blocks can still have their transparent texels
+        case CompressedFormat::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case CompressedFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case CompressedFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case CompressedFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case CompressedFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case CompressedFormat::ETC2_RGB: return GL_COMPRESSED_RGB8_ETC2;
+        case CompressedFormat::ETC2_RGBA: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        default: return GL_NONE;
+    }
+}
+
+std::size_t Texture::GetCompressedBlockSize(CompressedFormat format) {
+    switch (format) {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC4:
+        case CompressedFormat::ETC2_RGB:
+            return 8;
+        case CompressedFormat::BC3:
+        case CompressedFormat::BC5:
+        case CompressedFormat::BC7:
+        case CompressedFormat::ETC2_RGBA:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+std::size_t Texture::GetCompressedLevelSize(CompressedFormat format, int width, int height) {
+    std::size_t blocksX = std::max(1, (width + 3) / 4);
+    std::size_t blocksY = std::max(1, (height + 3) / 4);
+    return blocksX * blocksY * GetCompressedBlockSize(format);
+}
+
+bool Texture::IsCompressedFormatSupported(CompressedFormat format) {
+    switch (format) {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC3:
+            return GLEW_EXT_texture_compression_s3tc;
+        // rgtc is core since 3.0
+        case CompressedFormat::BC4:
+        case CompressedFormat::BC5:
+            return true;
+        case CompressedFormat::BC7:
+            return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+        case CompressedFormat::ETC2_RGB:
+        case CompressedFormat::ETC2_RGBA:
+            return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+        default:
+            return false;
+    }
+}
+
+bool Texture::CanDecodeCompressedFormat(CompressedFormat format) {
+    switch (format) {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC3:
+        case CompressedFormat::BC4:
+        case CompressedFormat::BC5:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// writes 16 rgba texels, in the bc2/bc3 color blocks the 3-color mode isn't used
+void DecodeBC1Block(const uint8_t* block, uint8_t* out, bool alwaysFourColors) {
+    uint16_t c0 = block[0] | (block[1] << 8);
+    uint16_t c1 = block[2] | (block[3] << 8);
+    auto expand565 = [](uint16_t c, uint8_t* rgba) {
+        int r = (c >> 11) & 31;
+        int g = (c >> 5) & 63;
+        int b = c & 31;
+        rgba[0] = (uint8_t) ((r << 3) | (r >> 2));
+        rgba[1] = (uint8_t) ((g << 2) | (g >> 4));
+        rgba[2] = (uint8_t) ((b << 3) | (b >> 2));
+        rgba[3] = 255;
+    };
+    uint8_t colors[4][4];
+    expand565(c0, colors[0]);
+    expand565(c1, colors[1]);
+    for (int i = 0; i < 3; i++) {
+        if (c0 > c1 || alwaysFourColors) {
+            colors[2][i] = (uint8_t) ((2 * colors[0][i] + colors[1][i] + 1) / 3);
+            colors[3][i] = (uint8_t) ((colors[0][i] + 2 * colors[1][i] + 1) / 3);
+        }
+        else {
+            colors[2][i] = (uint8_t) ((colors[0][i] + colors[1][i]) / 2);
+            colors[3][i] = 0;
+        }
+    }
+    colors[2][3] = 255;
+    colors[3][3] = (c0 > c1 || alwaysFourColors) ? 255 : 0;
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t) block[7] << 24);
+    for (int i = 0; i < 16; i++) {
+        std::memcpy(out + i * 4, colors[(indices >> (2 * i)) & 3], 4);
+    }
+}
+
+// writes 16 single-channel values, stride bytes apart
+void DecodeBC4Block(const uint8_t* block, uint8_t* out, int stride) {
+    int a0 = block[0];
+    int a1 = block[1];
+    uint8_t values[8];
+    values[0] = (uint8_t) a0;
+    values[1] = (uint8_t) a1;
+    if (a0 > a1) {
+        for (int i = 2; i < 8; i++)
+            values[i] = (uint8_t) (((8 - i) * a0 + (i - 1) * a1 + 3) / 7);
+    }
+    else {
+        for (int i = 2; i < 6; i++)
+            values[i] = (uint8_t) (((6 - i) * a0 + (i - 1) * a1 + 2) / 5);
+        values[6] = 0;
+        values[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++)
+        indices |= (uint64_t) block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++) {
+        out[i * stride] = values[(indices >> (3 * i)) & 7];
+    }
+}
+
+int Texture::DecodeCompressedLevel(CompressedFormat format, const CompressedImage::Level& level, std::vector<uint8_t>& pixels) {
+    int channels;
+    switch (format) {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC3:
+            channels = 4;
+            break;
+        case CompressedFormat::BC4:
+            channels = 1;
+            break;
+        case CompressedFormat::BC5:
+            channels = 2;
+            break;
+        default:
+            return 0;
+    }
+    if (level.data.size() < GetCompressedLevelSize(format, level.width, level.height))
+        return 0;
+    std::size_t blockSize = GetCompressedBlockSize(format);
+    int blocksX = std::max(1, (level.width + 3) / 4);
+    int blocksY = std::max(1, (level.height + 3) / 4);
+    pixels.resize((std::size_t) level.width * level.height * channels);
+    uint8_t texels[16 * 4];
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            const uint8_t* block = level.data.data() + ((std::size_t) by * blocksX + bx) * blockSize;
+            switch (format) {
+                case CompressedFormat::BC1:
+                    DecodeBC1Block(block, texels, false);
+                    break;
+                case CompressedFormat::BC3:
+                    DecodeBC1Block(block + 8, texels, true);
+                    DecodeBC4Block(block, texels + 3, 4);
+                    break;
+                case CompressedFormat::BC4:
+                    DecodeBC4Block(block, texels, 1);
+                    break;
+                case CompressedFormat::BC5:
+                    DecodeBC4Block(block, texels, 2);
+                    DecodeBC4Block(block + 8, texels + 1, 2);
+                    break;
+                default:
+                    break;
+            }
+            // the blocks hanging over the edge are cut off
+            for (int y = 0; y < 4 && by * 4 + y < level.height; y++) {
+                for (int x = 0; x < 4 && bx * 4 + x < level.width; x++) {
+                    std::size_t dst = ((std::size_t) (by * 4 + y) * level.width + bx * 4 + x) * channels;
+                    std::memcpy(pixels.data() + dst, texels + (y * 4 + x) * channels, channels);
+                }
+            }
+        }
+    }
+    return channels;
+}
\ No newline at end of file
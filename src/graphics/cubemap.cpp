@@ -1,4 +1,6 @@
 #include <latren/graphics/cubemap.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
 #include <latren/io/paths.h>
 
 #include <stb/stb_image.h>
@@ -34,7 +36,7 @@ Texture::TextureID Cubemap::LoadTextureFromDir(const std::string& dir, bool flip
 Texture::TextureID Cubemap::LoadTextureFromFaces(const std::string& dir, const char* const faces[6], bool flipHorizontally) {
     Texture::TextureID texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_CUBE_MAP, texture);
     std::fs::path resourceDir = ResourcePath(Paths::RESOURCE_DIRS.at(Resources::ResourceType::TEXTURE)).GetParsedPath();
     std::string textureDir = (resourceDir / std::fs::path(dir)).generic_string();
 
@@ -0,0 +1,174 @@
+#include <latren/graphics/culling.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LATREN_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace Culling;
+
+void BoundsArray::Resize(std::size_t count) {
+    count_ = count;
+    std::size_t padded = GetPaddedCount();
+    // the padding is filled with empty boxes at the origin, they get masked out anyway
+    for (std::vector<float>* v : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+        v->assign(padded, 0.0f);
+}
+
+void BoundsArray::Set(std::size_t i, const ViewFrustum::AABB& aabb) {
+    centerX[i] = aabb.center.x;
+    centerY[i] = aabb.center.y;
+    centerZ[i] = aabb.center.z;
+    extentX[i] = aabb.extents.x;
+    extentY[i] = aabb.extents.y;
+    extentZ[i] = aabb.extents.z;
+}
+
+std::size_t BoundsArray::GetCount() const {
+    return count_;
+}
+
+std::size_t BoundsArray::GetPaddedCount() const {
+    return (count_ + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+}
+
+void VisibilitySet::Resize(std::size_t count) {
+    bits_.assign((count + 63) / 64, 0);
+}
+
+void VisibilitySet::Clear() {
+    std::fill(bits_.begin(), bits_.end(), 0);
+}
+
+void VisibilitySet::Set(std::size_t i) {
+    bits_[i / 64] |= (std::uint64_t) 1 << (i % 64);
+}
+
+bool VisibilitySet::Test(std::size_t i) const {
+    return (bits_[i / 64] >> (i % 64)) & 1;
+}
+
+void VisibilitySet::Merge(const VisibilitySet& other) {
+    for (std::size_t i = 0; i < bits_.size() && i < other.bits_.size(); i++)
+        bits_[i] |= other.bits_[i];
+}
+
+void VisibilitySet::Subtract(const VisibilitySet& other) {
+    for (std::size_t i = 0; i < bits_.size() && i < other.bits_.size(); i++)
+        bits_[i] &= ~other.bits_[i];
+}
+
+std::size_t VisibilitySet::Count() const {
+    std::size_t count = 0;
+    for (std::uint64_t word : bits_)
+        count += std::bitset<64>(word).count();
+    return count;
+}
+
+std::vector<std::uint64_t>& VisibilitySet::GetWords() {
+    return bits_;
+}
+
+const std::vector<std::uint64_t>& VisibilitySet::GetWords() const {
+    return bits_;
+}
+
+Culling::FrustumTestResult Culling::TestFrustum(const ViewFrustum& frustum, const ViewFrustum::AABB& aabb, int& planeMask) {
+    const ViewFrustum::FrustumPlane* planes[6] = {
+        &frustum.left, &frustum.right, &frustum.top, &frustum.bottom, &frustum.nearClippingPlane, &frustum.farClippingPlane
+    };
+    for (int p = 0; p < 6; p++) {
+        if ((planeMask & (1 << p)) == 0)
+            continue;
+        const ViewFrustum::FrustumPlane& plane = *planes[p];
+        float r =
+            aabb.extents.x * std::abs(plane.normal.x) +
+            aabb.extents.y * std::abs(plane.normal.y) +
+            aabb.extents.z * std::abs(plane.normal.z);
+        float s = glm::dot(plane.normal, aabb.center) - plane.dist;
+        if (s < -r)
+            return FrustumTestResult::OUTSIDE;
+        if (s >= r)
+            planeMask &= ~(1 << p);
+    }
+    return planeMask == 0 ? FrustumTestResult::INSIDE : FrustumTestResult::INTERSECTS;
+}
+
+bool Culling::Intersects(const ViewFrustum::AABB& a, const ViewFrustum::AABB& b) {
+    glm::vec3 d = glm::abs(a.center - b.center);
+    glm::vec3 e = a.extents + b.extents;
+    return d.x <= e.x && d.y <= e.y && d.z <= e.z;
+}
+
+bool Culling::IntersectsSphere(const ViewFrustum::AABB& aabb, const glm::vec3& center, float radius) {
+    glm::vec3 closest = glm::clamp(center, aabb.GetMin(), aabb.GetMax());
+    glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+bool Culling::IntersectsRay(const ViewFrustum::AABB& aabb, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance, float& t) {
+    glm::vec3 t0 = (aabb.GetMin() - origin) * invDir;
+    glm::vec3 t1 = (aabb.GetMax() - origin) * invDir;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+    float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+    t = enter;
+    return enter <= exit;
+}
+
+void Culling::CullAABBs(const ViewFrustum& frustum, const BoundsArray& bounds, VisibilitySet& visibility) {
+    const ViewFrustum::FrustumPlane* planes[6] = {
+        &frustum.left, &frustum.right, &frustum.top, &frustum.bottom, &frustum.nearClippingPlane, &frustum.farClippingPlane
+    };
+    std::size_t count = bounds.GetCount();
+    visibility.Resize(count);
+    std::vector<std::uint64_t>& words = visibility.GetWords();
+
+    #ifdef LATREN_CULLING_SSE
+    __m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+    for (int p = 0; p < 6; p++) {
+        nx[p] = _mm_set1_ps(planes[p]->normal.x);
+        ny[p] = _mm_set1_ps(planes[p]->normal.y);
+        nz[p] = _mm_set1_ps(planes[p]->normal.z);
+        ax[p] = _mm_set1_ps(std::abs(planes[p]->normal.x));
+        ay[p] = _mm_set1_ps(std::abs(planes[p]->normal.y));
+        az[p] = _mm_set1_ps(std::abs(planes[p]->normal.z));
+        d[p] = _mm_set1_ps(planes[p]->dist);
+    }
+    for (std::size_t i = 0; i < count; i += BATCH_SIZE) {
+        __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            // projected radius of the box onto the plane normal
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])), _mm_mul_ps(ez, az[p]));
+            // signed distance from the plane to the center
+            __m128 s = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx[p]), _mm_mul_ps(cy, ny[p])), _mm_mul_ps(cz, nz[p])), d[p]);
+            inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(_mm_setzero_ps(), r), s));
+        }
+        std::uint64_t mask = (std::uint64_t) _mm_movemask_ps(inside);
+        // BATCH_SIZE divides 64 so a batch never crosses a word
+        words[i / 64] |= mask << (i % 64);
+    }
+    // the padding might've set some bits past the end
+    if (count % 64 != 0)
+        words.back() &= ((std::uint64_t) 1 << (count % 64)) - 1;
+    #else
+    for (std::size_t i = 0; i < count; i++) {
+        ViewFrustum::AABB aabb;
+        aabb.center = glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+        aabb.extents = glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+        if (frustum.IsOnFrustum(aabb))
+            visibility.Set(i);
+    }
+    #endif
+}
\ No newline at end of file
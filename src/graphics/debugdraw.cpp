@@ -0,0 +1,168 @@
+#include <latren/graphics/debugdraw.h>
+#include <latren/graphics/renderer.h>
+#include <latren/ui/text.h>
+#include <latren/io/resourcemanager.h>
+#include <latren/systems.h>
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/constants.hpp>
+
+// the stream buffer segments are 1 MiB, keep each upload well under that
+const std::size_t MAX_VERTICES_PER_DRAW = 32768;
+const int SPHERE_SEGMENTS = 16;
+
+void DebugDraw::Init(GLuint streamBuffer) {
+    shader_ = Shader(Shaders::ShaderID::DEBUG);
+    glGenVertexArrays(1, &vao_);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, pos)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, color)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Systems::GetRenderer().GetGLState().BindVertexArray(0);
+}
+
+void DebugDraw::Delete() {
+    if (vao_ != GL_NONE)
+        GLState::DeleteVertexArray(vao_);
+    vao_ = GL_NONE;
+    Clear();
+}
+
+void DebugDraw::Line(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color) {
+    GLuint c = glm::packUnorm4x8(color);
+    lines_.push_back({ from, c });
+    lines_.push_back({ to, c });
+}
+
+void DebugDraw::Point(const glm::vec3& pos, const glm::vec4& color) {
+    points_.push_back({ pos, glm::packUnorm4x8(color) });
+}
+
+void DebugDraw::Box(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color) {
+    Box(min, max, glm::mat4(1.0f), color);
+}
+
+void DebugDraw::Box(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, const glm::vec4& color) {
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner = glm::vec3(
+            (i & 1) ? max.x : min.x,
+            (i & 2) ? max.y : min.y,
+            (i & 4) ? max.z : min.z
+        );
+        corners[i] = transform * glm::vec4(corner, 1.0f);
+    }
+    // every pair of corners that differ by exactly one bit is an edge
+    for (int i = 0; i < 8; i++) {
+        for (int bit = 1; bit < 8; bit <<= 1) {
+            if ((i & bit) == 0)
+                Line(corners[i], corners[i | bit], color);
+        }
+    }
+}
+
+void DebugDraw::Sphere(const glm::vec3& center, float radius, const glm::vec4& color) {
+    // three great circles
+    float step = glm::two_pi<float>() / SPHERE_SEGMENTS;
+    for (int i = 0; i < SPHERE_SEGMENTS; i++) {
+        float a0 = i * step;
+        float a1 = (i + 1) * step;
+        glm::vec2 p0 = glm::vec2(std::cos(a0), std::sin(a0)) * radius;
+        glm::vec2 p1 = glm::vec2(std::cos(a1), std::sin(a1)) * radius;
+        Line(center + glm::vec3(p0.x, p0.y, 0.0f), center + glm::vec3(p1.x, p1.y, 0.0f), color);
+        Line(center + glm::vec3(p0.x, 0.0f, p0.y), center + glm::vec3(p1.x, 0.0f, p1.y), color);
+        Line(center + glm::vec3(0.0f, p0.x, p0.y), center + glm::vec3(0.0f, p1.x, p1.y), color);
+    }
+}
+
+void DebugDraw::Frustum(const glm::mat4& viewProjection, const glm::vec4& color) {
+    // the ndc cube back in world space
+    glm::mat4 inv = glm::inverse(viewProjection);
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 corner = inv * glm::vec4(
+            (i & 1) ? 1.0f : -1.0f,
+            (i & 2) ? 1.0f : -1.0f,
+            (i & 4) ? 1.0f : -1.0f,
+            1.0f
+        );
+        corners[i] = glm::vec3(corner) / corner.w;
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int bit = 1; bit < 8; bit <<= 1) {
+            if ((i & bit) == 0)
+                Line(corners[i], corners[i | bit], color);
+        }
+    }
+}
+
+void DebugDraw::Marker(const glm::vec3& pos, const std::string& text, const glm::vec4& color) {
+    Point(pos, color);
+    if (!text.empty())
+        markers_.push_back({ pos, color, text });
+}
+
+void DebugDraw::DrawVertices(const std::vector<Vertex>& vertices, GLenum mode) {
+    if (vertices.empty())
+        return;
+    StreamBuffer& stream = Systems::GetRenderer().GetStreamBuffer();
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao_);
+    // usually this is just one iteration, only split up if there's a crazy amount of stuff queued
+    for (std::size_t first = 0; first < vertices.size(); first += MAX_VERTICES_PER_DRAW) {
+        std::size_t count = std::min(MAX_VERTICES_PER_DRAW, vertices.size() - first);
+        StreamBuffer::Allocation a = stream.Upload(&vertices[first], count * sizeof(Vertex), sizeof(Vertex));
+        if (a.data == nullptr)
+            break;
+        glDrawArrays(mode, a.first, (GLsizei) count);
+        GLState::CountDraw(mode, count);
+    }
+}
+
+void DebugDraw::DrawMarkerLabels(const glm::mat4& viewProjection) {
+    if (markers_.empty() || !Systems::GetResources().GetFontManager()->HasLoaded(markerFont))
+        return;
+    const UI::Text::Font& font = Systems::GetResources().GetFontManager()->Get(markerFont);
+    Shader textShader = Shader(Shaders::ShaderID::UI_TEXT);
+    textShader.Use();
+    // same virtual resolution as the ui
+    textShader.SetUniform("projection", glm::ortho(0.0f, 1280.0f, 0.0f, 720.0f));
+    for (const TextMarker& marker : markers_) {
+        glm::vec4 clip = viewProjection * glm::vec4(marker.pos, 1.0f);
+        if (clip.w <= 0.0f)
+            continue;
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        glm::vec2 screenPos = (ndc * 0.5f + 0.5f) * glm::vec2(1280.0f, 720.0f);
+        textShader.SetUniform("textColor", marker.color);
+        UI::Text::RenderText(font, marker.text, screenPos + glm::vec2(pointSize), .35f * font.GetSizeModifier(), 1.0f);
+    }
+}
+
+void DebugDraw::Flush(const glm::mat4& viewProjection) {
+    if (!lines_.empty() || !points_.empty()) {
+        shader_.Use();
+        DrawVertices(lines_, GL_LINES);
+        glPointSize(pointSize);
+        DrawVertices(points_, GL_POINTS);
+        glPointSize(1.0f);
+    }
+    if (!markers_.empty()) {
+        Systems::GetRenderer().GetGLState().Disable(GL_DEPTH_TEST);
+        DrawMarkerLabels(viewProjection);
+        Systems::GetRenderer().GetGLState().Enable(GL_DEPTH_TEST);
+    }
+    Clear();
+}
+
+void DebugDraw::Clear() {
+    // clear() keeps the capacity so the vectors stop allocating after the first few frames
+    lines_.clear();
+    points_.clear();
+    markers_.clear();
+}
+
+std::size_t DebugDraw::GetQueuedVertexCount() const {
+    return lines_.size() + points_.size();
+}
\ No newline at end of file
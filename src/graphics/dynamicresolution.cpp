@@ -0,0 +1,103 @@
+#include <latren/graphics/dynamicresolution.h>
+
+#include <algorithm>
+#include <cmath>
+
+// how much of the new sample goes into the smoothed frame time
+const float FRAME_TIME_SMOOTHING = .2f;
+// frames to wait after a change so the smoothed time catches up with the new scale
+const int ADJUST_INTERVAL = 10;
+// don't bother with changes smaller than this
+const float MIN_SCALE_CHANGE = .02f;
+const float MAX_SCALE_CHANGE = .1f;
+// frames between this and the target are fine as they are
+const float TARGET_HEADROOM = .9f;
+
+void DynamicResolution::Init() {
+    glGenQueries(QUERIES, queries_.data());
+    pending_.fill(false);
+    query_ = 0;
+    scale_ = 1.0f;
+    gpuFrameTime_ = 0.0f;
+}
+
+void DynamicResolution::Delete() {
+    if (queries_[0] != GL_NONE)
+        glDeleteQueries(QUERIES, queries_.data());
+    queries_.fill(GL_NONE);
+    pending_.fill(false);
+}
+
+void DynamicResolution::BeginFrame() {
+    if (queries_[0] == GL_NONE)
+        return;
+    // oldest first, query_ is the one that was used QUERIES frames ago
+    for (int i = 0; i < QUERIES; i++) {
+        int q = (query_ + i) % QUERIES;
+        if (!pending_[q])
+            continue;
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(queries_[q], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries_[q], GL_QUERY_RESULT, &elapsed);
+        pending_[q] = false;
+        float ms = static_cast<float>(elapsed) / 1000000.0f;
+        gpuFrameTime_ = gpuFrameTime_ == 0.0f ? ms : gpuFrameTime_ + (ms - gpuFrameTime_) * FRAME_TIME_SMOOTHING;
+        framesSinceChange_++;
+    }
+    Adjust();
+    // the gpu is more than QUERIES frames behind, skip measuring this one rather than waiting for it
+    running_ = !pending_[query_];
+    if (running_)
+        glBeginQuery(GL_TIME_ELAPSED, queries_[query_]);
+}
+
+void DynamicResolution::EndFrame() {
+    if (!running_)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending_[query_] = true;
+    query_ = (query_ + 1) % QUERIES;
+    running_ = false;
+}
+
+void DynamicResolution::Adjust() {
+    if (!enabled) {
+        scale_ = 1.0f;
+        return;
+    }
+    float maxScale = std::clamp(this->maxScale, .1f, 1.0f);
+    float minScale = std::clamp(this->minScale, .1f, maxScale);
+    scale_ = std::clamp(scale_, minScale, maxScale);
+    if (gpuFrameTime_ <= 0.0f || framesSinceChange_ < ADJUST_INTERVAL)
+        return;
+    if (gpuFrameTime_ <= targetFrameTime && gpuFrameTime_ >= targetFrameTime * TARGET_HEADROOM)
+        return;
+    // the cost goes with the pixel count, so the scale with the square root
+    // aiming at the middle of the headroom so it doesn't just bounce off the edges
+    float aim = targetFrameTime * (1.0f + TARGET_HEADROOM) * .5f;
+    float wanted = scale_ * std::sqrt(aim / gpuFrameTime_);
+    wanted = std::clamp(wanted, scale_ - MAX_SCALE_CHANGE, scale_ + MAX_SCALE_CHANGE);
+    wanted = std::clamp(wanted, minScale, maxScale);
+    if (std::abs(wanted - scale_) < MIN_SCALE_CHANGE)
+        return;
+    scale_ = wanted;
+    framesSinceChange_ = 0;
+}
+
+float DynamicResolution::GetScale() const {
+    return scale_;
+}
+
+float DynamicResolution::GetGPUFrameTime() const {
+    return gpuFrameTime_;
+}
+
+glm::ivec2 DynamicResolution::GetRenderSize(const glm::ivec2& size) const {
+    return glm::ivec2(
+        std::max(static_cast<int>(size.x * scale_), 1),
+        std::max(static_cast<int>(size.y * scale_), 1)
+    );
+}
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include <latren/graphics/glstate.h>
+
+#include <spdlog/spdlog.h>
+
+const GLenum CAPABILITIES[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_DEPTH_CLAMP, GL_MULTISAMPLE };
+
+GLState* GLState::instance_ = nullptr;
+
+GLState::GLState() {
+    Invalidate();
+    instance_ = this;
+}
+
+GLState::~GLState() {
+    if (instance_ == this)
+        instance_ = nullptr;
+}
+
+void GLState::Invalidate() {
+    program_ = UNKNOWN;
+    vao_ = UNKNOWN;
+    activeTexture_ = UNKNOWN;
+    for (auto& unit : textures_)
+        unit.fill(UNKNOWN);
+    capabilities_.fill(UNKNOWN);
+    depthFunc_ = UNKNOWN;
+    depthMask_ = UNKNOWN;
+    cullFace_ = UNKNOWN;
+    blendFunc_.fill(UNKNOWN);
+    scissor_.fill(UNKNOWN);
+    viewport_.fill(UNKNOWN);
+}
+
+const GLState::Counters& GLState::GetCounters() const {
+    return counters_;
+}
+
+void GLState::ResetCounters() {
+    counters_ = Counters();
+}
+
+int GLState::GetTextureTarget(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D: return TEXTURE_2D;
+        case GL_TEXTURE_2D_MULTISAMPLE: return TEXTURE_2D_MULTISAMPLE;
+        case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+        case GL_TEXTURE_BUFFER: return TEXTURE_BUFFER;
+        default: return -1;
+    }
+}
+
+GLenum GLState::GetTextureBinding(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D: return GL_TEXTURE_BINDING_2D;
+        case GL_TEXTURE_2D_MULTISAMPLE: return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+        case GL_TEXTURE_2D_ARRAY: return GL_TEXTURE_BINDING_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP: return GL_TEXTURE_BINDING_CUBE_MAP;
+        case GL_TEXTURE_BUFFER: return GL_TEXTURE_BINDING_BUFFER;
+        default: return GL_NONE;
+    }
+}
+
+int GLState::GetCapability(GLenum cap) {
+    for (int i = 0; i < TOTAL_CAPABILITIES; i++) {
+        if (CAPABILITIES[i] == cap)
+            return i;
+    }
+    return -1;
+}
+
+bool GLState::Changed(GLint& shadow, GLint value) {
+    counters_.calls++;
+    if (shadow == value) {
+        counters_.elided++;
+        return false;
+    }
+    shadow = value;
+    return true;
+}
+
+bool GLState::ValidateValue(GLenum pname, GLint expected) const {
+    if (expected == UNKNOWN)
+        return true;
+    GLint actual;
+    glGetIntegerv(pname, &actual);
+    if (actual != expected) {
+        spdlog::error("[GLState] Stale state 0x{:X}: expected {}, actually {}", pname, expected, actual);
+        return false;
+    }
+    return true;
+}
+
+bool GLState::ValidateCapability(int cap) const {
+    if (capabilities_[cap] == UNKNOWN)
+        return true;
+    GLint actual = glIsEnabled(CAPABILITIES[cap]) ? 1 : 0;
+    if (actual != capabilities_[cap]) {
+        spdlog::error("[GLState] Stale capability 0x{:X}: expected {}, actually {}", CAPABILITIES[cap], capabilities_[cap], actual);
+        return false;
+    }
+    return true;
+}
+
+bool GLState::Validate() const {
+    bool valid = true;
+    valid &= ValidateValue(GL_CURRENT_PROGRAM, program_);
+    valid &= ValidateValue(GL_VERTEX_ARRAY_BINDING, vao_);
+    GLint prevActive;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &prevActive);
+    if (activeTexture_ != UNKNOWN && prevActive != GL_TEXTURE0 + activeTexture_) {
+        spdlog::error("[GLState] Stale active texture: expected {}, actually {}", activeTexture_, prevActive - GL_TEXTURE0);
+        valid = false;
+    }
+    const GLenum targets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BUFFER };
+    for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        for (GLenum target : targets)
+            valid &= ValidateValue(GetTextureBinding(target), textures_[unit][GetTextureTarget(target)]);
+    }
+    glActiveTexture(prevActive);
+    for (int i = 0; i < TOTAL_CAPABILITIES; i++)
+        valid &= ValidateCapability(i);
+    valid &= ValidateValue(GL_DEPTH_FUNC, depthFunc_);
+    valid &= ValidateValue(GL_DEPTH_WRITEMASK, depthMask_);
+    valid &= ValidateValue(GL_CULL_FACE_MODE, cullFace_);
+    valid &= ValidateValue(GL_BLEND_SRC_RGB, blendFunc_[0]);
+    valid &= ValidateValue(GL_BLEND_DST_RGB, blendFunc_[1]);
+    if (scissor_[0] != UNKNOWN) {
+        std::array<GLint, 4> box;
+        glGetIntegerv(GL_SCISSOR_BOX, box.data());
+        if (box != scissor_) {
+            spdlog::error("[GLState] Stale scissor box");
+            valid = false;
+        }
+    }
+    if (viewport_[0] != UNKNOWN) {
+        std::array<GLint, 4> box;
+        glGetIntegerv(GL_VIEWPORT, box.data());
+        if (box != viewport_) {
+            spdlog::error("[GLState] Stale viewport");
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+void GLState::UseProgram(GLuint program) {
+    if (Changed(program_, (GLint) program)) {
+        glUseProgram(program);
+        counters_.programBinds++;
+    }
+    else if (validateState)
+        ValidateValue(GL_CURRENT_PROGRAM, program_);
+}
+
+void GLState::BindVertexArray(GLuint vao) {
+    if (Changed(vao_, (GLint) vao)) {
+        glBindVertexArray(vao);
+        counters_.vertexArrayBinds++;
+    }
+    else if (validateState)
+        ValidateValue(GL_VERTEX_ARRAY_BINDING, vao_);
+}
+
+void GLState::ActiveTexture(GLuint unit) {
+    if (Changed(activeTexture_, (GLint) unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    else if (validateState)
+        ValidateValue(GL_ACTIVE_TEXTURE, GL_TEXTURE0 + activeTexture_);
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture, GLuint unit) {
+    int t = GetTextureTarget(target);
+    ActiveTexture(unit);
+    // not tracked, the unit's state is unknown after this
+    if (t == -1 || unit >= MAX_TEXTURE_UNITS) {
+        glBindTexture(target, texture);
+        counters_.textureBinds++;
+        return;
+    }
+    if (Changed(textures_[unit][t], (GLint) texture)) {
+        glBindTexture(target, texture);
+        counters_.textureBinds++;
+    }
+    else if (validateState)
+        ValidateValue(GetTextureBinding(target), textures_[unit][t]);
+}
+
+void GLState::SetEnabled(GLenum cap, bool enabled) {
+    int c = GetCapability(cap);
+    if (c == -1) {
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+        return;
+    }
+    if (Changed(capabilities_[c], enabled ? 1 : 0)) {
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+    else if (validateState) {
+        ValidateCapability(c);
+    }
+}
+
+void GLState::Enable(GLenum cap) {
+    SetEnabled(cap, true);
+}
+
+void GLState::Disable(GLenum cap) {
+    SetEnabled(cap, false);
+}
+
+void GLState::DepthFunc(GLenum func) {
+    if (Changed(depthFunc_, (GLint) func))
+        glDepthFunc(func);
+    else if (validateState)
+        ValidateValue(GL_DEPTH_FUNC, depthFunc_);
+}
+
+void GLState::DepthMask(bool mask) {
+    if (Changed(depthMask_, mask ? GL_TRUE : GL_FALSE))
+        glDepthMask(mask ? GL_TRUE : GL_FALSE);
+    else if (validateState)
+        ValidateValue(GL_DEPTH_WRITEMASK, depthMask_);
+}
+
+void GLState::CullFace(GLenum face) {
+    if (Changed(cullFace_, (GLint) face))
+        glCullFace(face);
+    else if (validateState)
+        ValidateValue(GL_CULL_FACE_MODE, cullFace_);
+}
+
+void GLState::BlendFunc(GLenum src, GLenum dst) {
+    counters_.calls++;
+    if (blendFunc_[0] == (GLint) src && blendFunc_[1] == (GLint) dst) {
+        counters_.elided++;
+        if (validateState) {
+            ValidateValue(GL_BLEND_SRC_RGB, blendFunc_[0]);
+            ValidateValue(GL_BLEND_DST_RGB, blendFunc_[1]);
+        }
+        return;
+    }
+    blendFunc_ = { (GLint) src, (GLint) dst };
+    glBlendFunc(src, dst);
+}
+
+void GLState::Scissor(GLint x, GLint y, GLsizei w, GLsizei h) {
+    std::array<GLint, 4> box = { x, y, w, h };
+    counters_.calls++;
+    if (scissor_ == box) {
+        counters_.elided++;
+        return;
+    }
+    scissor_ = box;
+    glScissor(x, y, w, h);
+}
+
+void GLState::Viewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+    std::array<GLint, 4> box = { x, y, w, h };
+    counters_.calls++;
+    if (viewport_ == box) {
+        counters_.elided++;
+        return;
+    }
+    viewport_ = box;
+    glViewport(x, y, w, h);
+}
+
+void GLState::DeleteTexture(GLuint texture) {
+    if (texture == GL_NONE)
+        return;
+    if (instance_ != nullptr) {
+        for (auto& unit : instance_->textures_) {
+            for (GLint& bound : unit) {
+                if (bound == (GLint) texture)
+                    bound = 0;
+            }
+        }
+    }
+    glDeleteTextures(1, &texture);
+}
+
+void GLState::DeleteVertexArray(GLuint vao) {
+    if (vao == GL_NONE)
+        return;
+    if (instance_ != nullptr && instance_->vao_ == (GLint) vao)
+        instance_->vao_ = 0;
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GLState::CountDraw(GLenum mode, std::size_t count, std::size_t instances, bool newCall) {
+    if (instance_ == nullptr)
+        return;
+    Counters& c = instance_->counters_;
+    if (newCall)
+        c.draws++;
+    c.instances += instances;
+    switch (mode) {
+        case GL_TRIANGLES:
+            c.triangles += count / 3 * instances;
+            break;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            if (count >= 3)
+                c.triangles += (count - 2) * instances;
+            break;
+    }
+}
+
+void GLState::CountUniform() {
+    if (instance_ != nullptr)
+        instance_->counters_.uniforms++;
+}
+
+void GLState::CountUpload(std::size_t bytes) {
+    if (instance_ != nullptr)
+        instance_->counters_.uploadBytes += bytes;
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include <latren/graphics/lightclusters.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LATREN_CLUSTERS_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace UniformBlocks;
+
+// 16:9 tiles, the x * y count has to be a multiple of 4 for the sse loop
+const glm::uvec3 LightClusters::GRID_SIZE = glm::uvec3(16, 9, 24);
+const std::size_t TILES_PER_SLICE = LightClusters::GRID_SIZE.x * LightClusters::GRID_SIZE.y;
+const std::size_t CLUSTER_COUNT = TILES_PER_SLICE * LightClusters::GRID_SIZE.z;
+
+void LightClusters::TextureBuffer::Create(GLenum f) {
+    format = f;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // can't attach an empty buffer on some drivers
+    glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &texture);
+    Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::TextureBuffer::Delete() {
+    if (texture != GL_NONE)
+        GLState::DeleteTexture(texture);
+    if (buffer != GL_NONE)
+        glDeleteBuffers(1, &buffer);
+    texture = GL_NONE;
+    buffer = GL_NONE;
+}
+
+void LightClusters::TextureBuffer::Upload(const void* data, GLsizeiptr size) {
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<GLsizeiptr>(size, 16), nullptr, GL_STREAM_DRAW);
+    if (size > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+        GLState::CountUpload(size);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::Init() {
+    lightBuffer_.Create(GL_RGBA32F);
+    clusterBuffer_.Create(GL_RG32UI);
+    indexBuffer_.Create(GL_R32UI);
+    uniforms_.Create(Binding::LIGHTS, sizeof(LightClusterData));
+    clusters_.resize(CLUSTER_COUNT);
+    for (std::vector<float>* v : { &minX_, &minY_, &minZ_, &maxX_, &maxY_, &maxZ_ })
+        v->resize(CLUSTER_COUNT);
+}
+
+void LightClusters::Delete() {
+    lightBuffer_.Delete();
+    clusterBuffer_.Delete();
+    indexBuffer_.Delete();
+    uniforms_.Delete();
+}
+
+void LightClusters::UpdateLights(const std::vector<Lights::LightData>& lights) {
+    packedLights_.clear();
+    for (const Lights::LightData& l : lights) {
+        packedLights_.push_back(glm::vec4(l.color, l.intensity));
+        packedLights_.push_back(glm::vec4(l.pos, l.range));
+        packedLights_.push_back(glm::vec4(l.dir, l.y));
+        // ints would be denormals as float bits, just convert them
+        packedLights_.push_back(glm::vec4((float) l.type, 0.0f, l.cutOffMin, l.cutOffMax));
+    }
+    lightBuffer_.Upload(packedLights_.data(), packedLights_.size() * sizeof(glm::vec4));
+}
+
+void LightClusters::CalculateClusterBounds(const Camera& camera) {
+    float p00 = camera.projectionMatrix[0][0];
+    float p11 = camera.projectionMatrix[1][1];
+    float near = camera.clippingNear;
+    float far = camera.clippingFar;
+    for (std::size_t z = 0; z < GRID_SIZE.z; z++) {
+        // exponential slices, the near ones are thin
+        float sliceNear = near * std::pow(far / near, (float) z / GRID_SIZE.z);
+        float sliceFar = near * std::pow(far / near, (float) (z + 1) / GRID_SIZE.z);
+        for (std::size_t y = 0; y < GRID_SIZE.y; y++) {
+            float ndcY0 = -1.0f + 2.0f * y / GRID_SIZE.y;
+            float ndcY1 = -1.0f + 2.0f * (y + 1) / GRID_SIZE.y;
+            for (std::size_t x = 0; x < GRID_SIZE.x; x++) {
+                float ndcX0 = -1.0f + 2.0f * x / GRID_SIZE.x;
+                float ndcX1 = -1.0f + 2.0f * (x + 1) / GRID_SIZE.x;
+                // the view space x at depth d is ndc.x * d / p00
+                float xs[4] = { ndcX0 * sliceNear / p00, ndcX1 * sliceNear / p00, ndcX0 * sliceFar / p00, ndcX1 * sliceFar / p00 };
+                float ys[4] = { ndcY0 * sliceNear / p11, ndcY1 * sliceNear / p11, ndcY0 * sliceFar / p11, ndcY1 * sliceFar / p11 };
+                std::size_t i = z * TILES_PER_SLICE + y * GRID_SIZE.x + x;
+                minX_[i] = *std::min_element(xs, xs + 4);
+                maxX_[i] = *std::max_element(xs, xs + 4);
+                minY_[i] = *std::min_element(ys, ys + 4);
+                maxY_[i] = *std::max_element(ys, ys + 4);
+                minZ_[i] = -sliceFar;
+                maxZ_[i] = -sliceNear;
+            }
+        }
+    }
+}
+
+std::size_t LightClusters::GetSlice(float depth) const {
+    float near = projectionParams_.z;
+    float far = projectionParams_.w;
+    float slice = std::log(std::max(depth, near) / near) / std::log(far / near) * GRID_SIZE.z;
+    return std::min<std::size_t>((std::size_t) std::max(slice, 0.0f), GRID_SIZE.z - 1);
+}
+
+void LightClusters::AssignLight(uint32_t index, const Lights::LightData& light, const glm::mat4& view) {
+    glm::vec3 center = view * glm::vec4(light.pos, 1.0f);
+    float radius = light.range;
+    float depth = -center.z;
+    if (radius <= 0.0f || depth + radius < projectionParams_.z || depth - radius > projectionParams_.w)
+        return;
+    std::size_t firstSlice = GetSlice(depth - radius);
+    std::size_t lastSlice = GetSlice(depth + radius);
+
+    bool isSpotlight = light.type == static_cast<int>(Lights::LightType::SPOTLIGHT) && light.cutOffMax > 0.0f;
+    glm::vec3 coneDir;
+    float coneSin = 0.0f, coneCos = 1.0f;
+    if (isSpotlight) {
+        coneDir = glm::normalize(glm::mat3(view) * light.dir);
+        coneCos = std::min(light.cutOffMax, 1.0f);
+        coneSin = std::sqrt(1.0f - coneCos * coneCos);
+    }
+    // the sphere is a loose fit for spotlights, check the cone against the cluster's bounding sphere too
+    auto coneTest = [&](std::size_t c) {
+        glm::vec3 clusterMin(minX_[c], minY_[c], minZ_[c]);
+        glm::vec3 clusterMax(maxX_[c], maxY_[c], maxZ_[c]);
+        glm::vec3 sphereCenter = (clusterMin + clusterMax) * .5f;
+        float sphereRadius = glm::length(clusterMax - clusterMin) * .5f;
+        glm::vec3 v = sphereCenter - center;
+        float lenSq = glm::dot(v, v);
+        float v1Len = glm::dot(v, coneDir);
+        float distClosest = coneCos * std::sqrt(std::max(lenSq - v1Len * v1Len, 0.0f)) - v1Len * coneSin;
+        return !(distClosest > sphereRadius || v1Len > sphereRadius + radius || v1Len < -sphereRadius);
+    };
+    auto assign = [&](std::size_t c) {
+        if (isSpotlight && !coneTest(c))
+            return;
+        assignedClusters_.push_back((uint32_t) c);
+        assignedLights_.push_back(index);
+    };
+
+    std::size_t begin = firstSlice * TILES_PER_SLICE;
+    std::size_t end = (lastSlice + 1) * TILES_PER_SLICE;
+    #ifdef LATREN_CLUSTERS_SSE
+    __m128 cx = _mm_set1_ps(center.x);
+    __m128 cy = _mm_set1_ps(center.y);
+    __m128 cz = _mm_set1_ps(center.z);
+    __m128 r2 = _mm_set1_ps(radius * radius);
+    __m128 zero = _mm_setzero_ps();
+    for (std::size_t i = begin; i < end; i += 4) {
+        // distance from the center to the closest point of the box on each axis
+        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX_[i]), cx), _mm_sub_ps(cx, _mm_loadu_ps(&maxX_[i]))), zero);
+        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY_[i]), cy), _mm_sub_ps(cy, _mm_loadu_ps(&maxY_[i]))), zero);
+        __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ_[i]), cz), _mm_sub_ps(cz, _mm_loadu_ps(&maxZ_[i]))), zero);
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int mask = _mm_movemask_ps(_mm_cmple_ps(distSq, r2));
+        while (mask != 0) {
+            assign(i + Culling::CountTrailingZeros((std::uint64_t) mask));
+            mask &= mask - 1;
+        }
+    }
+    #else
+    for (std::size_t i = begin; i < end; i++) {
+        float dx = std::max(std::max(minX_[i] - center.x, center.x - maxX_[i]), 0.0f);
+        float dy = std::max(std::max(minY_[i] - center.y, center.y - maxY_[i]), 0.0f);
+        float dz = std::max(std::max(minZ_[i] - center.z, center.z - maxZ_[i]), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= radius * radius)
+            assign(i);
+    }
+    #endif
+}
+
+void LightClusters::Update(const Camera& camera, const glm::ivec2& screenSize, const std::vector<Lights::LightData>& lights) {
+    glm::vec4 projectionParams = glm::vec4(camera.projectionMatrix[0][0], camera.projectionMatrix[1][1], camera.clippingNear, camera.clippingFar);
+    if (projectionParams != projectionParams_) {
+        projectionParams_ = projectionParams;
+        CalculateClusterBounds(camera);
+    }
+
+    globalLights_.clear();
+    assignedClusters_.clear();
+    assignedLights_.clear();
+    for (uint32_t i = 0; i < lights.size(); i++) {
+        const Lights::LightData& light = lights[i];
+        if (!light.enabled)
+            continue;
+        switch (static_cast<Lights::LightType>(light.type)) {
+            case Lights::LightType::POINT:
+            case Lights::LightType::SPOTLIGHT:
+                AssignLight(i, light, camera.viewMatrix);
+                break;
+            case Lights::LightType::DIRECTIONAL:
+            case Lights::LightType::DIRECTIONAL_PLANE:
+                globalLights_.push_back(i);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // counting sort by cluster, the global lights go first in the index list
+    for (glm::uvec2& c : clusters_)
+        c = glm::uvec2(0);
+    for (uint32_t c : assignedClusters_)
+        clusters_[c].y++;
+    uint32_t offset = (uint32_t) globalLights_.size();
+    for (glm::uvec2& c : clusters_) {
+        c.x = offset;
+        offset += c.y;
+        c.y = 0;
+    }
+    indices_.resize(offset);
+    std::copy(globalLights_.begin(), globalLights_.end(), indices_.begin());
+    for (std::size_t i = 0; i < assignedClusters_.size(); i++) {
+        glm::uvec2& c = clusters_[assignedClusters_[i]];
+        indices_[c.x + c.y++] = assignedLights_[i];
+    }
+
+    clusterBuffer_.Upload(clusters_.data(), clusters_.size() * sizeof(glm::uvec2));
+    indexBuffer_.Upload(indices_.data(), indices_.size() * sizeof(uint32_t));
+
+    LightClusterData data;
+    data.gridSize = glm::uvec4(GRID_SIZE, (unsigned) globalLights_.size());
+    float logRatio = std::log(camera.clippingFar / camera.clippingNear);
+    data.depthParams = glm::vec4(
+        camera.clippingNear,
+        camera.clippingFar,
+        GRID_SIZE.z / logRatio,
+        -(GRID_SIZE.z * std::log(camera.clippingNear)) / logRatio
+    );
+    data.invScreenSize = glm::vec4(1.0f / screenSize.x, 1.0f / screenSize.y, 0.0f, 0.0f);
+    uniforms_.Update(&data, sizeof(data));
+}
+
+void LightClusters::Bind() const {
+    GLState& gl = Systems::GetRenderer().GetGLState();
+    gl.BindTexture(GL_TEXTURE_BUFFER, lightBuffer_.texture, TextureUnit::LIGHT_BUFFER_UNIT);
+    gl.BindTexture(GL_TEXTURE_BUFFER, clusterBuffer_.texture, TextureUnit::LIGHT_CLUSTER_UNIT);
+    gl.BindTexture(GL_TEXTURE_BUFFER, indexBuffer_.texture, TextureUnit::LIGHT_INDEX_UNIT);
+}
+
+std::size_t LightClusters::GetAssignmentCount() const {
+    return assignedClusters_.size();
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include <latren/graphics/lod.h>
+#include <latren/graphics/mesh.h>
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+// symmetric 4x4 matrix, the sum of the squared distances to a set of planes
+struct Quadric {
+    std::array<double, 10> m = { };
+
+    static Quadric FromPlane(double a, double b, double c, double d) {
+        Quadric q;
+        q.m = { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+        return q;
+    }
+    Quadric& operator+=(const Quadric& other) {
+        for (int i = 0; i < 10; i++)
+            m[i] += other.m[i];
+        return *this;
+    }
+    double Evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return
+            m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x +
+            m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y +
+            m[7] * z * z + 2.0 * m[8] * z +
+            m[9];
+    }
+};
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+const int MAX_SIMPLIFY_PASSES = 64;
+
+std::vector<unsigned int> LOD::Simplify(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::size_t targetIndexCount, float targetError, float* resultError) {
+    std::size_t vertexCount = vertices.size() / 3;
+    auto getPos = [&](unsigned int i) { return glm::vec3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]); };
+
+    // vertices that only differ by their uvs/normals share the same position vertex
+    std::vector<unsigned int> positionVertex(vertexCount);
+    {
+        struct PositionHash {
+            std::size_t operator()(const std::array<uint32_t, 3>& p) const {
+                return (p[0] * 73856093u) ^ (p[1] * 19349663u) ^ (p[2] * 83492791u);
+            }
+        };
+        std::unordered_map<std::array<uint32_t, 3>, unsigned int, PositionHash> positions;
+        for (unsigned int i = 0; i < vertexCount; i++) {
+            std::array<uint32_t, 3> key;
+            std::memcpy(key.data(), &vertices[i * 3], sizeof(key));
+            positionVertex[i] = positions.insert({ key, i }).first->second;
+        }
+    }
+    // count the distinct vertices per position, more than one means a seam
+    std::vector<unsigned int> variants(vertexCount, 0);
+    {
+        std::vector<bool> used(vertexCount, false);
+        for (unsigned int idx : indices) {
+            if (!used[idx]) {
+                used[idx] = true;
+                variants[positionVertex[idx]]++;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<uint64_t, int> edgeUses;
+        auto edgeKey = [](unsigned int a, unsigned int b) { return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b); };
+        for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+            unsigned int p[3] = { positionVertex[indices[t]], positionVertex[indices[t + 1]], positionVertex[indices[t + 2]] };
+            glm::vec3 a = getPos(p[0]), b = getPos(p[1]), c = getPos(p[2]);
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float len = glm::length(n);
+            if (len > 0.0f) {
+                n /= len;
+                Quadric q = Quadric::FromPlane(n.x, n.y, n.z, -glm::dot(n, a));
+                for (unsigned int v : p)
+                    quadrics[v] += q;
+            }
+            for (int e = 0; e < 3; e++)
+                edgeUses[edgeKey(p[e], p[(e + 1) % 3])]++;
+        }
+        // open borders would shrink
+        for (const auto& [key, uses] : edgeUses) {
+            if (uses == 1) {
+                locked[key >> 32] = true;
+                locked[key & 0xFFFFFFFF] = true;
+            }
+        }
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            if (variants[v] > 1)
+                locked[v] = true;
+        }
+    }
+
+    std::vector<unsigned int> result = indices;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertexCount);
+    double maxCost = static_cast<double>(targetError) * targetError;
+    double reachedCost = 0.0;
+
+    for (int pass = 0; pass < MAX_SIMPLIFY_PASSES && result.size() > targetIndexCount; pass++) {
+        for (auto& tris : vertexTriangles)
+            tris.clear();
+        for (std::size_t t = 0; t < result.size(); t += 3) {
+            for (int i = 0; i < 3; i++)
+                vertexTriangles[result[t + i]].push_back(static_cast<unsigned int>(t));
+        }
+
+        collapses.clear();
+        std::unordered_map<uint64_t, bool> seenEdges;
+        for (std::size_t t = 0; t < result.size(); t += 3) {
+            for (int e = 0; e < 3; e++) {
+                unsigned int u = result[t + e];
+                unsigned int v = result[t + (e + 1) % 3];
+                unsigned int pu = positionVertex[u], pv = positionVertex[v];
+                uint64_t key = (static_cast<uint64_t>(std::min(pu, pv)) << 32) | std::max(pu, pv);
+                if (!seenEdges.insert({ key, true }).second)
+                    continue;
+                Quadric q = quadrics[pu];
+                q += quadrics[pv];
+                // only collapse onto the other end, that way the vertex buffer doesn't change
+                double costToV = locked[pu] ? -1.0 : q.Evaluate(getPos(pv));
+                double costToU = locked[pv] ? -1.0 : q.Evaluate(getPos(pu));
+                if (costToV >= 0.0 && (costToU < 0.0 || costToV <= costToU))
+                    collapses.push_back({ u, v, costToV });
+                else if (costToU >= 0.0)
+                    collapses.push_back({ v, u, costToU });
+            }
+        }
+        if (collapses.empty())
+            break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        for (unsigned int i = 0; i < vertexCount; i++)
+            remap[i] = i;
+        std::fill(touched.begin(), touched.end(), false);
+        std::size_t indexCount = result.size();
+        std::size_t applied = 0;
+        for (const Collapse& c : collapses) {
+            if (c.cost > maxCost || indexCount <= targetIndexCount)
+                break;
+            unsigned int from = positionVertex[c.from];
+            unsigned int to = positionVertex[c.to];
+            if (touched[from] || touched[to])
+                continue;
+
+            // the triangles around the removed vertex mustn't flip
+            glm::vec3 toPos = getPos(to);
+            bool flips = false;
+            std::size_t removedTriangles = 0;
+            for (unsigned int t : vertexTriangles[c.from]) {
+                unsigned int p[3] = { positionVertex[result[t]], positionVertex[result[t + 1]], positionVertex[result[t + 2]] };
+                if (p[0] == to || p[1] == to || p[2] == to) {
+                    removedTriangles++;
+                    continue;
+                }
+                glm::vec3 a = getPos(p[0]), b = getPos(p[1]), d = getPos(p[2]);
+                glm::vec3 before = glm::cross(b - a, d - a);
+                glm::vec3 moved[3] = { a, b, d };
+                for (int i = 0; i < 3; i++) {
+                    if (p[i] == from)
+                        moved[i] = toPos;
+                }
+                glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                if (glm::dot(before, after) <= 0.0f) {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips)
+                continue;
+
+            remap[c.from] = c.to;
+            quadrics[to] += quadrics[from];
+            reachedCost = std::max(reachedCost, c.cost);
+            // the neighbourhood is stale until the next pass
+            for (unsigned int t : vertexTriangles[c.from]) {
+                for (int i = 0; i < 3; i++)
+                    touched[positionVertex[result[t + i]]] = true;
+            }
+            indexCount -= removedTriangles * 3;
+            applied++;
+        }
+        if (applied == 0)
+            break;
+
+        std::size_t write = 0;
+        for (std::size_t t = 0; t < result.size(); t += 3) {
+            unsigned int a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+            if (positionVertex[a] == positionVertex[b] || positionVertex[b] == positionVertex[c] || positionVertex[a] == positionVertex[c])
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+    if (resultError != nullptr)
+        *resultError = static_cast<float>(std::sqrt(reachedCost));
+    return result;
+}
+
+void LOD::GenerateLODs(Mesh& mesh, const LODSettings& settings) {
+    mesh.lods.clear();
+    std::size_t triangles = mesh.indices.size() / 3;
+    if (!settings.enabled || triangles < settings.minTriangles)
+        return;
+    float scale = glm::length(mesh.aabb.extents) * 2.0f;
+    if (scale <= 0.0f)
+        return;
+    std::size_t levels = std::min(settings.errors.size(), settings.ratios.size());
+    const std::vector<unsigned int>* previous = &mesh.indices;
+    for (std::size_t i = 0; i < levels; i++) {
+        std::size_t target = static_cast<std::size_t>(triangles * settings.ratios[i]) * 3;
+        float error = 0.0f;
+        std::vector<unsigned int> lodIndices = Simplify(mesh.vertices, *previous, target, settings.errors[i] * scale, &error);
+        // barely simplified (or not at all), the rest won't be any better
+        if (lodIndices.empty() || lodIndices.size() > previous->size() * 9 / 10)
+            break;
+        mesh.lods.push_back({ std::move(lodIndices), error / scale });
+        previous = &mesh.lods.back().indices;
+    }
+    if (!mesh.lods.empty())
+        spdlog::debug("Generated {} LOD levels for mesh '{}' ({} -> {} triangles)", mesh.lods.size(), mesh.id, triangles, mesh.lods.back().indices.size() / 3);
+}
+
+float LOD::GetScreenSize(const ViewFrustum::AABB& aabb, const Camera& camera) {
+    float radius = glm::length(aabb.extents);
+    float distance = glm::length(aabb.center - camera.pos);
+    if (distance <= radius)
+        return std::numeric_limits<float>::max();
+    // projectionMatrix[1][1] is cot(fov / 2)
+    return radius * camera.projectionMatrix[1][1] / distance;
+}
+
+int LOD::SelectLevel(float screenSize, const std::vector<float>& thresholds, int current) {
+    int levels = static_cast<int>(thresholds.size());
+    int level = std::clamp(current, 0, levels);
+    while (level < levels && screenSize < thresholds[level] * (1.0f - HYSTERESIS))
+        level++;
+    while (level > 0 && screenSize > thresholds[level - 1] * (1.0f + HYSTERESIS))
+        level--;
+    return level;
+}
\ No newline at end of file
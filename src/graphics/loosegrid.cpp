@@ -0,0 +1,86 @@
+#include <latren/graphics/loosegrid.h>
+
+LooseGrid::LooseGrid(float cellSize) : cellSize_(cellSize) { }
+
+void LooseGrid::SetCellSize(float size) {
+    cellSize_ = size;
+    // everything has to be rehashed
+    for (std::uint32_t i = 0; i < items_.size(); i++) {
+        if (items_[i].inserted)
+            Unlink(i);
+    }
+    for (std::uint32_t i = 0; i < items_.size(); i++) {
+        if (items_[i].inserted)
+            Insert(i);
+    }
+}
+
+float LooseGrid::GetCellSize() const {
+    return cellSize_;
+}
+
+glm::ivec3 LooseGrid::GetCellCoords(const glm::vec3& pos) const {
+    return glm::ivec3(glm::floor(pos / cellSize_));
+}
+
+std::uint64_t LooseGrid::GetCellKey(const glm::ivec3& c) {
+    // 21 bits per axis
+    const std::uint64_t mask = (1 << 21) - 1;
+    return ((std::uint64_t) c.x & mask) | (((std::uint64_t) c.y & mask) << 21) | (((std::uint64_t) c.z & mask) << 42);
+}
+
+void LooseGrid::Clear() {
+    for (auto& [key, cell] : cells_)
+        cell.clear();
+    oversized_.clear();
+    items_.clear();
+}
+
+void LooseGrid::Resize(std::size_t count) {
+    for (std::uint32_t i = (std::uint32_t) count; i < items_.size(); i++)
+        Remove(i);
+    items_.resize(count);
+}
+
+void LooseGrid::Insert(std::uint32_t i) {
+    Item& item = items_[i];
+    glm::vec3 size = item.aabb.extents * 2.0f;
+    item.oversized = size.x > cellSize_ || size.y > cellSize_ || size.z > cellSize_;
+    std::vector<std::uint32_t>& list = item.oversized ? oversized_ : cells_[item.cell = GetCellKey(GetCellCoords(item.aabb.center))];
+    item.position = (std::uint32_t) list.size();
+    list.push_back(i);
+    item.inserted = true;
+}
+
+void LooseGrid::Unlink(std::uint32_t i) {
+    Item& item = items_[i];
+    std::vector<std::uint32_t>& list = item.oversized ? oversized_ : cells_.at(item.cell);
+    // swap remove and fix up the moved item
+    std::uint32_t last = list.back();
+    list[item.position] = last;
+    items_[last].position = item.position;
+    list.pop_back();
+    item.inserted = false;
+}
+
+void LooseGrid::Update(std::uint32_t i, const ViewFrustum::AABB& aabb) {
+    Item& item = items_[i];
+    item.aabb = aabb;
+    if (item.inserted) {
+        glm::vec3 size = aabb.extents * 2.0f;
+        bool oversized = size.x > cellSize_ || size.y > cellSize_ || size.z > cellSize_;
+        if (oversized == item.oversized && (oversized || GetCellKey(GetCellCoords(aabb.center)) == item.cell))
+            return;
+        Unlink(i);
+    }
+    Insert(i);
+}
+
+void LooseGrid::Remove(std::uint32_t i) {
+    if (i < items_.size() && items_[i].inserted)
+        Unlink(i);
+}
+
+std::size_t LooseGrid::GetCellCount() const {
+    return cells_.size();
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include <latren/graphics/material.h>
+#include <latren/graphics/renderer.h>
+#include <latren/graphics/commandlist.h>
+#include <latren/systems.h>
 
 void Material::RestoreDefaultUniforms() {
     SetShaderUniform<glm::vec3>("color", glm::vec3(1.0f));
@@ -21,38 +24,75 @@ void Material::ClearUniforms() {
 
 void Material::SetTexture(Texture::TextureID t) {
     texture_ = t;
+    textureArray_ = Texture::ArrayLayer();
+}
+
+void Material::SetTexture(const Texture::ArrayLayer& layer) {
+    textureArray_ = layer;
 }
 
 void Material::BindTexture() const {
-    glBindTexture(GL_TEXTURE_2D, texture_);
+    if (HasTextureArray())
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D_ARRAY, textureArray_.array, UniformBlocks::TextureUnit::TEXTURE_ARRAY_UNIT);
+    else
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, texture_);
+}
+
+bool Material::IsBatchCompatible(const Material& other) const {
+    return
+        shader_.GetProgram() == other.shader_.GetProgram() &&
+        textureArray_.array == other.textureArray_.array &&
+        (HasTextureArray() || texture_ == other.texture_) &&
+        cullFaces == other.cullFaces &&
+        intUniforms_ == other.intUniforms_ &&
+        floatUniforms_ == other.floatUniforms_ &&
+        mat2Uniforms_ == other.mat2Uniforms_ &&
+        mat3Uniforms_ == other.mat3Uniforms_ &&
+        mat4Uniforms_ == other.mat4Uniforms_ &&
+        vec2Uniforms_ == other.vec2Uniforms_ &&
+        vec3Uniforms_ == other.vec3Uniforms_ &&
+        vec4Uniforms_ == other.vec4Uniforms_;
 }
 
 void Material::Use(const Shader& shader) const {
     shader.Use();
-    shader.SetUniform("material.hasTexture", texture_ != TEXTURE_NONE);
+    shader.SetUniform("material.hasTexture", !HasTextureArray() && texture_ != TEXTURE_NONE);
+    shader.SetUniform("material.hasTextureArray", HasTextureArray());
+    // the instanced shaders take the layer per instance instead
+    if (HasTextureArray())
+        shader.SetUniform("textureLayer", static_cast<float>(textureArray_.layer));
     BindTexture();
- 
-    for (const auto& i : intUniforms_)
-        shader.SetUniform(("material." + i.first).c_str(), i.second);
-    for (const auto& f : floatUniforms_)
-        shader.SetUniform(("material." + f.first).c_str(), f.second);
-    for (const auto& mat2 : mat2Uniforms_)
-        shader.SetUniform(("material." + mat2.first).c_str(), mat2.second);
-    for (const auto& mat3 : mat3Uniforms_)
-        shader.SetUniform(("material." + mat3.first).c_str(), mat3.second);
-    for (const auto& mat4 : mat4Uniforms_)
-        shader.SetUniform(("material." + mat4.first).c_str(), mat4.second);
-    for (const auto& vec2 : vec2Uniforms_)
-        shader.SetUniform(("material." + vec2.first).c_str(), vec2.second);
-    for (const auto& vec3 : vec3Uniforms_)
-        shader.SetUniform(("material." + vec3.first).c_str(), vec3.second);
-    for (const auto& vec4 : vec4Uniforms_)
-        shader.SetUniform(("material." + vec4.first).c_str(), vec4.second);
+
+    ForEachUniform([&](const std::string& name, const auto& value) {
+        shader.SetUniform(("material." + name).c_str(), value);
+    });
 
     if (cullFaces)
-        glEnable(GL_CULL_FACE);
+        Systems::GetRenderer().GetGLState().Enable(GL_CULL_FACE);
     else
-        glDisable(GL_CULL_FACE);
+        Systems::GetRenderer().GetGLState().Disable(GL_CULL_FACE);
+}
+
+void Material::Record(CommandList& commands, const Shader& shader) const {
+    commands.UseShader(shader);
+    commands.SetUniform("material.hasTexture", !HasTextureArray() && texture_ != TEXTURE_NONE);
+    commands.SetUniform("material.hasTextureArray", HasTextureArray());
+    if (HasTextureArray()) {
+        commands.SetUniform("textureLayer", static_cast<float>(textureArray_.layer));
+        commands.BindTexture(GL_TEXTURE_2D_ARRAY, textureArray_.array, UniformBlocks::TextureUnit::TEXTURE_ARRAY_UNIT);
+    }
+    else {
+        commands.BindTexture(GL_TEXTURE_2D, texture_);
+    }
+
+    std::string uniformName = "material.";
+    ForEachUniform([&](const std::string& name, const auto& value) {
+        uniformName.resize(9);
+        uniformName += name;
+        commands.SetUniform(uniformName.c_str(), value);
+    });
+
+    commands.SetEnabled(GL_CULL_FACE, cullFaces);
 }
 
 void Material::Use() const {
@@ -1,8 +1,15 @@
 #include <latren/graphics/mesh.h>
+#include <latren/graphics/renderer.h>
+#include <latren/graphics/commandlist.h>
+#include <latren/systems.h>
 #include <latren/graphics/texture.h>
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <spdlog/spdlog.h>
+#include <glm/gtc/packing.hpp>
 
 Mesh::Mesh(const std::vector<float>& v, const std::vector<unsigned int>& i, const std::vector<float>& t, const std::vector<float>& n) : vertices(v), indices(i), texCoords(t), normals(n) { }
 Mesh::Mesh(const std::vector<float>& v, const std::vector<unsigned int>& i, const std::vector<float>& t) : vertices(v), texCoords(t), indices(i), normals(v) { }
@@ -14,86 +21,238 @@ Mesh::Mesh(const std::vector<float>& v, const std::vector<unsigned int>& i) : ve
 }
 Mesh::Mesh(const std::string& meshId, const std::vector<float>& v, const std::vector<unsigned int>& i, const std::vector<float>& t) : Mesh(v, i, t) { id = meshId; }
 Mesh::Mesh(const std::string& meshId, const std::vector<float>& v, const std::vector<unsigned int>& i) : Mesh(v, i) { id = meshId; }
-Mesh::Mesh(const Mesh& m) : id(m.id), vertices(m.vertices), indices(m.indices), texCoords(m.texCoords), normals(m.normals) { }
+Mesh::Mesh(const Mesh& m) : id(m.id), vertices(m.vertices), indices(m.indices), lods(m.lods), texCoords(m.texCoords), normals(m.normals), layout(m.layout), useMeshArena(m.useMeshArena) { }
 Mesh::Mesh(Mesh&& m) :
     id(m.id),
     vertices(m.vertices),
     indices(m.indices),
+    lods(m.lods),
     texCoords(m.texCoords),
     normals(m.normals),
+    layout(m.layout),
+    useMeshArena(m.useMeshArena),
+    indexType(m.indexType),
+    bufferSize(m.bufferSize),
+    arena(m.arena),
+    arenaAllocation(m.arenaAllocation),
     vao(m.vao),
     vbo(m.vbo),
-    ebo(m.ebo),
-    normalBuffer(m.normalBuffer),
-    texCoordBuffer(m.texCoordBuffer)
+    ebo(m.ebo)
 {
     m.vao = GL_NONE;
     m.vbo = GL_NONE;
     m.ebo = GL_NONE;
-    m.normalBuffer = GL_NONE;
-    m.texCoordBuffer = GL_NONE;
+    m.bufferSize = 0;
+    m.arena = nullptr;
+}
+
+// half floats keep at least ~1/1000 precision within this range
+const float HALF_FLOAT_TEXCOORD_RANGE = 2.0f;
+
+uint32_t PackNormal(float x, float y, float z) {
+    auto pack = [](float f) -> uint32_t {
+        return static_cast<uint32_t>(static_cast<int32_t>(std::round(std::clamp(f, -1.0f, 1.0f) * 511.0f))) & 0x3FF;
+    };
+    return pack(x) | (pack(y) << 10) | (pack(z) << 20);
+}
+
+void Mesh::ChooseLayout() {
+    bool fitsHalfFloat = std::all_of(texCoords.begin(), texCoords.end(), [](float f) { return std::abs(f) <= HALF_FLOAT_TEXCOORD_RANGE; });
+    layout = fitsHalfFloat ? VertexLayouts::PACKED : VertexLayouts::PACKED_FLOAT_TEXCOORDS;
+}
+
+std::vector<uint8_t> Mesh::PackVertices() const {
+    std::size_t vertexCount = vertices.size() / 3;
+    bool halfTexCoords = layout.texCoordFormat == VertexLayout::TexCoordFormat::HALF_FLOAT;
+    bool packedNormals = layout.normalFormat == VertexLayout::NormalFormat::PACKED;
+
+    std::size_t posSize = layout.GetPositionSize();
+    std::size_t texCoordSize = layout.GetTexCoordSize();
+    std::size_t normalSize = layout.GetNormalSize();
+    std::size_t texCoordOffset = layout.GetTexCoordOffset(vertexCount);
+    std::size_t normalOffset = layout.GetNormalOffset(vertexCount);
+    auto attribStride = [&](std::size_t size) { return layout.interleaved ? layout.GetVertexSize() : size; };
+
+    std::vector<uint8_t> vertexData(layout.GetVertexSize() * vertexCount);
+    for (std::size_t i = 0; i < vertexCount; i++) {
+        std::memcpy(&vertexData[i * attribStride(posSize)], &vertices[i * 3], posSize);
+
+        float u = (i * 2 + 1 < texCoords.size()) ? texCoords[i * 2] : 0.0f;
+        float v = (i * 2 + 1 < texCoords.size()) ? texCoords[i * 2 + 1] : 0.0f;
+        uint8_t* texCoordPtr = &vertexData[texCoordOffset + i * attribStride(texCoordSize)];
+        if (halfTexCoords) {
+            uint16_t packed[2] = { glm::packHalf1x16(u), glm::packHalf1x16(v) };
+            std::memcpy(texCoordPtr, packed, texCoordSize);
+        }
+        else {
+            float unpacked[2] = { u, v };
+            std::memcpy(texCoordPtr, unpacked, texCoordSize);
+        }
+
+        glm::vec3 n(0.0f);
+        if (i * 3 + 2 < normals.size())
+            n = glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+        uint8_t* normalPtr = &vertexData[normalOffset + i * attribStride(normalSize)];
+        if (packedNormals) {
+            uint32_t packed = PackNormal(n.x, n.y, n.z);
+            std::memcpy(normalPtr, &packed, normalSize);
+        }
+        else {
+            std::memcpy(normalPtr, &n.x, normalSize);
+        }
+    }
+    return vertexData;
 }
 
 void Mesh::GenerateVAO() {
+    DeleteBuffers();
+    std::size_t vertexCount = vertices.size() / 3;
+    std::vector<uint8_t> vertexData = PackVertices();
+
+    // the lod levels go after the full mesh in the same ebo
+    std::vector<unsigned int> allIndices;
+    const std::vector<unsigned int>* uploadIndices = &indices;
+    if (!lods.empty()) {
+        allIndices = indices;
+        for (MeshLOD& lod : lods) {
+            lod.first = allIndices.size();
+            allIndices.insert(allIndices.end(), lod.indices.begin(), lod.indices.end());
+        }
+        uploadIndices = &allIndices;
+    }
+    std::vector<uint16_t> shortIndices;
+    const void* indexData = uploadIndices->data();
+    std::size_t indexBytes;
+    if (layout.indexFormat == VertexLayout::IndexFormat::SMALLEST && vertexCount <= std::numeric_limits<uint16_t>::max() + 1) {
+        shortIndices.assign(uploadIndices->begin(), uploadIndices->end());
+        indexData = shortIndices.data();
+        indexBytes = shortIndices.size() * sizeof(uint16_t);
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    else {
+        indexBytes = uploadIndices->size() * sizeof(uint32_t);
+        indexType = GL_UNSIGNED_INT;
+    }
+    bufferSize = vertexData.size() + indexBytes;
+
+    if (useMeshArena) {
+        MeshArena* target = Systems::GetRenderer().GetMeshArenas().Get(layout, indexType);
+        if (target != nullptr && target->Allocate(vertexData.data(), vertexCount, indexData, uploadIndices->size(), arenaAllocation)) {
+            arena = target;
+            vao = arena->GetVertexArray();
+            return;
+        }
+    }
+
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao);
 
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(0);
+    glBufferData(GL_ARRAY_BUFFER, vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
+    layout.SetAttribPointers(vertexCount);
 
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &texCoordBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
-    glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(texCoords[0]), texCoords.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(1);
-
-    glGenBuffers(1, &normalBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(normals[0]), normals.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(2);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW);
+    GLState::CountUpload(bufferSize);
     
-    glBindVertexArray(0);
+    Systems::GetRenderer().GetGLState().BindVertexArray(0);
 }
 
 void Mesh::Bind() const {
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GetIndexBuffer());
+}
+
+int Mesh::GetLODCount() const {
+    return static_cast<int>(lods.size()) + 1;
+}
+
+std::size_t Mesh::GetIndexCount(int lod) const {
+    lod = std::clamp(lod, 0, static_cast<int>(lods.size()));
+    return lod == 0 ? indices.size() : lods[lod - 1].indices.size();
+}
+
+std::size_t Mesh::GetFirstIndex(int lod) const {
+    lod = std::clamp(lod, 0, static_cast<int>(lods.size()));
+    std::size_t first = lod == 0 ? 0 : lods[lod - 1].first;
+    return arena != nullptr ? arenaAllocation.firstIndex + first : first;
+}
+
+GLint Mesh::GetBaseVertex() const {
+    return arena != nullptr ? static_cast<GLint>(arenaAllocation.firstVertex) : 0;
+}
+
+GLuint Mesh::GetIndexBuffer() const {
+    // the arena's ebo changes when it grows
+    return arena != nullptr ? arena->GetIndexBuffer() : ebo;
+}
+
+// byte offset of the index in the ebo
+std::size_t GetIndexOffset(const Mesh& mesh, std::size_t first) {
+    return first * (mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+void Mesh::Render(int lod) const {
+    if (!cullFaces)
+        Systems::GetRenderer().GetGLState().Disable(GL_CULL_FACE);
+    void* offset = reinterpret_cast<void*>(GetIndexOffset(*this, GetFirstIndex(lod)));
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(GetIndexCount(lod)), indexType, offset, GetBaseVertex());
+    GLState::CountDraw(GL_TRIANGLES, GetIndexCount(lod));
 }
 
-void Mesh::Render() const {
+void Mesh::RenderRange(std::size_t first, std::size_t count) const {
     if (!cullFaces)
-        glDisable(GL_CULL_FACE);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+        Systems::GetRenderer().GetGLState().Disable(GL_CULL_FACE);
+    if (arena != nullptr)
+        first += arenaAllocation.firstIndex;
+    void* offset = reinterpret_cast<void*>(GetIndexOffset(*this, first));
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(count), indexType, offset, GetBaseVertex());
+    GLState::CountDraw(GL_TRIANGLES, count);
+}
+
+void Mesh::Record(CommandList& commands, int lod) const {
+    commands.BindVertexArray(vao, GetIndexBuffer());
+    if (!cullFaces)
+        commands.SetEnabled(GL_CULL_FACE, false);
+    commands.DrawElements(indexType, static_cast<GLsizei>(GetIndexCount(lod)), GetIndexOffset(*this, GetFirstIndex(lod)), GetBaseVertex());
+}
+
+void Mesh::RenderInstanced(GLsizei instances, int lod) const {
+    if (!cullFaces)
+        Systems::GetRenderer().GetGLState().Disable(GL_CULL_FACE);
+    void* offset = reinterpret_cast<void*>(GetIndexOffset(*this, GetFirstIndex(lod)));
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(GetIndexCount(lod)), indexType, offset, instances, GetBaseVertex());
+    GLState::CountDraw(GL_TRIANGLES, GetIndexCount(lod), instances);
 }
 
 std::shared_ptr<Mesh> Meshes::CreateMeshInstance(const Mesh& m) {
     auto mesh = std::make_shared<Mesh>(m);
+    mesh->useMeshArena = true;
     mesh->GenerateVAO();
     return mesh;
 }
 
-Mesh::~Mesh() {
+void Mesh::DeleteBuffers() {
+    if (arena != nullptr) {
+        // the vao belongs to the arena
+        arena->Free(arenaAllocation);
+        arena = nullptr;
+        vao = GL_NONE;
+    }
     if (vao != GL_NONE)
-        glDeleteVertexArrays(1, &vao);
+        GLState::DeleteVertexArray(vao);
     if (vbo != GL_NONE)
         glDeleteBuffers(1, &vbo);
     if (ebo != GL_NONE)
         glDeleteBuffers(1, &ebo);
-    if (texCoordBuffer != GL_NONE)
-        glDeleteBuffers(1, &texCoordBuffer);
-    if (normalBuffer != GL_NONE)
-        glDeleteBuffers(1, &normalBuffer);
     vao = GL_NONE;
     vbo = GL_NONE;
     ebo = GL_NONE;
-    texCoordBuffer = GL_NONE;
-    normalBuffer = GL_NONE;
+    bufferSize = 0;
+}
+
+Mesh::~Mesh() {
+    DeleteBuffers();
 }
\ No newline at end of file
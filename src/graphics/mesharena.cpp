@@ -0,0 +1,226 @@
+#include <latren/graphics/mesharena.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+std::size_t RangeAllocator::Allocate(std::size_t size) {
+    if (size == 0)
+        return NONE;
+    auto it = std::find_if(free_.begin(), free_.end(), [&](const Range& r) { return r.size >= size; });
+    if (it == free_.end())
+        return NONE;
+    std::size_t offset = it->offset;
+    it->offset += size;
+    it->size -= size;
+    if (it->size == 0)
+        free_.erase(it);
+    used_ += size;
+    return offset;
+}
+
+void RangeAllocator::Free(std::size_t offset, std::size_t size) {
+    if (size == 0)
+        return;
+    auto it = std::lower_bound(free_.begin(), free_.end(), offset, [](const Range& r, std::size_t o) { return r.offset < o; });
+    it = free_.insert(it, { offset, size });
+    // merge with the next one and then the previous one
+    auto next = it + 1;
+    if (next != free_.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        it = free_.erase(next) - 1;
+    }
+    if (it != free_.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            free_.erase(it);
+        }
+    }
+    used_ -= std::min(size, used_);
+}
+
+void RangeAllocator::Grow(std::size_t capacity) {
+    if (capacity <= capacity_)
+        return;
+    std::size_t added = capacity - capacity_;
+    if (!free_.empty() && free_.back().offset + free_.back().size == capacity_)
+        free_.back().size += added;
+    else
+        free_.push_back({ capacity_, added });
+    capacity_ = capacity;
+}
+
+void RangeAllocator::Clear() {
+    free_.clear();
+    capacity_ = 0;
+    used_ = 0;
+}
+
+std::size_t RangeAllocator::GetCapacity() const {
+    return capacity_;
+}
+
+std::size_t RangeAllocator::GetUsed() const {
+    return used_;
+}
+
+void MeshArena::Create(const VertexLayout& layout, GLenum indexType) {
+    layout_ = layout;
+    indexType_ = indexType;
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &ebo_);
+    vertices_.Clear();
+    indices_.Clear();
+    Reserve(INITIAL_VERTICES, INITIAL_INDICES);
+}
+
+void MeshArena::Delete() {
+    if (vao_ != GL_NONE)
+        GLState::DeleteVertexArray(vao_);
+    if (vbo_ != GL_NONE)
+        glDeleteBuffers(1, &vbo_);
+    if (ebo_ != GL_NONE)
+        glDeleteBuffers(1, &ebo_);
+    vao_ = GL_NONE;
+    vbo_ = GL_NONE;
+    ebo_ = GL_NONE;
+}
+
+std::size_t MeshArena::GetIndexSize() const {
+    return indexType_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void MeshArena::GrowBuffer(GLuint& buffer, std::size_t oldSize, std::size_t newSize) {
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+    if (oldSize > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
+
+void MeshArena::Reserve(std::size_t vertexCount, std::size_t indexCount) {
+    std::size_t vertexCapacity = std::max(vertices_.GetCapacity(), INITIAL_VERTICES);
+    while (vertexCapacity < vertexCount)
+        vertexCapacity *= 2;
+    std::size_t indexCapacity = std::max(indices_.GetCapacity(), INITIAL_INDICES);
+    while (indexCapacity < indexCount)
+        indexCapacity *= 2;
+    bool grown = false;
+    if (vertexCapacity > vertices_.GetCapacity()) {
+        GrowBuffer(vbo_, vertices_.GetCapacity() * layout_.GetVertexSize(), vertexCapacity * layout_.GetVertexSize());
+        vertices_.Grow(vertexCapacity);
+        grown = true;
+    }
+    if (indexCapacity > indices_.GetCapacity()) {
+        GrowBuffer(ebo_, indices_.GetCapacity() * GetIndexSize(), indexCapacity * GetIndexSize());
+        indices_.Grow(indexCapacity);
+        grown = true;
+    }
+    if (!grown)
+        return;
+    // the vao handle stays the same, so the meshes don't have to know about this
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    layout_.SetAttribPointers(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    Systems::GetRenderer().GetGLState().BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool MeshArena::Allocate(const void* vertexData, std::size_t vertexCount, const void* indexData, std::size_t indexCount, Allocation& allocation) {
+    if (vao_ == GL_NONE || vertexCount == 0 || indexCount == 0)
+        return false;
+    std::size_t firstVertex = vertices_.Allocate(vertexCount);
+    if (firstVertex == RangeAllocator::NONE) {
+        Reserve(vertices_.GetCapacity() + vertexCount, 0);
+        firstVertex = vertices_.Allocate(vertexCount);
+    }
+    std::size_t firstIndex = indices_.Allocate(indexCount);
+    if (firstIndex == RangeAllocator::NONE) {
+        Reserve(0, indices_.GetCapacity() + indexCount);
+        firstIndex = indices_.Allocate(indexCount);
+    }
+    allocation = { firstVertex, vertexCount, firstIndex, indexCount };
+
+    std::size_t vertexSize = layout_.GetVertexSize();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * vertexSize, vertexCount * vertexSize, vertexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * GetIndexSize(), indexCount * GetIndexSize(), indexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    GLState::CountUpload(vertexCount * vertexSize + indexCount * GetIndexSize());
+    return true;
+}
+
+void MeshArena::Free(const Allocation& allocation) {
+    vertices_.Free(allocation.firstVertex, allocation.vertexCount);
+    indices_.Free(allocation.firstIndex, allocation.indexCount);
+}
+
+bool MeshArena::Matches(const VertexLayout& layout, GLenum indexType) const {
+    return layout_.IsVertexCompatible(layout) && indexType_ == indexType;
+}
+
+GLuint MeshArena::GetVertexArray() const {
+    return vao_;
+}
+
+GLuint MeshArena::GetIndexBuffer() const {
+    return ebo_;
+}
+
+GLenum MeshArena::GetIndexType() const {
+    return indexType_;
+}
+
+std::size_t MeshArena::GetBufferSize() const {
+    return vertices_.GetCapacity() * layout_.GetVertexSize() + indices_.GetCapacity() * GetIndexSize();
+}
+
+std::size_t MeshArena::GetUsedSize() const {
+    return vertices_.GetUsed() * layout_.GetVertexSize() + indices_.GetUsed() * GetIndexSize();
+}
+
+MeshArena* MeshArenas::Get(const VertexLayout& layout, GLenum indexType) {
+    // the attribute offsets of the non-interleaved layouts depend on the vertex count
+    if (!layout.interleaved)
+        return nullptr;
+    for (const auto& arena : arenas_) {
+        if (arena->Matches(layout, indexType))
+            return arena.get();
+    }
+    auto& arena = arenas_.emplace_back(std::make_unique<MeshArena>());
+    arena->Create(layout, indexType);
+    spdlog::debug("Created a mesh arena ({} byte vertices, {}-bit indices)", layout.GetVertexSize(), indexType == GL_UNSIGNED_SHORT ? 16 : 32);
+    return arena.get();
+}
+
+void MeshArenas::Delete() {
+    // the arenas themselves stay around, the meshes still give their ranges back to them
+    for (const auto& arena : arenas_)
+        arena->Delete();
+}
+
+std::size_t MeshArenas::GetBufferSize() const {
+    std::size_t size = 0;
+    for (const auto& arena : arenas_)
+        size += arena->GetBufferSize();
+    return size;
+}
+
+std::size_t MeshArenas::GetUsedSize() const {
+    std::size_t size = 0;
+    for (const auto& arena : arenas_)
+        size += arena->GetUsedSize();
+    return size;
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <latren/systems.h>
 
 #include <spdlog/spdlog.h>
+#include <memory>
 
 std::shared_ptr<Mesh> Model::ProcessMesh(const aiMesh* mesh, const aiScene* scene) {
     auto processedMesh = std::make_shared<Mesh>();
@@ -33,7 +34,9 @@ std::shared_ptr<Mesh> Model::ProcessMesh(const aiMesh* mesh, const aiScene* scen
     glm::vec3 aabbMin(mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z);
     glm::vec3 aabbMax(mesh->mAABB.mMax.x, mesh->mAABB.mMax.y, mesh->mAABB.mMax.z);
     processedMesh->aabb = ViewFrustum::AABB::FromMinMax(aabbMin, aabbMax);
-    processedMesh->GenerateVAO();
+    LOD::GenerateLODs(*processedMesh, lodSettings_);
+    processedMesh->ChooseLayout();
+    processedMesh->useMeshArena = true;
     return processedMesh;
 }
 
@@ -47,7 +50,8 @@ void Model::ProcessNodes(const aiNode* node, const aiScene* scene) {
     }
 }
 
-void Model::LoadModel(const std::string& path) {
+void Model::LoadModel(const std::string& path, const LODSettings& lodSettings, bool generateVAOs) {
+    lodSettings_ = lodSettings;
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenBoundingBoxes);
     if (!scene) {
@@ -62,17 +66,29 @@ void Model::LoadModel(const std::string& path) {
     }
     dir_ = path.substr(0, path.find_last_of('/'));
     ProcessNodes(rootNode, scene);
+    if (generateVAOs)
+        GenerateVAOs();
+}
+
+void Model::GenerateVAOs() {
+    for (auto& m : meshes)
+        m->GenerateVAO();
 }
 
 std::optional<Model> Resources::ModelManager::LoadResource(const ResourcePath& path) {
-    Model model;
-    model.LoadModel(path.GetParsedPathStr());
-    std::string id = GetItemID();
+    return DecodeResource(path, GetItemID(), GetAdditionalData())();
+}
+
+std::function<std::optional<Model>()> Resources::ModelManager::DecodeResource(const ResourcePath& path, const std::string& id, const AdditionalImportData&) {
+    // shared since std::function has to be copyable
+    auto model = std::make_shared<Model>();
     const auto& items = Systems::GetResources().GetObjectSerializer()->GetItems();
-    if (items.find(id) != items.end()) {
+    bool hasObjData = items.find(id) != items.end();
+    model->LoadModel(path.GetParsedPathStr(), hasObjData ? items.at(id).lod : LODSettings(), false);
+    if (hasObjData) {
         const Object& objData = Systems::GetResources().GetObjectSerializer()->GetItem(id);
         if (objData.defaultMaterial != nullptr) {
-            for (auto& m : model.meshes) {
+            for (auto& m : model->meshes) {
                 m->material = objData.defaultMaterial;
                 if (objData.size != glm::vec3(1.0f)) {
                     for (int i = 0; i < m->vertices.size(); i++) {
@@ -80,18 +96,20 @@ std::optional<Model> Resources::ModelManager::LoadResource(const ResourcePath& p
                     }
                     m->aabb.center *= objData.size;
                     m->aabb.extents *= objData.size;
-                    m->GenerateVAO();
                 }
             }
         }
         for (const auto& [i, mat] : objData.materials) {
-            if (i >= model.meshes.size())
+            if (i >= model->meshes.size())
                 continue;
-            model.meshes.at(i)->material = mat;
+            model->meshes.at(i)->material = mat;
         }
     }
     else {
         spdlog::warn("Object '{}' not defined in objects.json!", id);
     }
-    return model;
+    return [model]() {
+        model->GenerateVAOs();
+        return std::optional<Model>(*model);
+    };
 }
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include <latren/graphics/occlusion.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
+#include <latren/graphics/component/renderable.h>
+
+#include <algorithm>
+#include <limits>
+
+void OcclusionCuller::Init(const glm::ivec2& size) {
+    size_ = size;
+    depthShader_ = Shader(Shaders::ShaderID::UNLIT);
+
+    glGenTextures(1, &depthTexture_);
+    Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, depthTexture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, size_.x, size_.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture_, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(2, pbos_.data());
+    for (GLuint pbo : pbos_) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size_.x * size_.y * sizeof(float), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    levelSizes_.clear();
+    hiZ_.clear();
+    glm::ivec2 levelSize = size_;
+    while (true) {
+        levelSizes_.push_back(levelSize);
+        hiZ_.emplace_back(levelSize.x * levelSize.y, 1.0f);
+        if (levelSize.x == 1 && levelSize.y == 1)
+            break;
+        levelSize = glm::max((levelSize + 1) / 2, glm::ivec2(1));
+    }
+    hasDepth_ = false;
+}
+
+void OcclusionCuller::Delete() {
+    for (GLsync& fence : fences_) {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (fbo_ != GL_NONE)
+        glDeleteFramebuffers(1, &fbo_);
+    if (depthTexture_ != GL_NONE)
+        GLState::DeleteTexture(depthTexture_);
+    if (pbos_[0] != GL_NONE)
+        glDeleteBuffers(2, pbos_.data());
+    fbo_ = GL_NONE;
+    depthTexture_ = GL_NONE;
+    pbos_ = { GL_NONE, GL_NONE };
+    hasDepth_ = false;
+}
+
+void OcclusionCuller::Invalidate() {
+    hasDepth_ = false;
+    staleFrames_ = 0;
+}
+
+bool OcclusionCuller::HasDepth() const {
+    return hasDepth_;
+}
+
+void OcclusionCuller::BuildHiZ(const float* depth) {
+    std::copy(depth, depth + size_.x * size_.y, hiZ_[0].begin());
+    for (std::size_t level = 1; level < hiZ_.size(); level++) {
+        const std::vector<float>& src = hiZ_[level - 1];
+        const glm::ivec2& srcSize = levelSizes_[level - 1];
+        std::vector<float>& dst = hiZ_[level];
+        const glm::ivec2& dstSize = levelSizes_[level];
+        for (int y = 0; y < dstSize.y; y++) {
+            int y0 = std::min(y * 2, srcSize.y - 1);
+            int y1 = std::min(y * 2 + 1, srcSize.y - 1);
+            for (int x = 0; x < dstSize.x; x++) {
+                int x0 = std::min(x * 2, srcSize.x - 1);
+                int x1 = std::min(x * 2 + 1, srcSize.x - 1);
+                dst[y * dstSize.x + x] = std::max(
+                    std::max(src[y0 * srcSize.x + x0], src[y0 * srcSize.x + x1]),
+                    std::max(src[y1 * srcSize.x + x0], src[y1 * srcSize.x + x1])
+                );
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::ReadBackSlot(int slot) {
+    GLsync& fence = fences_[slot];
+    if (fence == nullptr)
+        return false;
+    // not done yet, just keep the old depth instead of stalling
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    bool read = false;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[slot]);
+    const float* depth = static_cast<const float*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size_.x * size_.y * sizeof(float), GL_MAP_READ_BIT));
+    if (depth != nullptr) {
+        BuildHiZ(depth);
+        hiZViewProjection_ = pboViewProjections_[slot];
+        read = true;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return read;
+}
+
+void OcclusionCuller::ReadBack() {
+    // two slots: frame_ is the one RenderOccluders writes next, so it also holds the older pending readback.
+    // both are polled so that a slot can't be left with its fence set, RenderOccluders would skip it forever.
+    // the older one first so the newer depth wins if both are ready
+    bool read = false;
+    read |= ReadBackSlot(frame_);
+    read |= ReadBackSlot((frame_ + 1) % 2);
+    if (read) {
+        hasDepth_ = true;
+        staleFrames_ = 0;
+    }
+    // the occluders or the readbacks have stopped, don't keep culling against an old view
+    else if (hasDepth_ && ++staleFrames_ > MAX_STALE_FRAMES) {
+        hasDepth_ = false;
+    }
+}
+
+void OcclusionCuller::RenderOccluders(const std::vector<IRenderable*>& occluders, const glm::mat4& viewProjection) {
+    // still waiting for the previous readback of this pbo, skip a frame
+    if (fences_[frame_] != nullptr)
+        return;
+
+    GLState& gl = Systems::GetRenderer().GetGLState();
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    gl.Viewport(0, 0, size_.x, size_.y);
+    gl.Enable(GL_DEPTH_TEST);
+    gl.DepthMask(true);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    for (IRenderable* occluder : occluders) {
+        occluder->IRender(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f), &depthShader_, RENDER_MODE_NO_MATERIALS);
+    }
+    gl.Enable(GL_CULL_FACE);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[frame_]);
+    glReadPixels(0, 0, size_.x, size_.y, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences_[frame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pboViewProjections_[frame_] = viewProjection;
+    frame_ = (frame_ + 1) % 2;
+}
+
+float OcclusionCuller::GetMaxDepth(int level, const glm::ivec2& min, const glm::ivec2& max) const {
+    const std::vector<float>& depth = hiZ_[level];
+    const glm::ivec2& size = levelSizes_[level];
+    float maxDepth = 0.0f;
+    for (int y = min.y; y <= max.y; y++) {
+        for (int x = min.x; x <= max.x; x++)
+            maxDepth = std::max(maxDepth, depth[y * size.x + x]);
+    }
+    return maxDepth;
+}
+
+bool OcclusionCuller::IsOccluded(const ViewFrustum::AABB& aabb) const {
+    if (!hasDepth_)
+        return false;
+    glm::vec2 screenMin = glm::vec2(std::numeric_limits<float>::max());
+    glm::vec2 screenMax = glm::vec2(-std::numeric_limits<float>::max());
+    float minDepth = 1.0f;
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner = aabb.center + aabb.extents * glm::vec3(
+            (i & 1) ? 1.0f : -1.0f,
+            (i & 2) ? 1.0f : -1.0f,
+            (i & 4) ? 1.0f : -1.0f
+        );
+        glm::vec4 clip = hiZViewProjection_ * glm::vec4(corner, 1.0f);
+        // crosses the near plane, can't say anything
+        if (clip.w <= 0.0f)
+            return false;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        screenMin = glm::min(screenMin, glm::vec2(ndc));
+        screenMax = glm::max(screenMax, glm::vec2(ndc));
+        minDepth = std::min(minDepth, ndc.z * 0.5f + 0.5f);
+    }
+    // off screen (in the old view), the frustum test decides these
+    if (screenMax.x < -1.0f || screenMax.y < -1.0f || screenMin.x > 1.0f || screenMin.y > 1.0f)
+        return false;
+
+    glm::vec2 size = glm::vec2(size_);
+    glm::ivec2 pixelMin = glm::clamp(glm::ivec2((glm::clamp(screenMin, -1.0f, 1.0f) * 0.5f + 0.5f) * size), glm::ivec2(0), size_ - 1);
+    glm::ivec2 pixelMax = glm::clamp(glm::ivec2((glm::clamp(screenMax, -1.0f, 1.0f) * 0.5f + 0.5f) * size), glm::ivec2(0), size_ - 1);
+
+    // pick the level where the rect is at most 2 texels wide so there's only a few to check
+    int level = 0;
+    glm::ivec2 extent = pixelMax - pixelMin;
+    while (level + 1 < (int) hiZ_.size() && (extent.x > 1 || extent.y > 1)) {
+        extent /= 2;
+        level++;
+    }
+    glm::ivec2 levelMin = pixelMin / (1 << level);
+    glm::ivec2 levelMax = glm::min(pixelMax / (1 << level), levelSizes_[level] - 1);
+    return minDepth > GetMaxDepth(level, levelMin, levelMax);
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include <latren/graphics/particles.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LATREN_PARTICLES_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace Particles;
+
+void ParticleBuffer::Reserve(std::size_t capacity) {
+    capacity_ = capacity;
+    count_ = std::min(count_, capacity_);
+    for (std::vector<float>* v : { &posX, &posY, &posZ, &velX, &velY, &velZ, &life, &invLifetime, &size })
+        v->resize(capacity_, 0.0f);
+}
+
+std::size_t ParticleBuffer::Add() {
+    if (count_ == capacity_)
+        return capacity_;
+    return count_++;
+}
+
+void ParticleBuffer::Clear() {
+    count_ = 0;
+}
+
+void ParticleBuffer::RemoveDead() {
+    std::size_t i = 0;
+    while (i < count_) {
+        if (life[i] < 1.0f) {
+            i++;
+            continue;
+        }
+        // the last one takes its place and gets checked on the next round
+        count_--;
+        for (std::vector<float>* v : { &posX, &posY, &posZ, &velX, &velY, &velZ, &life, &invLifetime, &size })
+            (*v)[i] = (*v)[count_];
+    }
+}
+
+std::size_t ParticleBuffer::GetCount() const {
+    return count_;
+}
+
+std::size_t ParticleBuffer::GetCapacity() const {
+    return capacity_;
+}
+
+std::uint32_t PackColor(const glm::vec4& color) {
+    glm::vec4 c = glm::clamp(color, glm::vec4(0.0f), glm::vec4(1.0f)) * 255.0f + .5f;
+    return
+        static_cast<std::uint32_t>(c.r) |
+        static_cast<std::uint32_t>(c.g) << 8 |
+        static_cast<std::uint32_t>(c.b) << 16 |
+        static_cast<std::uint32_t>(c.a) << 24;
+}
+
+// linear between the evenly spaced keys
+template <typename T>
+T SampleKeys(const std::vector<T>& keys, float t) {
+    if (keys.size() == 1)
+        return keys[0];
+    float f = t * (keys.size() - 1);
+    std::size_t i = std::min(static_cast<std::size_t>(f), keys.size() - 2);
+    float a = f - i;
+    return keys[i] * (1.0f - a) + keys[i + 1] * a;
+}
+
+ColorCurve::ColorCurve() {
+    table_.fill(0xffffffff);
+}
+
+void ColorCurve::Set(const std::vector<glm::vec4>& keys) {
+    if (keys.empty()) {
+        table_.fill(0xffffffff);
+        return;
+    }
+    for (std::size_t i = 0; i < CURVE_RESOLUTION; i++)
+        table_[i] = PackColor(SampleKeys(keys, static_cast<float>(i) / (CURVE_RESOLUTION - 1)));
+}
+
+FloatCurve::FloatCurve() {
+    table_.fill(1.0f);
+}
+
+void FloatCurve::Set(const std::vector<float>& keys) {
+    if (keys.empty()) {
+        table_.fill(1.0f);
+        return;
+    }
+    for (std::size_t i = 0; i < CURVE_RESOLUTION; i++)
+        table_[i] = SampleKeys(keys, static_cast<float>(i) / (CURVE_RESOLUTION - 1));
+}
+
+Bounds::Bounds() :
+    min(std::numeric_limits<float>::max()),
+    max(-std::numeric_limits<float>::max())
+{ }
+
+void Bounds::Merge(const Bounds& other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+bool Bounds::IsEmpty() const {
+    return min.x > max.x;
+}
+
+void Particles::Simulate(ParticleBuffer& buffer, std::size_t begin, std::size_t end, float dt, const glm::vec3& gravity, float drag) {
+    float dragFactor = std::max(1.0f - drag * dt, 0.0f);
+    glm::vec3 dv = gravity * dt;
+    std::size_t i = begin;
+
+    #ifdef LATREN_PARTICLES_SSE
+    __m128 dt4 = _mm_set1_ps(dt);
+    __m128 drag4 = _mm_set1_ps(dragFactor);
+    __m128 dvx = _mm_set1_ps(dv.x);
+    __m128 dvy = _mm_set1_ps(dv.y);
+    __m128 dvz = _mm_set1_ps(dv.z);
+    for (; i + BATCH_SIZE <= end; i += BATCH_SIZE) {
+        __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&buffer.velX[i]), dvx), drag4);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&buffer.velY[i]), dvy), drag4);
+        __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&buffer.velZ[i]), dvz), drag4);
+        _mm_storeu_ps(&buffer.velX[i], vx);
+        _mm_storeu_ps(&buffer.velY[i], vy);
+        _mm_storeu_ps(&buffer.velZ[i], vz);
+        _mm_storeu_ps(&buffer.posX[i], _mm_add_ps(_mm_loadu_ps(&buffer.posX[i]), _mm_mul_ps(vx, dt4)));
+        _mm_storeu_ps(&buffer.posY[i], _mm_add_ps(_mm_loadu_ps(&buffer.posY[i]), _mm_mul_ps(vy, dt4)));
+        _mm_storeu_ps(&buffer.posZ[i], _mm_add_ps(_mm_loadu_ps(&buffer.posZ[i]), _mm_mul_ps(vz, dt4)));
+        __m128 age = _mm_mul_ps(_mm_loadu_ps(&buffer.invLifetime[i]), dt4);
+        _mm_storeu_ps(&buffer.life[i], _mm_add_ps(_mm_loadu_ps(&buffer.life[i]), age));
+    }
+    #endif
+
+    // the tail (or everything without sse), written the same way so the compiler can vectorize it
+    for (; i < end; i++) {
+        buffer.velX[i] = (buffer.velX[i] + dv.x) * dragFactor;
+        buffer.velY[i] = (buffer.velY[i] + dv.y) * dragFactor;
+        buffer.velZ[i] = (buffer.velZ[i] + dv.z) * dragFactor;
+        buffer.posX[i] += buffer.velX[i] * dt;
+        buffer.posY[i] += buffer.velY[i] * dt;
+        buffer.posZ[i] += buffer.velZ[i] * dt;
+        buffer.life[i] += buffer.invLifetime[i] * dt;
+    }
+}
+
+Bounds Particles::ComputeBounds(const ParticleBuffer& buffer, std::size_t begin, std::size_t end) {
+    Bounds bounds;
+    std::size_t i = begin;
+
+    #ifdef LATREN_PARTICLES_SSE
+    if (i + BATCH_SIZE <= end) {
+        __m128 minX = _mm_loadu_ps(&buffer.posX[i]), maxX = minX;
+        __m128 minY = _mm_loadu_ps(&buffer.posY[i]), maxY = minY;
+        __m128 minZ = _mm_loadu_ps(&buffer.posZ[i]), maxZ = minZ;
+        for (i += BATCH_SIZE; i + BATCH_SIZE <= end; i += BATCH_SIZE) {
+            __m128 x = _mm_loadu_ps(&buffer.posX[i]);
+            __m128 y = _mm_loadu_ps(&buffer.posY[i]);
+            __m128 z = _mm_loadu_ps(&buffer.posZ[i]);
+            minX = _mm_min_ps(minX, x);
+            maxX = _mm_max_ps(maxX, x);
+            minY = _mm_min_ps(minY, y);
+            maxY = _mm_max_ps(maxY, y);
+            minZ = _mm_min_ps(minZ, z);
+            maxZ = _mm_max_ps(maxZ, z);
+        }
+        alignas(16) float lanes[6][BATCH_SIZE];
+        _mm_store_ps(lanes[0], minX);
+        _mm_store_ps(lanes[1], minY);
+        _mm_store_ps(lanes[2], minZ);
+        _mm_store_ps(lanes[3], maxX);
+        _mm_store_ps(lanes[4], maxY);
+        _mm_store_ps(lanes[5], maxZ);
+        for (std::size_t l = 0; l < BATCH_SIZE; l++) {
+            bounds.min = glm::min(bounds.min, glm::vec3(lanes[0][l], lanes[1][l], lanes[2][l]));
+            bounds.max = glm::max(bounds.max, glm::vec3(lanes[3][l], lanes[4][l], lanes[5][l]));
+        }
+    }
+    #endif
+
+    for (; i < end; i++) {
+        glm::vec3 p(buffer.posX[i], buffer.posY[i], buffer.posZ[i]);
+        bounds.min = glm::min(bounds.min, p);
+        bounds.max = glm::max(bounds.max, p);
+    }
+    return bounds;
+}
+
+void Particles::WriteInstances(const ParticleBuffer& buffer, const std::uint32_t* order, std::size_t begin, std::size_t end, const ColorCurve& color, const FloatCurve& size, Instance* out) {
+    for (std::size_t i = begin; i < end; i++) {
+        std::size_t p = order != nullptr ? order[i] : i;
+        float t = std::min(buffer.life[p], 1.0f);
+        Instance& instance = out[i - begin];
+        instance.x = buffer.posX[p];
+        instance.y = buffer.posY[p];
+        instance.z = buffer.posZ[p];
+        instance.size = buffer.size[p] * size.Sample(t);
+        instance.color = color.Sample(t);
+    }
+}
+
+// flips the float bits so that they sort as unsigned ints
+inline std::uint32_t FloatToSortKey(float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    std::uint32_t mask = (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+    return bits ^ mask;
+}
+
+const std::vector<std::uint32_t>& DepthSorter::Sort(const ParticleBuffer& buffer, const glm::vec3& viewPos, const glm::vec3& viewDir) {
+    std::size_t count = buffer.GetCount();
+    keys_.resize(count);
+    tmpKeys_.resize(count);
+    order_.resize(count);
+    tmpOrder_.resize(count);
+
+    // all four histograms in one pass
+    std::uint32_t histograms[4][256] = { };
+    float offset = glm::dot(viewPos, viewDir);
+    for (std::size_t i = 0; i < count; i++) {
+        float depth = buffer.posX[i] * viewDir.x + buffer.posY[i] * viewDir.y + buffer.posZ[i] * viewDir.z - offset;
+        // inverted so that the furthest ones come first
+        std::uint32_t key = ~FloatToSortKey(depth);
+        keys_[i] = key;
+        order_[i] = static_cast<std::uint32_t>(i);
+        for (int pass = 0; pass < 4; pass++)
+            histograms[pass][(key >> (pass * 8)) & 0xff]++;
+    }
+
+    for (int pass = 0; pass < 4; pass++) {
+        std::uint32_t* histogram = histograms[pass];
+        // every key has the same byte here, nothing would move
+        if (histogram[(keys_.empty() ? 0 : keys_[0] >> (pass * 8)) & 0xff] == count)
+            continue;
+        std::uint32_t sum = 0;
+        for (int b = 0; b < 256; b++) {
+            std::uint32_t c = histogram[b];
+            histogram[b] = sum;
+            sum += c;
+        }
+        int shift = pass * 8;
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint32_t dst = histogram[(keys_[i] >> shift) & 0xff]++;
+            tmpKeys_[dst] = keys_[i];
+            tmpOrder_[dst] = order_[i];
+        }
+        keys_.swap(tmpKeys_);
+        order_.swap(tmpOrder_);
+    }
+    return order_;
+}
\ No newline at end of file
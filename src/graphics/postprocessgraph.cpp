@@ -0,0 +1,115 @@
+#include <latren/graphics/postprocessgraph.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
+
+#include <algorithm>
+
+const std::string PostProcessGraph::SCENE = "SCENE";
+// pass targets are allocated in steps of this
+const int TARGET_SIZE_GRANULARITY = 32;
+
+void PostProcessGraph::AddPass(const Pass& pass) {
+    passes_.push_back(pass);
+}
+
+void PostProcessGraph::InsertPass(const Pass& pass, const std::string& before) {
+    auto it = std::find_if(passes_.begin(), passes_.end(), [&](const Pass& p) { return p.name == before; });
+    passes_.insert(it, pass);
+}
+
+void PostProcessGraph::RemovePass(const std::string& name) {
+    passes_.erase(std::remove_if(passes_.begin(), passes_.end(), [&](const Pass& p) { return p.name == name; }), passes_.end());
+}
+
+PostProcessGraph::Pass* PostProcessGraph::GetPass(const std::string& name) {
+    auto it = std::find_if(passes_.begin(), passes_.end(), [&](const Pass& p) { return p.name == name; });
+    return it != passes_.end() ? &*it : nullptr;
+}
+
+void PostProcessGraph::Execute(GLuint sceneTexture, const glm::ivec2& sceneSize, const glm::ivec2& sceneTextureSize, GLuint outputFramebuffer, const glm::ivec2& outputSize, const Shape& quad) {
+    GLState& gl = Systems::GetRenderer().GetGLState();
+    passesDrawn_ = 0;
+    outputs_.clear();
+    glm::vec2 textureSize = glm::vec2(sceneTextureSize);
+    glm::vec2 uvScale = glm::vec2(sceneSize) / textureSize;
+    glm::vec2 uvMax = (glm::vec2(sceneSize) - .5f) / textureSize;
+    outputs_[SCENE] = { sceneTexture, nullptr, glm::vec4(uvScale.x, uvScale.y, uvMax.x, uvMax.y), 1.0f / textureSize };
+
+    // the last pass that samples each output, the target goes back to the pool after that
+    std::unordered_map<std::string, const Pass*> lastReads;
+    const Pass* lastPass = nullptr;
+    for (const Pass& pass : passes_) {
+        if (!pass.enabled)
+            continue;
+        for (const auto& [sampler, source] : pass.inputs) {
+            lastReads[source] = &pass;
+        }
+        lastPass = &pass;
+    }
+    if (lastPass == nullptr)
+        return;
+
+    RenderTargetPool& pool = Systems::GetRenderer().GetRenderTargetPool();
+    quad.Bind();
+    for (const Pass& pass : passes_) {
+        if (!pass.enabled)
+            continue;
+        RenderTarget* target = nullptr;
+        glm::ivec2 size = outputSize;
+        if (&pass == lastPass) {
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+        }
+        else {
+            size = glm::ivec2(glm::vec2(sceneSize) * pass.scale);
+            size = glm::ivec2(std::max(size.x, 1), std::max(size.y, 1));
+            // rounded up so that small size changes (dynamic resolution) still get the same targets
+            RenderTargetDesc desc;
+            desc.size = (size + TARGET_SIZE_GRANULARITY - 1) / TARGET_SIZE_GRANULARITY * TARGET_SIZE_GRANULARITY;
+            desc.format = pass.format;
+            target = pool.Acquire(desc);
+            glBindFramebuffer(GL_FRAMEBUFFER, target->GetFramebuffer());
+        }
+        gl.Viewport(0, 0, size.x, size.y);
+
+        pass.shader.Use();
+        GLuint unit = 0;
+        for (const auto& [sampler, source] : pass.inputs) {
+            auto it = outputs_.find(source);
+            if (it == outputs_.end())
+                continue;
+            gl.BindTexture(GL_TEXTURE_2D, it->second.texture, unit);
+            pass.shader.SetUniform(sampler.c_str(), static_cast<int>(unit));
+            pass.shader.SetUniform((sampler + "Rect").c_str(), it->second.rect);
+            pass.shader.SetUniform((sampler + "TexelSize").c_str(), it->second.texelSize);
+            unit++;
+        }
+        if (pass.setUniforms)
+            pass.setUniforms(pass.shader);
+        glDrawArrays(GL_TRIANGLES, 0, quad.numVertices);
+        GLState::CountDraw(GL_TRIANGLES, quad.numVertices);
+        passesDrawn_++;
+
+        if (target != nullptr) {
+            if (lastReads.count(pass.name) == 0) {
+                pool.Release(target);
+            }
+            else {
+                glm::vec2 allocated = glm::vec2(target->GetSize());
+                glm::vec2 uvScale = glm::vec2(size) / allocated;
+                glm::vec2 uvMax = (glm::vec2(size) - .5f) / allocated;
+                outputs_[pass.name] = { target->GetTexture(), target, glm::vec4(uvScale.x, uvScale.y, uvMax.x, uvMax.y), 1.0f / allocated };
+            }
+        }
+        for (const auto& [sampler, source] : pass.inputs) {
+            auto it = outputs_.find(source);
+            if (it != outputs_.end() && it->second.target != nullptr && lastReads.at(source) == &pass) {
+                pool.Release(it->second.target);
+                it->second.target = nullptr;
+            }
+        }
+    }
+}
+
+std::size_t PostProcessGraph::GetPassesDrawn() const {
+    return passesDrawn_;
+}
\ No newline at end of file
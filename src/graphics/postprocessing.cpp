@@ -1,6 +1,7 @@
 #include <latren/graphics/postprocessing.h>
 
 #include <cstring>
+#include <algorithm>
 
 #define PP_UNIFORM_NAME(name) "postProcessing." #name
 #define PP_UPDATE_UNIFORM(shader, uniform) shader.SetUniform(PP_UNIFORM_NAME(uniform), uniform)
@@ -22,6 +23,12 @@ void PostProcessing::ApplyUniforms(const Shader& shader) const {
     PP_UPDATE_UNIFORM(shader, kernel.vignette.size);
     PP_UPDATE_UNIFORM(shader, kernel.vignette.treshold);
 
+    PP_UPDATE_UNIFORM(shader, blur.isActive);
+    PP_UPDATE_UNIFORM(shader, blur.blend);
+    PP_UPDATE_UNIFORM(shader, blur.vignette.isActive);
+    PP_UPDATE_UNIFORM(shader, blur.vignette.size);
+    PP_UPDATE_UNIFORM(shader, blur.vignette.treshold);
+
     PP_UPDATE_UNIFORM(shader, vignette.isActive);
     PP_UPDATE_UNIFORM(shader, vignette.size);
     PP_UPDATE_UNIFORM(shader, vignette.treshold);
@@ -31,4 +38,31 @@ void PostProcessing::ApplyUniforms(const Shader& shader) const {
     PP_UPDATE_UNIFORM(shader, contrast);
     PP_UPDATE_UNIFORM(shader, brightness);
     PP_UPDATE_UNIFORM(shader, saturation);
+}
+
+std::vector<float> PostProcessing::GetBlurWeights() const {
+    int radius = std::clamp(blur.radius, 0, Blur::MAX_RADIUS);
+    if (!blur.gaussian)
+        return Convolution::BoxBlur1D(radius);
+    // covers about 3 sigmas with the taps
+    float sigma = blur.sigma > 0.0f ? blur.sigma : std::max(radius / 3.0f, .5f);
+    return Convolution::GaussianBlur1D(radius, sigma);
+}
+
+std::vector<float> Convolution::GaussianBlur1D(int radius, float sigma) {
+    std::vector<float> weights(radius + 1);
+    float s = 2.0f * sigma * sigma;
+    float sum = 0.0f;
+    for (int i = 0; i <= radius; i++) {
+        weights[i] = std::exp(-(float) (i * i) / s);
+        sum += i == 0 ? weights[i] : 2.0f * weights[i];
+    }
+    for (float& w : weights) {
+        w /= sum;
+    }
+    return weights;
+}
+
+std::vector<float> Convolution::BoxBlur1D(int radius) {
+    return std::vector<float>(radius + 1, 1.0f / (2 * radius + 1));
 }
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <latren/graphics/programcache.h>
+#include <latren/io/resourcepath.h>
+
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+// bump when the file layout changes
+const uint32_t CACHE_VERSION = 1;
+const uint32_t CACHE_MAGIC = 0x4342504c; // 'LPBC'
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+    double compileTime;
+};
+
+// fnv-1a
+void HashBytes(uint64_t& hash, const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+void HashString(uint64_t& hash, const std::string& str) {
+    uint64_t size = str.size();
+    HashBytes(hash, &size, sizeof(size));
+    HashBytes(hash, str.data(), str.size());
+}
+
+std::string GetGLString(GLenum name) {
+    const GLubyte* str = glGetString(name);
+    return str != nullptr ? reinterpret_cast<const char*>(str) : "";
+}
+
+void ProgramCache::Init() {
+    initialized_ = true;
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    supported_ = formats > 0;
+    driver_ = GetGLString(GL_VENDOR) + "|" + GetGLString(GL_RENDERER) + "|" + GetGLString(GL_VERSION) + "|" + GetGLString(GL_SHADING_LANGUAGE_VERSION);
+    if (!supported_)
+        spdlog::info("Program binaries not supported, shaders will always be compiled");
+}
+
+std::fs::path ProgramCache::GetPath(uint64_t key) const {
+    return ResourcePath("${shadercache}").GetParsedPath() / fmt::format("{:016x}.bin", key);
+}
+
+uint64_t ProgramCache::GetKey(const std::vector<Shaders::ShaderSource>& sources) {
+    if (!initialized_)
+        Init();
+    uint64_t hash = 0xcbf29ce484222325ull;
+    HashBytes(hash, &CACHE_VERSION, sizeof(CACHE_VERSION));
+    HashString(hash, driver_);
+    for (const Shaders::ShaderSource& s : sources) {
+        uint32_t type = s.type;
+        HashBytes(hash, &type, sizeof(type));
+        HashString(hash, s.source);
+    }
+    return hash;
+}
+
+bool ProgramCache::Load(GLuint program, uint64_t key) {
+    if (!initialized_)
+        Init();
+    if (!enabled || !supported_)
+        return false;
+    double start = glfwGetTime();
+    std::fs::path path = GetPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    CacheHeader header;
+    std::vector<char> binary;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        // the length is checked against what's actually left, a broken file shouldn't get to allocate gigabytes
+        std::error_code err;
+        std::uintmax_t fileSize = std::fs::file_size(path, err);
+        bool lengthMatches = !err && fileSize >= sizeof(header) && header.length == fileSize - sizeof(header);
+        if (header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.key == key && lengthMatches) {
+            binary.resize(header.length);
+            if (!file.read(binary.data(), binary.size()))
+                binary.clear();
+        }
+    }
+    file.close();
+    if (binary.empty()) {
+        spdlog::warn("Invalid program binary '{}'", path.filename().generic_string());
+        return false;
+    }
+
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // usually a driver update that didn't change the version string
+        spdlog::debug("Program binary '{}' rejected by the driver", path.filename().generic_string());
+        std::error_code err;
+        std::fs::remove(path, err);
+        stats_.rejected++;
+        return false;
+    }
+    stats_.hits++;
+    stats_.loadTime += (glfwGetTime() - start) * 1000.0;
+    stats_.savedTime += header.compileTime;
+    return true;
+}
+
+void ProgramCache::PrepareProgram(GLuint program) {
+    if (enabled && supported_)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::Store(GLuint program, uint64_t key, double compileTime) {
+    stats_.misses++;
+    stats_.compileTime += compileTime;
+    if (!enabled || !supported_)
+        return;
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0)
+        return;
+
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.key = key;
+    std::vector<char> binary(length);
+    GLenum format = GL_NONE;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+    header.compileTime = compileTime;
+
+    std::error_code err;
+    std::fs::path path = GetPath(key);
+    std::fs::create_directories(path.parent_path(), err);
+    // written next to it first so that a crash halfway doesn't leave a broken binary behind
+    std::fs::path tmpPath = path;
+    tmpPath += ".tmp";
+    std::ofstream file(tmpPath, std::ios::binary);
+    if (!file.is_open()) {
+        spdlog::warn("Cannot write program binary '{}'", path.filename().generic_string());
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), header.length);
+    file.close();
+    std::fs::rename(tmpPath, path, err);
+    if (err)
+        std::fs::remove(tmpPath, err);
+}
+
+const ProgramCache::Stats& ProgramCache::GetStats() const {
+    return stats_;
+}
+
+void ProgramCache::ResetStats() {
+    stats_ = Stats();
+}
\ No newline at end of file
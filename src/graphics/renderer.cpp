@@ -2,14 +2,37 @@
 #include <latren/graphics/postprocessing.h>
 #include <latren/graphics/component/light.h>
 #include <latren/graphics/component/renderable.h>
+#include <latren/graphics/component/meshrenderer.h>
 #include <latren/systems.h>
 #include <latren/gamewindow.h>
 #include <latren/physics/physics.h>
 #include <latren/ui/canvas.h>
 #include <latren/io/resourcemanager.h>
 #include <latren/io/configs.h>
+#include <latren/threads/threadpool.h>
 
 #include <spdlog/spdlog.h>
+#include <typeinfo>
+#include <algorithm>
+#include <cstddef>
+
+// the instance model matrix takes up 4 attribute locations starting from this
+const GLuint INSTANCE_MATRIX_LOCATION = 3;
+// right after the matrix columns
+const GLuint INSTANCE_LAYER_LOCATION = INSTANCE_MATRIX_LOCATION + 4;
+// bytes of streamed geometry per frame
+const GLsizeiptr STREAM_BUFFER_SEGMENT_SIZE = 1 << 20;
+// low-res on purpose, it's read back to the cpu every frame
+const glm::ivec2 OCCLUSION_BUFFER_SIZE = glm::ivec2(256, 144);
+// fewer than this per worker isn't worth the handoff
+const std::size_t MIN_RENDERERS_PER_COMMAND_LIST = 64;
+const std::string BLUR_HORIZONTAL_PASS = "blurHorizontal";
+const std::string BLUR_VERTICAL_PASS = "blurVertical";
+const std::string COMPOSITE_PASS = "composite";
+// timer sections, the render passes go first
+const std::size_t GPU_TIMER_POST_PROCESSING = RenderPass::TOTAL_RENDER_PASSES;
+const std::size_t GPU_TIMER_UI = GPU_TIMER_POST_PROCESSING + 1;
+const std::size_t GPU_TIMER_SECTIONS = GPU_TIMER_UI + 1;
 
 Renderer::Renderer(Viewport* window) {
     SetViewport(window);
@@ -19,11 +42,21 @@ Renderer::~Renderer() {
     for (GLuint s : shaders_)
         glDeleteProgram(s);
 
-    glDeleteFramebuffers(1, &fbo_);
-    glDeleteRenderbuffers(1, &rbo_);
-    glDeleteTextures(1, &framebufferTexture_);
-    glDeleteFramebuffers(1, &MSAAFbo_);
-    glDeleteTextures(1, &MSAATextureColorBuffer_);
+    cameraUniforms_.Delete();
+    lightClusters_.Delete();
+    glDeleteBuffers(1, &instanceBuffer_);
+    if (multiDrawSupported_) {
+        glDeleteBuffers(1, &indirectBuffer_);
+        glDeleteBuffers(1, &instanceIndexBuffer_);
+    }
+    meshArenas_.Delete();
+    debugDraw_.Delete();
+    occlusion_.Delete();
+    staticBatches_.Clear();
+    dynamicResolution_.Delete();
+    gpuTimers_.Delete();
+    statsLog_.Close();
+    streamBuffer_.Delete();
 
     shaders_.clear();
 
@@ -32,20 +65,22 @@ Renderer::~Renderer() {
             delete v;
     }
     canvases_.clear();
+    // after the canvases since the text components give their targets back
+    renderTargets_.Delete();
 }
 
 bool Renderer::Init() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glEnable(GL_DEPTH_TEST);
+    glState_.Enable(GL_DEPTH_TEST);
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
+    glState_.Enable(GL_CULL_FACE);
+    glState_.CullFace(GL_BACK);
+    glState_.Enable(GL_BLEND);
+    glState_.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
 
     glfwWindowHint(GLFW_SAMPLES, 4);
-    glEnable(GL_MULTISAMPLE);
+    glState_.Enable(GL_MULTISAMPLE);
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // debug line rendering
 
     float aspectRatio = 16.0f / 9.0f;
@@ -55,40 +90,35 @@ bool Renderer::Init() {
     camera_.pos = glm::vec3(0.0f);
 
     viewportSize_ = viewport_->GetSize();
+    renderSize_ = viewportSize_;
 
-    glGenFramebuffers(1, &MSAAFbo_);
-    glBindFramebuffer(GL_FRAMEBUFFER, MSAAFbo_);
-
-    glGenTextures(1, &MSAATextureColorBuffer_);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, MSAATextureColorBuffer_);
-    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, viewportSize_.x, viewportSize_.y, GL_TRUE);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, MSAATextureColorBuffer_, 0);
-
-    glGenRenderbuffers(1, &rbo_);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo_);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, viewportSize_.x, viewportSize_.y);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo_);
+    AcquireSceneTargets();
 
-    glGenFramebuffers(1, &fbo_);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    cameraUniforms_.Create(UniformBlocks::Binding::CAMERA, sizeof(UniformBlocks::CameraData));
+    lightClusters_.Init();
+    lightsDirty_ = true;
 
-    glGenTextures(1, &framebufferTexture_);
-    glBindTexture(GL_TEXTURE_2D, framebufferTexture_);
-    Systems::GetResources().GetTextureManager()->Set("FRAMEBUFFER", framebufferTexture_);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, viewportSize_.x, viewportSize_.y, 0, GL_RGB, GL_UNSIGNED_BYTE, GL_NONE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebufferTexture_, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glGenBuffers(1, &instanceBuffer_);
+    multiDrawSupported_ = GLEW_VERSION_4_3;
+    if (multiDrawSupported_) {
+        glGenBuffers(1, &indirectBuffer_);
+        glGenBuffers(1, &instanceIndexBuffer_);
+    }
+    else {
+        spdlog::info("OpenGL 4.3 not supported, drawing the instanced meshes without multi-draw-indirect");
+    }
 
     framebufferShader_ = Shader(Shaders::ShaderID::FRAMEBUFFER);
 
-    Shapes::CreateDefaultShapes();
+    streamBuffer_.Create(STREAM_BUFFER_SEGMENT_SIZE);
+    if (!streamBuffer_.IsPersistent())
+        spdlog::info("ARB_buffer_storage not supported, streaming geometry with glBufferSubData");
+
+    Shapes::CreateDefaultShapes(streamBuffer_.GetBuffer());
+    debugDraw_.Init(streamBuffer_.GetBuffer());
+    occlusion_.Init(OCCLUSION_BUFFER_SIZE);
+    dynamicResolution_.Init();
+    gpuTimers_.Init(GPU_TIMER_SECTIONS);
 
     framebufferShape_ = Shapes::GetDefaultShape(Shapes::DefaultShape::RECTANGLE_VEC2_VEC2);
     const float quadVertices[] = {
@@ -103,6 +133,32 @@ bool Renderer::Init() {
     };
     framebufferShape_.SetVertexData(quadVertices);
 
+    PostProcessGraph::Pass blurHorizontal;
+    blurHorizontal.name = BLUR_HORIZONTAL_PASS;
+    blurHorizontal.shader = Shader(Shaders::ShaderID::BLUR);
+    blurHorizontal.inputs = { { "source", PostProcessGraph::SCENE } };
+    blurHorizontal.enabled = false;
+    PostProcessGraph::Pass blurVertical = blurHorizontal;
+    blurVertical.name = BLUR_VERTICAL_PASS;
+    blurVertical.inputs = { { "source", BLUR_HORIZONTAL_PASS } };
+    blurHorizontal.setUniforms = [this](const Shader& shader) {
+        shader.SetUniform("direction", glm::vec2(postProcessing_.blur.offset, 0.0f));
+        shader.SetUniform("radius", blurRadius_);
+        shader.SetUniform("weights", blurWeights_);
+    };
+    blurVertical.setUniforms = [this](const Shader& shader) {
+        shader.SetUniform("direction", glm::vec2(0.0f, postProcessing_.blur.offset));
+        shader.SetUniform("radius", blurRadius_);
+        shader.SetUniform("weights", blurWeights_);
+    };
+    PostProcessGraph::Pass composite;
+    composite.name = COMPOSITE_PASS;
+    composite.shader = framebufferShader_;
+    composite.inputs = { { "screenTexture", PostProcessGraph::SCENE }, { "blurTexture", BLUR_VERTICAL_PASS } };
+    postProcessGraph_.AddPass(blurHorizontal);
+    postProcessGraph_.AddPass(blurVertical);
+    postProcessGraph_.AddPass(composite);
+
     std::shared_ptr<Material> missingMaterial = std::make_shared<Material>(Shaders::ShaderID::STROBE_UNLIT);
     missingMaterial->SetShaderUniform("colors[0]", glm::vec3(0.0f));
     missingMaterial->SetShaderUniform("colors[1]", glm::vec3(1.0f, 0.0f, 1.0f));
@@ -114,24 +170,38 @@ bool Renderer::Init() {
 }
 
 void Renderer::UpdateLighting() {
-    for (GLuint shader : shaders_) {
-        glUseProgram(shader);
-        Lights::ResetIndices();
-        Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<Lights::ILight>([&](Lights::ILight& l, IComponentMemoryPool&) {
-            while (Lights::IsReserved(Lights::LIGHTS_INDEX)) {
-                Lights::LIGHTS_INDEX++;
-            }
-            l.UseAsNext();
-            l.ApplyLight(shader);
-        });
-        if (Lights::LIGHTS_INDEX < maxRenderedLights_) {
-            for (int i = Lights::LIGHTS_INDEX; i < maxRenderedLights_; i++) {
-                if (!Lights::IsReserved(i))
-                    glUniform1i(glGetUniformLocation(shader, std::string("lights[" + std::to_string(i) + "].enabled").c_str()), GL_FALSE);
-            }
+    Lights::ResetIndices();
+    int skippedLights = 0;
+    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<Lights::ILight>([&](Lights::ILight& l, IComponentMemoryPool&) {
+        while (Lights::IsReserved(Lights::LIGHTS_INDEX)) {
+            Lights::LIGHTS_INDEX++;
+        }
+        l.UseAsNext();
+        if (l.GetIndex() >= Lights::MAX_LIGHTS) {
+            skippedLights++;
+            return;
         }
+        if (l.GetIndex() >= lights_.size())
+            lights_.resize(l.GetIndex() + 1);
+        Lights::LightData& data = lights_.at(l.GetIndex());
+        data = Lights::LightData();
+        l.ApplyLight(data);
+    });
+    for (int i = std::min<int>(Lights::LIGHTS_INDEX, lights_.size()); i < lights_.size(); i++) {
+        if (!Lights::IsReserved(i))
+            lights_[i].enabled = GL_FALSE;
     }
-    maxRenderedLights_ = std::max(Lights::LIGHTS_INDEX, maxRenderedLights_);
+    if (skippedLights > 0)
+        spdlog::warn("Too many lights, " + std::to_string(skippedLights) + " won't be rendered");
+    lightsDirty_ = true;
+}
+
+void Renderer::UpdateLight(const Lights::ILight& l) {
+    int i = l.GetIndex();
+    if (i < 0 || i >= lights_.size())
+        return;
+    l.ApplyLight(lights_[i]);
+    lightsDirty_ = true;
 }
 
 void Renderer::SetViewport(Viewport* viewport) {
@@ -145,45 +215,331 @@ Camera& Renderer::GetCamera() {
 void Renderer::CopyShadersFromResources() {
     const auto& shaderMap = Systems::GetResources().GetShaderManager()->GetAll();
     shaders_.clear();
+    instancedShaders_.clear();
     std::transform(shaderMap.begin(), shaderMap.end(), std::back_inserter(shaders_), [](const auto& s) { return s.second; });
 }
 
 void Renderer::Start() {
     CopyShadersFromResources();
     UpdateLighting();
-    UpdateFrustum();
+    BuildStaticBVH();
 }
 
 void Renderer::SortMeshesByDistance() {
-    std::sort(renderablesOnFrustum_.begin(), renderablesOnFrustum_.end(), [&](GeneralComponentReference& r1, GeneralComponentReference& r2) {
-        glm::vec3 pos1 = r1.CastComponent<IRenderable>().GetPosition();
-        glm::vec3 pos2 = r2.CastComponent<IRenderable>().GetPosition();
-        return glm::distance(camera_.pos, pos1) > glm::distance(camera_.pos, pos2);
+    // just updates the distances, the visible renderables are sorted with these every frame
+    for (std::size_t i = 0; i < renderables_.size(); i++) {
+        if (!renderables_[i].IsNull())
+            distances_[i] = glm::distance(camera_.pos, renderables_[i].CastComponent<IRenderable>().GetPosition());
+    }
+    for (std::size_t i = 0; i < staticRenderables_.size(); i++) {
+        staticDistances_[i] = glm::distance(camera_.pos, staticPositions_[i]);
+    }
+}
+
+bool Renderer::IsInStaticBVH(const IRenderable& r, const GeneralComponentReference& ref) const {
+    return r.staticIndex_ < staticRenderables_.size() && staticRenderables_[r.staticIndex_] == ref;
+}
+
+void Renderer::RebuildStaticBVH() {
+    staticRenderables_.clear();
+    staticPositions_.clear();
+    std::vector<ViewFrustum::AABB> bounds;
+    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool& pool) {
+        ViewFrustum::AABB aabb;
+        if (!r.IsStatic() || r.IsAlwaysOnFrustum() || !r.GetWorldAABB(aabb))
+            return;
+        r.staticIndex_ = staticRenderables_.size();
+        staticRenderables_.push_back({ &pool, static_cast<IComponent&>(r) });
+        staticPositions_.push_back(r.GetPosition());
+        bounds.push_back(aabb);
+    });
+    staticBvh_.Build(bounds);
+    staticDistances_.assign(staticRenderables_.size(), 0.0f);
+    staticExcluded_.Resize(staticRenderables_.size());
+    deadStaticRenderables_ = 0;
+    if (!staticRenderables_.empty())
+        spdlog::info("Built static BVH ({} renderables, {} nodes)", staticRenderables_.size(), staticBvh_.GetNodeCount());
+}
+
+void Renderer::BuildStaticBVH() {
+    RebuildStaticBVH();
+    BuildStaticBatches();
+    UpdateFrustum();
+    SortMeshesByDistance();
+}
+
+void Renderer::AddStaticRenderables() {
+    std::vector<ViewFrustum::AABB> bounds;
+    std::vector<GeneralComponentReference> batched;
+    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool& pool) {
+        GeneralComponentReference ref = { &pool, static_cast<IComponent&>(r) };
+        ViewFrustum::AABB aabb;
+        if (IsInStaticBVH(r, ref) || !r.IsStatic() || r.IsAlwaysOnFrustum() || !r.GetWorldAABB(aabb))
+            return;
+        r.staticIndex_ = staticRenderables_.size();
+        staticRenderables_.push_back(ref);
+        staticPositions_.push_back(r.GetPosition());
+        bounds.push_back(aabb);
+        const MeshRenderer* meshRenderer = dynamic_cast<const MeshRenderer*>(&r);
+        if (useStaticBatching && !r.staticBatched_ && meshRenderer != nullptr && StaticBatches::CanBatch(*meshRenderer)) {
+            r.staticBatched_ = true;
+            batched.push_back(ref);
+        }
     });
+    if (bounds.empty())
+        return;
+    staticBvh_.Insert(bounds);
+    staticDistances_.resize(staticRenderables_.size(), 0.0f);
+    staticExcluded_.Resize(staticRenderables_.size());
+    // only the new ones get merged, into a group of their own
+    staticBatches_.Add(batched);
+    UpdateStaticBatchedSet();
+    UpdateFrustum();
+    SortMeshesByDistance();
+}
+
+void Renderer::RemoveStaticRenderables() {
+    std::size_t live = 0;
+    for (GeneralComponentReference& ref : staticRenderables_) {
+        if (ref.pool == nullptr)
+            continue;
+        if (ref.IsNull()) {
+            // cleared so that a new component at the same index can't end up in this slot
+            ref = { nullptr, 0 };
+            deadStaticRenderables_++;
+            continue;
+        }
+        live++;
+    }
+    // the dead slots are skipped everywhere, the tree is only rebuilt once they're taking up too much of it
+    if (deadStaticRenderables_ > live)
+        RebuildStaticBVH();
+    UpdateStaticBatches();
+    UpdateFrustum();
+    SortMeshesByDistance();
+}
+
+void Renderer::UpdateStaticBatchedSet() {
+    // they stay in the bvh so that the spatial queries still find them
+    staticBatched_.Resize(staticRenderables_.size());
+    staticBatched_.Clear();
+    for (std::size_t i = 0; i < staticRenderables_.size(); i++) {
+        if (!staticRenderables_[i].IsNull() && staticRenderables_[i].CastComponent<IRenderable>().staticBatched_)
+            staticBatched_.Set(i);
+    }
+}
+
+void Renderer::UpdateStaticBatches() {
+    staticBatchesDirty_ = false;
+    for (GeneralComponentReference& ref : staticBatches_.RemoveStale()) {
+        ref.CastComponent<IRenderable>().staticBatched_ = false;
+    }
+    UpdateStaticBatchedSet();
+}
+
+void Renderer::BuildStaticBatches() {
+    staticBatchesDirty_ = false;
+    std::vector<GeneralComponentReference> batched;
+    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool& pool) {
+        r.staticBatched_ = false;
+        const MeshRenderer* meshRenderer = dynamic_cast<const MeshRenderer*>(&r);
+        if (!useStaticBatching || meshRenderer == nullptr || !StaticBatches::CanBatch(*meshRenderer))
+            return;
+        r.staticBatched_ = true;
+        batched.push_back({ &pool, static_cast<IComponent&>(r) });
+    });
+    staticBatches_.Build(batched);
+    UpdateStaticBatchedSet();
+}
+
+void Renderer::RefitStaticBVH() {
+    for (std::size_t i = 0; i < staticRenderables_.size(); i++) {
+        GeneralComponentReference& ref = staticRenderables_[i];
+        if (ref.IsNull())
+            continue;
+        IRenderable& r = ref.CastComponent<IRenderable>();
+        ViewFrustum::AABB aabb;
+        if (r.GetWorldAABB(aabb))
+            staticBvh_.Update((std::uint32_t) i, aabb);
+        staticPositions_[i] = r.GetPosition();
+    }
+    staticBvh_.Refit();
+    // the batches have the old transforms baked in, and there's no telling which ones moved
+    BuildStaticBatches();
 }
 
 void Renderer::UpdateFrustum() {
-    renderablesOnFrustum_.clear();
+    renderables_.clear();
+    staticExcluded_.Clear();
+    std::size_t batchedCount = 0;
     Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool& pool) {
-        if (r.IsAlwaysOnFrustum() || r.IsOnFrustum(camera_.frustum))
-            renderablesOnFrustum_.push_back({ &pool, static_cast<IComponent&>(r) });
+        GeneralComponentReference ref = { &pool, static_cast<IComponent&>(r) };
+        if (r.staticBatched_)
+            batchedCount++;
+        if (IsInStaticBVH(r, ref)) {
+            if (r.IsStatic())
+                return;
+            staticExcluded_.Set(r.staticIndex_);
+        }
+        // its geometry is still in the batches
+        if (r.staticBatched_ && !r.IsStatic())
+            staticBatchesDirty_ = true;
+        renderables_.push_back(ref);
     });
+    // some of the batched ones have been destroyed
+    if (batchedCount != staticBatches_.GetStats().renderers)
+        staticBatchesDirty_ = true;
+    RepackCullingBounds();
+    CullRenderables();
+}
+
+void Renderer::RepackCullingBounds() {
+    std::size_t count = renderables_.size();
+    cullingBounds_.Resize(count);
+    alwaysVisible_.Resize(count);
+    distances_.resize(count);
+    dynamicGrid_.Clear();
+    dynamicGrid_.Resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        IRenderable& r = renderables_[i].CastComponent<IRenderable>();
+        r.cullingIndex_ = i;
+        ViewFrustum::AABB aabb;
+        bool hasBounds = r.GetWorldAABB(aabb);
+        if (hasBounds) {
+            cullingBounds_.Set(i, aabb);
+            dynamicGrid_.Update((std::uint32_t) i, aabb);
+        }
+        if (r.IsAlwaysOnFrustum() || !hasBounds)
+            alwaysVisible_.Set(i);
+    }
+}
+
+void Renderer::UpdateCullingBounds(const IRenderable& r, const GeneralComponentReference& ref) {
+    // copied components carry the index with them, so make sure the slot is actually this one's
+    std::size_t i = r.cullingIndex_;
+    if (i >= renderables_.size() || renderables_[i] != ref)
+        return;
+    ViewFrustum::AABB aabb;
+    if (r.GetWorldAABB(aabb)) {
+        cullingBounds_.Set(i, aabb);
+        dynamicGrid_.Update((std::uint32_t) i, aabb);
+    }
+}
+
+void Renderer::CullRenderables() {
+    Culling::CullAABBs(camera_.frustum, cullingBounds_, visibility_);
+    visibility_.Merge(alwaysVisible_);
+    staticBvh_.CullFrustum(camera_.frustum, staticVisibility_);
+    staticVisibility_.Subtract(staticExcluded_);
+    staticVisibility_.Subtract(staticBatched_);
+
+    visibleRenderables_.clear();
+    visibility_.ForEach([&](std::size_t i) {
+        if (!renderables_[i].IsNull())
+            visibleRenderables_.push_back({ distances_[i], renderables_[i] });
+    });
+    staticVisibility_.ForEach([&](std::size_t i) {
+        if (!staticRenderables_[i].IsNull())
+            visibleRenderables_.push_back({ staticDistances_[i], staticRenderables_[i] });
+    });
+    // furthest first
+    std::sort(visibleRenderables_.begin(), visibleRenderables_.end(), [](const VisibleRenderable& a, const VisibleRenderable& b) {
+        if (a.distance != b.distance)
+            return a.distance > b.distance;
+        return a.ref.index < b.ref.index;
+    });
+    renderablesOnFrustum_.clear();
+    for (const VisibleRenderable& v : visibleRenderables_)
+        renderablesOnFrustum_.push_back(v.ref);
+    // the excluded static ones are in both lists and the batched ones are drawn separately
+    stats_.cullingTested = renderables_.size() + staticRenderables_.size() - staticExcluded_.Count() - staticBatched_.Count();
+    stats_.frustumCulled = stats_.cullingTested - std::min(visibleRenderables_.size(), stats_.cullingTested);
+}
+
+void Renderer::CullOccludedRenderables() {
+    occlusion_.ReadBack();
+    occluders_.clear();
+    auto it = renderablesOnFrustum_.begin();
+    while (it != renderablesOnFrustum_.end()) {
+        if (it->IsNull()) {
+            ++it;
+            continue;
+        }
+        IRenderable& r = it->CastComponent<IRenderable>();
+        ViewFrustum::AABB aabb;
+        bool hasBounds = r.GetWorldAABB(aabb);
+        if (hasBounds && r.IsOccluder())
+            occluders_.push_back(&r);
+        if (hasBounds && r.IsOccludee() && !r.IsAlwaysOnFrustum()) {
+            stats_.occlusionTests++;
+            if (occlusion_.IsOccluded(aabb)) {
+                stats_.occlusionCulled++;
+                stats_.occlusionCulledDrawCalls += r.GetDrawCallCount();
+                it = renderablesOnFrustum_.erase(it);
+                continue;
+            }
+        }
+        ++it;
+    }
+    if (occluders_.empty()) {
+        occlusion_.Invalidate();
+        return;
+    }
+    // these get tested against next frame
+    occlusion_.RenderOccluders(occluders_, camera_.projectionMatrix * camera_.viewMatrix);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneTarget_->GetFramebuffer());
+    glState_.Viewport(0, 0, renderSize_.x, renderSize_.y);
+}
+
+void Renderer::UpdateUniformBuffers() {
+    UniformBlocks::CameraData cameraData;
+    cameraData.projection = camera_.projectionMatrix;
+    cameraData.view = camera_.viewMatrix;
+    cameraData.viewPos = camera_.pos;
+    cameraData.time = (float) Systems::GetTime();
+    cameraUniforms_.Update(&cameraData, sizeof(cameraData));
+
+    if (lightsDirty_) {
+        lightClusters_.UpdateLights(lights_);
+        lightsDirty_ = false;
+    }
+    lightClusters_.Update(camera_, renderSize_, lights_);
+    lightClusters_.Bind();
+    stats_.clusteredLights = lightClusters_.GetAssignmentCount();
 }
 
 void Renderer::Render() {
+    double start = glfwGetTime();
+    stats_ = RenderStats();
+    glState_.ResetCounters();
+    gpuTimers_.BeginFrame();
+    if (staticBatchesDirty_)
+        UpdateStaticBatches();
+    dynamicResolution_.BeginFrame();
+    renderSize_ = dynamicResolution_.GetRenderSize(viewportSize_);
+    stats_.gpuFrameTime = dynamicResolution_.GetGPUFrameTime();
+    stats_.resolutionScale = dynamicResolution_.GetScale();
+    UpdateUniformBuffers();
+
     // first pass (draw into framebuffer)
-    glBindFramebuffer(GL_FRAMEBUFFER, MSAAFbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneTarget_->GetFramebuffer());
+    glState_.Viewport(0, 0, renderSize_.x, renderSize_.y);
     
-    glEnable(GL_DEPTH_TEST);
+    glState_.Enable(GL_DEPTH_TEST);
 
     glClearColor(skyboxColor.r, skyboxColor.g, skyboxColor.b, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glUseProgram(0);
-    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool&) {
-        if (!r.IsStatic())
+    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool& pool) {
+        if (!r.IsStatic()) {
             r.CalculateMatrices();
+            UpdateCullingBounds(r, { &pool, static_cast<IComponent&>(r) });
+        }
     });
+    CullRenderables();
+    if (useOcclusionCulling)
+        CullOccludedRenderables();
+    stats_.cullingVisible = renderablesOnFrustum_.size();
     // todo: cache these
     for (auto& pass : renderPasses_) {
         pass.clear();
@@ -195,7 +551,9 @@ void Renderer::Render() {
             it = renderablesOnFrustum_.erase(it);
             continue;
         }
-        renderPasses_[ref.CastComponent<IRenderable>().GetRenderPass()].push_back(ref);
+        IRenderable& renderable = ref.CastComponent<IRenderable>();
+        renderable.UpdateLOD(camera_);
+        renderPasses_[renderable.GetRenderPass()].push_back(ref);
         ++it;
     }
 
@@ -203,27 +561,21 @@ void Renderer::Render() {
 
     // draw skybox
     if (skybox != nullptr) {
-        glDepthFunc(GL_LEQUAL);
-        glCullFace(GL_FRONT);
-        glEnable(GL_DEPTH_CLAMP);
+        glState_.DepthFunc(GL_LEQUAL);
+        glState_.CullFace(GL_FRONT);
+        glState_.Enable(GL_DEPTH_CLAMP);
 
         const Shader* shader = &skybox->material->GetShader();
         shader->Use();
-        glm::mat4 skyboxView = glm::mat4(glm::mat3(camera_.viewMatrix));
-        shader->SetUniform("view", skyboxView);
-        shader->SetUniform("projection", camera_.projectionMatrix);
         shader->SetUniform("clippingFar", camera_.clippingFar);
         
-        glBindVertexArray(skybox->vao);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skybox->ebo);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+        skybox->Bind();
+        glState_.BindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
 
         skybox->Render();
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
-        glCullFace(GL_BACK);
-        glDisable(GL_DEPTH_CLAMP);
+        glState_.DepthFunc(GL_LESS);
+        glState_.CullFace(GL_BACK);
+        glState_.Disable(GL_DEPTH_CLAMP);
     }
     
     DoRenderPass(RenderPass::LATE);
@@ -234,32 +586,71 @@ void Renderer::Render() {
         DebugDrawNormals();
     if (showHitboxes)
         DebugDrawHitboxes();
+    debugDraw_.Flush(camera_.projectionMatrix * camera_.viewMatrix);
 
     // second pass (draw framebuffer onto screen)
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, MSAAFbo_);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
-    glBlitFramebuffer(0, 0, viewportSize_.x, viewportSize_.y, 0, 0, viewportSize_.x, viewportSize_.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneTarget_->GetFramebuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveTarget_->GetFramebuffer());
+    glBlitFramebuffer(0, 0, renderSize_.x, renderSize_.y, 0, 0, renderSize_.x, renderSize_.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
+    // the rest (and the ui) is at the native resolution
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RestoreViewport();
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_DEPTH_TEST);
+    glState_.Disable(GL_DEPTH_TEST);
 
-    framebufferShader_.Use();
-    framebufferShape_.Bind();
-    glBindTexture(GL_TEXTURE_2D, framebufferTexture_);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    // the composite upscales the corner the scene was drawn into
+    gpuTimers_.Begin(GPU_TIMER_POST_PROCESSING);
+    postProcessGraph_.Execute(resolveTarget_->GetTexture(), renderSize_, resolveTarget_->GetSize(), 0, viewportSize_, framebufferShape_);
+    gpuTimers_.End(GPU_TIMER_POST_PROCESSING);
+    stats_.postProcessPasses = postProcessGraph_.GetPassesDrawn();
 
-    glEnable(GL_DEPTH_TEST);
+    glState_.Enable(GL_DEPTH_TEST);
     glClear(GL_DEPTH_BUFFER_BIT);
     DoRenderPass(RenderPass::AFTER_POST_PROCESSING);
-    glDisable(GL_DEPTH_TEST);
+    glState_.Disable(GL_DEPTH_TEST);
+    gpuTimers_.Begin(GPU_TIMER_UI);
     for (auto& c : canvases_) {
         c.second->Update();
         c.second->Draw();
     }
+    gpuTimers_.End(GPU_TIMER_UI);
+
+    glState_.Enable(GL_DEPTH_TEST);
+    dynamicResolution_.EndFrame();
+    streamBuffer_.NextFrame();
+    renderTargets_.NextFrame();
+    stats_.renderTargets = renderTargets_.GetStats().targets;
+    stats_.renderTargetMemory = renderTargets_.GetStats().memoryUsage;
+    stats_.renderTargetAllocations = renderTargets_.GetStats().allocations;
+    stats_.renderTargetFrees = renderTargets_.GetStats().frees;
+
+    const GLState::Counters& counters = glState_.GetCounters();
+    stats_.stateChanges = counters.calls - counters.elided;
+    stats_.stateChangesElided = counters.elided;
+    stats_.glDrawCalls = counters.draws;
+    stats_.triangles = counters.triangles;
+    stats_.instances = counters.instances;
+    stats_.programBinds = counters.programBinds;
+    stats_.textureBinds = counters.textureBinds;
+    stats_.vertexArrayBinds = counters.vertexArrayBinds;
+    stats_.uniformCalls = counters.uniforms;
+    stats_.uploadBytes = counters.uploadBytes;
+    gpuTimers_.EndFrame();
+    for (int p = 0; p < RenderPass::TOTAL_RENDER_PASSES; p++)
+        stats_.passGPUTime[p] = gpuTimers_.GetTime(p);
+    stats_.postProcessGPUTime = gpuTimers_.GetTime(GPU_TIMER_POST_PROCESSING);
+    stats_.uiGPUTime = gpuTimers_.GetTime(GPU_TIMER_UI);
+    if (glState_.validateState)
+        glState_.Validate();
+    stats_.cpuRenderTime = static_cast<float>((glfwGetTime() - start) * 1000.0);
+    frameStats_ = stats_;
+    statsLog_.Write(frameStats_);
+}
 
-    glEnable(GL_DEPTH_TEST);
+void IRenderable::SetDepthTest(bool enabled) {
+    Systems::GetRenderer().GetGLState().SetEnabled(GL_DEPTH_TEST, enabled);
 }
 
 void Renderer::RenderItem(IRenderable& renderable, int renderMode) {
@@ -267,34 +658,327 @@ void Renderer::RenderItem(IRenderable& renderable, int renderMode) {
 }
 
 void Renderer::DoRenderPass(RenderPass::Enum pass) {
+    // only the normal pass is instanced, the others might rely on the distance sorting
+    bool instancing = useInstancing && pass == RenderPass::NORMAL;
+    // same goes for the command lists, they're replayed after the rest of the pass
+    bool recording = useCommandLists && pass == RenderPass::NORMAL;
+    std::size_t draws = glState_.GetCounters().draws;
+    gpuTimers_.Begin(pass);
+    if (pass == RenderPass::NORMAL && !staticBatches_.IsEmpty()) {
+        std::size_t meshes = 0;
+        std::size_t drawCalls = staticBatches_.Render(camera_.frustum, meshes);
+        stats_.drawCalls += drawCalls;
+        stats_.unbatchedDrawCalls += meshes;
+        stats_.staticBatchDrawCalls += drawCalls;
+        stats_.staticBatchedMeshes += meshes;
+    }
     for (GeneralComponentReference& ref : renderPasses_[pass]) {
-        RenderItem(ref.CastComponent<IRenderable>());
+        IRenderable& renderable = ref.CastComponent<IRenderable>();
+        // derived renderers could override the rendering so check for the exact type
+        bool isMeshRenderer = typeid(renderable) == typeid(MeshRenderer);
+        if (instancing && isMeshRenderer && QueueInstances(static_cast<MeshRenderer&>(renderable)))
+            continue;
+        if (recording && isMeshRenderer) {
+            recordedRenderers_.push_back(static_cast<const MeshRenderer*>(&renderable));
+            continue;
+        }
+        RenderItem(renderable);
+        std::size_t drawCalls = renderable.GetDrawCallCount();
+        stats_.drawCalls += drawCalls;
+        stats_.unbatchedDrawCalls += drawCalls;
+    }
+    RecordCommandLists();
+    SubmitCommandLists();
+    DrawInstances();
+    gpuTimers_.End(pass);
+    stats_.passDrawCalls[pass] += glState_.GetCounters().draws - draws;
+}
+
+void Renderer::RecordCommandLists() {
+    if (recordedRenderers_.empty())
+        return;
+    Threads::ThreadPool& pool = Systems::GetThreadPool();
+    std::size_t lists = pool.GetChunkCount(recordedRenderers_.size(), MIN_RENDERERS_PER_COMMAND_LIST);
+    if (commandLists_.size() < lists)
+        commandLists_.resize(lists);
+    // nothing in here can touch gl or the renderer, the lists are the only output
+    pool.ParallelFor(recordedRenderers_.size(), MIN_RENDERERS_PER_COMMAND_LIST, [&](std::size_t list, std::size_t begin, std::size_t end) {
+        CommandList& commands = commandLists_[list];
+        commands.Clear();
+        for (std::size_t i = begin; i < end; i++) {
+            recordedRenderers_[i]->RecordCommands(commands);
+        }
+    });
+    stats_.commandLists += lists;
+    recordedRenderers_.clear();
+}
+
+void Renderer::SubmitCommandLists() {
+    for (CommandList& commands : commandLists_) {
+        if (commands.IsEmpty())
+            continue;
+        commands.Submit(glState_, uniformLocations_);
+        std::size_t drawCalls = commands.GetDrawCount();
+        stats_.drawCalls += drawCalls;
+        stats_.unbatchedDrawCalls += drawCalls;
+        stats_.recordedDrawCalls += drawCalls;
+        commands.Clear();
+    }
+}
+
+const Shader* Renderer::GetShaderVariant(std::unordered_map<GLuint, std::optional<Shader>>& variants, const Shader& shader, const std::string& suffix) {
+    GLuint program = shader.GetProgram();
+    auto it = variants.find(program);
+    if (it == variants.end()) {
+        std::optional<Shader> variant;
+        std::string variantId = shader.GetIDString() + suffix;
+        if (Systems::GetResources().GetShaderManager()->HasLoaded(variantId))
+            variant = Shader(variantId);
+        it = variants.insert({ program, variant }).first;
+    }
+    return it->second.has_value() ? &it->second.value() : nullptr;
+}
+
+const Shader* Renderer::GetInstancedShader(const Shader& shader) {
+    return GetShaderVariant(instancedShaders_, shader, Shaders::INSTANCED_SUFFIX);
+}
+
+const Shader* Renderer::GetMultiDrawShader(const Shader& shader) {
+    return GetShaderVariant(multiDrawShaders_, shader, Shaders::MULTI_DRAW_SUFFIX);
+}
+
+Material* Renderer::GetBatchMaterial(Material* material) {
+    if (!material->HasTextureArray())
+        return material;
+    auto it = batchMaterialLookup_.find(material);
+    if (it != batchMaterialLookup_.end())
+        return it->second;
+    // compared every frame since the uniforms can change at any time, but only once per material
+    Material* batch = material;
+    for (Material* m : batchMaterials_) {
+        if (m->IsBatchCompatible(*material)) {
+            batch = m;
+            break;
+        }
+    }
+    if (batch == material)
+        batchMaterials_.push_back(material);
+    batchMaterialLookup_[material] = batch;
+    return batch;
+}
+
+bool Renderer::QueueInstances(const MeshRenderer& renderer) {
+    // these change the state per renderer, just draw them normally
+    if (renderer.useCustomMaterial || renderer.disableDepthTest)
+        return false;
+    for (const auto& mesh : renderer.meshes.Get()) {
+        if (mesh->material != nullptr && GetInstancedShader(mesh->material->GetShader()) == nullptr)
+            return false;
+    }
+    for (const auto& mesh : renderer.meshes.Get()) {
+        if (mesh->material == nullptr)
+            continue;
+        int lod = std::clamp(renderer.lodLevel_, 0, mesh->GetLODCount() - 1);
+        float layer = static_cast<float>(std::max(mesh->material->GetTextureArray().layer, 0));
+        meshInstances_.push_back({ mesh.get(), lod, GetBatchMaterial(mesh->material.get()), layer, renderer.modelMatrix_ * mesh->transformMatrix });
+    }
+    return true;
+}
+
+void Renderer::DrawInstances() {
+    if (meshInstances_.empty())
+        return;
+    bool multiDraw = multiDrawSupported_ && useMultiDrawIndirect;
+    // a multi-draw needs the same material and arena next to each other, an instanced draw just the same mesh
+    std::sort(meshInstances_.begin(), meshInstances_.end(), [](const MeshInstance& a, const MeshInstance& b) {
+        if (a.material != b.material)
+            return std::less<const Material*>()(a.material, b.material);
+        if (a.mesh->arena != b.mesh->arena)
+            return std::less<const MeshArena*>()(a.mesh->arena, b.mesh->arena);
+        if (a.mesh->cullFaces != b.mesh->cullFaces)
+            return a.mesh->cullFaces;
+        if (a.mesh != b.mesh)
+            return std::less<const Mesh*>()(a.mesh, b.mesh);
+        return a.lod < b.lod;
+    });
+    instanceData_.clear();
+    for (const MeshInstance& instance : meshInstances_) {
+        instanceData_.push_back({ instance.modelMatrix, glm::vec4(instance.textureLayer, 0.0f, 0.0f, 0.0f) });
+    }
+    // reallocating orphans the previous frame's buffer so we don't have to wait for it
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, instanceData_.size() * sizeof(InstanceData), instanceData_.data(), GL_STREAM_DRAW);
+    GLState::CountUpload(instanceData_.size() * sizeof(InstanceData));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // every run of the same mesh, lod and material is an instanced draw, or a command of the multi-draw
+    // if the whole bucket (material, arena and face culling) can go through one
+    instanceBatches_.clear();
+    indirectCommands_.clear();
+    std::size_t begin = 0;
+    while (begin < meshInstances_.size()) {
+        const MeshInstance& first = meshInstances_.at(begin);
+        bool bucket = multiDraw && first.mesh->arena != nullptr && GetMultiDrawShader(first.material->GetShader()) != nullptr;
+        InstanceBatch batch = { begin, begin, indirectCommands_.size(), 0 };
+        do {
+            const MeshInstance& run = meshInstances_.at(batch.end);
+            std::size_t end = batch.end + 1;
+            while (end < meshInstances_.size() && meshInstances_[end].mesh == run.mesh && meshInstances_[end].lod == run.lod && meshInstances_[end].material == run.material)
+                end++;
+            if (bucket) {
+                indirectCommands_.push_back({
+                    static_cast<GLuint>(run.mesh->GetIndexCount(run.lod)),
+                    static_cast<GLuint>(end - batch.end),
+                    static_cast<GLuint>(run.mesh->GetFirstIndex(run.lod)),
+                    run.mesh->GetBaseVertex(),
+                    static_cast<GLuint>(batch.end)
+                });
+            }
+            batch.end = end;
+        } while (
+            bucket && batch.end < meshInstances_.size() &&
+            meshInstances_[batch.end].material == first.material &&
+            meshInstances_[batch.end].mesh->arena == first.mesh->arena &&
+            meshInstances_[batch.end].mesh->cullFaces == first.mesh->cullFaces
+        );
+        batch.commandCount = indirectCommands_.size() - batch.firstCommand;
+        instanceBatches_.push_back(batch);
+        begin = batch.end;
+    }
+
+    if (!indirectCommands_.empty()) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer_);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCommands_.size() * sizeof(DrawElementsIndirectCommand), indirectCommands_.data(), GL_STREAM_DRAW);
+        GLState::CountUpload(indirectCommands_.size() * sizeof(DrawElementsIndirectCommand));
+        if (instanceIndexCapacity_ < meshInstances_.size()) {
+            instanceIndexCapacity_ = std::max(meshInstances_.size(), instanceIndexCapacity_ * 2);
+            std::vector<GLuint> indices(instanceIndexCapacity_);
+            for (std::size_t i = 0; i < indices.size(); i++)
+                indices[i] = static_cast<GLuint>(i);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceIndexBuffer_);
+            glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+            GLState::CountUpload(indices.size() * sizeof(GLuint));
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        // the same data the instanced draws read as attributes
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, UniformBlocks::StorageBinding::INSTANCE_DATA, instanceBuffer_);
+    }
+
+    for (const InstanceBatch& batch : instanceBatches_) {
+        const MeshInstance& first = meshInstances_.at(batch.begin);
+        GLsizei instances = static_cast<GLsizei>(batch.end - batch.begin);
+        if (batch.commandCount > 0) {
+            first.material->Use(*GetMultiDrawShader(first.material->GetShader()));
+            if (!first.mesh->cullFaces)
+                glState_.Disable(GL_CULL_FACE);
+            glState_.BindVertexArray(first.mesh->arena->GetVertexArray());
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, first.mesh->arena->GetIndexBuffer());
+            // the base instance offsets the index, so every command starts from its own matrices
+            glBindBuffer(GL_ARRAY_BUFFER, instanceIndexBuffer_);
+            glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION);
+            glVertexAttribIPointer(INSTANCE_MATRIX_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+            glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION, 1);
+            glMultiDrawElementsIndirect(
+                GL_TRIANGLES,
+                first.mesh->arena->GetIndexType(),
+                reinterpret_cast<void*>(batch.firstCommand * sizeof(DrawElementsIndirectCommand)),
+                static_cast<GLsizei>(batch.commandCount),
+                0
+            );
+            for (std::size_t i = 0; i < batch.commandCount; i++) {
+                const DrawElementsIndirectCommand& cmd = indirectCommands_[batch.firstCommand + i];
+                GLState::CountDraw(GL_TRIANGLES, cmd.count, cmd.instanceCount, i == 0);
+            }
+            glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION, 0);
+            glDisableVertexAttribArray(INSTANCE_MATRIX_LOCATION);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            stats_.multiDrawCalls++;
+        }
+        else {
+            first.material->Use(*GetInstancedShader(first.material->GetShader()));
+            first.mesh->Bind();
+            // the mesh vaos are shared, so the instance attributes are only enabled for the draw
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+            std::size_t offset = batch.begin * sizeof(InstanceData);
+            for (GLuint i = 0; i < 4; i++) {
+                GLuint location = INSTANCE_MATRIX_LOCATION + i;
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(offset + i * sizeof(glm::vec4)));
+                glVertexAttribDivisor(location, 1);
+            }
+            glEnableVertexAttribArray(INSTANCE_LAYER_LOCATION);
+            glVertexAttribPointer(INSTANCE_LAYER_LOCATION, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(offset + offsetof(InstanceData, params)));
+            glVertexAttribDivisor(INSTANCE_LAYER_LOCATION, 1);
+            first.mesh->RenderInstanced(instances, first.lod);
+            // the matrix columns and the layer
+            for (GLuint i = 0; i < 5; i++) {
+                glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + i, 0);
+                glDisableVertexAttribArray(INSTANCE_MATRIX_LOCATION + i);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        stats_.drawCalls++;
+        stats_.instancedDrawCalls++;
+        stats_.instancedMeshes += instances;
     }
+    if (!indirectCommands_.empty())
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    stats_.unbatchedDrawCalls += meshInstances_.size();
+    meshInstances_.clear();
+    batchMaterials_.clear();
+    batchMaterialLookup_.clear();
+}
+
+void Renderer::AcquireSceneTargets() {
+    // released first so resizing back and forth gets the old targets back from the pool
+    renderTargets_.Release(sceneTarget_);
+    renderTargets_.Release(resolveTarget_);
+    glm::ivec2 size = glm::ivec2(std::max(viewportSize_.x, 1), std::max(viewportSize_.y, 1));
+
+    RenderTargetDesc sceneDesc;
+    sceneDesc.size = size;
+    sceneDesc.samples = 4;
+    sceneDesc.depthFormat = GL_DEPTH24_STENCIL8;
+    sceneTarget_ = renderTargets_.Acquire(sceneDesc);
+
+    RenderTargetDesc resolveDesc;
+    resolveDesc.size = size;
+    resolveTarget_ = renderTargets_.Acquire(resolveDesc);
+    Systems::GetResources().GetTextureManager()->Set("FRAMEBUFFER", resolveTarget_->GetTexture());
 }
 
 void Renderer::RestoreViewport() {
-    glViewport(0, 0, viewportSize_.x, viewportSize_.y);
+    glState_.Viewport(0, 0, viewportSize_.x, viewportSize_.y);
 }
 
 void Renderer::UpdateCameraProjection(int width, int height) {
     viewportSize_ = glm::ivec2(width, height);
-    glViewport(0, 0, width, height);
-
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, MSAATextureColorBuffer_);
-    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, width, height, GL_TRUE);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo_);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, width, height);
-    glBindTexture(GL_TEXTURE_2D, framebufferTexture_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, GL_NONE);
+    glState_.Viewport(0, 0, width, height);
+    AcquireSceneTargets();
 
     camera_.aspectRatio = (float) width / (float) height;
     camera_.projectionMatrix = glm::perspective(glm::radians(camera_.fov), camera_.aspectRatio, camera_.clippingNear, camera_.clippingFar);
 }
 
 void Renderer::ApplyPostProcessing(const PostProcessing& postProcessing) {
+    postProcessing_ = postProcessing;
     framebufferShader_.Use();
     postProcessing.ApplyUniforms(framebufferShader_);
-    glUseProgram(0);
+    glState_.UseProgram(0);
+
+    bool blur = postProcessing.blur.isActive && postProcessing.blur.blend > 0.0f;
+    std::vector<float> weights = postProcessing.GetBlurWeights();
+    blurRadius_ = static_cast<int>(weights.size()) - 1;
+    blurWeights_.fill(0.0f);
+    std::copy(weights.begin(), weights.end(), blurWeights_.begin());
+    for (const std::string& name : { BLUR_HORIZONTAL_PASS, BLUR_VERTICAL_PASS }) {
+        PostProcessGraph::Pass* pass = postProcessGraph_.GetPass(name);
+        if (pass == nullptr)
+            continue;
+        pass->enabled = blur;
+        pass->scale = std::clamp(postProcessing.blur.resolutionScale, .1f, 1.0f);
+    }
 }
 
 void Renderer::UpdateVideoSettings(const Config::VideoSettings& settings) {
@@ -303,10 +987,15 @@ void Renderer::UpdateVideoSettings(const Config::VideoSettings& settings) {
     framebufferShader_.SetUniform("cfg.contrast", settings.contrast);
     framebufferShader_.SetUniform("cfg.brightness", settings.brightness);
     framebufferShader_.SetUniform("cfg.saturation", settings.saturation);
-    glUseProgram(0);
+    glState_.UseProgram(0);
 
     camera_.fov = settings.fov;
 
+    dynamicResolution_.enabled = settings.dynamicResolution;
+    dynamicResolution_.targetFrameTime = settings.targetFrameTime;
+    dynamicResolution_.minScale = settings.minResolutionScale;
+    dynamicResolution_.maxScale = settings.maxResolutionScale;
+
     glm::ivec2 wndSize = viewport_->GetSize();
     if (wndSize.x > 0 && wndSize.y > 0)
         UpdateCameraProjection(wndSize.x, wndSize.y);
@@ -316,7 +1005,6 @@ UI::Canvas& Renderer::CreateCanvas(std::string id) {
     UI::Canvas* c = new UI::Canvas();
     c->isOwnedByRenderer = true;
     auto [ it, inserted ] = canvases_.insert({ id, c });
-    it->second->GenerateBackgroundShape();
     return *it->second;
 }
 
@@ -347,8 +1035,9 @@ void Renderer::CleanUp() {
             delete v;
     }
     canvases_.clear();
+    renderables_.clear();
     renderablesOnFrustum_.clear();
-    UpdateFrustum();
+    BuildStaticBVH();
 }
 
 std::size_t Renderer::CountEntitiesOnFrustum() const {
@@ -361,6 +1050,39 @@ void Renderer::ForEachRenderableOnFrustum(const std::function<void(IRenderable&)
     }
 }
 
+void Renderer::QueryAABB(const ViewFrustum::AABB& aabb, const std::function<void(IRenderable&)>& fn) {
+    staticBvh_.QueryAABB(aabb, [&](std::uint32_t i) {
+        if (!staticExcluded_.Test(i) && !staticRenderables_[i].IsNull())
+            fn(staticRenderables_[i].CastComponent<IRenderable>());
+    });
+    dynamicGrid_.QueryAABB(aabb, [&](std::uint32_t i) {
+        if (!renderables_[i].IsNull())
+            fn(renderables_[i].CastComponent<IRenderable>());
+    });
+}
+
+void Renderer::QuerySphere(const glm::vec3& center, float radius, const std::function<void(IRenderable&)>& fn) {
+    staticBvh_.QuerySphere(center, radius, [&](std::uint32_t i) {
+        if (!staticExcluded_.Test(i) && !staticRenderables_[i].IsNull())
+            fn(staticRenderables_[i].CastComponent<IRenderable>());
+    });
+    dynamicGrid_.QuerySphere(center, radius, [&](std::uint32_t i) {
+        if (!renderables_[i].IsNull())
+            fn(renderables_[i].CastComponent<IRenderable>());
+    });
+}
+
+void Renderer::QueryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, const std::function<void(IRenderable&, float)>& fn) {
+    staticBvh_.QueryRay(origin, dir, maxDistance, [&](std::uint32_t i, float t) {
+        if (!staticExcluded_.Test(i) && !staticRenderables_[i].IsNull())
+            fn(staticRenderables_[i].CastComponent<IRenderable>(), t);
+    });
+    dynamicGrid_.QueryRay(origin, dir, maxDistance, [&](std::uint32_t i, float t) {
+        if (!renderables_[i].IsNull())
+            fn(renderables_[i].CastComponent<IRenderable>(), t);
+    });
+}
+
 std::shared_ptr<Material> Renderer::GetMaterial(const std::string& mat) const {
     if (materials_.find(mat) == materials_.end())
         return materials_.at(MATERIAL_MISSING);
@@ -375,10 +1097,59 @@ const std::vector<GLuint>& Renderer::GetShaders() const {
     return shaders_;
 }
 
+const RenderStats& Renderer::GetStats() const {
+    return frameStats_;
+}
+
+bool Renderer::StartStatsLog(const std::string& path) {
+    if (!statsLog_.Open(path))
+        return false;
+    spdlog::info("Logging render stats to '{}'", path);
+    return true;
+}
+
+void Renderer::StopStatsLog() {
+    statsLog_.Close();
+}
+
+StreamBuffer& Renderer::GetStreamBuffer() {
+    return streamBuffer_;
+}
+
+MeshArenas& Renderer::GetMeshArenas() {
+    return meshArenas_;
+}
+
+PostProcessGraph& Renderer::GetPostProcessGraph() {
+    return postProcessGraph_;
+}
+
+RenderTargetPool& Renderer::GetRenderTargetPool() {
+    return renderTargets_;
+}
+
+StaticBatches& Renderer::GetStaticBatches() {
+    return staticBatches_;
+}
+
+GLState& Renderer::GetGLState() {
+    return glState_;
+}
+
+DynamicResolution& Renderer::GetDynamicResolution() {
+    return dynamicResolution_;
+}
+
+DebugDraw& Renderer::GetDebugDraw() {
+    return debugDraw_;
+}
+
 void Renderer::DebugDrawNormals() {
-    Systems::GetEntityManager().GetComponentMemory().ForEachDerivedComponent<IRenderable>([&](IRenderable& r, IComponentMemoryPool&) {
-        RenderItem(r, RENDER_MODE_DEBUG_NORMALS);
-    });
+    // no point in drawing the normals of everything outside the view
+    for (GeneralComponentReference& ref : renderablesOnFrustum_) {
+        if (!ref.IsNull())
+            RenderItem(ref.CastComponent<IRenderable>(), RENDER_MODE_DEBUG_NORMALS);
+    }
 }
 
 void Renderer::DebugDrawHitboxes() {
@@ -0,0 +1,184 @@
+#include <latren/graphics/renderstats.h>
+#include <latren/io/resourcepath.h>
+
+#include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
+#include <cmath>
+
+void RenderStats::ForEachValue(const std::function<void(const std::string&, double)>& fn) const {
+    fn("drawCalls", (double) drawCalls);
+    fn("unbatchedDrawCalls", (double) unbatchedDrawCalls);
+    fn("glDrawCalls", (double) glDrawCalls);
+    for (int p = 0; p < RenderPass::TOTAL_RENDER_PASSES; p++) {
+        std::string pass = std::string(magic_enum::enum_name(static_cast<RenderPass::Enum>(p)));
+        fn("drawCalls_" + pass, (double) passDrawCalls[p]);
+    }
+    fn("instancedDrawCalls", (double) instancedDrawCalls);
+    fn("instancedMeshes", (double) instancedMeshes);
+    fn("multiDrawCalls", (double) multiDrawCalls);
+    fn("triangles", (double) triangles);
+    fn("instances", (double) instances);
+    fn("programBinds", (double) programBinds);
+    fn("textureBinds", (double) textureBinds);
+    fn("vertexArrayBinds", (double) vertexArrayBinds);
+    fn("uniformCalls", (double) uniformCalls);
+    fn("uploadBytes", (double) uploadBytes);
+    fn("stateChanges", (double) stateChanges);
+    fn("stateChangesElided", (double) stateChangesElided);
+    fn("cullingTested", (double) cullingTested);
+    fn("cullingVisible", (double) cullingVisible);
+    fn("frustumCulled", (double) frustumCulled);
+    fn("occlusionTests", (double) occlusionTests);
+    fn("occlusionCulled", (double) occlusionCulled);
+    fn("occlusionCulledDrawCalls", (double) occlusionCulledDrawCalls);
+    fn("clusteredLights", (double) clusteredLights);
+    fn("recordedDrawCalls", (double) recordedDrawCalls);
+    fn("commandLists", (double) commandLists);
+    fn("staticBatchDrawCalls", (double) staticBatchDrawCalls);
+    fn("staticBatchedMeshes", (double) staticBatchedMeshes);
+    fn("cpuRenderTime", cpuRenderTime);
+    fn("gpuFrameTime", gpuFrameTime);
+    for (int p = 0; p < RenderPass::TOTAL_RENDER_PASSES; p++) {
+        std::string pass = std::string(magic_enum::enum_name(static_cast<RenderPass::Enum>(p)));
+        fn("gpuTime_" + pass, passGPUTime[p]);
+    }
+    fn("gpuTime_POST_PROCESSING", postProcessGPUTime);
+    fn("gpuTime_UI", uiGPUTime);
+    fn("resolutionScale", resolutionScale);
+    fn("postProcessPasses", (double) postProcessPasses);
+    fn("renderTargets", (double) renderTargets);
+    fn("renderTargetMemory", (double) renderTargetMemory);
+    fn("renderTargetAllocations", (double) renderTargetAllocations);
+    fn("renderTargetFrees", (double) renderTargetFrees);
+}
+
+std::string RenderStats::FormatValue(double value) {
+    if (value == std::floor(value))
+        return fmt::format("{:.0f}", value);
+    return fmt::format("{:.2f}", value);
+}
+
+GLuint GPUTimers::GetQuery(int frame, std::size_t section, bool end) const {
+    return queries_[(frame * sections_ + section) * 2 + (end ? 1 : 0)];
+}
+
+void GPUTimers::Init(std::size_t sections) {
+    sections_ = sections;
+    queries_.resize(FRAMES * sections_ * 2);
+    glGenQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+    written_.assign(FRAMES * sections_, false);
+    times_.assign(sections_, 0.0f);
+    pending_.fill(false);
+    frame_ = 0;
+}
+
+void GPUTimers::Delete() {
+    if (!queries_.empty())
+        glDeleteQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+    queries_.clear();
+    written_.clear();
+    sections_ = 0;
+    running_ = false;
+}
+
+void GPUTimers::BeginFrame() {
+    if (queries_.empty())
+        return;
+    // oldest first, same as the dynamic resolution queries
+    for (int i = 0; i < FRAMES; i++) {
+        int f = (frame_ + i) % FRAMES;
+        if (!pending_[f])
+            continue;
+        // the timestamps finish in order, so the frame is done once its last one is
+        GLuint last = GL_NONE;
+        for (std::size_t s = 0; s < sections_; s++) {
+            if (written_[f * sections_ + s])
+                last = GetQuery(f, s, true);
+        }
+        if (last != GL_NONE) {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+        }
+        for (std::size_t s = 0; s < sections_; s++) {
+            if (!written_[f * sections_ + s])
+                continue;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(GetQuery(f, s, false), GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(GetQuery(f, s, true), GL_QUERY_RESULT, &end);
+            times_[s] = static_cast<float>(end - begin) / 1000000.0f;
+        }
+        pending_[f] = false;
+    }
+    // the gpu is more than FRAMES behind, skip timing this one rather than waiting for it
+    running_ = !pending_[frame_];
+    if (running_) {
+        for (std::size_t s = 0; s < sections_; s++)
+            written_[frame_ * sections_ + s] = false;
+    }
+}
+
+void GPUTimers::EndFrame() {
+    if (!running_)
+        return;
+    pending_[frame_] = true;
+    frame_ = (frame_ + 1) % FRAMES;
+    running_ = false;
+}
+
+void GPUTimers::Begin(std::size_t section) {
+    if (!running_ || section >= sections_)
+        return;
+    glQueryCounter(GetQuery(frame_, section, false), GL_TIMESTAMP);
+}
+
+void GPUTimers::End(std::size_t section) {
+    if (!running_ || section >= sections_)
+        return;
+    glQueryCounter(GetQuery(frame_, section, true), GL_TIMESTAMP);
+    written_[frame_ * sections_ + section] = true;
+}
+
+float GPUTimers::GetTime(std::size_t section) const {
+    return section < times_.size() ? times_[section] : 0.0f;
+}
+
+bool RenderStatsLog::Open(const std::string& path) {
+    Close();
+    std::fs::path parsed = ResourcePath(path).GetParsedPath();
+    std::error_code err;
+    if (parsed.has_parent_path())
+        std::fs::create_directories(parsed.parent_path(), err);
+    file_.open(parsed, std::ios::trunc);
+    if (!file_.is_open()) {
+        spdlog::warn("Cannot open render stats log '{}'", parsed.generic_string());
+        return false;
+    }
+    file_ << "frame";
+    RenderStats().ForEachValue([&](const std::string& name, double) {
+        file_ << "," << name;
+    });
+    file_ << "\n";
+    frame_ = 0;
+    return true;
+}
+
+void RenderStatsLog::Close() {
+    if (file_.is_open())
+        file_.close();
+}
+
+bool RenderStatsLog::IsOpen() const {
+    return file_.is_open();
+}
+
+void RenderStatsLog::Write(const RenderStats& stats) {
+    if (!file_.is_open())
+        return;
+    file_ << frame_++;
+    stats.ForEachValue([&](const std::string&, double value) {
+        file_ << "," << RenderStats::FormatValue(value);
+    });
+    file_ << "\n";
+}
\ No newline at end of file
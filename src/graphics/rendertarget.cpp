@@ -0,0 +1,206 @@
+#include <latren/graphics/rendertarget.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
+
+#include <algorithm>
+
+// the pixel format glTexImage2D wants with the sized internal format, nothing's uploaded anyway
+GLenum GetBaseFormat(GLenum format) {
+    switch (format) {
+        case GL_R8:
+        case GL_R16F:
+        case GL_R32F:
+            return GL_RED;
+        case GL_RG8:
+        case GL_RG16F:
+        case GL_RG32F:
+            return GL_RG;
+        case GL_RGBA8:
+        case GL_RGBA16F:
+        case GL_RGBA32F:
+            return GL_RGBA;
+        default:
+            return GL_RGB;
+    }
+}
+
+std::size_t GetBytesPerPixel(GLenum format) {
+    switch (format) {
+        case GL_R8:
+            return 1;
+        case GL_RG8:
+        case GL_R16F:
+            return 2;
+        case GL_RG16F:
+        case GL_R32F:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+            return 4;
+        case GL_RGB16F:
+        case GL_RGBA16F:
+        case GL_RG32F:
+            return 8;
+        case GL_RGB32F:
+        case GL_RGBA32F:
+            return 16;
+        case GL_NONE:
+            return 0;
+        // rgb8 is padded to 4 bytes pretty much everywhere
+        default:
+            return 4;
+    }
+}
+
+void RenderTarget::Create(const RenderTargetDesc& desc) {
+    if (IsCreated() && desc == desc_)
+        return;
+    Delete();
+    desc_ = desc;
+    GLState& gl = Systems::GetRenderer().GetGLState();
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    glGenTextures(1, &texture_);
+    if (desc_.samples > 0) {
+        gl.BindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture_);
+        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, desc_.samples, desc_.format, desc_.size.x, desc_.size.y, GL_TRUE);
+    }
+    else {
+        gl.BindTexture(GL_TEXTURE_2D, texture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, desc_.format, desc_.size.x, desc_.size.y, 0, GetBaseFormat(desc_.format), GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GetTextureTarget(), texture_, 0);
+
+    if (desc_.depthFormat != GL_NONE) {
+        glGenRenderbuffers(1, &depthBuffer_);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer_);
+        if (desc_.samples > 0)
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc_.samples, desc_.depthFormat, desc_.size.x, desc_.size.y);
+        else
+            glRenderbufferStorage(GL_RENDERBUFFER, desc_.depthFormat, desc_.size.x, desc_.size.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        GLenum attachment = desc_.depthFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, depthBuffer_);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::Delete() {
+    if (fbo_ != GL_NONE)
+        glDeleteFramebuffers(1, &fbo_);
+    if (texture_ != GL_NONE)
+        GLState::DeleteTexture(texture_);
+    if (depthBuffer_ != GL_NONE)
+        glDeleteRenderbuffers(1, &depthBuffer_);
+    fbo_ = GL_NONE;
+    texture_ = GL_NONE;
+    depthBuffer_ = GL_NONE;
+    desc_ = RenderTargetDesc();
+}
+
+void RenderTarget::Bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    Systems::GetRenderer().GetGLState().Viewport(0, 0, desc_.size.x, desc_.size.y);
+}
+
+bool RenderTarget::IsCreated() const {
+    return fbo_ != GL_NONE;
+}
+
+GLuint RenderTarget::GetFramebuffer() const {
+    return fbo_;
+}
+
+GLuint RenderTarget::GetTexture() const {
+    return texture_;
+}
+
+GLenum RenderTarget::GetTextureTarget() const {
+    return desc_.samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+}
+
+const glm::ivec2& RenderTarget::GetSize() const {
+    return desc_.size;
+}
+
+const RenderTargetDesc& RenderTarget::GetDesc() const {
+    return desc_;
+}
+
+std::size_t RenderTarget::GetMemoryUsage() const {
+    if (!IsCreated())
+        return 0;
+    std::size_t pixels = static_cast<std::size_t>(desc_.size.x) * desc_.size.y * std::max(desc_.samples, 1);
+    return pixels * (GetBytesPerPixel(desc_.format) + GetBytesPerPixel(desc_.depthFormat));
+}
+
+RenderTarget* RenderTargetPool::Acquire(const RenderTargetDesc& desc) {
+    for (auto& entry : entries_) {
+        if (!entry->inUse && entry->target.GetDesc() == desc) {
+            entry->inUse = true;
+            entry->lastUsed = frame_;
+            frameStats_.reuses++;
+            return &entry->target;
+        }
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->target.Create(desc);
+    entry->inUse = true;
+    entry->lastUsed = frame_;
+    frameStats_.allocations++;
+    entries_.push_back(std::move(entry));
+    return &entries_.back()->target;
+}
+
+void RenderTargetPool::Release(RenderTarget* target) {
+    if (target == nullptr)
+        return;
+    for (auto& entry : entries_) {
+        if (&entry->target == target) {
+            entry->inUse = false;
+            entry->lastUsed = frame_;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::NextFrame() {
+    auto it = entries_.begin();
+    while (it != entries_.end()) {
+        Entry& entry = **it;
+        if (!entry.inUse && frame_ - entry.lastUsed > RETENTION_FRAMES) {
+            entry.target.Delete();
+            it = entries_.erase(it);
+            frameStats_.frees++;
+            continue;
+        }
+        ++it;
+    }
+    frameStats_.targets = entries_.size();
+    frameStats_.targetsInUse = std::count_if(entries_.begin(), entries_.end(), [](const auto& e) { return e->inUse; });
+    frameStats_.memoryUsage = 0;
+    for (const auto& entry : entries_) {
+        frameStats_.memoryUsage += entry->target.GetMemoryUsage();
+    }
+    stats_ = frameStats_;
+    frameStats_ = Stats();
+    frame_++;
+}
+
+void RenderTargetPool::Delete() {
+    for (auto& entry : entries_) {
+        entry->target.Delete();
+    }
+    entries_.clear();
+    stats_ = Stats();
+    frameStats_ = Stats();
+}
+
+const RenderTargetPool::Stats& RenderTargetPool::GetStats() const {
+    return stats_;
+}
\ No newline at end of file
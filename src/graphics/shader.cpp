@@ -1,4 +1,6 @@
 #include <latren/graphics/shader.h>
+#include <latren/graphics/renderer.h>
+#include <latren/graphics/uniformbuffer.h>
 #include <latren/systems.h>
 #include <latren/io/paths.h>
 #include <latren/io/resourcemanager.h>
@@ -6,6 +8,7 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
+#include <thread>
 #include <spdlog/spdlog.h>
 
 using namespace Shaders;
@@ -13,6 +16,8 @@ using namespace Shaders;
 const std::string Shaders::EXT_VERT = ".vert";
 const std::string Shaders::EXT_FRAG = ".frag";
 const std::string Shaders::EXT_GEOM = ".geom";
+const std::string Shaders::INSTANCED_SUFFIX = "_INSTANCED";
+const std::string Shaders::MULTI_DRAW_SUFFIX = "_MULTI_DRAW";
 
 std::string GetShaderInfoLog(GLuint shader) {
     int logLength;
@@ -40,29 +45,31 @@ std::string GetProgramInfoLog(GLuint program) {
     return "";
 }
 
-void LoadShaderFromFile(GLuint shader, const ResourcePath& path) {
-    std::string shaderData;
+bool ReadShaderFile(const ResourcePath& path, std::string& shaderData) {
     std::ifstream shaderStream(path.GetParsedPathStr(), std::ios::in);
-    if (shaderStream.is_open()) {
-        std::stringstream ss;
-        ss << shaderStream.rdbuf();
-        shaderData = ss.str();
-        shaderStream.close();
-    }
-    else {
+    if (!shaderStream.is_open()) {
         spdlog::error("Cannot read shader file!");
-        return;
+        return false;
     }
-    char const* shaderDataPtr = shaderData.c_str();
+    std::stringstream ss;
+    ss << shaderStream.rdbuf();
+    shaderData = ss.str();
+    shaderStream.close();
+    return true;
+}
+
+// only submits the compile, the status is checked once the program is linked
+GLuint CompileShader(GLuint program, const ShaderSource& s) {
+    GLuint shader = glCreateShader(s.type);
+    spdlog::info("Compiling shader '" + s.name + "'");
+    char const* shaderDataPtr = s.source.c_str();
     glShaderSource(shader, 1, &shaderDataPtr, nullptr);
     glCompileShader(shader);
-
-    auto shaderMessage = GetShaderInfoLog(shader);
-	if (shaderMessage != "")
-		spdlog::info(shaderMessage);
+    glAttachShader(program, shader);
+    return shader;
 }
 
-void Resources::ShaderManager::LoadShader(GLuint program, const ResourcePath& path, Shaders::ShaderType t) {
+void Resources::ShaderManager::ReadShader(std::vector<ShaderSource>& sources, const ResourcePath& path, Shaders::ShaderType t) {
     GLuint shaderType;
     switch (t) {
         case ShaderType::VERT:
@@ -75,48 +82,151 @@ void Resources::ShaderManager::LoadShader(GLuint program, const ResourcePath& pa
             shaderType = GL_GEOMETRY_SHADER;
             break;
         case ShaderType::VERT_FRAG:
-            LoadShader(program, path.GetUnparsedPathStr() + EXT_VERT, ShaderType::VERT);
-            LoadShader(program, path.GetUnparsedPathStr() + EXT_FRAG, ShaderType::FRAG);
+            ReadShader(sources, path.GetUnparsedPathStr() + EXT_VERT, ShaderType::VERT);
+            ReadShader(sources, path.GetUnparsedPathStr() + EXT_FRAG, ShaderType::FRAG);
             return;
         case ShaderType::VERT_FRAG_GEOM:
-            LoadShader(program, path.GetUnparsedPathStr() + EXT_VERT, ShaderType::VERT);
-            LoadShader(program, path.GetUnparsedPathStr() + EXT_FRAG, ShaderType::FRAG);
-            LoadShader(program, path.GetUnparsedPathStr() + EXT_GEOM, ShaderType::GEOM);
+            ReadShader(sources, path.GetUnparsedPathStr() + EXT_VERT, ShaderType::VERT);
+            ReadShader(sources, path.GetUnparsedPathStr() + EXT_FRAG, ShaderType::FRAG);
+            ReadShader(sources, path.GetUnparsedPathStr() + EXT_GEOM, ShaderType::GEOM);
             return;
         default:
             return;
     }
-    GLuint shader = glCreateShader(shaderType);
-    spdlog::info("Compiling shader '" + std::fs::path(path.GetParsedPathStr()).filename().generic_string() + "'");
-    LoadShaderFromFile(shader, path);
-    glAttachShader(program, shader);
-    glDeleteShader(shader);
+    ShaderSource source;
+    source.type = shaderType;
+    source.name = std::fs::path(path.GetParsedPathStr()).filename().generic_string();
+    if (ReadShaderFile(path, source.source))
+        sources.push_back(source);
 }
 
-void Resources::ShaderManager::LoadStandardShader(Shaders::ShaderID id, const ResourcePath& path, Shaders::ShaderType t) {
-    std::string strId = std::string(magic_enum::enum_name(id));
-    onResourceLoad.Dispatch(strId);
+GLuint Resources::ShaderManager::CreateProgram(const std::string& id, const std::vector<ShaderSource>& sources) {
+    onResourceLoad.Dispatch(id);
     GLuint program = glCreateProgram();
-    LoadShader(program, ResourcePath("${core_shaders}", path), t);
+    items_[id] = program;
+    uint64_t key = programCache_.GetKey(sources);
+    if (programCache_.Load(program, key)) {
+        spdlog::debug("Loaded program '{}' from the shader cache", id);
+        UniformBlocks::BindProgram(program);
+        return program;
+    }
+    PendingProgram pending;
+    pending.id = id;
+    pending.program = program;
+    pending.key = key;
+    pending.start = glfwGetTime();
+    for (const ShaderSource& s : sources)
+        pending.shaders.push_back(CompileShader(program, s));
+    programCache_.PrepareProgram(program);
     glLinkProgram(program);
-    auto programMessage = GetProgramInfoLog(program);
+    if (batchDepth_ > 0) {
+        pendingPrograms_.push_back(pending);
+        return program;
+    }
+    return FinishProgram(pending);
+}
+
+GLuint Resources::ShaderManager::FinishProgram(const PendingProgram& pending) {
+    // this is where the driver has to finish the compile
+    GLint linked = GL_FALSE;
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+    double compileTime = (glfwGetTime() - pending.start) * 1000.0;
+    for (GLuint shader : pending.shaders) {
+        auto shaderMessage = GetShaderInfoLog(shader);
+        if (shaderMessage != "")
+            spdlog::info(shaderMessage);
+        glDetachShader(pending.program, shader);
+        glDeleteShader(shader);
+    }
+    auto programMessage = GetProgramInfoLog(pending.program);
 	if (programMessage != "")
 		spdlog::info(programMessage);
-    items_[strId] = program;
+
+    if (!linked) {
+        glDeleteProgram(pending.program);
+        std::string missing = std::string(magic_enum::enum_name(ShaderID::MISSING));
+        if (pending.id != missing && HasLoaded(missing)) {
+            spdlog::error("Shader program '{}' failed to link, using the placeholder", pending.id);
+            items_[pending.id] = items_.at(missing);
+        }
+        else {
+            spdlog::error("Shader program '{}' failed to link", pending.id);
+            items_[pending.id] = GL_NONE;
+        }
+        return items_.at(pending.id);
+    }
+    programCache_.Store(pending.program, pending.key, compileTime);
+    UniformBlocks::BindProgram(pending.program);
+    return pending.program;
+}
+
+void Resources::ShaderManager::BeginBatch() {
+    if (batchDepth_++ > 0)
+        return;
+    batchStart_ = glfwGetTime();
+    if (!parallelCompileChecked_) {
+        parallelCompileChecked_ = true;
+        // let the driver use as many threads as it wants
+        if (GLEW_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (GLEW_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+}
+
+void Resources::ShaderManager::EndBatch() {
+    if (batchDepth_ == 0 || --batchDepth_ > 0)
+        return;
+    std::size_t programs = pendingPrograms_.size();
+    bool parallel = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+    // finish them in the order they're done so the compile times mean something,
+    // without the extension the status queries just block in order
+    while (!pendingPrograms_.empty()) {
+        bool finished = false;
+        for (auto it = pendingPrograms_.begin(); it != pendingPrograms_.end(); ++it) {
+            GLint done = GL_TRUE;
+            if (parallel)
+                glGetProgramiv(it->program, GL_COMPLETION_STATUS_KHR, &done);
+            if (done) {
+                FinishProgram(*it);
+                pendingPrograms_.erase(it);
+                finished = true;
+                break;
+            }
+        }
+        if (!finished)
+            std::this_thread::yield();
+    }
+    if (programs > 0)
+        spdlog::info("Compiled {} shader programs in {:.1f} ms{}", programs, (glfwGetTime() - batchStart_) * 1000.0, parallel ? " (parallel)" : "");
+}
+
+void Resources::ShaderManager::LogLoadTimes() {
+    const ProgramCache::Stats& stats = programCache_.GetStats();
+    if (stats.hits == 0 && stats.misses == 0)
+        return;
+    spdlog::info(
+        "Shader programs: {} from cache in {:.1f} ms (~{:.1f} ms of compiling saved), {} compiled in {:.1f} ms",
+        stats.hits, stats.loadTime, stats.savedTime - stats.loadTime, stats.misses, stats.compileTime
+    );
+    if (stats.rejected > 0)
+        spdlog::info("  ({} cached binaries were rejected by the driver)", stats.rejected);
+    programCache_.ResetStats();
+}
+
+void Resources::ShaderManager::LoadStandardShader(Shaders::ShaderID id, const ResourcePath& path, Shaders::ShaderType t) {
+    std::vector<ShaderSource> sources;
+    ReadShader(sources, ResourcePath("${core_shaders}", path), t);
+    CreateProgram(std::string(magic_enum::enum_name(id)), sources);
 }
 
 void Resources::ShaderManager::LoadShader(const std::string& id, const ResourcePath& vert, const ResourcePath& frag, const ResourcePath& geom) {
-    onResourceLoad.Dispatch(id);
-    GLuint program = glCreateProgram();
-    LoadShader(program, vert, ShaderType::VERT);
-    LoadShader(program, frag, ShaderType::FRAG);
+    std::vector<ShaderSource> sources;
+    ReadShader(sources, vert, ShaderType::VERT);
+    ReadShader(sources, frag, ShaderType::FRAG);
     if (!geom.IsEmpty())
-        LoadShader(program, geom, ShaderType::GEOM);
-    glLinkProgram(program);
-    auto programMessage = GetProgramInfoLog(program);
-	if (programMessage != "")
-		spdlog::info(programMessage);
-    items_[id] = program;
+        ReadShader(sources, geom, ShaderType::GEOM);
+    CreateProgram(id, sources);
 }
 
 void Resources::ShaderManager::LoadStandardShader(Shaders::ShaderID id, const ResourcePath& vert, const ResourcePath& frag, const ResourcePath& geom) {
@@ -129,6 +239,9 @@ void Resources::ShaderManager::LoadStandardShader(Shaders::ShaderID id, const Re
 }
 
 void Resources::ShaderManager::LoadStandardShaders() {
+    // the placeholder for the ones that fail, so it's loaded before the batch
+    LoadStandardShader(ShaderID::MISSING, "unlit" + EXT_VERT, "missing" + EXT_FRAG);
+    BeginBatch();
     LoadStandardShader(ShaderID::UNLIT, "unlit", ShaderType::VERT_FRAG);
     LoadStandardShader(ShaderID::LIT, "lit", ShaderType::VERT_FRAG);
     LoadStandardShader(ShaderID::FRAMEBUFFER, "framebuffer", ShaderType::VERT_FRAG);
@@ -140,6 +253,20 @@ void Resources::ShaderManager::LoadStandardShaders() {
     LoadStandardShader(ShaderID::STROBE_UNLIT, "unlit" + EXT_VERT, "strobe_unlit" + EXT_FRAG);
     LoadStandardShader(ShaderID::SKYBOX, "skybox", ShaderType::VERT_FRAG);
     LoadStandardShader(ShaderID::BILLBOARD, "billboard" + EXT_VERT, "unlit" + EXT_FRAG, "billboard" + EXT_GEOM);
+    LoadStandardShader(ShaderID::UNLIT_INSTANCED, "unlit_instanced" + EXT_VERT, "unlit" + EXT_FRAG);
+    LoadStandardShader(ShaderID::LIT_INSTANCED, "lit_instanced" + EXT_VERT, "lit" + EXT_FRAG);
+    LoadStandardShader(ShaderID::STROBE_UNLIT_INSTANCED, "unlit_instanced" + EXT_VERT, "strobe_unlit" + EXT_FRAG);
+    LoadStandardShader(ShaderID::DEBUG, "debug", ShaderType::VERT_FRAG);
+    LoadStandardShader(ShaderID::BLUR, "framebuffer" + EXT_VERT, "blur" + EXT_FRAG);
+    LoadStandardShader(ShaderID::PARTICLE, "particle", ShaderType::VERT_FRAG);
+    // glsl 430 for the storage buffer, the renderer draws these buckets the old way otherwise
+    if (GLEW_VERSION_4_3) {
+        LoadStandardShader(ShaderID::UNLIT_MULTI_DRAW, "unlit_multidraw" + EXT_VERT, "unlit" + EXT_FRAG);
+        LoadStandardShader(ShaderID::LIT_MULTI_DRAW, "lit_multidraw" + EXT_VERT, "lit" + EXT_FRAG);
+        LoadStandardShader(ShaderID::STROBE_UNLIT_MULTI_DRAW, "unlit_multidraw" + EXT_VERT, "strobe_unlit" + EXT_FRAG);
+    }
+    EndBatch();
+    LogLoadTimes();
 }
 
 void Resources::ShaderManager::Load(const Resources::ShaderImport& import) {
@@ -154,9 +281,16 @@ void Resources::ShaderManager::Load(const Resources::ShaderImport& import) {
 // tried to template this so the boilerplate wouldn't be needed but instead got the whackiest runtime errors known to man
 void Resources::ShaderManager::LoadImports(const Imports<ShaderImport>& imports) {
     SetPath(imports.parentPath);
+    BeginBatch();
     for (const auto& import : imports.imports)
         Load(import);
+    EndBatch();
     RestoreDefaultPath();
+    LogLoadTimes();
+}
+
+ProgramCache& Resources::ShaderManager::GetProgramCache() {
+    return programCache_;
 }
 
 GLuint& Resources::ShaderManager::Get(ShaderID shader) {
@@ -193,5 +327,5 @@ std::string Shader::GetIDString() const {
 }
 
 void Shader::Use() const {
-    glUseProgram(GetProgram());
+    Systems::GetRenderer().GetGLState().UseProgram(GetProgram());
 }
\ No newline at end of file
@@ -1,23 +1,33 @@
 #include <latren/graphics/shape.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
 
 #include <cstring>
 
 void Shape::GenerateVAO() {
-    glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * numVertices * numVertexAttributes, NULL, GL_DYNAMIC_DRAW);
+    GenerateVAO(vbo);
+    ownsBuffer_ = true;
+}
+
+void Shape::GenerateVAO(GLuint buffer) {
+    vbo = buffer;
+    ownsBuffer_ = false;
+    glGenVertexArrays(1, &vao);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
     for (int i = 0; i < numVertexAttributes / stride; i++) {
         glEnableVertexAttribArray(i);
         glVertexAttribPointer(i, stride, GL_FLOAT, GL_FALSE, numVertexAttributes * sizeof(float), reinterpret_cast<void*>(i * stride * sizeof(float)));
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    Systems::GetRenderer().GetGLState().BindVertexArray(0);
 }
 
 void Shape::Bind() const {
-    glBindVertexArray(vao);
+    Systems::GetRenderer().GetGLState().BindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 }
 
@@ -38,7 +48,8 @@ Shape::Shape(Shape&& s) :
     numVertices(s.numVertices),
     stride(s.stride),
     vao(s.vao),
-    vbo(s.vbo)
+    vbo(s.vbo),
+    ownsBuffer_(s.ownsBuffer_)
 {
     vertexData = s.vertexData;
     s.vertexData = nullptr;
@@ -48,9 +59,11 @@ Shape::Shape(Shape&& s) :
 
 void Shape::DeleteBuffers() {
     if (vao != GL_NONE)
-        glDeleteVertexArrays(1, &vao);
-    if (vbo != GL_NONE)
+        GLState::DeleteVertexArray(vao);
+    if (vbo != GL_NONE && ownsBuffer_)
         glDeleteBuffers(1, &vbo);
+    vao = GL_NONE;
+    vbo = GL_NONE;
     if (vertexData != nullptr)
         delete[] vertexData;
     vertexData = nullptr;
@@ -83,6 +96,7 @@ Shape& Shape::operator=(Shape&& s) {
     stride = s.stride;
     vao = s.vao;
     vbo = s.vbo;
+    ownsBuffer_ = s.ownsBuffer_;
     vertexData = s.vertexData;
 
     s.vertexData = nullptr;
@@ -107,7 +121,7 @@ void Shape::SetVertexData(float* f, bool copy) {
     Bind();
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * s, vertexData, GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    Systems::GetRenderer().GetGLState().BindVertexArray(0);
 }
 
 void Shape::SetVertexData(const float* f) {
@@ -116,8 +130,9 @@ void Shape::SetVertexData(const float* f) {
 
 Shape RECTANGLE_VEC4;
 Shape RECTANGLE_VEC2_VEC2;
+Shape STREAM_VEC4;
 
-void Shapes::CreateDefaultShapes() {
+void Shapes::CreateDefaultShapes(GLuint streamBuffer) {
     RECTANGLE_VEC4.numVertices = 6;
     RECTANGLE_VEC4.numVertexAttributes = 4;
     RECTANGLE_VEC4.stride = 4;
@@ -127,6 +142,10 @@ void Shapes::CreateDefaultShapes() {
     RECTANGLE_VEC2_VEC2.numVertexAttributes = 4;
     RECTANGLE_VEC2_VEC2.stride = 2;
     RECTANGLE_VEC2_VEC2.GenerateVAO();
+
+    STREAM_VEC4.numVertexAttributes = 4;
+    STREAM_VEC4.stride = 4;
+    STREAM_VEC4.GenerateVAO(streamBuffer);
 }
 
 const Shape& Shapes::GetDefaultShape(Shapes::DefaultShape shape) {
@@ -135,6 +154,8 @@ const Shape& Shapes::GetDefaultShape(Shapes::DefaultShape shape) {
             return RECTANGLE_VEC4;
         case DefaultShape::RECTANGLE_VEC2_VEC2:
             return RECTANGLE_VEC2_VEC2;
+        case DefaultShape::STREAM_VEC4:
+            return STREAM_VEC4;
     }
     throw;
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include <latren/graphics/staticbatches.h>
+#include <latren/graphics/component/meshrenderer.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
+
+#include <map>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+struct BatchedMesh {
+    const Mesh* mesh;
+    glm::mat4 modelMatrix;
+};
+
+// material, face culling and the cell, sorted so that the cells of a batch are next to each other
+using BatchKey = std::tuple<Material*, bool, int, int, int>;
+
+bool StaticBatches::CanBatch(const MeshRenderer& renderer) {
+    // derived renderers could override the rendering
+    if (typeid(renderer) != typeid(MeshRenderer))
+        return false;
+    if (!renderer.IsStatic() || renderer.alwaysOnFrustum || renderer.renderPass != RenderPass::NORMAL)
+        return false;
+    if (renderer.useCustomMaterial || renderer.disableDepthTest)
+        return false;
+    // these need their own bounds for the occlusion culling
+    if (renderer.occluder || renderer.occludee)
+        return false;
+    if (renderer.meshes->empty())
+        return false;
+    for (const auto& mesh : renderer.meshes.Get()) {
+        if (mesh->material == nullptr || !mesh->lods.empty() || mesh->vertices.empty() || mesh->indices.empty())
+            return false;
+    }
+    return true;
+}
+
+void StaticBatches::BuildGroup(Group& group) {
+    std::map<BatchKey, std::vector<BatchedMesh>> groups;
+    std::map<BatchKey, std::shared_ptr<Material>> materials;
+    Stats& stats = group.stats;
+    stats = Stats();
+    for (GeneralComponentReference& ref : group.renderers) {
+        const MeshRenderer* renderer = &ref.CastComponent<MeshRenderer>();
+        ViewFrustum::AABB aabb;
+        renderer->GetWorldAABB(aabb);
+        glm::ivec3 cell = glm::ivec3(glm::floor(aabb.center / cellSize));
+        for (const auto& mesh : renderer->meshes.Get()) {
+            BatchKey key = { mesh->material.get(), mesh->cullFaces, cell.x, cell.y, cell.z };
+            groups[key].push_back({ mesh.get(), renderer->GetModelMatrix() * mesh->transformMatrix });
+            materials[key] = mesh->material;
+            stats.meshes++;
+        }
+    }
+    stats.renderers = group.renderers.size();
+
+    std::unique_ptr<Mesh> mesh;
+    std::shared_ptr<Material> material;
+    bool cullFaces = true;
+    auto finishBatch = [&]() {
+        if (mesh == nullptr)
+            return;
+        mesh->material = material;
+        mesh->cullFaces = cullFaces;
+        mesh->ChooseLayout();
+        mesh->GenerateVAO();
+        // the merged copies aren't needed after the upload
+        mesh->vertices = std::vector<float>();
+        mesh->normals = std::vector<float>();
+        mesh->texCoords = std::vector<float>();
+        Batch batch;
+        batch.material = material;
+        batch.mesh = std::move(mesh);
+        batch.firstCell = group.batches.empty() ? 0 : group.batches.back().firstCell + group.batches.back().cellCount;
+        batch.cellCount = group.cells.size() - batch.firstCell;
+        group.batches.push_back(std::move(batch));
+    };
+
+    for (const auto& [key, meshes] : groups) {
+        bool newMaterial = mesh == nullptr || std::get<0>(key) != material.get() || std::get<1>(key) != cullFaces;
+        if (newMaterial || mesh->vertices.size() / 3 >= maxBatchVertices) {
+            finishBatch();
+            mesh = std::make_unique<Mesh>();
+            mesh->id = "static_batch";
+            material = materials.at(key);
+            cullFaces = std::get<1>(key);
+        }
+        Cell cell;
+        cell.first = mesh->indices.size();
+        cell.meshes = meshes.size();
+        glm::vec3 cellMin = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 cellMax = glm::vec3(-std::numeric_limits<float>::max());
+        for (const BatchedMesh& m : meshes) {
+            unsigned int baseVertex = static_cast<unsigned int>(mesh->vertices.size() / 3);
+            std::size_t vertexCount = m.mesh->vertices.size() / 3;
+            glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(m.modelMatrix)));
+            for (std::size_t i = 0; i < vertexCount; i++) {
+                glm::vec3 v = m.modelMatrix * glm::vec4(m.mesh->vertices[i * 3], m.mesh->vertices[i * 3 + 1], m.mesh->vertices[i * 3 + 2], 1.0f);
+                mesh->vertices.insert(mesh->vertices.end(), { v.x, v.y, v.z });
+                cellMin = glm::min(cellMin, v);
+                cellMax = glm::max(cellMax, v);
+
+                glm::vec3 n(0.0f);
+                if (i * 3 + 2 < m.mesh->normals.size())
+                    n = normalMatrix * glm::vec3(m.mesh->normals[i * 3], m.mesh->normals[i * 3 + 1], m.mesh->normals[i * 3 + 2]);
+                // degenerate normals would turn into nans
+                float length = glm::length(n);
+                if (length > 1e-8f)
+                    n /= length;
+                mesh->normals.insert(mesh->normals.end(), { n.x, n.y, n.z });
+
+                // padded so that the meshes without texcoords don't shift the rest
+                float u = (i * 2 + 1 < m.mesh->texCoords.size()) ? m.mesh->texCoords[i * 2] : 0.0f;
+                float v2 = (i * 2 + 1 < m.mesh->texCoords.size()) ? m.mesh->texCoords[i * 2 + 1] : 0.0f;
+                mesh->texCoords.insert(mesh->texCoords.end(), { u, v2 });
+            }
+            // mirrored transforms flip the winding
+            bool flip = glm::determinant(glm::mat3(m.modelMatrix)) < 0.0f;
+            const std::vector<unsigned int>& indices = m.mesh->indices;
+            for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+                mesh->indices.push_back(baseVertex + indices[i]);
+                mesh->indices.push_back(baseVertex + indices[flip ? i + 2 : i + 1]);
+                mesh->indices.push_back(baseVertex + indices[flip ? i + 1 : i + 2]);
+            }
+        }
+        cell.count = mesh->indices.size() - cell.first;
+        cell.aabb = ViewFrustum::AABB::FromMinMax(cellMin, cellMax);
+        group.cells.push_back(cell);
+    }
+    finishBatch();
+
+    group.cellBounds.Resize(group.cells.size());
+    for (std::size_t i = 0; i < group.cells.size(); i++) {
+        group.cellBounds.Set(i, group.cells[i].aabb);
+    }
+    stats.batches = group.batches.size();
+    stats.cells = group.cells.size();
+    stats.groups = 1;
+    if (!group.batches.empty())
+        spdlog::info("Built static batches ({} renderers, {} meshes -> {} batches, {} cells)", stats.renderers, stats.meshes, stats.batches, stats.cells);
+}
+
+void StaticBatches::UpdateStats() {
+    stats_ = Stats();
+    for (const Group& group : groups_) {
+        stats_.batches += group.stats.batches;
+        stats_.cells += group.stats.cells;
+        stats_.renderers += group.stats.renderers;
+        stats_.meshes += group.stats.meshes;
+        stats_.groups++;
+    }
+}
+
+void StaticBatches::Build(const std::vector<GeneralComponentReference>& renderers) {
+    Clear();
+    Add(renderers);
+}
+
+void StaticBatches::Add(const std::vector<GeneralComponentReference>& renderers) {
+    if (renderers.empty())
+        return;
+    Group& group = groups_.emplace_back();
+    group.renderers = renderers;
+    BuildGroup(group);
+    UpdateStats();
+}
+
+std::vector<GeneralComponentReference> StaticBatches::RemoveStale() {
+    std::vector<GeneralComponentReference> released;
+    std::vector<GeneralComponentReference> remaining;
+    for (auto it = groups_.begin(); it != groups_.end();) {
+        bool stale = false;
+        for (GeneralComponentReference& ref : it->renderers) {
+            if (ref.IsNull() || !CanBatch(ref.CastComponent<MeshRenderer>())) {
+                stale = true;
+                break;
+            }
+        }
+        if (!stale) {
+            it++;
+            continue;
+        }
+        for (GeneralComponentReference& ref : it->renderers) {
+            if (ref.IsNull())
+                continue;
+            if (CanBatch(ref.CastComponent<MeshRenderer>()))
+                remaining.push_back(ref);
+            else
+                released.push_back(ref);
+        }
+        it = groups_.erase(it);
+    }
+    // a stage unload takes its whole group with it, so usually there's nothing to merge again
+    Add(remaining);
+    UpdateStats();
+    return released;
+}
+
+void StaticBatches::Clear() {
+    groups_.clear();
+    stats_ = Stats();
+}
+
+std::size_t StaticBatches::Render(const ViewFrustum& frustum, std::size_t& meshes) {
+    std::size_t drawCalls = 0;
+    for (const Group& group : groups_) {
+        if (group.cells.empty())
+            continue;
+        Culling::CullAABBs(frustum, group.cellBounds, visibility_);
+        for (const Batch& batch : group.batches) {
+            const Shader& shader = batch.material->GetShader();
+            bool bound = false;
+            std::size_t end = batch.firstCell + batch.cellCount;
+            std::size_t i = batch.firstCell;
+            while (i < end) {
+                if (!visibility_.Test(i)) {
+                    i++;
+                    continue;
+                }
+                if (!bound) {
+                    batch.material->Use(shader);
+                    shader.SetUniform("model", glm::mat4(1.0f));
+                    batch.mesh->Bind();
+                    bound = true;
+                }
+                // the cells are back to back in the index buffer, so a run of visible ones is a single draw
+                std::size_t first = group.cells[i].first;
+                std::size_t count = 0;
+                while (i < end && visibility_.Test(i)) {
+                    count += group.cells[i].count;
+                    meshes += group.cells[i].meshes;
+                    i++;
+                }
+                batch.mesh->RenderRange(first, count);
+                drawCalls++;
+            }
+        }
+    }
+    return drawCalls;
+}
+
+bool StaticBatches::IsEmpty() const {
+    return stats_.batches == 0;
+}
+
+const StaticBatches::Stats& StaticBatches::GetStats() const {
+    return stats_;
+}
\ No newline at end of file
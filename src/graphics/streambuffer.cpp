@@ -0,0 +1,133 @@
+#include <latren/graphics/streambuffer.h>
+#include <latren/graphics/glstate.h>
+
+#include <spdlog/spdlog.h>
+#include <cstring>
+
+void StreamBuffer::Create(GLsizeiptr segmentSize) {
+    segmentSize_ = segmentSize;
+    segment_ = 0;
+    head_ = 0;
+    GLsizeiptr size = segmentSize_ * FRAMES;
+    persistent_ = GLEW_ARB_buffer_storage;
+
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    if (persistent_) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        mapped_ = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        if (mapped_ == nullptr) {
+            spdlog::warn("Couldn't map the stream buffer persistently, falling back to glBufferSubData");
+            glDeleteBuffers(1, &vbo_);
+            glGenBuffers(1, &vbo_);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+            persistent_ = false;
+        }
+    }
+    if (!persistent_) {
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        staging_.resize(size);
+        mapped_ = staging_.data();
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::Delete() {
+    for (GLsync& fence : fences_) {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (vbo_ != GL_NONE) {
+        if (persistent_) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &vbo_);
+    }
+    vbo_ = GL_NONE;
+    mapped_ = nullptr;
+    staging_ = std::vector<char>();
+}
+
+void StreamBuffer::WaitForSegment(int segment) {
+    GLsync& fence = fences_[segment];
+    if (fence == nullptr)
+        return;
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::AdvanceSegment() {
+    if (fences_[segment_] != nullptr)
+        glDeleteSync(fences_[segment_]);
+    fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment_ = (segment_ + 1) % FRAMES;
+    WaitForSegment(segment_);
+    head_ = segment_ * segmentSize_;
+}
+
+void StreamBuffer::NextFrame() {
+    if (vbo_ == GL_NONE)
+        return;
+    AdvanceSegment();
+}
+
+StreamBuffer::Allocation StreamBuffer::Allocate(GLsizeiptr size, GLsizei stride) {
+    Allocation allocation;
+    if (size > segmentSize_ - stride) {
+        spdlog::error("Can't stream {} bytes (the segments are {} bytes)", size, segmentSize_);
+        return allocation;
+    }
+    GLintptr offset = (head_ + stride - 1) / stride * stride;
+    // ran out of space for this frame, just move on to the next segment early
+    if (offset + size > (segment_ + 1) * segmentSize_) {
+        AdvanceSegment();
+        offset = (head_ + stride - 1) / stride * stride;
+    }
+    head_ = offset + size;
+
+    allocation.data = mapped_ + offset;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.first = (GLint) (offset / stride);
+    return allocation;
+}
+
+void StreamBuffer::Commit(const Allocation& allocation, GLsizeiptr size) {
+    if (size <= 0)
+        return;
+    GLState::CountUpload(size);
+    // coherent mapping, nothing to do
+    if (persistent_)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferSubData(GL_ARRAY_BUFFER, allocation.offset, size, allocation.data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::Commit(const Allocation& allocation) {
+    Commit(allocation, allocation.size);
+}
+
+StreamBuffer::Allocation StreamBuffer::Upload(const void* data, GLsizeiptr size, GLsizei stride) {
+    Allocation allocation = Allocate(size, stride);
+    if (allocation.data == nullptr)
+        return allocation;
+    std::memcpy(allocation.data, data, size);
+    Commit(allocation);
+    return allocation;
+}
+
+GLuint StreamBuffer::GetBuffer() const {
+    return vbo_;
+}
+
+bool StreamBuffer::IsPersistent() const {
+    return persistent_;
+}
\ No newline at end of file
@@ -1,37 +1,192 @@
 #include <latren/graphics/texture.h>
+#include <latren/graphics/compressedtexture.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
 #include <latren/io/resourcemanager.h>
 
 #include <stb/stb_image.h>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <memory>
 
 using namespace Texture;
 
 std::optional<TextureID> Resources::TextureManager::LoadResource(const ResourcePath& path) {
+    return DecodeResource(path, GetItemID(), GetAdditionalData())();
+}
+
+std::function<std::optional<TextureID>()> Resources::TextureManager::DecodeResource(const ResourcePath& path, const std::string& id, const AdditionalImportData&) {
     std::fs::path parsedPath = path.GetParsedPath();
     if (!std::filesystem::exists(parsedPath)) {
         spdlog::warn("Texture does not exist!");
-        return std::optional<TextureID>(TEXTURE_NONE);
+        return [] { return std::optional<TextureID>(TEXTURE_NONE); };
     }
 
-    TextureID texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    std::fs::path compressedPath = IsCompressedTexturePath(parsedPath) ? parsedPath : std::fs::path();
+    if (compressedPath.empty() && preferCompressedTextures)
+        compressedPath = FindCompressedVariant(parsedPath);
+    if (!compressedPath.empty()) {
+        auto compressed = DecodeCompressedTexture(compressedPath);
+        if (compressed != nullptr)
+            return compressed;
+        // a broken variant falls back to the original, a broken .dds has nothing to fall back to
+        if (compressedPath == parsedPath)
+            return [] { return std::optional<TextureID>(TEXTURE_NONE); };
+    }
 
-    int width, height, imgChannels;
+    int width = 0, height = 0, imgChannels = 0;
     uint8_t* data = nullptr;
     data = stbi_load(parsedPath.generic_string().c_str(), &width, &height, &imgChannels, 0);
 
     if (data == nullptr) {
         spdlog::warn("Can't load texture!");
     }
-    // smartass way to convert from n channels to the corresponding opengl format
-    GLuint glFormat = (GL_RGB - 3) + imgChannels;
-    glTexImage2D(GL_TEXTURE_2D, 0, glFormat, width, height, 0, glFormat, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
+    // freed with the last copy of the upload job
+    std::shared_ptr<uint8_t> pixels(data, [](uint8_t* p) { stbi_image_free(p); });
+
+    return [this, pixels, width, height, imgChannels, id]() {
+        TextureID texture;
+        glGenTextures(1, &texture);
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // smartass way to convert from n channels to the corresponding opengl format
+        GLuint glFormat = (GL_RGB - 3) + imgChannels;
+        glTexImage2D(GL_TEXTURE_2D, 0, glFormat, width, height, 0, glFormat, GL_UNSIGNED_BYTE, pixels.get());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        if (packTextureArrays && pixels != nullptr)
+            pendingTextures_.push_back({ id, width, height, imgChannels, std::vector<uint8_t>(pixels.get(), pixels.get() + (std::size_t) width * height * imgChannels) });
+
+        return std::optional<TextureID>(texture);
+    };
+}
+
+std::function<std::optional<TextureID>()> Resources::TextureManager::DecodeCompressedTexture(const std::fs::path& path) {
+    auto image = std::make_shared<CompressedImage>();
+    if (!LoadCompressedImage(path, *image)) {
+        spdlog::warn("Can't load compressed texture '{}'!", path.generic_string());
+        return nullptr;
+    }
+    // the cpu fallback for the drivers without the format, decoded here so the game thread doesn't have to
+    auto decoded = std::make_shared<std::vector<CompressedImage::Level>>();
+    int channels = 0;
+    if (!IsCompressedFormatSupported(image->format)) {
+        if (!CanDecodeCompressedFormat(image->format)) {
+            spdlog::warn("{} textures aren't supported by the driver!", GetCompressedFormatName(image->format));
+            return nullptr;
+        }
+        for (const CompressedImage::Level& level : image->levels) {
+            CompressedImage::Level& pixels = decoded->emplace_back(CompressedImage::Level { level.width, level.height, { } });
+            channels = DecodeCompressedLevel(image->format, level, pixels.data);
+        }
+        image->levels.clear();
+        image->levels.shrink_to_fit();
+    }
+
+    return [image, decoded, channels]() {
+        TextureID texture;
+        glGenTextures(1, &texture);
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // the mips come from the file, glGenerateMipmap can't be used on compressed textures anyway
+        std::size_t levelCount;
+        if (decoded->empty()) {
+            levelCount = image->levels.size();
+            GLenum glFormat = GetCompressedGLFormat(image->format);
+            for (std::size_t i = 0; i < levelCount; i++) {
+                const CompressedImage::Level& level = image->levels.at(i);
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint) i, glFormat, level.width, level.height, 0, (GLsizei) level.data.size(), level.data.data());
+            }
+        }
+        else {
+            levelCount = decoded->size();
+            GLenum internalFormat = channels == 1 ? GL_R8 : channels == 2 ? GL_RG8 : GL_RGBA8;
+            GLenum glFormat = channels == 1 ? GL_RED : channels == 2 ? GL_RG : GL_RGBA;
+            GLint unpackAlignment;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (std::size_t i = 0; i < levelCount; i++) {
+                const CompressedImage::Level& level = decoded->at(i);
+                glTexImage2D(GL_TEXTURE_2D, (GLint) i, internalFormat, level.width, level.height, 0, glFormat, GL_UNSIGNED_BYTE, level.data.data());
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint) levelCount - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        return std::optional<TextureID>(texture);
+    };
+}
+
+void Resources::TextureManager::BuildTextureArrays() {
+    if (pendingTextures_.empty())
+        return;
+    // the arrays of an earlier load go, the textures in them are still there as plain 2d textures.
+    // the materials are parsed again after this so they'll pick up the new layers
+    for (TextureID array : textureArrays_) {
+        GLState::DeleteTexture(array);
+    }
+    textureArrays_.clear();
+    arrayLayers_.clear();
+    // same size and channel count, in import order within the group
+    std::map<std::tuple<int, int, int>, std::vector<const PendingTexture*>> groups;
+    for (const PendingTexture& texture : pendingTextures_) {
+        // the ones that got reloaded under another id or overwritten with Set aren't the same texture anymore
+        if (!HasLoaded(texture.id))
+            continue;
+        groups[{ texture.width, texture.height, texture.channels }].push_back(&texture);
+    }
+    GLint maxLayers = 256;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+    GLState& gl = Systems::GetRenderer().GetGLState();
+    for (const auto& [key, textures] : groups) {
+        if (textures.size() < static_cast<std::size_t>(std::max(minArrayLayers, 2)))
+            continue;
+        const auto& [width, height, channels] = key;
+        GLuint glFormat = (GL_RGB - 3) + channels;
+        for (std::size_t first = 0; first < textures.size(); first += maxLayers) {
+            GLsizei layers = static_cast<GLsizei>(std::min<std::size_t>(textures.size() - first, maxLayers));
+            TextureID array;
+            glGenTextures(1, &array);
+            gl.BindTexture(GL_TEXTURE_2D_ARRAY, array);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, glFormat, width, height, layers, 0, glFormat, GL_UNSIGNED_BYTE, nullptr);
+            for (GLsizei layer = 0; layer < layers; layer++) {
+                const PendingTexture& texture = *textures[first + layer];
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, glFormat, GL_UNSIGNED_BYTE, texture.pixels.data());
+                arrayLayers_[texture.id] = { array, layer };
+            }
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            textureArrays_.push_back(array);
+            spdlog::info("Packed {} {}x{} textures into a texture array", layers, width, height);
+        }
+    }
+    pendingTextures_.clear();
+    pendingTextures_.shrink_to_fit();
+}
+
+bool Resources::TextureManager::GetArrayLayer(const std::string& id, ArrayLayer& layer) const {
+    auto item = items_.find(id);
+    if (item == items_.end())
+        return false;
+    // the item ids aren't case sensitive, so look it up with the one it was loaded with
+    auto it = arrayLayers_.find(item->first);
+    if (it == arrayLayers_.end())
+        return false;
+    layer = it->second;
+    return true;
+}
 
-    return std::optional<TextureID>(texture);
+const std::vector<TextureID>& Resources::TextureManager::GetTextureArrays() const {
+    return textureArrays_;
 }
\ No newline at end of file
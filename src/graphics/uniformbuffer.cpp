@@ -0,0 +1,59 @@
+#include <latren/graphics/uniformbuffer.h>
+#include <latren/graphics/glstate.h>
+
+using namespace UniformBlocks;
+
+const char* UniformBlocks::CAMERA_BLOCK_NAME = "CameraData";
+const char* UniformBlocks::LIGHTS_BLOCK_NAME = "LightData";
+
+void BindBlock(GLuint program, const char* name, Binding binding) {
+    GLuint index = glGetUniformBlockIndex(program, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, binding);
+}
+
+void BindSampler(GLuint program, const char* name, TextureUnit unit) {
+    GLint location = glGetUniformLocation(program, name);
+    if (location != -1)
+        glUniform1i(location, unit);
+}
+
+void UniformBlocks::BindProgram(GLuint program) {
+    BindBlock(program, CAMERA_BLOCK_NAME, Binding::CAMERA);
+    BindBlock(program, LIGHTS_BLOCK_NAME, Binding::LIGHTS);
+    GLint prevProgram;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+    glUseProgram(program);
+    BindSampler(program, "lightBuffer", TextureUnit::LIGHT_BUFFER_UNIT);
+    BindSampler(program, "lightClusters", TextureUnit::LIGHT_CLUSTER_UNIT);
+    BindSampler(program, "lightIndices", TextureUnit::LIGHT_INDEX_UNIT);
+    BindSampler(program, "textureArraySampler", TextureUnit::TEXTURE_ARRAY_UNIT);
+    glUseProgram(prevProgram);
+}
+
+void UniformBuffer::Create(Binding binding, GLsizeiptr size) {
+    size_ = size;
+    glGenBuffers(1, &ubo_);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    glBufferData(GL_UNIFORM_BUFFER, size_, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo_);
+}
+
+void UniformBuffer::Delete() {
+    if (ubo_ != GL_NONE)
+        glDeleteBuffers(1, &ubo_);
+    ubo_ = GL_NONE;
+    size_ = 0;
+}
+
+void UniformBuffer::Update(const void* data, GLsizeiptr size, GLintptr offset) const {
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    GLState::CountUpload(size);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint UniformBuffer::GetBuffer() const {
+    return ubo_;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include <latren/graphics/vertexlayout.h>
+
+std::size_t VertexLayout::GetPositionSize() const {
+    return 3 * sizeof(float);
+}
+
+std::size_t VertexLayout::GetTexCoordSize() const {
+    return texCoordFormat == TexCoordFormat::HALF_FLOAT ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+}
+
+std::size_t VertexLayout::GetNormalSize() const {
+    return normalFormat == NormalFormat::PACKED ? sizeof(uint32_t) : 3 * sizeof(float);
+}
+
+std::size_t VertexLayout::GetVertexSize() const {
+    return GetPositionSize() + GetTexCoordSize() + GetNormalSize();
+}
+
+// interleaved: pos, texcoord, normal for each vertex
+// otherwise: all positions, then all texcoords, then all normals
+std::size_t VertexLayout::GetTexCoordOffset(std::size_t vertexCount) const {
+    return interleaved ? GetPositionSize() : GetPositionSize() * vertexCount;
+}
+
+std::size_t VertexLayout::GetNormalOffset(std::size_t vertexCount) const {
+    return interleaved ? GetPositionSize() + GetTexCoordSize() : (GetPositionSize() + GetTexCoordSize()) * vertexCount;
+}
+
+void VertexLayout::SetAttribPointers(std::size_t vertexCount) const {
+    auto attribStride = [&](std::size_t size) { return (GLsizei) (interleaved ? GetVertexSize() : size); };
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, attribStride(GetPositionSize()), nullptr);
+    glEnableVertexAttribArray(0);
+    void* texCoordOffset = reinterpret_cast<void*>(GetTexCoordOffset(vertexCount));
+    if (texCoordFormat == TexCoordFormat::HALF_FLOAT)
+        glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, attribStride(GetTexCoordSize()), texCoordOffset);
+    else
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, attribStride(GetTexCoordSize()), texCoordOffset);
+    glEnableVertexAttribArray(1);
+    void* normalOffset = reinterpret_cast<void*>(GetNormalOffset(vertexCount));
+    if (normalFormat == NormalFormat::PACKED)
+        glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, attribStride(GetNormalSize()), normalOffset);
+    else
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, attribStride(GetNormalSize()), normalOffset);
+    glEnableVertexAttribArray(2);
+}
+
+bool VertexLayout::IsVertexCompatible(const VertexLayout& other) const {
+    return interleaved == other.interleaved && normalFormat == other.normalFormat && texCoordFormat == other.texCoordFormat;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <latren/io/asyncloader.h>
+#include <latren/threads/threadpool.h>
+#include <latren/systems.h>
+
+#include <spdlog/spdlog.h>
+#include <magic_enum/magic_enum.hpp>
+#include <chrono>
+#include <limits>
+
+using namespace Resources;
+
+AsyncLoader::~AsyncLoader() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stateChanged_.wait(lock, [this] { return decoding_ == 0; });
+}
+
+void AsyncLoader::FinishJob(ResourceType t) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_[t]--;
+        totalPending_--;
+    }
+    stateChanged_.notify_all();
+}
+
+void AsyncLoader::Submit(ResourceType t, DecodeJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_[t]++;
+        totalPending_++;
+        decoding_++;
+    }
+    Systems::GetThreadPool().Submit([this, t, job] {
+        // a failed job still has to be counted as done, otherwise Finish would wait for it forever
+        UploadJob upload = nullptr;
+        try {
+            upload = job();
+        }
+        catch (std::exception& e) {
+            spdlog::error("Decoding a {} failed!", magic_enum::enum_name(t));
+            spdlog::debug(e.what());
+        }
+        catch (...) {
+            spdlog::error("Decoding a {} failed!", magic_enum::enum_name(t));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        uploads_.push_back({ t, upload });
+        decoding_--;
+        // notified under the lock, the loader might be getting destroyed as soon as it's released
+        stateChanged_.notify_all();
+    });
+}
+
+void AsyncLoader::SubmitUpload(ResourceType t, UploadJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_[t]++;
+        totalPending_++;
+        uploads_.push_back({ t, job });
+    }
+    stateChanged_.notify_all();
+}
+
+std::size_t AsyncLoader::ProcessUploads(double budget) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t count = 0;
+    while (true) {
+        std::pair<ResourceType, UploadJob> upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (uploads_.empty())
+                break;
+            upload = std::move(uploads_.front());
+            uploads_.pop_front();
+        }
+        if (upload.second != nullptr)
+            upload.second();
+        FinishJob(upload.first);
+        count++;
+        if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budget)
+            break;
+    }
+    return count;
+}
+
+void AsyncLoader::WaitForUploads() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stateChanged_.wait(lock, [this] { return !uploads_.empty() || totalPending_ == 0; });
+}
+
+void AsyncLoader::Finish() {
+    while (GetPendingCount() > 0) {
+        WaitForUploads();
+        ProcessUploads(std::numeric_limits<double>::infinity());
+    }
+}
+
+std::size_t AsyncLoader::GetPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalPending_;
+}
+
+std::size_t AsyncLoader::GetPendingCount(ResourceType t) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_.find(t);
+    return it != pending_.end() ? it->second : 0;
+}
\ No newline at end of file
@@ -105,8 +105,12 @@ std::vector<std::pair<std::string, std::shared_ptr<Material>>> ParseMaterials(co
         const json& textureJson = materialJson["texture"];
         if (!textureJson.is_object() || !textureJson.contains("src") || !textureJson["src"].is_string())
             return ParsingException(invalidMaterials);
-        else if (Systems::GetResources().GetTextureManager()->HasLoaded(textureJson["src"]))
+        else if (Systems::GetResources().GetTextureManager()->HasLoaded(textureJson["src"])) {
             m->SetTexture(Systems::GetResources().GetTextureManager()->Get(textureJson["src"]));
+            Texture::ArrayLayer layer;
+            if (Systems::GetResources().GetTextureManager()->GetArrayLayer(textureJson["src"], layer))
+                m->SetTexture(layer);
+        }
         else
             spdlog::warn("Texture '{}' not found!", textureJson["src"]);
     }
@@ -7,6 +7,45 @@ using namespace nlohmann;
 
 typedef std::pair<std::string, Object> ObjectPair;
 
+bool ParseFloatArray(std::vector<float>& arr, const json& arrJson) {
+    if (!arrJson.is_array())
+        return false;
+    arr.clear();
+    for (const auto& item : arrJson) {
+        if (!item.is_number())
+            return false;
+        arr.push_back(item.get<float>());
+    }
+    return true;
+}
+
+// either false to disable the lods or an object overriding some of the settings
+bool ParseLODSettings(LODSettings& lod, const json& lodJson) {
+    if (lodJson.is_boolean()) {
+        lod.enabled = lodJson.get<bool>();
+        return true;
+    }
+    if (!lodJson.is_object())
+        return false;
+    if (lodJson.contains("enabled")) {
+        if (!lodJson.at("enabled").is_boolean())
+            return false;
+        lod.enabled = lodJson.at("enabled");
+    }
+    if (lodJson.contains("errors") && !ParseFloatArray(lod.errors, lodJson.at("errors")))
+        return false;
+    if (lodJson.contains("ratios") && !ParseFloatArray(lod.ratios, lodJson.at("ratios")))
+        return false;
+    if (lodJson.contains("screenSizes") && !ParseFloatArray(lod.screenSizes, lodJson.at("screenSizes")))
+        return false;
+    if (lodJson.contains("minTriangles")) {
+        if (!lodJson.at("minTriangles").is_number_unsigned())
+            return false;
+        lod.minTriangles = lodJson.at("minTriangles");
+    }
+    return true;
+}
+
 std::optional<ObjectPair> ParseObject(const json& objJson) {
     if (!objJson.is_object())
         return std::nullopt;
@@ -27,6 +66,10 @@ std::optional<ObjectPair> ParseObject(const json& objJson) {
         if (!SetJSONPointerValue(&obj.size, objJson.at("size")))
             return std::nullopt;
     }
+    if (objJson.contains("lod")) {
+        if (!ParseLODSettings(obj.lod, objJson.at("lod")))
+            return std::nullopt;
+    }
     if (objJson.contains("materialOverrides")) {
         if (!objJson.at("materialOverrides").is_object())
             return std::nullopt;
@@ -4,6 +4,7 @@
 #include <latren/io/serializablestruct.h>
 #include <latren/systems.h>
 #include <latren/graphics/renderer.h>
+#include <latren/threads/threadpool.h>
 
 #include <fstream>
 
@@ -19,6 +20,7 @@ namespace Resources {
     ModelManager::ModelManager() : ResourceTypeManager<Model>(GetDefaultPath(ResourceType::MODEL), ResourceName("model")) { }
     StageManager::StageManager() : ResourceTypeManager<Stage>(GetDefaultPath(ResourceType::STAGE), ResourceName("stage")) {
         stageSerializer_ = std::make_unique<Serialization::StageSerializer>();
+        streamingLoader_ = std::make_unique<AsyncLoader>();
     }
     AudioManager::AudioManager() : ResourceTypeManager<AudioBufferHandle>(GetDefaultPath(ResourceType::AUDIO), ResourceName("audio file")) { }
 
@@ -171,47 +173,80 @@ Resources::Imports<Resources::ShaderImport> Resources::ListShaderImports(const C
 }
 
 template <typename T>
-std::function<void(const CFG::CFGObject*, Resources::ResourceType)> CreateLoader(T* mgr, VariantEventHandler<Resources::ResourceLoadEvent, void(std::size_t), void(const std::string&)>& eventHandler) {
+std::function<void()> ForwardImportLoads(Resources::ResourceTypeManager<T>* mgr, VariantEventHandler<Resources::ResourceLoadEvent, void(std::size_t), void(const std::string&)>& eventHandler) {
     using namespace Resources;
 
     if (mgr == nullptr)
         return nullptr;
-    return [&, mgr](const CFG::CFGObject* obj, ResourceType t) {
-        EventID event = mgr->onResourceLoad.Subscribe([&](const std::string& resource) {
-            eventHandler.Dispatch<const std::string&>(ResourceLoadEvent::ON_IMPORT_LOAD, resource);
-        });
-        mgr->LoadImports(ListImports(obj, t));
-        mgr->onResourceLoad.Unsubscribe(event);
-    };
+    EventID event = mgr->onResourceLoad.Subscribe([&](const std::string& resource) {
+        eventHandler.Dispatch<const std::string&>(ResourceLoadEvent::ON_IMPORT_LOAD, resource);
+    });
+    return [mgr, event] { mgr->onResourceLoad.Unsubscribe(event); };
+}
+
+template <typename T>
+void LoadImportList(Resources::ResourceTypeManager<T>* mgr, const Resources::Imports<>& imports, Resources::AsyncLoader* loader) {
+    if (mgr == nullptr)
+        return;
+    if (loader != nullptr)
+        mgr->LoadImportsAsync(imports, *loader);
+    else
+        mgr->LoadImports(imports);
+}
+
+void ModularResourceManager::LoadPendingImports(Resources::ResourceType t, bool async) {
+    using namespace Resources;
+
+    AsyncLoader* loader = async ? &asyncLoader_ : nullptr;
+    for (const auto& imports : pendingImports_[t]) {
+        switch (t) {
+            case ResourceType::TEXTURE:
+                LoadImportList(GetTextureManager(), imports, loader);
+                break;
+            case ResourceType::MODEL:
+                LoadImportList(GetModelManager(), imports, loader);
+                break;
+            case ResourceType::FONT:
+                LoadImportList(GetFontManager(), imports, loader);
+                break;
+            case ResourceType::STAGE:
+                LoadImportList(GetStageManager(), imports, loader);
+                break;
+            case ResourceType::AUDIO:
+                LoadImportList(GetAudioManager(), imports, loader);
+                break;
+            case ResourceType::TEXT:
+                LoadImportList(GetTextFileManager(), imports, loader);
+                break;
+            case ResourceType::BINARY:
+                LoadImportList(GetBinaryFileManager(), imports, loader);
+                break;
+            case ResourceType::JSON:
+                LoadImportList(GetJSONFileManager(), imports, loader);
+                break;
+            case ResourceType::CFG:
+                LoadImportList(GetCFGFileManager(), imports, loader);
+                break;
+            default:
+                break;
+        }
+    }
+    pendingImports_.erase(t);
 }
 
 void ModularResourceManager::LoadImports(const CFG::CFGObject* root) {
+    BeginLoadImports(root);
+    while (!UpdateLoading())
+        asyncLoader_.WaitForUploads();
+}
+
+void ModularResourceManager::BeginLoadImports(const CFG::CFGObject* root) {
     using namespace Resources;
 
-    std::unordered_map<ResourceType, std::function<void(const CFG::CFGObject*, ResourceType)>> loaders = {
-        { ResourceType::TEXTURE, CreateLoader(GetTextureManager(), eventHandler) },
-        { ResourceType::MODEL, CreateLoader(GetModelManager(), eventHandler) },
-        { ResourceType::FONT, CreateLoader(GetFontManager(), eventHandler) },
-        { ResourceType::STAGE, CreateLoader(GetStageManager(), eventHandler) },
-        { ResourceType::SHADER,
-            [&](const CFG::CFGObject* obj, ResourceType) {
-                ShaderManager* mgr = GetShaderManager();
-                if (mgr == nullptr)
-                    return;
-                EventID event = mgr->onResourceLoad.Subscribe([&](const std::string& resource) {
-                    eventHandler.Dispatch<const std::string&>(ResourceLoadEvent::ON_IMPORT_LOAD, resource);
-                });
-                mgr->LoadImports(ListShaderImports(obj));
-                mgr->onResourceLoad.Unsubscribe(event);
-            }
-        },
-        { ResourceType::AUDIO, CreateLoader(GetAudioManager(), eventHandler) },
+    // finish whatever was going on first
+    while (IsLoading() && !UpdateLoading())
+        asyncLoader_.WaitForUploads();
 
-        { ResourceType::TEXT, CreateLoader(GetTextFileManager(), eventHandler) },
-        { ResourceType::BINARY, CreateLoader(GetBinaryFileManager(), eventHandler) },
-        { ResourceType::JSON, CreateLoader(GetJSONFileManager(), eventHandler) },
-        { ResourceType::CFG, CreateLoader(GetCFGFileManager(), eventHandler) }
-    };
     std::unordered_map<std::string, ResourceType> cfgTypes = {
         { "[Texture]", ResourceType::TEXTURE },
         { "[Model]", ResourceType::MODEL },
@@ -225,53 +260,102 @@ void ModularResourceManager::LoadImports(const CFG::CFGObject* root) {
         { "[JSON]", ResourceType::JSON },
         { "[CFG]", ResourceType::CFG }
     };
+    std::unordered_map<ResourceType, bool> hasLoader = {
+        { ResourceType::TEXTURE, GetTextureManager() != nullptr },
+        { ResourceType::MODEL, GetModelManager() != nullptr },
+        { ResourceType::FONT, GetFontManager() != nullptr },
+        { ResourceType::STAGE, GetStageManager() != nullptr },
+        { ResourceType::SHADER, GetShaderManager() != nullptr },
+        { ResourceType::AUDIO, GetAudioManager() != nullptr },
+
+        { ResourceType::TEXT, GetTextFileManager() != nullptr },
+        { ResourceType::BINARY, GetBinaryFileManager() != nullptr },
+        { ResourceType::JSON, GetJSONFileManager() != nullptr },
+        { ResourceType::CFG, GetCFGFileManager() != nullptr }
+    };
     
     std::size_t importCount = 0;
-    std::unordered_map<ResourceType, std::vector<const CFG::CFGObject*>> imports;
     for (const auto& importList : root->GetItems()) {
         if (importList->type != CFG::CFGFieldType::ARRAY)
             continue;
         auto t = cfgTypes.find(importList->typeAnnotation);
         if (t == cfgTypes.end())
             continue;
-        if (loaders.count(t->second) == 0 || loaders.at(t->second) == nullptr)
+        if (!hasLoader.at(t->second))
             continue;
         const CFG::CFGObject* importListObj = static_cast<const CFG::CFGObject*>(importList);
-        imports[t->second].push_back(static_cast<const CFG::CFGObject*>(importListObj));
+        if (t->second == ResourceType::SHADER)
+            pendingShaderImports_.push_back(ListShaderImports(importListObj));
+        else
+            pendingImports_[t->second].push_back(ListImports(importListObj, t->second));
         importCount += importListObj->GetItems().size();
     }
 
-    auto loadImports = [&](ResourceType t) {
-        for (const auto& list : imports[t]) {
-            loaders[t](list, t);
-        }
+    importLoadSubscriptions_ = {
+        ForwardImportLoads(GetTextureManager(), eventHandler),
+        ForwardImportLoads(GetShaderManager(), eventHandler),
+        ForwardImportLoads(GetModelManager(), eventHandler),
+        ForwardImportLoads(GetFontManager(), eventHandler),
+        ForwardImportLoads(GetStageManager(), eventHandler),
+        ForwardImportLoads(GetAudioManager(), eventHandler),
+
+        ForwardImportLoads(GetTextFileManager(), eventHandler),
+        ForwardImportLoads(GetBinaryFileManager(), eventHandler),
+        ForwardImportLoads(GetJSONFileManager(), eventHandler),
+        ForwardImportLoads(GetCFGFileManager(), eventHandler)
     };
 
     eventHandler.Dispatch(ResourceLoadEvent::IMPORTS_INDEXED, importCount);
+    loadingStart_ = glfwGetTime();
+    loadingStage_ = LoadingStage::TEXTURES;
 
-    loadImports(ResourceType::TEXTURE);
-    loadImports(ResourceType::SHADER);
+    // nothing depends on the fonts and audio, so they can go along with the textures
+    LoadPendingImports(ResourceType::TEXTURE, true);
+    LoadPendingImports(ResourceType::FONT, true);
+    LoadPendingImports(ResourceType::AUDIO, true);
+}
 
-    if (GetMaterialSerializer() != nullptr) {
-        spdlog::info("Loading materials.json");
-        GetMaterialSerializer()->DeserializeFile("${materials.json}"_resp);
-        spdlog::info("Assigning materials to renderer");
-        GetMaterialSerializer()->Register(Systems::GetRenderer().GetMaterials());
-    }
+bool ModularResourceManager::UpdateLoading() {
+    using namespace Resources;
+
+    if (loadingStage_ == LoadingStage::IDLE)
+        return true;
+    asyncLoader_.ProcessUploads(uploadBudget);
+
+    if (loadingStage_ == LoadingStage::TEXTURES) {
+        if (asyncLoader_.GetPendingCount(ResourceType::TEXTURE) > 0)
+            return false;
+        if (GetTextureManager() != nullptr)
+            GetTextureManager()->BuildTextureArrays();
+
+        if (GetShaderManager() != nullptr) {
+            for (const auto& imports : pendingShaderImports_)
+                GetShaderManager()->LoadImports(imports);
+        }
+        pendingShaderImports_.clear();
+
+        if (GetMaterialSerializer() != nullptr) {
+            spdlog::info("Loading materials.json");
+            GetMaterialSerializer()->DeserializeFile("${materials.json}"_resp);
+            spdlog::info("Assigning materials to renderer");
+            GetMaterialSerializer()->Register(Systems::GetRenderer().GetMaterials());
+        }
+
+        if (GetObjectSerializer() != nullptr) {
+            spdlog::info("Loading objects.json");
+            GetObjectSerializer()->DeserializeFile("${objects.json}"_resp);
+        }
 
-    if (GetObjectSerializer() != nullptr) {
-        spdlog::info("Loading objects.json");
-        GetObjectSerializer()->DeserializeFile("${objects.json}"_resp);
+        LoadPendingImports(ResourceType::MODEL, true);
+        loadingStage_ = LoadingStage::MODELS;
     }
+    if (asyncLoader_.GetPendingCount() > 0)
+        return false;
 
-    loadImports(ResourceType::MODEL);
-    loadImports(ResourceType::FONT);
-    loadImports(ResourceType::AUDIO);
-    
-    loadImports(ResourceType::TEXT);
-    loadImports(ResourceType::BINARY);
-    loadImports(ResourceType::JSON);
-    loadImports(ResourceType::CFG);
+    LoadPendingImports(ResourceType::TEXT, false);
+    LoadPendingImports(ResourceType::BINARY, false);
+    LoadPendingImports(ResourceType::JSON, false);
+    LoadPendingImports(ResourceType::CFG, false);
 
     if (GetBlueprintSerializer() != nullptr) {
         spdlog::info("Loading blueprints.json");
@@ -279,11 +363,25 @@ void ModularResourceManager::LoadImports(const CFG::CFGObject* root) {
         spdlog::info("Using blueprints for stage loading");
         GetStageManager()->UseBlueprints(GetBlueprintSerializer());
     }
-    loadImports(ResourceType::STAGE);
+    LoadPendingImports(ResourceType::STAGE, false);
     /*if (blueprintsFile != nullptr) {
         spdlog::info("Unactivating blueprints");
         stageManager->UseBlueprints(nullptr);
     }*/
+
+    for (const auto& unsubscribe : importLoadSubscriptions_) {
+        if (unsubscribe != nullptr)
+            unsubscribe();
+    }
+    importLoadSubscriptions_.clear();
+    pendingImports_.clear();
+    loadingStage_ = LoadingStage::IDLE;
+    spdlog::info("Loaded imports in {:.1f} ms ({} worker threads)", (glfwGetTime() - loadingStart_) * 1000.0, Systems::GetThreadPool().GetThreadCount());
+    return true;
+}
+
+bool ModularResourceManager::IsLoading() const {
+    return loadingStage_ != LoadingStage::IDLE;
 }
 
 void ModularResourceManager::UnloadAll() {
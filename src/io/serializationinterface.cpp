@@ -39,6 +39,11 @@ bool JSONFileSerializer::StreamRead(std::ifstream& f) {
     return ParseJSON();
 }
 
+void JSONFileSerializer::DeserializeJSON(const nlohmann::json& j) {
+    data_ = j;
+    status_ = ParseJSON() ? SerializationStatus::OK : SerializationStatus::FAILED;
+}
+
 bool JSONFileSerializer::StreamWrite(std::ofstream& f) {
     try {
         f << data_.dump();
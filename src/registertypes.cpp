@@ -6,6 +6,7 @@
 #include <latren/audio/component/audiosourcecomponent.h>
 #include <latren/graphics/component/meshrenderer.h>
 #include <latren/graphics/component/billboard.h>
+#include <latren/graphics/component/particlesystem.h>
 #include <latren/graphics/component/light.h>
 #include <latren/physics/component/rigidbody.h>
 #include <latren/ui/component/containercomponent.h>
@@ -21,6 +22,7 @@ void ComponentSerialization::RegisterCoreComponents() {
 
     LATREN_REGISTER_COMPONENT(MeshRenderer);
     LATREN_REGISTER_COMPONENT(BillboardRenderer);
+    LATREN_REGISTER_COMPONENT(ParticleSystem);
     LATREN_REGISTER_COMPONENT(Lights::PointLight);
     LATREN_REGISTER_COMPONENT(Lights::DirectionalLight);
     LATREN_REGISTER_COMPONENT(Lights::DirectionalLightPlane);
@@ -49,6 +51,7 @@ void ComponentSerialization::RegisterCoreDeserializers() {
     Serialization::AssignJSONDeserializer<float>(DeserializeJSONNumber<float>);
     Serialization::AssignJSONDeserializer<glm::vec2, glm::ivec2>(DeserializeJSONVector<2>);
     Serialization::AssignJSONDeserializer<glm::vec3, glm::ivec3>(DeserializeJSONVector<3>);
+    Serialization::AssignJSONDeserializer<glm::vec4, glm::ivec4>(DeserializeJSONVector<4>);
     Serialization::AssignJSONDeserializer<Quaternion>([](Serialization::DeserializationContext& args, const nlohmann::json& j) {
         glm::vec3 eulers;
         Serialization::DeserializationContext vecArgs;
@@ -7,6 +7,8 @@
 #include <latren/graphics/renderer.h>
 
 #include <fstream>
+#include <chrono>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 std::optional<Stage> Resources::StageManager::LoadResource(const ResourcePath& path) {
@@ -20,6 +22,53 @@ std::optional<Stage> Resources::StageManager::LoadResource(const ResourcePath& p
     return s;
 }
 
+std::vector<Resources::StageManager::PreparedEntity> Resources::StageManager::PrepareEntities(const Stage& s) const {
+    std::vector<PreparedEntity> entities;
+    entities.reserve(s.entities.size());
+    for (const DeserializedEntity& e : s.entities) {
+        PreparedEntity& entity = entities.emplace_back();
+        entity.entity = &e;
+        for (const auto& c : e.components) {
+            PreparedComponent& component = entity.components.emplace_back(PreparedComponent { c.type, { } });
+            const SerializableFieldMap& componentFields = ComponentSerialization::GetComponentType(c.type).serializableFields;
+            for (const auto& [name, field] : c.fields) {
+                if (field.value == nullptr || componentFields.count(name) == 0)
+                    continue;
+                component.fields.push_back({ componentFields.at(name).offset, &field });
+            }
+        }
+    }
+    return entities;
+}
+
+bool Resources::StageManager::InstantiateEntity(Stage& s, const PreparedEntity& e, std::vector<GeneralComponentReference>& newComponents) {
+    EntityManager& entityManager = Systems::GetEntityManager();
+    Entity entity;
+    bool existed = entityManager.HasNamedEntity(e.entity->id);
+    if (existed) {
+        entity = entityManager.GetNamedEntity(e.entity->id);
+    }
+    else {
+        entity = entityManager.CreateEntity(e.entity->id);
+        s.instantiatedEntities.insert(entity);
+    }
+    for (const PreparedComponent& c : e.components) {
+        if (!entity.HasComponent(c.type)) {
+            newComponents.push_back(entity.AddComponent(c.type));
+        }
+        IComponent& instance = entity.GetComponent(c.type);
+        for (const auto& [offset, field] : c.fields) {
+            field->value->CopyValueTo((char*) &instance + offset);
+        }
+    }
+    return existed;
+}
+
+void Resources::StageManager::FinishStageLoad(const Stage& s) {
+    loadedStages_.insert(loadedStages_.begin(), s.id);
+    spdlog::info("Loaded stage '" + s.id + "' (" + std::to_string(s.entities.size()) + " entities modified)");
+}
+
 bool Resources::StageManager::LoadStage(const std::string& id) {
     if (items_.empty())
         return false;
@@ -29,40 +78,205 @@ bool Resources::StageManager::LoadStage(const std::string& id) {
     s.instantiatedEntities.clear();
 
     std::vector<GeneralComponentReference> newComponents;
-    EntityManager& entityManager = Systems::GetEntityManager();
-    for (const DeserializedEntity& e : s.entities) {
-        Entity entity;
-        if (entityManager.HasNamedEntity(e.id)) {
-            entity = entityManager.GetNamedEntity(e.id);
-        }
-        else {
-            entity = entityManager.CreateEntity(e.id);
-            s.instantiatedEntities.insert(entity);
-        }
-        for (const auto& c : e.components) {
-            if (!entity.HasComponent(c.type)) {
-                newComponents.push_back(entity.AddComponent(c.type));
-            }
-            IComponent& instance = entity.GetComponent(c.type);
-            const SerializableFieldMap& componentFields = ComponentSerialization::GetComponentType(instance.GetType()).serializableFields;
-            for (const auto& [name, field] : c.fields) {
-                if (field.value == nullptr || componentFields.count(name) == 0)
-                    continue;
-                field.value->CopyValueTo((char*) &instance + componentFields.at(name).offset);
-            }
-        }
+    for (const PreparedEntity& e : PrepareEntities(s)) {
+        InstantiateEntity(s, e, newComponents);
     }
-    loadedStages_.insert(loadedStages_.begin(), s.id);
-    spdlog::info("Loaded stage '" + id + "' (" + std::to_string(s.entities.size()) + " entities modified)");
+    FinishStageLoad(s);
     for (GeneralComponentReference& c : newComponents) {
         c->IStart();
     }
     Systems::GetRenderer().UpdateLighting();
-    Systems::GetRenderer().UpdateFrustum();
+    Systems::GetRenderer().BuildStaticBVH();
+    eventHandler.Dispatch(StageLoadEvent::LOADED, s.id, 1.0f);
+    return true;
+}
+
+std::shared_ptr<Resources::StageManager::StreamedStage> Resources::StageManager::GetStreamedStage(const std::string& id) const {
+    auto item = items_.find(id);
+    if (item == items_.end())
+        return nullptr;
+    for (const auto& stage : streaming_) {
+        if (stage->id == item->first)
+            return stage;
+    }
+    return nullptr;
+}
+
+bool Resources::StageManager::IsStageStreaming(const std::string& id) const {
+    return GetStreamedStage(id) != nullptr;
+}
+
+bool Resources::StageManager::IsStreaming() const {
+    return !streaming_.empty() || streamingLoader_->GetPendingCount() > 0;
+}
+
+void Resources::StageManager::PrepareStreamedStage(const std::shared_ptr<StreamedStage>& stage) {
+    Stage& s = items_.at(stage->id);
+    s.instantiatedEntities.clear();
+    // the map nodes don't move, so the worker can read the stage through this
+    const Stage* stagePtr = &s;
+    streamingLoader_->Submit(ResourceType::STAGE, [this, stage, stagePtr]() -> AsyncLoader::UploadJob {
+        std::vector<PreparedEntity> entities = PrepareEntities(*stagePtr);
+        return [stage, entities = std::move(entities)]() mutable {
+            stage->entities = std::move(entities);
+            stage->ready = true;
+        };
+    });
+}
+
+bool Resources::StageManager::LoadStageAsync(const std::string& id, const StageLoadCallback& callback) {
+    auto item = items_.find(id);
+    if (item == items_.end() || IsStageStreaming(id))
+        return false;
+    auto stage = std::make_shared<StreamedStage>();
+    // the id it was imported with, the lookups aren't case sensitive
+    stage->id = item->first;
+    stage->callback = callback;
+    streaming_.push_back(stage);
+    PrepareStreamedStage(stage);
     return true;
 }
 
+void Resources::StageManager::LoadStageFileAsync(const ResourcePath& path, const StageLoadCallback& callback) {
+    auto stage = std::make_shared<StreamedStage>();
+    stage->callback = callback;
+    streaming_.push_back(stage);
+    std::string pathStr = path.GetParsedPathStr();
+    streamingLoader_->Submit(ResourceType::STAGE, [this, stage, pathStr]() -> AsyncLoader::UploadJob {
+        // only the json is read here, some of the component deserializers (meshes, materials) need the game thread
+        auto json = std::make_shared<nlohmann::json>();
+        bool read = Serialization::UseInputFileStream(pathStr, std::ios_base::in, [&](std::ifstream& f) {
+            try {
+                *json = nlohmann::json::parse(f);
+            }
+            catch (std::exception& e) {
+                spdlog::error("[" + pathStr + "] Invalid JSON syntax!");
+                spdlog::debug(e.what());
+                return false;
+            }
+            return true;
+        });
+        return [this, stage, json, read, pathStr]() {
+            if (stage->cancelled)
+                return;
+            // a serializer of its own so the manager's one can still be used in the meantime
+            Serialization::StageSerializer serializer;
+            serializer.UseBlueprints(blueprints_);
+            serializer.SetPath(pathStr);
+            if (read)
+                serializer.DeserializeJSON(*json);
+            if (!read || !serializer.Success() || serializer.GetStage().id.empty()) {
+                spdlog::warn("Failed loading stage '{}'", pathStr);
+                FinishStreamedStage(stage, false);
+                return;
+            }
+            Stage& parsed = serializer.GetStage();
+            if (HasLoaded(parsed.id)) {
+                spdlog::warn("Stage '{}' has been loaded already, stream it with LoadStageAsync instead", parsed.id);
+                FinishStreamedStage(stage, false);
+                return;
+            }
+            stage->id = parsed.id;
+            items_[parsed.id] = std::move(parsed);
+            PrepareStreamedStage(stage);
+        };
+    });
+}
+
+void Resources::StageManager::FinishStreamedStage(const std::shared_ptr<StreamedStage>& stage, bool success) {
+    // the reference might be to the element itself
+    std::shared_ptr<StreamedStage> finished = stage;
+    streaming_.erase(std::remove(streaming_.begin(), streaming_.end(), finished), streaming_.end());
+    if (success) {
+        const Stage& s = items_.at(finished->id);
+        FinishStageLoad(s);
+        Systems::GetRenderer().UpdateLighting();
+        // only the stage's own renderables are added and batched, unless it moved ones that were there already
+        if (finished->modifiedExisting)
+            Systems::GetRenderer().BuildStaticBVH();
+        else
+            Systems::GetRenderer().AddStaticRenderables();
+        eventHandler.Dispatch(StageLoadEvent::LOADED, s.id, 1.0f);
+    }
+    if (finished->callback != nullptr)
+        finished->callback(finished->id, success);
+}
+
+void Resources::StageManager::UpdateStreaming() {
+    // the uploads of cancelled stages still have to be drained, they just don't do anything
+    if (streamingLoader_->GetPendingCount() > 0)
+        streamingLoader_->ProcessUploads(streamingBudget);
+    if (streaming_.empty())
+        return;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+    // the lighting and static renderable updates of a finished stage aren't free, so they get a frame of their own
+    for (const auto& stage : streaming_) {
+        if (stage->ready && stage->nextEntity >= stage->entities.size()) {
+            FinishStreamedStage(stage, true);
+            return;
+        }
+    }
+    // copied since IStart might load or unload stages
+    std::vector<std::shared_ptr<StreamedStage>> stages = streaming_;
+    for (const auto& stage : stages) {
+        if (elapsed() >= streamingBudget)
+            break;
+        if (!stage->ready || stage->cancelled)
+            continue;
+        Stage& s = items_.at(stage->id);
+        std::vector<GeneralComponentReference> newComponents;
+        while (stage->nextEntity < stage->entities.size() && elapsed() < streamingBudget) {
+            if (InstantiateEntity(s, stage->entities.at(stage->nextEntity++), newComponents))
+                stage->modifiedExisting = true;
+        }
+        for (GeneralComponentReference& c : newComponents) {
+            c->IStart();
+        }
+        float progress = stage->entities.empty() ? 1.0f : (float) stage->nextEntity / stage->entities.size();
+        eventHandler.Dispatch(StageLoadEvent::LOAD_PROGRESS, stage->id, progress);
+    }
+}
+
+void Resources::StageManager::StreamStages(const std::vector<std::string>& stages) {
+    std::vector<std::string> previous = streamedStages_;
+    for (const std::string& id : previous) {
+        if (std::find(stages.begin(), stages.end(), id) == stages.end())
+            UnloadStage(id);
+    }
+    for (const std::string& id : stages) {
+        if (std::find(streamedStages_.begin(), streamedStages_.end(), id) != streamedStages_.end())
+            continue;
+        // the ones loaded some other way aren't ours to unload
+        if (std::find(loadedStages_.begin(), loadedStages_.end(), id) != loadedStages_.end())
+            continue;
+        if (LoadStageAsync(id))
+            streamedStages_.push_back(id);
+    }
+}
+
 bool Resources::StageManager::UnloadStage(const std::string& id) {
+    streamedStages_.erase(std::remove(streamedStages_.begin(), streamedStages_.end(), id), streamedStages_.end());
+    std::shared_ptr<StreamedStage> streamed = GetStreamedStage(id);
+    if (streamed != nullptr) {
+        streamed->cancelled = true;
+        streaming_.erase(std::remove(streaming_.begin(), streaming_.end(), streamed), streaming_.end());
+        // the entities instantiated so far. the lighting hasn't been updated with them yet, but another
+        // stage finishing in the meantime might have put their renderables in the bvh
+        Stage& s = items_.at(streamed->id);
+        bool instantiated = !s.instantiatedEntities.empty();
+        for (EntityIndex entity : s.instantiatedEntities) {
+            Systems::GetEntityManager().DestroyEntity(entity);
+        }
+        s.instantiatedEntities.clear();
+        if (instantiated)
+            Systems::GetRenderer().RemoveStaticRenderables();
+        spdlog::info("Cancelled streaming stage '{}'", streamed->id);
+        if (streamed->callback != nullptr)
+            streamed->callback(streamed->id, false);
+        return true;
+    }
     auto idIt = std::find(loadedStages_.begin(), loadedStages_.end(), id);
     if (idIt == loadedStages_.end())
         return false;
@@ -72,11 +286,23 @@ bool Resources::StageManager::UnloadStage(const std::string& id) {
     }
     loadedStages_.erase(idIt);
     Systems::GetRenderer().UpdateLighting();
-    Systems::GetRenderer().UpdateFrustum();
+    Systems::GetRenderer().RemoveStaticRenderables();
+    eventHandler.Dispatch(StageLoadEvent::UNLOADED, id, 0.0f);
     return true;
 }
 
 void Resources::StageManager::UnloadAllStages() {
+    std::vector<std::shared_ptr<StreamedStage>> stages = streaming_;
+    for (const auto& stage : stages) {
+        if (!stage->id.empty()) {
+            UnloadStage(stage->id);
+            continue;
+        }
+        // the file's still being parsed
+        stage->cancelled = true;
+        FinishStreamedStage(stage, false);
+    }
+    streamedStages_.clear();
     for (int i = 0; i < loadedStages_.size(); i++) {
         UnloadStage(loadedStages_.at(i--));
     }
@@ -87,5 +313,6 @@ const std::vector<std::string>& Resources::StageManager::GetLoadedStages() {
 }
 
 void Resources::StageManager::UseBlueprints(Serialization::BlueprintSerializer* blueprints) {
+    blueprints_ = blueprints;
     stageSerializer_->UseBlueprints(blueprints);
 }
\ No newline at end of file
@@ -12,6 +12,7 @@ std::function<Renderer&()> GLOBAL_RENDERER_GETTER_;
 std::function<IResourceManager&()> GLOBAL_RESOURCES_GETTER_;
 std::function<AudioPlayer&()> GLOBAL_AUDIO_PLAYER_GETTER_; 
 std::function<PhysicsWorld&()> GLOBAL_PHYSICS_GETTER_;
+std::function<Threads::ThreadPool&()> GLOBAL_THREAD_POOL_GETTER_;
 std::function<double()> GLOBAL_TIME_GETTER_; 
 std::function<double()> GLOBAL_DELTA_TIME_GETTER_;
 
@@ -24,6 +25,7 @@ void Systems::UseGameInstance(std::unique_ptr<Game>&& instance) {
     SetResourcesGetter([]() -> IResourceManager& { return GetGame().GetResources(); });
     SetAudioPlayerGetter([]() -> AudioPlayer& { return GetGame().GetAudioPlayer(); });
     SetPhysicsGetter([]() -> PhysicsWorld& { return GetGame().GetPhysics(); });
+    SetThreadPoolGetter([]() -> Threads::ThreadPool& { return GetGame().GetThreadPool(); });
     SetTimeGetter([] { return GetGame().GetTime(); });
     SetDeltaTimeGetter([] { return GetGame().GetDeltaTime(); });
 }
@@ -80,6 +82,13 @@ PhysicsWorld& Systems::GetPhysics() {
     }
     return GLOBAL_PHYSICS_GETTER_();
 }
+Threads::ThreadPool& Systems::GetThreadPool() {
+    if (!GLOBAL_THREAD_POOL_GETTER_) {
+        spdlog::error("Getter not defined for Systems::GetThreadPool!");
+        throw;
+    }
+    return GLOBAL_THREAD_POOL_GETTER_();
+}
 
 double Systems::GetTime() {
     if (!GLOBAL_TIME_GETTER_) {
@@ -117,6 +126,9 @@ void Systems::SetAudioPlayerGetter(const std::function<AudioPlayer&()>& getter)
 void Systems::SetPhysicsGetter(const std::function<PhysicsWorld&()>& getter) {
     GLOBAL_PHYSICS_GETTER_ = getter;
 }
+void Systems::SetThreadPoolGetter(const std::function<Threads::ThreadPool&()>& getter) {
+    GLOBAL_THREAD_POOL_GETTER_ = getter;
+}
 void Systems::SetTimeGetter(const std::function<double()>& getter) {
     GLOBAL_TIME_GETTER_ = getter;
 }
@@ -100,6 +100,8 @@ void Plane::GenerateVertices() {
             normals.push_back(normal.z);
         }
     }
+    // the texcoords go up to the tiling so they usually won't fit in half floats
+    ChooseLayout();
 }
 
 std::shared_ptr<btHeightfieldTerrainShape> Plane::CreateBtCollider() const {
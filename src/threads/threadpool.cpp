@@ -0,0 +1,120 @@
+#include <latren/threads/threadpool.h>
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+using namespace Threads;
+
+ThreadPool::~ThreadPool() {
+    Stop();
+}
+
+void ThreadPool::Start(std::size_t threads) {
+    Stop();
+    if (threads == 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 0;
+    }
+    stopping_ = false;
+    for (std::size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+void ThreadPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobAvailable_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+    // nothing to hand it to, just do it here
+    if (workers_.empty()) {
+        job();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    jobAvailable_.notify_one();
+}
+
+std::size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+std::size_t ThreadPool::GetChunkCount(std::size_t count, std::size_t minChunk) const {
+    if (count == 0)
+        return 0;
+    std::size_t chunks = count / std::max<std::size_t>(minChunk, 1);
+    return std::clamp<std::size_t>(chunks, 1, workers_.size() + 1);
+}
+
+struct ParallelForState {
+    const std::function<void(std::size_t, std::size_t, std::size_t)>* fn;
+    std::size_t count;
+    std::size_t chunks;
+    std::atomic<std::size_t> next = 0;
+    std::atomic<std::size_t> done = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    void Work() {
+        while (true) {
+            std::size_t chunk = next++;
+            // the workers can pick this up after everything's done already, fn might be gone by then
+            if (chunk >= chunks)
+                return;
+            std::size_t begin = count * chunk / chunks;
+            std::size_t end = count * (chunk + 1) / chunks;
+            (*fn)(chunk, begin, end);
+            if (++done == chunks) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+void ThreadPool::ParallelFor(std::size_t count, std::size_t minChunk, const std::function<void(std::size_t, std::size_t, std::size_t)>& fn) {
+    std::size_t chunks = GetChunkCount(count, minChunk);
+    if (chunks == 0)
+        return;
+    if (chunks == 1) {
+        fn(0, 0, count);
+        return;
+    }
+    auto state = std::make_shared<ParallelForState>();
+    state->fn = &fn;
+    state->count = count;
+    state->chunks = chunks;
+    for (std::size_t i = 1; i < chunks; i++) {
+        Submit([state] { state->Work(); });
+    }
+    state->Work();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done == chunks; });
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <latren/ui/component/uicomponent.h>
 #include <latren/ui/materials.h>
 #include <latren/systems.h>
+#include <latren/graphics/renderer.h>
 #include <latren/input.h>
 #include <latren/gamewindow.h>
 #include <latren/debugmacros.h>
@@ -12,10 +13,6 @@ Canvas* Canvas::GetCanvas() {
     return static_cast<Canvas*>(this);
 }
 
-void Canvas::GenerateBackgroundShape() {
-    bgShape_ = Shapes::GetDefaultShape(Shapes::DefaultShape::RECTANGLE_VEC4);
-}
-
 void Canvas::Draw() {
     if (!isVisible)
         return;
@@ -27,52 +24,54 @@ void Canvas::Draw() {
     float bottom = bgVerticalAnchor == CanvasBackgroundVerticalAnchor::OVER ? 0 : -h;
 
     if (!bgOverflow) {
-        glEnable(GL_SCISSOR_TEST);
+        Systems::GetRenderer().GetGLState().Enable(GL_SCISSOR_TEST);
         glm::vec2 wndSizeFactor = glm::vec2(Systems::GetGameWindow().GetSize()) / glm::vec2(1280.0f, 720.0f);
         glm::vec2 pos = GetOffset();
         glm::ivec2 scissorPos = glm::vec2(pos.x, pos.y + bottom) * wndSizeFactor;
         glm::ivec2 scissorSize = glm::vec2(w, h) * wndSizeFactor;
-        glScissor(scissorPos.x, scissorPos.y, scissorSize.x, scissorSize.y);
+        Systems::GetRenderer().GetGLState().Scissor(scissorPos.x, scissorPos.y, scissorSize.x, scissorSize.y);
     }
 
     if (bgMaterial != nullptr) {
         bgMaterial->Use();
         bgMaterial->GetShader().SetUniform("projection", proj);
-        bgShape_.SetVertexData(new float[24] {
+        const float vertices[] = {
             0, top,     0.0f, 0.0f,
             0, bottom,  0.0f, 1.0f,
             w, bottom,  1.0f, 1.0f,
             0, top,     0.0f, 0.0f,
             w, bottom,  1.0f, 1.0f,
             w, top,     1.0f, 0.0f
-        }, false);
-        bgShape_.Bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        };
+        StreamBuffer::Allocation a = Systems::GetRenderer().GetStreamBuffer().Upload(vertices, sizeof(vertices), 4 * sizeof(float));
+        Shapes::GetDefaultShape(Shapes::DefaultShape::STREAM_VEC4).Bind();
+        glDrawArrays(GL_TRIANGLES, a.first, 6);
+        GLState::CountDraw(GL_TRIANGLES, 6);
     }
     
     for (auto& [p, layer] : components_) {
         layer.ForEach([&](UIComponent& c) {
             if (c.isVisible) {
                 if (!bgOverflow)
-                    glEnable(GL_SCISSOR_TEST);
+                    Systems::GetRenderer().GetGLState().Enable(GL_SCISSOR_TEST);
                 
                 #ifdef LATREN_DEBUG_UI_BOUNDS
                 UI::SOLID_UI_SHAPE_MATERIAL->Use();
                 UI::SOLID_UI_SHAPE_MATERIAL->GetShader().SetUniform("material.color", glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
                 UI::SOLID_UI_SHAPE_MATERIAL->GetShader().SetUniform("projection", glm::ortho(0.0f, 1280.0f, 0.0f, 720.0f));
                 const Rect& bounds = c.GetBounds();
-                Shape s = Shapes::GetDefaultShape(Shapes::DefaultShape::RECTANGLE_VEC4);
-                s.SetVertexData(new float[24] {
+                const float boundsVertices[] = {
                     bounds.left,    bounds.top,     0.0f, 0.0f,
                     bounds.left,    bounds.bottom,  0.0f, 1.0f,
                     bounds.right,   bounds.bottom,  1.0f, 1.0f,
                     bounds.left,    bounds.top,     0.0f, 0.0f,
                     bounds.right,   bounds.bottom,  1.0f, 1.0f,
                     bounds.right,   bounds.top,     1.0f, 0.0f
-                }, false);
-                s.Bind();
+                };
+                StreamBuffer::Allocation boundsAlloc = Systems::GetRenderer().GetStreamBuffer().Upload(boundsVertices, sizeof(boundsVertices), 4 * sizeof(float));
+                Shapes::GetDefaultShape(Shapes::DefaultShape::STREAM_VEC4).Bind();
                 glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+                glDrawArrays(GL_TRIANGLES, boundsAlloc.first, 6);
                 glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
                 #endif
 
@@ -81,7 +80,7 @@ void Canvas::Draw() {
         });
     }
     if (!bgOverflow) {
-        glDisable(GL_SCISSOR_TEST);
+        Systems::GetRenderer().GetGLState().Disable(GL_SCISSOR_TEST);
     }
 }
 
@@ -1,4 +1,6 @@
 #include <latren/ui/component/imagecomponent.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
 #include <latren/ui/materials.h>
 #include <latren/ui/canvas.h>
 
@@ -28,8 +30,9 @@ void Image::Render(UIComponent*, const glm::mat4& proj) {
     material->GetShader().SetUniform("projection", proj);
     if (texture != TEXTURE_NONE) {
         material->GetShader().SetUniform("material.hasTexture", true);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, texture);
     }
     quadShape_.Bind();
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    GLState::CountDraw(GL_TRIANGLES, 6);
 }
\ No newline at end of file
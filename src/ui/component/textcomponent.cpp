@@ -1,5 +1,6 @@
 #include <latren/ui/component/textcomponent.h>
 #include <latren/systems.h>
+#include <latren/graphics/renderer.h>
 #include <latren/io/resourcemanager.h>
 #include <latren/gamewindow.h>
 #include <latren/debugmacros.h>
@@ -8,15 +9,13 @@
 
 using namespace UI;
 
+// text targets are allocated in steps of this so that most text changes fit in the old one
+const int TEXT_TARGET_GRANULARITY = 64;
+
 void TextComponent::Delete() {
-    if (renderingMethod_ == TextRenderingMethod::RENDER_TO_TEXTURE) {
-        if (fbo_ != GL_NONE)
-            glDeleteFramebuffers(1, &fbo_);
-        if (texture_ != GL_NONE)
-            glDeleteTextures(1, &texture_);
-    }
-    fbo_ = GL_NONE;
-    texture_ = GL_NONE;
+    if (target_ != nullptr)
+        Systems::GetRenderer().GetRenderTargetPool().Release(target_);
+    target_ = nullptr;
 }
 
 void TextComponent::Start() {
@@ -27,10 +26,6 @@ void TextComponent::Start() {
     #ifdef LATREN_FORCE_TEXT_RENDER_TO_TEXTURE
     renderingMethod_ = TextRenderingMethod::RENDER_TO_TEXTURE;
     #endif
-    shape_.numVertexAttributes = 4;
-    shape_.stride = 4;
-    shape_.GenerateVAO();
-
     Systems::GetGameWindow().eventHandler.Subscribe(WindowEventType::WINDOW_RESIZE,
         LambdaByReference([](TextComponent& c, const glm::ivec2& size) {
             c.UpdateWindowSize(size);
@@ -41,11 +36,8 @@ void TextComponent::Start() {
     hasStarted_ = true;
     UpdateTextMetrics();
     CalculateBounds();
-    if (renderingMethod_ == TextRenderingMethod::RENDER_TO_TEXTURE) {
-        glGenFramebuffers(1, &fbo_);
-        glGenTextures(1, &texture_);
+    if (renderingMethod_ == TextRenderingMethod::RENDER_TO_TEXTURE)
         RenderTexture();
-    }
     UIComponent::Start();
 }
 
@@ -138,32 +130,33 @@ void TextComponent::Render(const glm::mat4& proj) {
         bool scissor = (forceTextSize.x != -1 || forceTextSize.y != -1);
         if (scissor) {
             glm::vec2 wndRatio = (glm::vec2) Systems::GetGameWindow().GetSize() / glm::vec2(1280.0f, 720.0f);
-            glEnable(GL_SCISSOR_TEST);
+            Systems::GetRenderer().GetGLState().Enable(GL_SCISSOR_TEST);
             glm::vec2 scissorPos = glm::vec2(generalBounds_.left, generalBounds_.bottom) * wndRatio;
             glm::vec2 scissorSize = forceTextSize * wndRatio;
-            glScissor((GLint) scissorPos.x, (GLint) scissorPos.y, (GLint) scissorSize.x, (GLint) scissorSize.y);
+            Systems::GetRenderer().GetGLState().Scissor((GLint) scissorPos.x, (GLint) scissorPos.y, (GLint) scissorSize.x, (GLint) scissorSize.y);
         }
         RenderTextToPos(glm::vec2(bounds_.left, bounds_.bottom));
         if (scissor)
-            glDisable(GL_SCISSOR_TEST);
+            Systems::GetRenderer().GetGLState().Disable(GL_SCISSOR_TEST);
     }
-    else if (renderingMethod_ == TextRenderingMethod::RENDER_TO_TEXTURE) {
-        shape_.SetVertexData(new float[24] {
-            bounds_.left,   bounds_.top,        0.0f, 1.0f,
+    else if (renderingMethod_ == TextRenderingMethod::RENDER_TO_TEXTURE && target_ != nullptr) {
+        glm::vec2 uv = glm::vec2(textureSize_) / glm::vec2(target_->GetSize());
+        const float vertices[] = {
+            bounds_.left,   bounds_.top,        0.0f, uv.y,
             bounds_.left,   bounds_.bottom,     0.0f, 0.0f,
-            bounds_.right,  bounds_.bottom,     1.0f, 0.0f,
-
-            bounds_.left,   bounds_.top,        0.0f, 1.0f,
-            bounds_.right,  bounds_.bottom,     1.0f, 0.0f,
-            bounds_.right,  bounds_.top,        1.0f, 1.0f
-        }, false);
-        shape_.Bind();
-
-        glBindTexture(GL_TEXTURE_2D, texture_);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+            bounds_.right,  bounds_.bottom,     uv.x, 0.0f,
+
+            bounds_.left,   bounds_.top,        0.0f, uv.y,
+            bounds_.right,  bounds_.bottom,     uv.x, 0.0f,
+            bounds_.right,  bounds_.top,        uv.x, uv.y
+        };
+        StreamBuffer::Allocation a = Systems::GetRenderer().GetStreamBuffer().Upload(vertices, sizeof(vertices), 4 * sizeof(float));
+        Shapes::GetDefaultShape(Shapes::DefaultShape::STREAM_VEC4).Bind();
+
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, target_->GetTexture());
+        glDrawArrays(GL_TRIANGLES, a.first, 6);
+        GLState::CountDraw(GL_TRIANGLES, 6);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
 
         #ifdef LATREN_DEBUG_TEXT_TEXTURES
         auto& f = Systems::GetResources().GetFontManager()->Get(font);
@@ -182,21 +175,22 @@ void TextComponent::RenderTexture() {
     glm::vec2 wndRatio = (glm::vec2) Systems::GetGameWindow().GetSize() / glm::vec2(1280.0f, 720.0f);
     glm::ivec2 texSize = actualTextSize_ * wndRatio;
     textureSize_ = texSize;
-    glViewport(0, 0, (int) texSize.x, texSize.y);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-    glBindTexture(GL_TEXTURE_2D, texture_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    GLfloat borderColor[4] = { 0, 0, 0, 1 };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, texSize.x, texSize.y, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glClearTexImage(texture_, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
-
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture_, 0);
-    glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    
+
+    // the old target goes back first so it gets handed out again if the size rounds to the same
+    RenderTargetPool& pool = Systems::GetRenderer().GetRenderTargetPool();
+    pool.Release(target_);
+    RenderTargetDesc desc;
+    desc.size = glm::max(texSize, glm::ivec2(1));
+    desc.size = (desc.size + TEXT_TARGET_GRANULARITY - 1) / TEXT_TARGET_GRANULARITY * TEXT_TARGET_GRANULARITY;
+    desc.format = GL_R8;
+    target_ = pool.Acquire(desc);
+
+    // the whole target is cleared so the unused part around the text samples as empty
+    glBindFramebuffer(GL_FRAMEBUFFER, target_->GetFramebuffer());
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    Systems::GetRenderer().GetGLState().Viewport(0, 0, texSize.x, texSize.y);
+
     // finally drawing
     textureShader_.Use();
     textureShader_.SetUniform("textColor", glm::vec4(1.0f));
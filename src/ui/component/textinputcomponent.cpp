@@ -1,5 +1,6 @@
 #include <latren/ui/component/textinputcomponent.h>
 #include <latren/systems.h>
+#include <latren/graphics/renderer.h>
 #include <latren/input.h>
 #include <latren/gamewindow.h>
 #include <latren/io/resourcemanager.h>
@@ -40,7 +41,6 @@ void TextInputComponent::Unfocus() {
 
 void TextInputComponent::Start() {
     TextComponent::Start();
-    caretShape_ = Shapes::GetDefaultShape(Shapes::DefaultShape::RECTANGLE_VEC4);
 
     specialKeyEvent_ = Systems::GetGameWindow().keyboardEventHandler.Subscribe(Input::KeyboardEventType::TEXT_INPUT_SPECIAL,
         LambdaByReference([&](TextInputComponent& c, Input::KeyboardEvent e) {
@@ -114,7 +114,7 @@ void TextInputComponent::Render(const glm::mat4& proj) {
         float caretLeft = caretPos + caretOffset.x;
         float caretRight = caretPos + caretWidth * aspectRatioModifier_ + caretOffset.x;
 
-        float vertices[] = {
+        const float vertices[] = {
             // pos      // texCoords
             caretLeft, caretTop,     0.0f, 0.0f,
             caretLeft, caretBottom,  0.0f, 1.0f,
@@ -123,9 +123,10 @@ void TextInputComponent::Render(const glm::mat4& proj) {
             caretRight, caretBottom,  1.0f, 1.0f,
             caretRight, caretTop,     1.0f, 0.0f
         };
-        caretShape_.SetVertexData(vertices);
-        caretShape_.Bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        StreamBuffer::Allocation a = Systems::GetRenderer().GetStreamBuffer().Upload(vertices, sizeof(vertices), 4 * sizeof(float));
+        Shapes::GetDefaultShape(Shapes::DefaultShape::STREAM_VEC4).Bind();
+        glDrawArrays(GL_TRIANGLES, a.first, 6);
+        GLState::CountDraw(GL_TRIANGLES, 6);
     }
 }
 
@@ -0,0 +1,43 @@
+#include <latren/ui/renderstatsoverlay.h>
+#include <latren/ui/text.h>
+#include <latren/graphics/renderer.h>
+#include <latren/io/resourcemanager.h>
+#include <latren/systems.h>
+
+using namespace UI;
+
+void RenderStatsOverlay::RefreshText() {
+    text_.clear();
+    Systems::GetRenderer().GetStats().ForEachValue([&](const std::string& name, double value) {
+        if (hideZeros && value == 0.0)
+            return;
+        if (!text_.empty())
+            text_ += '\n';
+        text_ += name + ": " + RenderStats::FormatValue(value);
+    });
+}
+
+void RenderStatsOverlay::Draw() {
+    if (!isVisible || font.empty() || !Systems::GetResources().GetFontManager()->HasLoaded(font))
+        return;
+    double time = Systems::GetTime();
+    if (text_.empty() || time - lastRefresh_ >= refreshInterval) {
+        RefreshText();
+        lastRefresh_ = time;
+    }
+    if (text_.empty())
+        return;
+
+    const Text::Font& f = Systems::GetResources().GetFontManager()->Get(font);
+    float scale = size * f.GetSizeModifier();
+    shader_.Use();
+    shader_.SetUniform("textColor", color);
+    shader_.SetUniform("projection", GetProjectionMatrix());
+    // RenderText starts from the baseline of the first row
+    glm::vec2 pos = position - glm::vec2(0.0f, f.fontHeight * scale);
+    Text::RenderText(f, text_, pos, scale, 1.0f, HorizontalAlignment::LEFT, 5.0f * size);
+}
+
+const std::string& RenderStatsOverlay::GetText() const {
+    return text_;
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <latren/ui/text.h>
 #include <latren/graphics/shape.h>
+#include <latren/graphics/renderer.h>
+#include <latren/systems.h>
 #include <latren/graphics/textureatlas.h>
 #include <latren/io/resourcemanager.h>
 #include <latren/debugmacros.h>
@@ -10,6 +12,8 @@
 #include <unordered_map>
 #include <iostream>
 #include <sstream>
+#include <mutex>
+#include <memory>
 
 using namespace UI::Text;
 
@@ -68,7 +72,7 @@ BaseLine GetRowBaseLine(const Font& font, const T& text, bool applyModifier = tr
 GLuint CreateOpenGLFontTexture(const uint8_t* buffer, int w, int h) {
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(
         GL_TEXTURE_2D,
         0,
@@ -89,18 +93,45 @@ GLuint CreateOpenGLFontTexture(const uint8_t* buffer, int w, int h) {
     return texture;
 }
 
+// everything DecodeResource hands over to the game thread
+struct DecodedFont {
+    Font font;
+    bool createAtlas;
+    std::vector<WCHAR_T> chars;
+    std::vector<Texture::Sprite> atlasSprites;
+    Texture::TextureAtlas atlas = { nullptr, 0, 0 };
+
+    ~DecodedFont() {
+        // yeah yeah these are redundant but since we're handing raw buffers i'll stick to raw heap arrays
+        for (Texture::Sprite& s : atlasSprites) {
+            delete[] s.buffer;
+        }
+        delete[] atlas.buffer;
+    }
+};
+
+// FT_New_Face and FT_Done_Face touch the library, the faces themselves can be used from any thread
+std::mutex FREETYPE_LIBRARY_MUTEX;
+
 std::optional<Font> Resources::FontManager::LoadResource(const ResourcePath& path) {
+    return DecodeResource(path, GetItemID(), GetAdditionalData())();
+}
+
+std::function<std::optional<Font>()> Resources::FontManager::DecodeResource(const ResourcePath& path, const std::string&, const AdditionalImportData& additional) {
     std::string pathStr = path.GetParsedPathStr();
-    Font font;
-    const auto& additional = GetAdditionalData();
+    auto decoded = std::make_shared<DecodedFont>();
+    Font& font = decoded->font;
     glm::ivec2 fontSize = fontSize_;
     if (!additional.empty()) {
-        fontSize = { 0, std::get<int>(GetAdditionalData().at(0)) };
+        fontSize = { 0, std::get<int>(additional.at(0)) };
     }
-    bool createAtlas = true;
+    decoded->createAtlas = true;
 
-    if (FT_New_Face(FREETYPE_LIBRARY, pathStr.c_str(), 0, &font.fontFace))
-        return std::nullopt;
+    {
+        std::lock_guard<std::mutex> lock(FREETYPE_LIBRARY_MUTEX);
+        if (FT_New_Face(FREETYPE_LIBRARY, pathStr.c_str(), 0, &font.fontFace))
+            return [] { return std::nullopt; };
+    }
     FT_Face& face = font.fontFace;
     FT_Set_Pixel_Sizes(face, fontSize.x, fontSize.y);
     
@@ -109,10 +140,9 @@ std::optional<Font> Resources::FontManager::LoadResource(const ResourcePath& pat
     FT_ULong c = FT_Get_First_Char(face, &i);
     FT_ULong wcharMax = std::numeric_limits<WCHAR_T>::max();
     
-    std::vector<WCHAR_T> chars;
-    std::vector<Texture::Sprite> atlasSprites;
+    std::vector<WCHAR_T>& chars = decoded->chars;
+    std::vector<Texture::Sprite>& atlasSprites = decoded->atlasSprites;
     
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     while (i != 0) {
         if (FT_Load_Char(face, c, FT_LOAD_RENDER) != 0) {
             allGlyphsLoaded = false;
@@ -121,26 +151,23 @@ std::optional<Font> Resources::FontManager::LoadResource(const ResourcePath& pat
         const FT_GlyphSlot& glyph = face->glyph;
         
         Character character;
+        character.texture = GL_NONE;
         character.size = glm::ivec2(glyph->bitmap.width, glyph->bitmap.rows);
         character.bearing = glm::ivec2(glyph->bitmap_left, glyph->bitmap_top);
         // some bitshift magic from learnopengl.com
         // just multiplies by 64 since for some reason freetype uses 1/64 pixel as a unit
         character.advance = glyph->advance.x >> 6;
 
-        if (!createAtlas)
-            character.texture = CreateOpenGLFontTexture(glyph->bitmap.buffer, glyph->bitmap.width, glyph->bitmap.rows);
-
         font.charMap.insert(std::pair<WCHAR_T, Character>((WCHAR_T) c, character));
         chars.push_back((WCHAR_T) c);
 
-        if (createAtlas) {
-            Texture::Sprite s;
-            s.w = character.size.x;
-            s.h = character.size.y;
-            s.buffer = new uint8_t[s.w * s.h];
-            std::copy(glyph->bitmap.buffer, glyph->bitmap.buffer + s.w * s.h, s.buffer);
-            atlasSprites.push_back(s);
-        }
+        // the glyph bitmaps are kept for the game thread, as an atlas or the separate textures
+        Texture::Sprite s;
+        s.w = character.size.x;
+        s.h = character.size.y;
+        s.buffer = new uint8_t[s.w * s.h];
+        std::copy(glyph->bitmap.buffer, glyph->bitmap.buffer + s.w * s.h, s.buffer);
+        atlasSprites.push_back(s);
 
         c = FT_Get_Next_Char(face, c, &i);
         if (c > wcharMax)
@@ -150,12 +177,9 @@ std::optional<Font> Resources::FontManager::LoadResource(const ResourcePath& pat
     if (!allGlyphsLoaded)
         spdlog::warn("Some glyphs not loaded!", pathStr);
     
-    if (createAtlas) {
-        Texture::TextureAtlas atlas = Texture::CreateAtlas(atlasSprites, 1, 1);
-        GLuint atlasTexture = CreateOpenGLFontTexture(atlas.buffer, atlas.w, atlas.h);
-        font.atlasTexture = atlasTexture;
-        font.atlasSize = glm::ivec2(atlas.w, atlas.h);
-
+    if (decoded->createAtlas) {
+        decoded->atlas = Texture::CreateAtlas(atlasSprites, 1, 1);
+        const Texture::TextureAtlas& atlas = decoded->atlas;
         spdlog::info("Grouped {} characters into a {}x{} atlas texture", atlas.spriteData.size(), atlas.w, atlas.h);
 
         #ifdef LATREN_DUMP_FONT_ATLAS_PNGS
@@ -163,19 +187,8 @@ std::optional<Font> Resources::FontManager::LoadResource(const ResourcePath& pat
         #endif
 
         for (const auto& sprite : atlas.spriteData) {
-            Character& c = font.charMap[chars.at(sprite.id)];
-            c.texture = atlasTexture;
-            c.atlasOffset = sprite.offset;
-        }
-        
-        // yeah yeah these are redundant but since we're handing raw buffers i'll stick to raw heap arrays
-        for (Texture::Sprite& s : atlasSprites) {
-            delete[] s.buffer;
+            font.charMap[chars.at(sprite.id)].atlasOffset = sprite.offset;
         }
-        delete[] atlas.buffer;
-    }
-    else {
-        font.atlasTexture = TEXTURE_NONE;
     }
 
     // this is fucking genius
@@ -183,7 +196,27 @@ std::optional<Font> Resources::FontManager::LoadResource(const ResourcePath& pat
     font.fontHeight = (face->size->metrics.ascender - face->size->metrics.descender) >> 6;
     font.size = fontSize;
 
-    return std::optional<Font>(font);
+    return [decoded]() {
+        Font& font = decoded->font;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (decoded->createAtlas) {
+            const Texture::TextureAtlas& atlas = decoded->atlas;
+            GLuint atlasTexture = CreateOpenGLFontTexture(atlas.buffer, atlas.w, atlas.h);
+            font.atlasTexture = atlasTexture;
+            font.atlasSize = glm::ivec2(atlas.w, atlas.h);
+            for (const auto& sprite : atlas.spriteData) {
+                font.charMap[decoded->chars.at(sprite.id)].texture = atlasTexture;
+            }
+        }
+        else {
+            font.atlasTexture = TEXTURE_NONE;
+            for (std::size_t i = 0; i < decoded->chars.size(); i++) {
+                const Texture::Sprite& s = decoded->atlasSprites.at(i);
+                font.charMap[decoded->chars.at(i)].texture = CreateOpenGLFontTexture(s.buffer, s.w, s.h);
+            }
+        }
+        return std::optional<Font>(font);
+    };
 }
 
 void Resources::FontManager::SetFontSize(const glm::ivec2& size) {
@@ -195,18 +228,29 @@ void Resources::FontManager::SetFontSize(int size) {
 }
 
 void UI::Text::RenderText(const Font& font, const std::string& text, glm::vec2 pos, float size, float aspectRatio, HorizontalAlignment alignment, float lineSpacing) {    
-    glActiveTexture(GL_TEXTURE0);
-    Shapes::GetDefaultShape(Shapes::DefaultShape::RECTANGLE_VEC4).Bind();
+    if (text.empty())
+        return;
+    Systems::GetRenderer().GetGLState().ActiveTexture(0);
     std::vector<int> lineWidths = GetLineWidths(font, text);
     int textWidth = *std::max_element(lineWidths.begin(), lineWidths.end());
     int line = 0;
     glm::vec2 startPos = pos;
-    
-    struct CharToRender {
-        glm::vec2 pos;
-        const Character& c;
+    bool useAtlas = (font.atlasTexture != TEXTURE_NONE);
+
+    struct CharQuad {
+        struct {
+            float posX, posY, texX, texY;
+        } tl0, bl0, br0, tl1, br1, tr1;
     };
-    std::vector<CharToRender> charsToRender;
+    // the quads are written straight into the stream buffer, one per character at most
+    StreamBuffer& stream = Systems::GetRenderer().GetStreamBuffer();
+    const GLsizei vertexSize = sizeof(CharQuad) / 6;
+    StreamBuffer::Allocation alloc = stream.Allocate(text.size() * sizeof(CharQuad), vertexSize);
+    if (alloc.data == nullptr)
+        return;
+    CharQuad* quads = static_cast<CharQuad*>(alloc.data);
+    int quadCount = 0;
+
     float m = font.GetSizeModifier();
     for (std::string::const_iterator it = text.begin(); it != text.end(); ++it) {
         const Character& c = font.GetChar(*it);
@@ -230,74 +274,51 @@ void UI::Text::RenderText(const Font& font, const std::string& text, glm::vec2 p
                 actualPos.x = pos.x + (c.bearing.x * m * size + (textWidth - lineWidths.at(line)) / 2.0f) / m * size * aspectRatio;
                 break;
         }
-
-        charsToRender.push_back({ actualPos, c });
-        
         pos.x += c.advance * size * aspectRatio;
+
+        float w = c.size.x * size * aspectRatio;
+        float h = c.size.y * size;
+        float texTop = 0.0f;
+        float texBottom = 1.0f;
+        float texLeft = 0.0f;
+        float texRight = 1.0f;
+        if (useAtlas) {
+            texTop = c.atlasOffset.y / (float) font.atlasSize.y;
+            texBottom = (c.atlasOffset.y + c.size.y) / (float) font.atlasSize.y;
+            texLeft = c.atlasOffset.x / (float) font.atlasSize.x;
+            texRight = (c.atlasOffset.x + c.size.x) / (float) font.atlasSize.x;
+        }
+        quads[quadCount++] = {
+            { actualPos.x,     actualPos.y + h,   texLeft,  texTop },
+            { actualPos.x,     actualPos.y,       texLeft,  texBottom },
+            { actualPos.x + w, actualPos.y,       texRight, texBottom },
+
+            { actualPos.x,     actualPos.y + h,   texLeft,  texTop },
+            { actualPos.x + w, actualPos.y,       texRight, texBottom },
+            { actualPos.x + w, actualPos.y + h,   texRight, texTop }
+        };
     }
-    bool useAtlas = (font.atlasTexture != TEXTURE_NONE);
+    stream.Commit(alloc, quadCount * sizeof(CharQuad));
+    Shapes::GetDefaultShape(Shapes::DefaultShape::STREAM_VEC4).Bind();
 
-    struct CharQuad {
-        struct {
-            float posX, posY, texX, texY;
-        } tl0, bl0, br0, tl1, br1, tr1;
-    };
     if (useAtlas) {
-        std::vector<CharQuad> vertices;
-        vertices.reserve(charsToRender.size());
-        for (const CharToRender& c : charsToRender) {
-            float inwards = 0.0f;
-            float texTop = (c.c.atlasOffset.y + inwards) / (float) font.atlasSize.y;
-            float texBottom = c.c.atlasOffset.y / (float) font.atlasSize.y + (c.c.size.y - inwards) / (float) font.atlasSize.y;
-            float texLeft = (c.c.atlasOffset.x + inwards) / (float) font.atlasSize.x;
-            float texRight = c.c.atlasOffset.x / (float) font.atlasSize.x + (c.c.size.x - inwards) / (float) font.atlasSize.x;
-
-            float w = c.c.size.x * size * aspectRatio;
-            float h = c.c.size.y * size;
-
-            vertices.push_back({
-                { c.pos.x,     c.pos.y + h,   texLeft,  texTop },
-                { c.pos.x,     c.pos.y,       texLeft,  texBottom },
-                { c.pos.x + w, c.pos.y,       texRight, texBottom },
-
-                { c.pos.x,     c.pos.y + h,   texLeft,  texTop },
-                { c.pos.x + w, c.pos.y,       texRight, texBottom },
-                { c.pos.x + w, c.pos.y + h,   texRight, texTop }
-            });
-        }
-        Shape s;
-        s.numVertices = 6 * (int) vertices.size();
-        s.numVertexAttributes = 4;
-        s.stride = 4;
-        s.GenerateVAO();
-        s.Bind();
-        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(CharQuad), vertices.data()); 
-        glBindTexture(GL_TEXTURE_2D, font.atlasTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 6 * (int) vertices.size());
+        Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, font.atlasTexture);
+        glDrawArrays(GL_TRIANGLES, alloc.first, 6 * quadCount);
+        GLState::CountDraw(GL_TRIANGLES, 6 * quadCount);
     }
     else {
-        Shapes::GetDefaultShape(Shapes::DefaultShape::RECTANGLE_VEC4).Bind();
-        for (const auto& c : charsToRender) {
-            float w = c.c.size.x * size * aspectRatio;
-            float h = c.c.size.y * size;
-            CharQuad quad = {
-                { c.pos.x,     c.pos.y + h,   0.0f, 0.0f },
-                { c.pos.x,     c.pos.y,       0.0f, 1.0f },
-                { c.pos.x + w, c.pos.y,       1.0f, 1.0f },
-
-                { c.pos.x,     c.pos.y + h,   0.0f, 0.0f },
-                { c.pos.x + w, c.pos.y,       1.0f, 1.0f },
-                { c.pos.x + w, c.pos.y + h,   1.0f, 0.0f }
-            };
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(quad), &quad); 
-
-            glBindTexture(GL_TEXTURE_2D, c.c.texture);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+        // every glyph has its own texture, draw them one by one
+        int i = 0;
+        for (char ch : text) {
+            if (ch == '\n')
+                continue;
+            Systems::GetRenderer().GetGLState().BindTexture(GL_TEXTURE_2D, font.GetChar(ch).texture);
+            glDrawArrays(GL_TRIANGLES, alloc.first + 6 * i, 6);
+            GLState::CountDraw(GL_TRIANGLES, 6);
+            ++i;
         }
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 int UI::Text::GetLineWidth(const Font& font, const std::string& text) {
@@ -0,0 +1,185 @@
+// offline texture compressor, png/jpg/tga -> dds with the whole mip chain.
+// the engine picks the .dds up instead of the original when it's next to it (TextureManager::preferCompressedTextures)
+//
+// usage: latren-texcompress [-f auto|bc1|bc3|bc4|bc5] input.png [output.dds]
+
+#include <latren/graphics/compressedtexture.h>
+
+#include <stb/stb_image.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb/stb_dxt.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+using namespace Texture;
+
+struct Image {
+    int width;
+    int height;
+    int channels;
+    std::vector<uint8_t> pixels;
+};
+
+// box filter, the odd rows and columns at the edge get clamped
+Image Downsample(const Image& src) {
+    Image dst;
+    dst.width = std::max(1, src.width / 2);
+    dst.height = std::max(1, src.height / 2);
+    dst.channels = src.channels;
+    dst.pixels.resize((std::size_t) dst.width * dst.height * dst.channels);
+    for (int y = 0; y < dst.height; y++) {
+        for (int x = 0; x < dst.width; x++) {
+            int x0 = std::min(x * 2, src.width - 1);
+            int x1 = std::min(x * 2 + 1, src.width - 1);
+            int y0 = std::min(y * 2, src.height - 1);
+            int y1 = std::min(y * 2 + 1, src.height - 1);
+            for (int c = 0; c < src.channels; c++) {
+                auto at = [&](int sx, int sy) { return (int) src.pixels[((std::size_t) sy * src.width + sx) * src.channels + c]; };
+                int sum = at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1);
+                dst.pixels[((std::size_t) y * dst.width + x) * dst.channels + c] = (uint8_t) ((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+// the 4x4 block at bx, by as rgba, the texels over the edge repeat the last row and column
+void FetchBlock(const Image& img, int bx, int by, uint8_t* rgba) {
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int sx = std::min(bx * 4 + x, img.width - 1);
+            int sy = std::min(by * 4 + y, img.height - 1);
+            const uint8_t* p = &img.pixels[((std::size_t) sy * img.width + sx) * img.channels];
+            uint8_t* out = rgba + (y * 4 + x) * 4;
+            switch (img.channels) {
+                case 1:
+                    out[0] = out[1] = out[2] = p[0];
+                    out[3] = 255;
+                    break;
+                case 2:
+                    out[0] = p[0];
+                    out[1] = p[1];
+                    out[2] = 0;
+                    out[3] = 255;
+                    break;
+                case 3:
+                    std::memcpy(out, p, 3);
+                    out[3] = 255;
+                    break;
+                default:
+                    std::memcpy(out, p, 4);
+                    break;
+            }
+        }
+    }
+}
+
+CompressedImage::Level CompressLevel(const Image& img, CompressedFormat format) {
+    CompressedImage::Level level { img.width, img.height, std::vector<uint8_t>(GetCompressedLevelSize(format, img.width, img.height)) };
+    std::size_t blockSize = GetCompressedBlockSize(format);
+    int blocksX = std::max(1, (img.width + 3) / 4);
+    int blocksY = std::max(1, (img.height + 3) / 4);
+    uint8_t rgba[16 * 4];
+    uint8_t channel[16 * 2];
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            uint8_t* dst = level.data.data() + ((std::size_t) by * blocksX + bx) * blockSize;
+            FetchBlock(img, bx, by, rgba);
+            switch (format) {
+                case CompressedFormat::BC1:
+                    stb_compress_dxt_block(dst, rgba, 0, STB_DXT_HIGHQUAL);
+                    break;
+                case CompressedFormat::BC3:
+                    stb_compress_dxt_block(dst, rgba, 1, STB_DXT_HIGHQUAL);
+                    break;
+                case CompressedFormat::BC4:
+                    for (int i = 0; i < 16; i++)
+                        channel[i] = rgba[i * 4];
+                    stb_compress_bc4_block(dst, channel);
+                    break;
+                case CompressedFormat::BC5:
+                    for (int i = 0; i < 16; i++) {
+                        channel[i * 2] = rgba[i * 4];
+                        channel[i * 2 + 1] = rgba[i * 4 + 1];
+                    }
+                    stb_compress_bc5_block(dst, channel);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return level;
+}
+
+CompressedFormat PickFormat(const Image& img) {
+    switch (img.channels) {
+        case 1: return CompressedFormat::BC4;
+        case 2: return CompressedFormat::BC5;
+        case 3: return CompressedFormat::BC1;
+    }
+    // BC1 is half the size, so use it if the alpha doesn't actually do anything
+    for (std::size_t i = 3; i < img.pixels.size(); i += 4) {
+        if (img.pixels[i] != 255)
+            return CompressedFormat::BC3;
+    }
+    return CompressedFormat::BC1;
+}
+
+int main(int argc, char** argv) {
+    std::string formatArg = "auto";
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc)
+            formatArg = argv[++i];
+        else
+            paths.push_back(arg);
+    }
+    if (paths.empty() || paths.size() > 2) {
+        std::cerr << "usage: " << argv[0] << " [-f auto|bc1|bc3|bc4|bc5] input.png [output.dds]" << std::endl;
+        return 1;
+    }
+    std::fs::path input = paths.at(0);
+    std::fs::path output = paths.size() > 1 ? std::fs::path(paths.at(1)) : std::fs::path(input).replace_extension(".dds");
+
+    Image img;
+    uint8_t* data = stbi_load(input.generic_string().c_str(), &img.width, &img.height, &img.channels, 0);
+    if (data == nullptr) {
+        std::cerr << "can't load " << input.generic_string() << ": " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+    img.pixels.assign(data, data + (std::size_t) img.width * img.height * img.channels);
+    stbi_image_free(data);
+
+    CompressedImage compressed;
+    if (formatArg == "auto")
+        compressed.format = PickFormat(img);
+    else if (formatArg == "bc1")
+        compressed.format = CompressedFormat::BC1;
+    else if (formatArg == "bc3")
+        compressed.format = CompressedFormat::BC3;
+    else if (formatArg == "bc4")
+        compressed.format = CompressedFormat::BC4;
+    else if (formatArg == "bc5")
+        compressed.format = CompressedFormat::BC5;
+    else {
+        std::cerr << "unknown format " << formatArg << std::endl;
+        return 1;
+    }
+
+    // all the way down to 1x1, the engine uses every level it finds
+    compressed.levels.push_back(CompressLevel(img, compressed.format));
+    while (img.width > 1 || img.height > 1) {
+        img = Downsample(img);
+        compressed.levels.push_back(CompressLevel(img, compressed.format));
+    }
+    if (!SaveDDS(output, compressed)) {
+        std::cerr << "can't write " << output.generic_string() << std::endl;
+        return 1;
+    }
+    std::cout << input.generic_string() << " -> " << output.generic_string() << " (" << GetCompressedFormatName(compressed.format) << ", " << compressed.levels.size() << " levels)" << std::endl;
+    return 0;
+}
\ No newline at end of file